@@ -2,17 +2,38 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 #include <cstdint>      // 用于 uint32_t, uint64_t
 #include <cstring>      // 用于 memcpy
 #include <stdexcept>    // (可选) 用于错误处理
+#include <iostream>     // 用于调试日志
+#include <atomic>
 
-// --- V2 布局常量 ---
+// --- 调试日志 ---
+
+/**
+ * @brief 调试日志开关 (默认打开；服务器和压测会关闭它，避免每次写入都打印)
+ */
+inline std::atomic<bool>& DebugLogEnabled() {
+    static std::atomic<bool> enabled(true);
+    return enabled;
+}
+
+// 只在调试日志打开时打印一行 (用法: KV_DEBUG_LOG("[Builder] 刷盘 " << key);)
+#define KV_DEBUG_LOG(msg) \
+    do { if (DebugLogEnabled()) { std::cout << msg << std::endl; } } while (0)
+
+// --- V3 布局常量 ---
 
 // 我们的演示用数据块大小阈值 (真实世界是 4KB+)
 const uint32_t DATA_BLOCK_SIZE_THRESHOLD = 128; // 128 字节
 
+// 默认的页大小 (用于数据块的页对齐布局)
+const uint32_t DEFAULT_PAGE_SIZE = 4096; // 4 KB
+
 // 用于校验 SSTable 文件的“魔数”
-const uint64_t SSTABLE_MAGIC_NUMBER = 0xDEADBEEFCAFEF00D;
+// (V3 在 Footer 中新增了 MetaIndex Block 句柄，因此换用新魔数，旧 V2 文件会被拒绝)
+const uint64_t SSTABLE_MAGIC_NUMBER = 0xDEADBEEFCAFEF00E;
 
 /**
  * @brief BlockHandle (块句柄) - "数据块的指针"
@@ -50,42 +71,82 @@ struct BlockHandle {
 const uint32_t BLOCK_HANDLE_SIZE = sizeof(uint64_t) + sizeof(uint32_t); // 12 字节
 
 /**
- * @brief Footer (文件尾) - "索引块的指针"
- * 磁盘布局: [index_block_handle (12B)] [magic_number (8B)]
+ * @brief Footer (文件尾) - "元数据块的指针"
+ * 磁盘布局: [metaindex_block_handle (12B)] [index_block_handle (12B)] [magic_number (8B)]
  */
 struct Footer {
-    BlockHandle index_block_handle_; // 指向 Index Block
-    uint64_t magic_number_ = 0;      // 魔数
+    BlockHandle metaindex_block_handle_; // 指向 MetaIndex Block
+    BlockHandle index_block_handle_;     // 指向 Index Block
+    uint64_t magic_number_ = 0;          // 魔数
 
     /**
      * @brief 【EncodeTo 实现】
-     * 将此结构体序列化（扁平化）为一个20字节的序列，并追加到 dst
+     * 将此结构体序列化（扁平化）为一个32字节的序列，并追加到 dst
      */
     void EncodeTo(std::string* dst) const {
+        metaindex_block_handle_.EncodeTo(dst);
         index_block_handle_.EncodeTo(dst);
         dst->append(reinterpret_cast<const char*>(&magic_number_), sizeof(magic_number_));
     }
 
     /**
      * @brief 【DecodeFrom 实现】
-     * 从 input (一个20字节的视图) 中解析，填充此结构体
+     * 从 input (一个32字节的视图) 中解析，填充此结构体
      */
     bool DecodeFrom(std::string_view input) {
-        if (input.size() < (BLOCK_HANDLE_SIZE + sizeof(magic_number_))) {
+        if (input.size() < (2 * BLOCK_HANDLE_SIZE + sizeof(magic_number_))) {
             return false;
         }
-        // 先校验魔数 (魔数在 handle 之后)
-        memcpy(&magic_number_, input.data() + BLOCK_HANDLE_SIZE, sizeof(magic_number_));
+        // 先校验魔数 (魔数在两个 handle 之后)
+        memcpy(&magic_number_, input.data() + 2 * BLOCK_HANDLE_SIZE, sizeof(magic_number_));
         if (magic_number_ != SSTABLE_MAGIC_NUMBER) {
             return false; // 这不是一个有效的 SSTable 文件
         }
-        // 魔数正确，现在解析 handle
-        std::string_view handle_input = input.substr(0, BLOCK_HANDLE_SIZE);
-        return index_block_handle_.DecodeFrom(&handle_input);
+        // 魔数正确，现在依次解析两个 handle
+        std::string_view handle_input = input.substr(0, 2 * BLOCK_HANDLE_SIZE);
+        return metaindex_block_handle_.DecodeFrom(&handle_input) &&
+               index_block_handle_.DecodeFrom(&handle_input);
     }
 };
 
-const uint32_t FOOTER_SIZE = BLOCK_HANDLE_SIZE + sizeof(uint64_t); // 20 字节
+const uint32_t FOOTER_SIZE = 2 * BLOCK_HANDLE_SIZE + sizeof(uint64_t); // 32 字节
+
+// --- MetaIndex Block ---
+// MetaIndex Block 是一个 K/V 序列: [元数据块名] -> [BlockHandle]
+// 新的元数据块只需要在这里登记一个名字，不需要再修改 Footer。
+const char* const METAINDEX_PROPERTIES_KEY = "kv.properties";    // -> Properties Block
+const char* const METAINDEX_FILTER_INDEX_KEY = "kv.filter.index"; // -> Filter Index Block (可选)
+
+// --- 定长整数编码辅助函数 ---
+// (与 BlockHandle 相同，按本机字节序直接拷贝)
+
+inline void PutFixed32(std::string* dst, uint32_t value) {
+    dst->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void PutFixed64(std::string* dst, uint64_t value) {
+    dst->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief 从 input 的开头读取一个 4 字节整数（并从 input 中移除）
+ */
+inline bool GetFixed32(std::string_view* input, uint32_t* value) {
+    if (input->size() < sizeof(*value)) return false;
+    memcpy(value, input->data(), sizeof(*value));
+    input->remove_prefix(sizeof(*value));
+    return true;
+}
+
+/**
+ * @brief 从 input 的开头读取一个 8 字节整数（并从 input 中移除）
+ */
+inline bool GetFixed64(std::string_view* input, uint64_t* value) {
+    if (input->size() < sizeof(*value)) return false;
+    memcpy(value, input->data(), sizeof(*value));
+    input->remove_prefix(sizeof(*value));
+    return true;
+}
 
 // --- 内部 K/V 格式辅助函数 ---
 // Data Block 和 Index Block 内部都使用这个简单的 K/V 格式
@@ -138,4 +199,92 @@ inline bool readKV(std::string_view* input, std::string_view* key, std::string_v
     input->remove_prefix(value_len);
 
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief TableProperties (表属性) - "SSTable 的统计信息"
+ * 由 Builder 在 Finish() 时写入 Properties Block，Reader 在打开时加载。
+ * 磁盘布局: 与 Data Block 相同的 K/V 序列，Key 为属性名，Value 为 8 字节整数。
+ * (未知的属性名在解析时会被忽略，便于以后追加新属性)
+ */
+struct TableProperties {
+    uint64_t num_entries_ = 0;      // K/V 条目总数
+    uint64_t num_data_blocks_ = 0;  // Data Block 个数
+    uint64_t raw_key_size_ = 0;     // 所有 Key 的原始字节数
+    uint64_t raw_value_size_ = 0;   // 所有 Value 的原始字节数
+    uint64_t data_size_ = 0;        // 所有 Data Block 的字节数 (不含填充)
+    uint64_t index_size_ = 0;       // Index Block 的字节数
+    uint64_t padding_size_ = 0;     // 为页对齐而插入的填充字节数
+    uint64_t page_size_ = 0;        // 页对齐使用的页大小 (0 表示未开启页对齐)
+    uint64_t filter_size_ = 0;      // 所有 Filter 分区的字节数
+    uint64_t num_filter_partitions_ = 0; // Filter 分区个数
+    uint64_t num_timestamped_entries_ = 0; // 能取出时间戳的条目数 (BuilderOptions::timestamp_extractor_)
+    uint64_t min_timestamp_ = 0;    // 这些条目中最小的时间戳
+    uint64_t max_timestamp_ = 0;    // 这些条目中最大的时间戳
+    uint64_t compression_ = 0;      // 数据块的压缩算法 (CompressionType；非 0 时每个数据块带 1 字节块类型)
+    uint64_t raw_data_size_ = 0;    // 所有 Data Block 压缩前的字节数
+    uint64_t comparator_ = 0;       // Key 的顺序 (ComparatorType)
+    uint64_t num_fixed_key_blocks_ = 0; // 使用定长 Key 布局的 Data Block 个数
+
+    /**
+     * @brief 【EncodeTo 实现】
+     * 将所有属性序列化为 K/V 序列，并追加到 dst
+     */
+    void EncodeTo(std::string* dst) const {
+        for (const auto& field : Fields()) {
+            const uint64_t& v = this->*(field.member);
+            writeKV(dst, field.name, std::string_view(reinterpret_cast<const char*>(&v), sizeof(v)));
+        }
+    }
+
+    /**
+     * @brief 【DecodeFrom 实现】
+     * 从 input (Properties Block 的内容) 中解析，填充此结构体
+     */
+    bool DecodeFrom(std::string_view input) {
+        while (!input.empty()) {
+            std::string_view name;
+            std::string_view value;
+            if (!readKV(&input, &name, &value) || value.size() != sizeof(uint64_t)) {
+                return false; // 块损坏
+            }
+            for (const auto& field : Fields()) {
+                if (name == field.name) {
+                    memcpy(&(this->*(field.member)), value.data(), sizeof(uint64_t));
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Field {
+        const char* name;
+        uint64_t TableProperties::* member;
+    };
+
+    // 属性名 <-> 成员 的对照表 (EncodeTo / DecodeFrom 共用)
+    static const std::vector<Field>& Fields() {
+        static const std::vector<Field> fields = {
+            {"kv.num.entries", &TableProperties::num_entries_},
+            {"kv.num.data.blocks", &TableProperties::num_data_blocks_},
+            {"kv.raw.key.size", &TableProperties::raw_key_size_},
+            {"kv.raw.value.size", &TableProperties::raw_value_size_},
+            {"kv.data.size", &TableProperties::data_size_},
+            {"kv.index.size", &TableProperties::index_size_},
+            {"kv.padding.size", &TableProperties::padding_size_},
+            {"kv.page.size", &TableProperties::page_size_},
+            {"kv.filter.size", &TableProperties::filter_size_},
+            {"kv.num.filter.partitions", &TableProperties::num_filter_partitions_},
+            {"kv.num.timestamped.entries", &TableProperties::num_timestamped_entries_},
+            {"kv.min.timestamp", &TableProperties::min_timestamp_},
+            {"kv.max.timestamp", &TableProperties::max_timestamp_},
+            {"kv.compression", &TableProperties::compression_},
+            {"kv.raw.data.size", &TableProperties::raw_data_size_},
+            {"kv.comparator", &TableProperties::comparator_},
+            {"kv.num.fixed.key.blocks", &TableProperties::num_fixed_key_blocks_},
+        };
+        return fields;
+    }
+};
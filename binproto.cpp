@@ -0,0 +1,241 @@
+#include "binproto.h"
+#include <cstring>
+#include "base.h"        // 用于 PutFixed32 / GetFixed32
+#include "kvstore.h"
+#include "outputbuffer.h"
+#include "writebatch.h"
+
+BinParseResult ParseBinFrame(std::string_view input, BinFrame* frame, size_t* consumed) {
+    if (input.size() < sizeof(uint32_t)) {
+        return BinParseResult::INCOMPLETE;
+    }
+    uint32_t len = 0;
+    memcpy(&len, input.data(), sizeof(len));
+    if (len < BIN_FRAME_HEADER_SIZE - sizeof(uint32_t) || len > BIN_MAX_FRAME_SIZE) {
+        return BinParseResult::ERROR;
+    }
+    if (input.size() - sizeof(uint32_t) < len) {
+        return BinParseResult::INCOMPLETE;
+    }
+    memcpy(&frame->request_id_, input.data() + 4, sizeof(uint32_t));
+    frame->code_ = static_cast<uint8_t>(input[8]);
+    frame->payload_ = input.substr(BIN_FRAME_HEADER_SIZE, len + sizeof(uint32_t) - BIN_FRAME_HEADER_SIZE);
+    *consumed = sizeof(uint32_t) + len;
+    return BinParseResult::OK;
+}
+
+void AppendBinFrameHeader(std::string* out, uint32_t request_id, uint8_t code, size_t payload_size) {
+    PutFixed32(out, static_cast<uint32_t>(BIN_FRAME_HEADER_SIZE - sizeof(uint32_t) + payload_size));
+    PutFixed32(out, request_id);
+    out->push_back(static_cast<char>(code));
+}
+
+void PutLengthPrefixed(std::string* dst, std::string_view s) {
+    PutFixed32(dst, static_cast<uint32_t>(s.size()));
+    dst->append(s.data(), s.size());
+}
+
+bool GetLengthPrefixed(std::string_view* input, std::string_view* result) {
+    uint32_t len = 0;
+    if (!GetFixed32(input, &len) || input->size() < len) {
+        return false;
+    }
+    *result = input->substr(0, len);
+    input->remove_prefix(len);
+    return true;
+}
+
+void EncodePingRequest(std::string* out, uint32_t request_id) {
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::PING), 0);
+}
+
+void EncodeGetRequest(std::string* out, uint32_t request_id, std::string_view key) {
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::GET), key.size());
+    out->append(key.data(), key.size());
+}
+
+void EncodePutRequest(std::string* out, uint32_t request_id, std::string_view key, std::string_view value) {
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::PUT),
+                         sizeof(uint32_t) + key.size() + value.size());
+    PutLengthPrefixed(out, key);
+    out->append(value.data(), value.size());
+}
+
+void EncodeDeleteRequest(std::string* out, uint32_t request_id, std::string_view key) {
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::DELETE), key.size());
+    out->append(key.data(), key.size());
+}
+
+void EncodeMultiGetRequest(std::string* out, uint32_t request_id, const std::vector<std::string_view>& keys) {
+    size_t payload_size = sizeof(uint32_t);
+    for (std::string_view key : keys) {
+        payload_size += sizeof(uint32_t) + key.size();
+    }
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::MULTI_GET), payload_size);
+    PutFixed32(out, static_cast<uint32_t>(keys.size()));
+    for (std::string_view key : keys) {
+        PutLengthPrefixed(out, key);
+    }
+}
+
+void EncodeWriteBatchRequest(std::string* out, uint32_t request_id, const WriteBatch& batch) {
+    const std::string& contents = batch.Contents();
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::WRITE_BATCH), contents.size());
+    out->append(contents);
+}
+
+void EncodeScanRequest(std::string* out, uint32_t request_id, std::string_view start, uint32_t limit) {
+    AppendBinFrameHeader(out, request_id, static_cast<uint8_t>(BinOpcode::SCAN),
+                         sizeof(uint32_t) + start.size());
+    PutFixed32(out, limit);
+    out->append(start.data(), start.size());
+}
+
+bool DecodeMultiGetReply(std::string_view payload, std::vector<std::string>* values, std::vector<bool>* found) {
+    uint32_t count = 0;
+    if (!GetFixed32(&payload, &count)) {
+        return false;
+    }
+    values->assign(count, std::string());
+    found->assign(count, false);
+    for (uint32_t i = 0; i < count; i++) {
+        std::string_view value;
+        if (payload.empty()) {
+            return false;
+        }
+        (*found)[i] = (payload[0] != 0);
+        payload.remove_prefix(1);
+        if (!GetLengthPrefixed(&payload, &value)) {
+            return false;
+        }
+        (*values)[i].assign(value.data(), value.size());
+    }
+    return payload.empty();
+}
+
+bool DecodeScanReply(std::string_view payload, std::vector<std::pair<std::string, std::string>>* results) {
+    uint32_t count = 0;
+    if (!GetFixed32(&payload, &count)) {
+        return false;
+    }
+    results->clear();
+    for (uint32_t i = 0; i < count; i++) {
+        std::string_view key, value;
+        if (!GetLengthPrefixed(&payload, &key) || !GetLengthPrefixed(&payload, &value)) {
+            return false;
+        }
+        results->emplace_back(std::string(key), std::string(value));
+    }
+    return payload.empty();
+}
+
+void BinCommandHandler::Reply(OutputBuffer* out, uint32_t request_id, BinStatus status,
+                              std::string_view payload) {
+    std::string* tail = out->Tail();
+    AppendBinFrameHeader(tail, request_id, static_cast<uint8_t>(status), payload.size());
+    tail->append(payload.data(), payload.size());
+}
+
+void BinCommandHandler::Execute(const BinFrame& request, OutputBuffer* out) {
+    std::string_view payload = request.payload_;
+    uint32_t id = request.request_id_;
+    switch (static_cast<BinOpcode>(request.code_)) {
+        case BinOpcode::PING:
+            Reply(out, id, BinStatus::OK, std::string_view());
+            return;
+
+        case BinOpcode::GET: {
+            std::string value; // 每次新建，大值直接移动进输出队列
+            if (!db_->Get(payload, &value)) {
+                Reply(out, id, BinStatus::NOT_FOUND, std::string_view());
+                return;
+            }
+            AppendBinFrameHeader(out->Tail(), id, static_cast<uint8_t>(BinStatus::OK), value.size());
+            out->AppendOwned(std::move(value));
+            return;
+        }
+
+        case BinOpcode::PUT: {
+            std::string_view key;
+            if (!GetLengthPrefixed(&payload, &key)) {
+                break;
+            }
+            bool ok = db_->Put(key, payload);
+            Reply(out, id, ok ? BinStatus::OK : BinStatus::ERROR, ok ? "" : "write failed");
+            return;
+        }
+
+        case BinOpcode::DELETE: {
+            bool ok = db_->Delete(payload);
+            Reply(out, id, ok ? BinStatus::OK : BinStatus::ERROR, ok ? "" : "write failed");
+            return;
+        }
+
+        case BinOpcode::MULTI_GET: {
+            uint32_t count = 0;
+            if (!GetFixed32(&payload, &count) || count > payload.size() / sizeof(uint32_t)) {
+                break;
+            }
+            std::vector<std::string_view> keys(count);
+            bool valid = true;
+            for (uint32_t i = 0; i < count && valid; i++) {
+                valid = GetLengthPrefixed(&payload, &keys[i]);
+            }
+            if (!valid || !payload.empty()) {
+                break;
+            }
+            std::vector<std::string> values;
+            std::vector<bool> found;
+            db_->MultiGet(keys, &values, &found);
+            size_t payload_size = sizeof(uint32_t);
+            for (const auto& value : values) {
+                payload_size += 1 + sizeof(uint32_t) + value.size();
+            }
+            std::string* tail = out->Tail();
+            AppendBinFrameHeader(tail, id, static_cast<uint8_t>(BinStatus::OK), payload_size);
+            PutFixed32(tail, count);
+            for (uint32_t i = 0; i < count; i++) {
+                tail = out->Tail();
+                tail->push_back(found[i] ? 1 : 0);
+                PutFixed32(tail, static_cast<uint32_t>(values[i].size()));
+                out->AppendOwned(std::move(values[i]));
+            }
+            return;
+        }
+
+        case BinOpcode::WRITE_BATCH: {
+            WriteBatch batch;
+            if (!batch.SetContents(payload)) {
+                break;
+            }
+            if (!batch.Validate()) {
+                Reply(out, id, BinStatus::ERROR, "malformed batch");
+                return;
+            }
+            bool ok = db_->Write(&batch);
+            Reply(out, id, ok ? BinStatus::OK : BinStatus::ERROR, ok ? "" : "write failed");
+            return;
+        }
+
+        case BinOpcode::SCAN: {
+            uint32_t limit = 0;
+            if (!GetFixed32(&payload, &limit)) {
+                break;
+            }
+            std::vector<std::pair<std::string, std::string>> results;
+            if (!db_->Scan(payload, limit, &results)) {
+                Reply(out, id, BinStatus::ERROR, "scan failed");
+                return;
+            }
+            payload_.clear();
+            PutFixed32(&payload_, static_cast<uint32_t>(results.size()));
+            for (const auto& kv : results) {
+                PutLengthPrefixed(&payload_, kv.first);
+                PutLengthPrefixed(&payload_, kv.second);
+            }
+            Reply(out, id, BinStatus::OK, payload_);
+            return;
+        }
+    }
+    Reply(out, id, BinStatus::ERROR, "bad request");
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+class KVStore;
+class WriteBatch;
+class OutputBuffer;
+
+/**
+ * 二进制协议 (小端)
+ *
+ * 请求帧: [len 4B][request_id 4B][opcode 1B][payload]
+ * 回复帧: [len 4B][request_id 4B][status 1B][payload]
+ * len 是 len 字段之后的字节数。回复携带请求的 request_id，
+ * 因此客户端可以在一个连接上流水线发送请求，并按 id 匹配 (可能乱序的) 回复。
+ *
+ * 请求 payload:
+ *   PING        : 空
+ *   GET         : [key]
+ *   PUT         : [klen 4B][key][value]
+ *   DELETE      : [key]
+ *   MULTI_GET   : [count 4B] ([klen 4B][key])*
+ *   WRITE_BATCH : WriteBatch::Contents()
+ *   SCAN        : [limit 4B][start key]
+ * 回复 payload (status == OK):
+ *   GET         : [value]                        (未找到时 status == NOT_FOUND)
+ *   MULTI_GET   : [count 4B] ([found 1B][vlen 4B][value])*
+ *   SCAN        : [count 4B] ([klen 4B][key][vlen 4B][value])*
+ *   其余        : 空
+ * status == ERROR 时 payload 是错误信息。
+ */
+
+enum class BinOpcode : uint8_t {
+    PING = 0,
+    GET = 1,
+    PUT = 2,
+    DELETE = 3,
+    MULTI_GET = 4,
+    WRITE_BATCH = 5,
+    SCAN = 6,
+};
+
+enum class BinStatus : uint8_t {
+    OK = 0,
+    NOT_FOUND = 1,
+    ERROR = 2,
+};
+
+// 帧头大小: len + request_id + opcode/status
+const size_t BIN_FRAME_HEADER_SIZE = 4 + 4 + 1;
+
+// 单个帧的最大长度
+const uint32_t BIN_MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief 二进制帧的解析结果
+ */
+enum class BinParseResult {
+    OK,          // 解析出了一个完整的帧
+    INCOMPLETE,  // 数据还不完整
+    ERROR,       // 帧长度非法 (应关闭连接)
+};
+
+/**
+ * @brief 一个已解析的帧 (请求或回复)
+ */
+struct BinFrame {
+    uint32_t request_id_ = 0;
+    uint8_t code_ = 0;            // 请求: BinOpcode；回复: BinStatus
+    std::string_view payload_;    // 指向输入缓冲区
+};
+
+/**
+ * @brief 从 input 的开头解析一个帧
+ * @param consumed [out] 成功时这个帧占用的字节数
+ */
+BinParseResult ParseBinFrame(std::string_view input, BinFrame* frame, size_t* consumed);
+
+/**
+ * @brief 追加一个帧头
+ */
+void AppendBinFrameHeader(std::string* out, uint32_t request_id, uint8_t code, size_t payload_size);
+
+// --- payload 编解码辅助 ---
+void PutLengthPrefixed(std::string* dst, std::string_view s);
+bool GetLengthPrefixed(std::string_view* input, std::string_view* result);
+
+// --- 请求编码 (客户端使用) ---
+void EncodePingRequest(std::string* out, uint32_t request_id);
+void EncodeGetRequest(std::string* out, uint32_t request_id, std::string_view key);
+void EncodePutRequest(std::string* out, uint32_t request_id, std::string_view key, std::string_view value);
+void EncodeDeleteRequest(std::string* out, uint32_t request_id, std::string_view key);
+void EncodeMultiGetRequest(std::string* out, uint32_t request_id, const std::vector<std::string_view>& keys);
+void EncodeWriteBatchRequest(std::string* out, uint32_t request_id, const WriteBatch& batch);
+void EncodeScanRequest(std::string* out, uint32_t request_id, std::string_view start, uint32_t limit);
+
+// --- 回复解码 (客户端使用) ---
+bool DecodeMultiGetReply(std::string_view payload, std::vector<std::string>* values, std::vector<bool>* found);
+bool DecodeScanReply(std::string_view payload, std::vector<std::pair<std::string, std::string>>* results);
+
+/**
+ * @brief BinCommandHandler (二进制请求执行器)
+ * 职责：在 KVStore 上执行一个请求帧，把回复帧追加到输出队列。
+ * GET 的大值会被移动进输出队列，由 writev 直接发送，不再拷贝一次。
+ */
+class BinCommandHandler {
+public:
+    explicit BinCommandHandler(KVStore* db) : db_(db) {}
+
+    void Execute(const BinFrame& request, OutputBuffer* out);
+
+private:
+    void Reply(OutputBuffer* out, uint32_t request_id, BinStatus status, std::string_view payload);
+
+    KVStore* db_;
+    std::string payload_; // 复用的回复 payload 缓冲区
+};
@@ -0,0 +1,366 @@
+#include "blockcache.h"
+#include <iostream>
+#include <iterator>
+
+// 每个条目除了块内容本身，还有链表节点和哈希表节点的开销 (估算)
+static const size_t kEntryOverhead = 64;
+
+static size_t PoolCapacity(size_t capacity, double ratio) {
+    if (ratio >= 1.0) {
+        return capacity;
+    }
+    return ratio <= 0.0 ? 0 : static_cast<size_t>(static_cast<double>(capacity) * ratio);
+}
+
+/**
+ * @brief 块内容的内存池：按大小分级的池 (复用释放的块) 建立在大页资源之上
+ */
+struct BlockCache::BlockMemory {
+    explicit BlockMemory(HugePageMode mode)
+        : pages_(mode), pool_(PoolOptions(), &pages_) {}
+
+    static std::pmr::pool_options PoolOptions() {
+        std::pmr::pool_options options;
+        options.largest_required_pool_block = HugePageResource::kHugePageSize / 2; // 更大的块单独映射
+        return options;
+    }
+
+    HugePageResource pages_;
+    std::pmr::synchronized_pool_resource pool_;
+};
+
+BlockCache::BlockCache(size_t capacity, SecondaryCache* secondary)
+    : capacity_(capacity),
+      usage_(0),
+      pool_capacity_{PoolCapacity(capacity, BlockCacheOptions().high_pri_pool_ratio_),
+                     PoolCapacity(capacity, BlockCacheOptions().low_pri_pool_ratio_)},
+      pool_usage_{0, 0, 0},
+      pinned_usage_(0),
+      secondary_(secondary),
+      hits_(0),
+      misses_(0),
+      secondary_hits_(0),
+      compressed_hits_(0) {}
+
+static bool UseCompressedTier(const BlockCacheOptions& options) {
+    if (options.compressed_capacity_ == 0) {
+        return false;
+    }
+    if (options.compression_.type_ == CompressionType::NONE || !CompressionSupported(options.compression_.type_)) {
+        std::cerr << "警告: 块缓存的压缩层不可用 (压缩算法不支持)，只使用热层" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+BlockCache::BlockCache(const BlockCacheOptions& options)
+    : capacity_(options.capacity_),
+      usage_(0),
+      pool_capacity_{PoolCapacity(options.capacity_, options.high_pri_pool_ratio_),
+                     PoolCapacity(options.capacity_, options.low_pri_pool_ratio_)},
+      pool_usage_{0, 0, 0},
+      pinned_usage_(0),
+      secondary_(UseCompressedTier(options) ? nullptr : options.secondary_),
+      compression_(options.compression_),
+      hits_(0),
+      misses_(0),
+      secondary_hits_(0),
+      compressed_hits_(0) {
+    if (UseCompressedTier(options)) {
+        BlockCacheOptions tier;
+        tier.capacity_ = options.compressed_capacity_;
+        tier.secondary_ = options.secondary_;
+        tier.huge_pages_ = options.huge_pages_;
+        compressed_ = std::make_unique<BlockCache>(tier);
+    }
+    if (options.huge_pages_ != HugePageMode::NONE) {
+        memory_ = std::make_shared<BlockMemory>(options.huge_pages_);
+    }
+}
+
+/**
+ * @brief 分配一个全局唯一的 file_id
+ */
+uint64_t BlockCache::NewId() {
+    static std::atomic<uint64_t> next_id(1);
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<BlockContents> BlockCache::NewBlock() const {
+    if (memory_ == nullptr) {
+        return std::make_shared<BlockContents>();
+    }
+    std::shared_ptr<BlockMemory> memory = memory_;
+    return std::shared_ptr<BlockContents>(new BlockContents(&memory->pool_),
+                                          [memory](BlockContents* block) { delete block; });
+}
+
+HugePageStats BlockCache::GetHugePageStats() const {
+    HugePageStats stats;
+    if (memory_ != nullptr) {
+        stats = memory_->pages_.GetStats();
+    }
+    if (compressed_ != nullptr) {
+        stats += compressed_->GetHugePageStats();
+    }
+    return stats;
+}
+
+/**
+ * @brief 插入一个块，并在超出容量时淘汰
+ */
+void BlockCache::Insert(uint64_t file_id, uint64_t offset,
+                        std::shared_ptr<const BlockContents> block, Priority priority) {
+    const Key key{file_id, offset};
+    const size_t charge = block->capacity() + kEntryOverhead; // 实际占用的字节数
+
+    std::vector<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool pinned = false;
+        auto it = table_.find(key);
+        if (it != table_.end()) {
+            pinned = it->second->pinned_; // 替换旧值 (固定的块替换后仍然固定)
+            RemoveLocked(it);
+        }
+
+        Entry entry{key, std::move(block), charge, priority, pinned};
+        LRUList& lru = ListFor(entry);
+        lru.push_front(std::move(entry));
+        table_[key] = lru.begin();
+        usage_ += charge;
+        ChargeLocked(lru.front(), true);
+        BalancePoolsLocked();
+        EvictLocked(&evicted);
+    }
+    if (!evicted.empty()) {
+        Demote(evicted);
+    }
+}
+
+/**
+ * @brief 把淘汰的块交给下一层 (压缩和写入二级缓存都在锁外进行，不阻塞其它查找)
+ */
+void BlockCache::Demote(const std::vector<Entry>& evicted) {
+    for (const Entry& entry : evicted) {
+        if (compressed_ != nullptr) {
+            if (compressed_->Contains(entry.key_.file_id_, entry.key_.offset_)) {
+                continue; // 从压缩层提升上来的块，压缩层还保留着
+            }
+            std::shared_ptr<BlockContents> encoded = compressed_->NewBlock();
+            CompressBlock(compression_, *entry.block_, encoded.get());
+            encoded->shrink_to_fit();
+            compressed_->Insert(entry.key_.file_id_, entry.key_.offset_, std::move(encoded), entry.priority_);
+        } else {
+            secondary_->Insert(entry.key_.file_id_, entry.key_.offset_, *entry.block_);
+        }
+    }
+}
+
+/**
+ * @brief 先查热层，再查压缩层
+ */
+bool BlockCache::Contains(uint64_t file_id, uint64_t offset) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (table_.count(Key{file_id, offset}) != 0) {
+            return true;
+        }
+    }
+    return compressed_ != nullptr && compressed_->Contains(file_id, offset);
+}
+
+/**
+ * @brief 查找一个块；命中时把它移到所在链表的头部
+ */
+std::shared_ptr<const BlockContents> BlockCache::Lookup(uint64_t file_id, uint64_t offset, Priority priority) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = table_.find(Key{file_id, offset});
+        if (it != table_.end()) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            Entry& entry = *it->second;
+            LRUList& from = ListFor(entry);
+            if (!entry.pinned_ && priority < entry.priority_) {
+                // 以更高的优先级再次读取 (例如 Compaction 读过的块又被用户读取)：提升到对应的池
+                ChargeLocked(entry, false);
+                entry.priority_ = priority;
+                ChargeLocked(entry, true);
+                LRUList& to = ListFor(entry);
+                to.splice(to.begin(), from, it->second);
+                BalancePoolsLocked();
+            } else {
+                from.splice(from.begin(), from, it->second); // O(1) 移到头部，迭代器保持有效
+            }
+            return entry.block_;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    if (compressed_ != nullptr) {
+        // 热层未命中：从压缩层 (以及它下面的二级缓存) 取回并解压，提升回热层
+        std::shared_ptr<const BlockContents> encoded = compressed_->Lookup(file_id, offset, priority);
+        if (encoded == nullptr) {
+            return nullptr;
+        }
+        std::shared_ptr<BlockContents> block = NewBlock();
+        if (!UncompressBlock(*encoded, block.get())) {
+            compressed_->Erase(file_id, offset);
+            return nullptr;
+        }
+        compressed_hits_.fetch_add(1, std::memory_order_relaxed);
+        Insert(file_id, offset, block, priority);
+        return block;
+    }
+    if (secondary_ == nullptr) {
+        return nullptr;
+    }
+    // 内存未命中：查二级缓存 (在锁外读文件)，命中的块复制到本缓存的内存中，提升回内存
+    std::shared_ptr<const std::string> stored = secondary_->Lookup(file_id, offset);
+    if (stored == nullptr) {
+        return nullptr;
+    }
+    secondary_hits_.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<BlockContents> block = NewBlock();
+    block->assign(stored->data(), stored->size());
+    Insert(file_id, offset, block, priority);
+    return block;
+}
+
+void BlockCache::Erase(uint64_t file_id, uint64_t offset) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = table_.find(Key{file_id, offset});
+        if (it != table_.end()) {
+            RemoveLocked(it);
+        }
+    }
+    if (compressed_ != nullptr) {
+        compressed_->Erase(file_id, offset);
+    } else if (secondary_ != nullptr) {
+        secondary_->Erase(file_id, offset);
+    }
+}
+
+bool BlockCache::Pin(uint64_t file_id, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = table_.find(Key{file_id, offset});
+    if (it == table_.end()) {
+        return false;
+    }
+    Entry& entry = *it->second;
+    if (!entry.pinned_) {
+        LRUList& from = ListFor(entry);
+        ChargeLocked(entry, false);
+        entry.pinned_ = true;
+        ChargeLocked(entry, true);
+        pinned_.splice(pinned_.begin(), from, it->second);
+    }
+    return true;
+}
+
+void BlockCache::Unpin(uint64_t file_id, uint64_t offset) {
+    std::vector<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = table_.find(Key{file_id, offset});
+        if (it == table_.end() || !it->second->pinned_) {
+            return;
+        }
+        Entry& entry = *it->second;
+        ChargeLocked(entry, false);
+        entry.pinned_ = false;
+        entry.priority_ = Priority::HIGH;
+        ChargeLocked(entry, true);
+        lru_[0].splice(lru_[0].begin(), pinned_, it->second);
+        BalancePoolsLocked();
+        EvictLocked(&evicted); // 固定期间可能已经超出容量
+    }
+    if (!evicted.empty()) {
+        Demote(evicted);
+    }
+}
+
+void BlockCache::GetKeys(std::vector<std::pair<uint64_t, uint64_t>>* keys) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys->clear();
+    keys->reserve(table_.size());
+    // 固定的块由打开文件的一方负责加载，最低优先级的块不值得预热
+    for (const LRUList* lru : {&lru_[0], &lru_[1]}) {
+        for (const Entry& entry : *lru) {
+            keys->emplace_back(entry.key_.file_id_, entry.key_.offset_);
+        }
+    }
+}
+
+size_t BlockCache::GetUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usage_;
+}
+
+size_t BlockCache::GetPoolUsage(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pool_usage_[static_cast<int>(priority)];
+}
+
+size_t BlockCache::GetPinnedUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pinned_usage_;
+}
+
+void BlockCache::ChargeLocked(const Entry& entry, bool add) {
+    size_t& usage = entry.pinned_ ? pinned_usage_ : pool_usage_[static_cast<int>(entry.priority_)];
+    if (add) {
+        usage += entry.charge_;
+    } else {
+        usage -= entry.charge_;
+    }
+}
+
+void BlockCache::RemoveLocked(std::unordered_map<Key, LRUList::iterator, KeyHash>::iterator it) {
+    LRUList::iterator entry = it->second;
+    usage_ -= entry->charge_;
+    ChargeLocked(*entry, false);
+    ListFor(*entry).erase(entry);
+    table_.erase(it);
+}
+
+/**
+ * @brief 高优先级池超出上限时，最旧的条目降到低优先级链表的头部；低优先级池同理降到最低优先级
+ */
+void BlockCache::BalancePoolsLocked() {
+    for (int pool = 0; pool < 2; ++pool) {
+        LRUList& from = lru_[pool];
+        LRUList& to = lru_[pool + 1];
+        while (pool_usage_[pool] > pool_capacity_[pool] && !from.empty()) {
+            Entry& entry = from.back();
+            ChargeLocked(entry, false);
+            entry.priority_ = static_cast<Priority>(pool + 1);
+            ChargeLocked(entry, true);
+            to.splice(to.begin(), from, std::prev(from.end()));
+        }
+    }
+}
+
+/**
+ * @brief 按 最低 -> 低 -> 高 优先级的顺序淘汰链表尾部，固定的块不淘汰
+ * (被淘汰的块如果仍被调用方持有，会在调用方释放后才真正释放内存)
+ */
+void BlockCache::EvictLocked(std::vector<Entry>* evicted) {
+    while (usage_ > capacity_) {
+        LRUList* victims_list = nullptr;
+        for (int pool = 2; pool >= 0; --pool) {
+            if (!lru_[pool].empty()) {
+                victims_list = &lru_[pool];
+                break;
+            }
+        }
+        if (victims_list == nullptr) {
+            break; // 只剩固定的块
+        }
+        LRUList& victims = *victims_list;
+        if (compressed_ != nullptr || secondary_ != nullptr) {
+            evicted->push_back(victims.back());
+        }
+        RemoveLocked(table_.find(victims.back().key_));
+    }
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "secondarycache.h"
+#include "compression.h"
+#include "hugepage.h"
+
+// 块的内容 (内存来自块缓存的内存池，见 BlockCache::NewBlock)
+using BlockContents = std::pmr::string;
+
+/**
+ * @brief BlockCacheOptions (块缓存选项)
+ */
+struct BlockCacheOptions {
+    // 热层 (未压缩的块) 的容量 (字节)
+    size_t capacity_ = 8 * 1024 * 1024;
+
+    // 压缩层的容量 (字节)，0 表示不使用压缩层；当前构建不支持 compression_ 时也不使用
+    size_t compressed_capacity_ = 0;
+
+    // 高优先级池最多占热层容量的比例：超出时池中最久未使用的条目降为低优先级。
+    // 池内的条目只有在低、最低优先级的条目全部淘汰后才会被淘汰 (数据块读取不会把它们挤出去)
+    double high_pri_pool_ratio_ = 0.5;
+
+    // 低优先级池最多占热层容量的比例：超出时池中最久未使用的条目降为最低优先级 (1.0 表示不限制)
+    double low_pri_pool_ratio_ = 1.0;
+
+    // 压缩层使用的压缩方式
+    CompressionOptions compression_ = {CompressionType::ZLIB, 1};
+
+    // 二级缓存 (可以为空；不拥有，生命周期必须覆盖这个缓存)
+    SecondaryCache* secondary_ = nullptr;
+
+    // 块内容使用的大页模式 (NONE 表示使用普通的堆内存)
+    // 开启时块内容从一个按大小分级的内存池中分配，内存池以 2MB 大页为单位向系统申请
+    HugePageMode huge_pages_ = HugePageMode::NONE;
+};
+
+/**
+ * @brief BlockCache (块缓存)
+ * 职责：在内存中缓存从 SSTable 读出的块 (Data Block / Filter 分区)，按字节数限制容量。
+ * 缓存条目以 (file_id, offset) 为键，值是只读的块内容。
+ *
+ * 淘汰策略：带优先级池的 LRU。
+ * 每个优先级各有一条 LRU 链表，容量不足时按 最低 -> 低 -> 高 的顺序淘汰链表尾部。
+ * 高 / 低优先级池各有一个占容量比例的上限，超出上限的最旧条目降到下一个优先级，
+ * 这样高优先级条目有保留的空间，又不会独占整个缓存。
+ * 被固定 (Pin) 的条目不参与淘汰 (仍然计入容量)，直到被 Erase。
+ *
+ * 可选的压缩层：热层淘汰的块压缩后放入一个更大的压缩层 (也是一个 BlockCache)，
+ * 热层未命中时从压缩层解压并提升回热层 (压缩层保留一份，再次淘汰时不需要重新压缩)。
+ * 可选的二级缓存 (SecondaryCache)：最下层淘汰的块交给它异步写入本地文件，
+ * 内存未命中时先查二级缓存，命中的块重新插入内存，仍未命中才需要读 SSTable。
+ * 层次: 热层 -> 压缩层 (如果有) -> 二级缓存 (如果有) -> SSTable。
+ * 容量按条目实际占用的字节数 (字符串的容量加上节点开销) 计算。
+ * 可选的大页内存：NewBlock() 分配的块内容放在大页上，减少随机查找时的 TLB 未命中。
+ *
+ * 线程安全：所有公有方法都可以被多个线程并发调用。
+ */
+class BlockCache {
+public:
+    /**
+     * @brief 缓存优先级
+     * HIGH:   元数据块 (如 Filter 分区)，尽量常驻
+     * LOW:    普通数据块
+     * BOTTOM: 只读一次的块 (如 Compaction 读取的输入)，最先淘汰
+     */
+    enum class Priority { HIGH, LOW, BOTTOM };
+
+    /**
+     * @brief 构造函数
+     * @param capacity 缓存容量 (字节)
+     * @param secondary 二级缓存 (可以为空；不拥有，生命周期必须覆盖这个缓存)
+     */
+    explicit BlockCache(size_t capacity, SecondaryCache* secondary = nullptr);
+
+    /**
+     * @brief 构造函数 (可以开启压缩层)
+     */
+    explicit BlockCache(const BlockCacheOptions& options);
+
+    // 禁用拷贝和赋值
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /**
+     * @brief 分配一个全局唯一的 file_id
+     * (每个 SSTableReader 打开时申请一个，避免不同文件的 offset 冲突)
+     */
+    static uint64_t NewId();
+
+    /**
+     * @brief 创建一个空的块，内容从本缓存的内存池分配 (没有开启大页时使用普通的堆内存)
+     * (块持有内存池的引用，缓存销毁后块依然有效)
+     */
+    std::shared_ptr<BlockContents> NewBlock() const;
+
+    /**
+     * @brief 插入一个块 (如果已存在则替换)
+     * @param file_id 文件的缓存 id (来自 NewId())
+     * @param offset 块在文件中的偏移量
+     * @param block 块内容
+     * @param priority 缓存优先级
+     */
+    void Insert(uint64_t file_id, uint64_t offset,
+                std::shared_ptr<const BlockContents> block, Priority priority);
+
+    /**
+     * @brief 查找一个块 (内存未命中时再查二级缓存)
+     * @param priority 从二级缓存命中时重新插入内存使用的优先级
+     * @return 命中时返回块内容 (调用方持有期间不会被释放)；未命中返回 nullptr
+     */
+    std::shared_ptr<const BlockContents> Lookup(uint64_t file_id, uint64_t offset,
+                                                Priority priority = Priority::LOW);
+
+    /**
+     * @brief 块是否在内存中 (热层或压缩层；不查二级缓存)
+     * 与 Lookup 不同，没有任何副作用：不计入命中统计，不调整 LRU 顺序，不提升优先级，不解压
+     * (例如预热时判断块是否还需要读取)
+     */
+    bool Contains(uint64_t file_id, uint64_t offset) const;
+
+    /**
+     * @brief 列出热层中所有块的键 (file_id, offset)，高优先级在前，同一优先级按最近使用在前
+     * (用于持久化缓存内容，重启后预热)
+     */
+    void GetKeys(std::vector<std::pair<uint64_t, uint64_t>>* keys) const;
+
+    /**
+     * @brief 删除一个块 (如果存在；固定的块也会被删除)
+     */
+    void Erase(uint64_t file_id, uint64_t offset);
+
+    /**
+     * @brief 固定一个已经在缓存中的块：不再被淘汰，直到 Erase
+     * (例如 L0 文件的 Filter 分区在文件存活期间一直常驻)
+     * @return false 如果块不在缓存中
+     */
+    bool Pin(uint64_t file_id, uint64_t offset);
+
+    /**
+     * @brief 取消固定：块回到高优先级链表的头部，重新参与淘汰
+     */
+    void Unpin(uint64_t file_id, uint64_t offset);
+
+    // --- 统计信息 ---
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetUsage() const;
+    size_t GetPoolUsage(Priority priority) const; // 某个优先级池的用量 (不含固定的块)
+    size_t GetPinnedUsage() const;
+    uint64_t GetHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return misses_.load(std::memory_order_relaxed); }
+    uint64_t GetSecondaryHits() const {
+        return compressed_ != nullptr ? compressed_->GetSecondaryHits()
+                                      : secondary_hits_.load(std::memory_order_relaxed);
+    }
+    SecondaryCache* GetSecondaryCache() const {
+        return compressed_ != nullptr ? compressed_->GetSecondaryCache() : secondary_;
+    }
+
+    // 压缩层 (未开启时返回 nullptr；它的 GetUsage / GetHits 就是压缩层的统计)
+    const BlockCache* GetCompressedTier() const { return compressed_.get(); }
+    uint64_t GetCompressedHits() const { return compressed_hits_.load(std::memory_order_relaxed); }
+
+    // 块内容 (包括压缩层) 所在内存的大页统计 (没有开启大页时全为 0)
+    HugePageStats GetHugePageStats() const;
+
+private:
+    struct Key {
+        uint64_t file_id_;
+        uint64_t offset_;
+        bool operator==(const Key& other) const {
+            return file_id_ == other.file_id_ && offset_ == other.offset_;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<uint64_t>()(key.file_id_ * 0x9E3779B97F4A7C15ULL ^ key.offset_);
+        }
+    };
+
+    struct Entry {
+        Key key_;
+        std::shared_ptr<const BlockContents> block_;
+        size_t charge_;      // 计入容量的字节数
+        Priority priority_;  // 所在的 LRU 链表
+        bool pinned_;        // 在 pinned_ 链表中，不参与淘汰
+    };
+
+    using LRUList = std::list<Entry>; // 头部 = 最近使用，尾部 = 最久未使用
+
+    LRUList& ListFor(const Entry& entry) {
+        return entry.pinned_ ? pinned_ : lru_[static_cast<int>(entry.priority_)];
+    }
+
+    // (私有) 把热层淘汰的块交给下一层 (压缩层或二级缓存)，在锁外调用
+    void Demote(const std::vector<Entry>& evicted);
+
+    // (私有, 需持有锁) 从链表和哈希表中移除一个条目
+    void RemoveLocked(std::unordered_map<Key, LRUList::iterator, KeyHash>::iterator it);
+
+    // (私有, 需持有锁) 把条目计入 / 移出它所在池 (或固定块) 的用量
+    void ChargeLocked(const Entry& entry, bool add);
+
+    // (私有, 需持有锁) 把超出池上限的最旧条目降到下一个优先级
+    void BalancePoolsLocked();
+
+    // (私有, 需持有锁) 淘汰条目直到用量不超过容量
+    // (有下一层时，被淘汰的条目移到 evicted 中，由调用方在锁外交给下一层)
+    void EvictLocked(std::vector<Entry>* evicted);
+
+    // --- 成员变量 ---
+    const size_t capacity_;
+    size_t usage_;
+    size_t pool_capacity_[2];   // HIGH / LOW 池的上限
+    size_t pool_usage_[3];      // 每个优先级池的用量
+    size_t pinned_usage_;
+    LRUList lru_[3];            // 按 Priority 下标
+    LRUList pinned_;
+    std::unordered_map<Key, LRUList::iterator, KeyHash> table_;
+    mutable std::mutex mutex_;
+    SecondaryCache* const secondary_;        // 直接的下一层 (有压缩层时挂在压缩层下面)
+    const CompressionOptions compression_;
+    std::unique_ptr<BlockCache> compressed_; // 压缩层 (存放 CompressBlock 编码后的块)
+
+    struct BlockMemory;                      // 大页内存池 (定义在 blockcache.cpp)
+    std::shared_ptr<BlockMemory> memory_;    // 没有开启大页时为空
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> secondary_hits_;
+    std::atomic<uint64_t> compressed_hits_;
+};
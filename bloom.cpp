@@ -0,0 +1,92 @@
+#include "bloom.h"
+#include <cstring>
+
+/**
+ * @brief 32 位哈希 (与 LevelDB 的 Hash() 相同的 Murmur 风格算法)
+ */
+uint32_t BloomHash(std::string_view key) {
+    const uint32_t seed = 0xbc9f1d34;
+    const uint32_t m = 0xc6a4a793;
+    const uint32_t r = 24;
+    const char* data = key.data();
+    const char* limit = data + key.size();
+    uint32_t h = seed ^ (static_cast<uint32_t>(key.size()) * m);
+
+    // 每次处理 4 字节
+    while (data + 4 <= limit) {
+        uint32_t w;
+        memcpy(&w, data, sizeof(w));
+        data += 4;
+        h += w;
+        h *= m;
+        h ^= (h >> 16);
+    }
+
+    // 处理剩余的字节
+    switch (limit - data) {
+        case 3:
+            h += static_cast<uint8_t>(data[2]) << 16;
+            [[fallthrough]];
+        case 2:
+            h += static_cast<uint8_t>(data[1]) << 8;
+            [[fallthrough]];
+        case 1:
+            h += static_cast<uint8_t>(data[0]);
+            h *= m;
+            h ^= (h >> r);
+            break;
+    }
+    return h;
+}
+
+/**
+ * @brief 构建过滤器 (双重哈希: 用一个哈希值模拟 k 个哈希函数)
+ */
+void CreateBloomFilter(const std::vector<uint32_t>& hashes, int bits_per_key, std::string* dst) {
+    // k = bits_per_key * ln(2)，此时误判率最低
+    int k = static_cast<int>(bits_per_key * 0.69);
+    if (k < 1) k = 1;
+    if (k > 30) k = 30;
+
+    // Key 太少时误判率会很高，所以至少使用 64 bit
+    size_t bits = hashes.size() * bits_per_key;
+    if (bits < 64) bits = 64;
+    size_t bytes = (bits + 7) / 8;
+    bits = bytes * 8;
+
+    const size_t init_size = dst->size();
+    dst->resize(init_size + bytes, 0);
+    dst->push_back(static_cast<char>(k)); // 记录探测次数
+    char* array = &(*dst)[init_size];
+    for (uint32_t h : hashes) {
+        const uint32_t delta = (h >> 17) | (h << 15); // 循环右移 17 位
+        for (int j = 0; j < k; j++) {
+            const uint32_t bitpos = h % bits;
+            array[bitpos / 8] |= (1 << (bitpos % 8));
+            h += delta;
+        }
+    }
+}
+
+/**
+ * @brief 查询过滤器
+ */
+bool BloomMayMatch(std::string_view key, std::string_view filter) {
+    const size_t len = filter.size();
+    if (len < 2) return false;
+
+    const size_t bits = (len - 1) * 8;
+    const int k = static_cast<uint8_t>(filter[len - 1]);
+    if (k > 30) {
+        return true; // 为未来的新编码保留，按“可能存在”处理
+    }
+
+    uint32_t h = BloomHash(key);
+    const uint32_t delta = (h >> 17) | (h << 15);
+    for (int j = 0; j < k; j++) {
+        const uint32_t bitpos = h % bits;
+        if ((filter[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
+        h += delta;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Bloom Filter (布隆过滤器)
+ * 职责：用很少的内存回答“这个 Key *可能* 在集合中吗？”。
+ * 回答“不在”时一定正确；回答“在”时有很小的误判率 (约 1% @ 10 bits/key)。
+ * 磁盘布局: [bit 数组 (N 字节)] [探测次数 k (1 字节)]
+ */
+
+/**
+ * @brief 计算 Key 的 32 位哈希 (构建和查询必须使用同一个哈希)
+ * (Builder 只缓存哈希值而不是 Key 本身，避免为每个 Key 分配内存)
+ */
+uint32_t BloomHash(std::string_view key);
+
+/**
+ * @brief 根据一组 Key 的哈希值构建过滤器，并追加到 dst
+ * @param hashes 由 BloomHash() 计算出的哈希值
+ * @param bits_per_key 每个 Key 分配的 bit 数 (越大误判率越低)
+ * @param dst [out] 过滤器内容被追加到这里
+ */
+void CreateBloomFilter(const std::vector<uint32_t>& hashes, int bits_per_key, std::string* dst);
+
+/**
+ * @brief 查询 Key 是否 *可能* 在过滤器中
+ * @return false 表示一定不在；true 表示可能在 (过滤器损坏时也返回 true)
+ */
+bool BloomMayMatch(std::string_view key, std::string_view filter);
@@ -0,0 +1,552 @@
+#include "compaction.h"
+#include "merger.h"
+#include "sstablereader.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <cstdio>    // 用于 std::remove
+#include <iostream>
+
+/**
+ * @brief 计算一组文件的 Key 范围 [smallest, largest]
+ */
+static void GetRange(const std::vector<FileMetaData>& files, std::string* smallest, std::string* largest) {
+    smallest->clear();
+    largest->clear();
+    for (size_t i = 0; i < files.size(); i++) {
+        if (i == 0 || files[i].smallest_ < *smallest) *smallest = files[i].smallest_;
+        if (i == 0 || files[i].largest_ > *largest) *largest = files[i].largest_;
+    }
+}
+
+static uint64_t TotalFileSize(const std::vector<FileMetaData>& files) {
+    uint64_t total = 0;
+    for (const FileMetaData& f : files) {
+        total += f.file_size_;
+    }
+    return total;
+}
+
+static bool Overlaps(const FileMetaData& a, const FileMetaData& b) {
+    return !(a.largest_ < b.smallest_ || b.largest_ < a.smallest_);
+}
+
+// --- Compaction ---
+
+bool Compaction::IsTrivialMove() const {
+    if (!inputs_[1].empty() || TotalFileSize(grandparents_) > max_grandparent_overlap_bytes_) {
+        return false;
+    }
+    // L0 的多个输入文件之间可能重叠，直接移动会破坏下一层“互不重叠”的约束
+    for (size_t i = 0; i < inputs_[0].size(); i++) {
+        for (size_t j = i + 1; j < inputs_[0].size(); j++) {
+            if (Overlaps(inputs_[0][i], inputs_[0][j])) return false;
+        }
+    }
+    return true;
+}
+
+OutputOptions CompactionOptions::OutputOptionsForLevel(int level) const {
+    OutputOptions result = output_;
+    if (level >= 0 && static_cast<size_t>(level) < compression_per_level_.size()) {
+        result.builder_options_.compression_ = compression_per_level_[level];
+    }
+    return result;
+}
+
+// --- CompactionPicker ---
+
+CompactionPicker::CompactionPicker(const CompactionOptions& options)
+    : options_(options) {}
+
+uint64_t CompactionPicker::MaxBytesForLevel(int level) const {
+    uint64_t result = options_.max_bytes_for_level_base_;
+    for (int l = 1; l < level; l++) {
+        result *= options_.level_size_multiplier_;
+    }
+    return result;
+}
+
+std::unique_ptr<Compaction> CompactionPicker::PickCompaction(const Version& version) {
+    if (options_.time_series_.enabled_) {
+        return PickTimeSeriesCompaction(version);
+    }
+    if (options_.fifo_.enabled_) {
+        return PickFifoCompaction(version);
+    }
+
+    // 1. 找出分数最高的层 (最后一层没有下一层，不参与)
+    int best_level = -1;
+    double best_score = 1.0;
+    for (int level = 0; level < NUM_LEVELS - 1; level++) {
+        double score = level == 0
+            ? static_cast<double>(version.files_[0].size()) / options_.l0_compaction_trigger_
+            : static_cast<double>(version.LevelBytes(level)) / MaxBytesForLevel(level);
+        if (score >= best_score) {
+            best_score = score;
+            best_level = level;
+        }
+    }
+    if (best_level < 0) {
+        // 每一层都没有超限，再看有没有超期的文件
+        return options_.periodic_compaction_seconds_ > 0 ? PickPeriodicCompaction(version) : nullptr;
+    }
+
+    // 2. 选出第一个输入文件：compact_pointer_ 之后的第一个文件 (没有则回到开头)
+    //    (L0 按文件编号排列，compact_pointer_ 不起作用，总是从最旧的文件开始)
+    const std::vector<FileMetaData>& files = version.files_[best_level];
+    const FileMetaData* first = &files[0];
+    if (best_level > 0) {
+        for (const FileMetaData& f : files) {
+            if (f.largest_ > compact_pointer_[best_level]) {
+                first = &f;
+                break;
+            }
+        }
+    }
+    return SetupLevelCompaction(version, best_level, *first);
+}
+
+std::unique_ptr<Compaction> CompactionPicker::SetupLevelCompaction(const Version& version, int level,
+                                                                   const FileMetaData& first) {
+    std::unique_ptr<Compaction> c(new Compaction);
+    c->level_ = level;
+    c->max_grandparent_overlap_bytes_ = options_.output_.max_grandparent_overlap_bytes_;
+    c->inputs_[0].push_back(first);
+
+    // 3. L0 的文件互相重叠：把所有与输入范围重叠的 L0 文件都加进来，直到范围不再扩大。
+    //    否则一个较旧的重叠文件会留在 L0，挡住被推到 L1 的新值。
+    if (level == 0) {
+        size_t count = 0;
+        while (count != c->inputs_[0].size()) {
+            count = c->inputs_[0].size();
+            std::string smallest, largest;
+            GetRange(c->inputs_[0], &smallest, &largest);
+            c->inputs_[0].clear();
+            version.GetOverlappingInputs(0, smallest, largest, &c->inputs_[0]);
+        }
+    }
+
+    SetupOtherInputs(version, c.get());
+
+    std::string smallest, largest;
+    GetRange(c->inputs_[0], &smallest, &largest);
+    compact_pointer_[level] = largest;
+    return c;
+}
+
+std::unique_ptr<Compaction> CompactionPicker::PickPeriodicCompaction(const Version& version) {
+    const uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    int oldest_level = -1;
+    const FileMetaData* oldest = nullptr;
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const FileMetaData& f : version.files_[level]) {
+            // 创建时间未知的文件 (0) 不参与
+            if (f.creation_time_ != 0 && f.creation_time_ + options_.periodic_compaction_seconds_ <= now &&
+                (oldest == nullptr || f.creation_time_ < oldest->creation_time_)) {
+                oldest = &f;
+                oldest_level = level;
+            }
+        }
+    }
+    if (oldest == nullptr) {
+        return nullptr;
+    }
+
+    // 下面还有数据时归并到下一层 (可能只是平凡移动，文件会一路下沉到最底层再被重写)
+    bool lowest = true;
+    for (int level = oldest_level + 1; level < NUM_LEVELS; level++) {
+        lowest = lowest && version.files_[level].empty();
+    }
+    if (!lowest || oldest_level == 0) {
+        return SetupLevelCompaction(version, oldest_level, *oldest);
+    }
+
+    // 最底层的文件原地重写：之下没有旧版本，删除标记可以丢弃
+    std::unique_ptr<Compaction> c(new Compaction);
+    c->type_ = Compaction::Type::REWRITE;
+    c->level_ = oldest_level;
+    c->inputs_[0].push_back(*oldest);
+    c->drop_deletions_ = true;
+    c->bottommost_ = true;
+    return c;
+}
+
+std::unique_ptr<Compaction> CompactionPicker::PickTimeSeriesCompaction(const Version& version) {
+    const TimeSeriesOptions& ts = options_.time_series_;
+    const std::vector<FileMetaData>& l0 = version.files_[0];
+
+    // 1. 过期：整个文件的最大时间戳都早于 now - ttl_，直接删除
+    if (ts.ttl_ > 0) {
+        uint64_t now = ts.clock_ ? ts.clock_()
+            : static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::system_clock::now().time_since_epoch()).count());
+        std::unique_ptr<Compaction> c(new Compaction);
+        c->type_ = Compaction::Type::DELETE_FILES;
+        for (const FileMetaData& f : l0) {
+            if (f.has_time_range_ && now > ts.ttl_ && f.max_timestamp_ < now - ts.ttl_) {
+                c->inputs_[0].push_back(f);
+            }
+        }
+        if (!c->inputs_[0].empty()) {
+            return c;
+        }
+    }
+
+    // 2. 按窗口分组，合并文件数最多且达到阈值的窗口
+    if (ts.window_compaction_trigger_ <= 0) {
+        return nullptr;
+    }
+    std::map<uint64_t, std::vector<FileMetaData>> windows;
+    bool all_windowed = true; // 是否每个文件都只属于一个窗口
+    for (const FileMetaData& f : l0) {
+        if (f.has_time_range_ && f.min_timestamp_ / ts.window_size_ == f.max_timestamp_ / ts.window_size_) {
+            windows[f.min_timestamp_ / ts.window_size_].push_back(f);
+        } else {
+            all_windowed = false;
+        }
+    }
+    const std::vector<FileMetaData>* best = nullptr;
+    for (const auto& window : windows) {
+        if (window.second.size() >= std::max<size_t>(ts.window_compaction_trigger_, 2) &&
+            (best == nullptr || window.second.size() > best->size())) {
+            best = &window.second;
+        }
+    }
+    if (best == nullptr) {
+        return nullptr;
+    }
+    std::unique_ptr<Compaction> c(new Compaction);
+    c->type_ = Compaction::Type::MERGE_L0;
+    c->inputs_[0] = *best;
+    // 窗口的 Key 只会出现在这个窗口的文件里；但开启时间序列模式之前写入的文件
+    // (没有时间范围，或者在 L1 及以上) 可能还有旧版本，这时必须保留删除标记
+    c->drop_deletions_ = all_windowed;
+    for (int level = 1; level < NUM_LEVELS; level++) {
+        c->drop_deletions_ = c->drop_deletions_ && version.files_[level].empty();
+    }
+    return c;
+}
+
+std::unique_ptr<Compaction> CompactionPicker::PickFifoCompaction(const Version& version) {
+    const FifoOptions& fifo = options_.fifo_;
+    const std::vector<FileMetaData>& l0 = version.files_[0]; // 按编号升序 (从旧到新)
+
+    // 1. 超出容量：从最旧的文件开始删除，直到总大小回到上限以内
+    uint64_t total = TotalFileSize(l0);
+    if (total > fifo.max_table_files_size_) {
+        std::unique_ptr<Compaction> c(new Compaction);
+        c->type_ = Compaction::Type::DELETE_FILES;
+        for (const FileMetaData& f : l0) {
+            if (total <= fifo.max_table_files_size_) {
+                break;
+            }
+            c->inputs_[0].push_back(f);
+            total -= f.file_size_;
+        }
+        return c;
+    }
+
+    // 2. 合并小文件：只取最新的连续小文件。输出编号比所有现存文件都大，
+    //    如果中间夹着没被合并的较新文件，合并后的旧值会盖住它的新值
+    if (!fifo.allow_merge_) {
+        return nullptr;
+    }
+    size_t count = 0;
+    while (count < l0.size() && l0[l0.size() - 1 - count].file_size_ < fifo.merge_max_file_size_) {
+        count++;
+    }
+    if (count < std::max<size_t>(fifo.merge_trigger_, 2)) {
+        return nullptr;
+    }
+    std::unique_ptr<Compaction> c(new Compaction);
+    c->type_ = Compaction::Type::MERGE_L0;
+    c->inputs_[0].assign(l0.end() - count, l0.end());
+    c->drop_deletions_ = count == l0.size();
+    for (int level = 1; level < NUM_LEVELS; level++) {
+        c->drop_deletions_ = c->drop_deletions_ && version.files_[level].empty();
+    }
+    return c;
+}
+
+/**
+ * @brief 计算下一层的输入 (与 inputs_[0] 的范围重叠的文件) 和祖父层
+ */
+void CompactionPicker::SetupOtherInputs(const Version& version, Compaction* c) const {
+    std::string smallest, largest;
+    GetRange(c->inputs_[0], &smallest, &largest);
+    version.GetOverlappingInputs(c->level_ + 1, smallest, largest, &c->inputs_[1]);
+
+    // 输出层之下没有数据时，这是一次最底层的 Compaction
+    c->bottommost_ = true;
+    for (int level = c->level_ + 2; level < NUM_LEVELS; level++) {
+        c->bottommost_ = c->bottommost_ && version.files_[level].empty();
+    }
+    c->drop_deletions_ = c->bottommost_;
+
+    if (c->level_ + 2 < NUM_LEVELS) {
+        std::vector<FileMetaData> all = c->inputs_[0];
+        all.insert(all.end(), c->inputs_[1].begin(), c->inputs_[1].end());
+        GetRange(all, &smallest, &largest);
+        version.GetOverlappingInputs(c->level_ + 2, smallest, largest, &c->grandparents_);
+    }
+}
+
+// --- RunCompaction ---
+
+/**
+ * @brief (辅助) 打开一个输入文件的迭代器
+ */
+static std::unique_ptr<Iterator> OpenInput(VersionSet* versions, const FileMetaData& f,
+                                           const TableOpener& open_table,
+                                           std::vector<std::shared_ptr<SSTableReader>>* readers) {
+    if (open_table) {
+        readers->push_back(open_table(f.number_));
+    } else {
+        readers->push_back(std::make_shared<SSTableReader>(TableFileName(versions->dbname(), f.number_)));
+    }
+    if (readers->back() == nullptr || !readers->back()->is_valid()) {
+        return nullptr;
+    }
+    // 输入只读一次：以最低优先级进入块缓存 (没有缓存时优先级不起作用)
+    std::unique_ptr<Iterator> it = readers->back()->NewIterator(BlockCache::Priority::BOTTOM);
+    it->SeekToFirst();
+    return it;
+}
+
+/**
+ * @brief (辅助) 把一个 K/V 写入输出：按 Compaction 的设置丢弃删除标记、把序列号清零
+ */
+static bool EmitEntry(const Compaction& c, std::string_view key, std::string_view value,
+                      std::string* scratch, TableOutputManager* output) {
+    if (c.drop_deletions_ || c.bottommost_) {
+        uint64_t sequence = 0;
+        ValueType type = TYPE_VALUE;
+        std::string_view user_value;
+        if (DecodeInternalValue(value, &sequence, &type, &user_value)) {
+            if (c.drop_deletions_ && type == TYPE_DELETION) {
+                return true;
+            }
+            if (c.bottommost_ && sequence != 0) {
+                scratch->clear();
+                EncodeInternalValue(scratch, 0, type, user_value);
+                return output->Add(key, *scratch);
+            }
+        }
+    }
+    return output->Add(key, value);
+}
+
+/**
+ * @brief (辅助) 删除过期 / 超出容量的文件：只修改 MANIFEST，然后 unlink
+ */
+static bool DeleteExpiredFiles(VersionSet* versions, const Compaction& c, CompactionStats* stats) {
+    VersionEdit edit;
+    for (const FileMetaData& f : c.inputs_[0]) {
+        edit.DeleteFile(c.level_, f.number_);
+    }
+    if (!versions->LogAndApply(&edit)) {
+        return false;
+    }
+    for (const FileMetaData& f : c.inputs_[0]) {
+        std::remove(TableFileName(versions->dbname(), f.number_).c_str());
+        KV_DEBUG_LOG("  [Compaction] 删除文件 #" << f.number_ << " (" << f.file_size_ << " 字节)");
+    }
+    stats->files_expired_ += c.inputs_[0].size();
+    return true;
+}
+
+/**
+ * @brief (辅助) 把 level_ 的若干文件合并后写回 level_ (MERGE_L0 / REWRITE)
+ * MERGE_L0 的输入是一个时间窗口的全部文件 (与其他文件的 Key 不相交)，或者最新的连续若干个文件；
+ * Flush 和 Compaction 由同一个后台线程串行执行，所以输出文件的编号比所有输入都大、
+ * 比之后刷盘的文件都小，L0 “编号越大越新”的顺序不变。
+ * REWRITE 的输入是一个 L1 及以上的文件，输出的 Key 范围不会超出它，同层依然互不重叠。
+ */
+static bool RunInPlaceCompaction(VersionSet* versions, const Compaction& c,
+                                const CompactionOptions& options, CompactionStats* stats,
+                                const TableOpener& open_table) {
+    std::vector<FileMetaData> inputs = c.inputs_[0];
+    std::sort(inputs.begin(), inputs.end(),
+              [](const FileMetaData& a, const FileMetaData& b) { return a.number_ > b.number_; });
+    std::vector<std::shared_ptr<SSTableReader>> readers;
+    std::vector<std::unique_ptr<Iterator>> children;
+    for (const FileMetaData& f : inputs) {
+        std::unique_ptr<Iterator> it = OpenInput(versions, f, open_table, &readers);
+        if (it == nullptr) return false;
+        children.push_back(std::move(it));
+        stats->bytes_read_ += f.file_size_;
+    }
+    std::unique_ptr<Iterator> merged = NewMergingIterator(std::move(children));
+    merged->SeekToFirst();
+
+    // 只输出一个文件，否则文件数可能一直不低于合并阈值
+    OutputOptions output_options = options.OutputOptionsForLevel(c.level_);
+    output_options.target_file_size_ = UINT64_MAX;
+    output_options.max_grandparent_overlap_bytes_ = UINT64_MAX;
+    TableOutputManager output(versions->dbname(), output_options,
+                              [versions]() { return versions->NewFileNumber(); });
+    bool ok = true;
+    std::string scratch;
+    for (; ok && merged->Valid(); merged->Next()) {
+        ok = EmitEntry(c, merged->key(), merged->value(), &scratch, &output);
+    }
+    ok = ok && merged->ok() && output.Finish();
+
+    VersionEdit edit;
+    for (const FileMetaData& f : c.inputs_[0]) {
+        edit.DeleteFile(c.level_, f.number_);
+    }
+    for (const FileMetaData& f : output.GetOutputs()) {
+        edit.AddFile(c.level_, f);
+    }
+    ok = ok && versions->LogAndApply(&edit);
+
+    readers.clear();
+    for (const FileMetaData& f : ok ? c.inputs_[0] : output.GetOutputs()) {
+        std::remove(TableFileName(versions->dbname(), f.number_).c_str());
+    }
+    if (!ok) {
+        std::cerr << "错误: L" << c.level_ << " 原地 Compaction 失败" << std::endl;
+        return false;
+    }
+    stats->compactions_++;
+    stats->bytes_written_ += TotalFileSize(output.GetOutputs());
+    KV_DEBUG_LOG("  [Compaction] 原地合并 L" << c.level_ << ": " << c.inputs_[0].size() << " 个文件 -> "
+                 << output.GetOutputs().size() << " 个文件");
+    return true;
+}
+
+bool RunCompaction(VersionSet* versions, const Compaction& c,
+                   const CompactionOptions& options, CompactionStats* stats,
+                   const TableOpener& open_table) {
+    CompactionStats local_stats;
+    if (stats == nullptr) stats = &local_stats;
+    if (c.type_ == Compaction::Type::DELETE_FILES) {
+        return DeleteExpiredFiles(versions, c, stats);
+    }
+    if (c.type_ == Compaction::Type::MERGE_L0 || c.type_ == Compaction::Type::REWRITE) {
+        return RunInPlaceCompaction(versions, c, options, stats, open_table);
+    }
+    const int output_level = c.level_ + 1;
+
+    // 1. 平凡移动：只改 MANIFEST，不读写任何数据
+    if (c.IsTrivialMove()) {
+        VersionEdit edit;
+        for (const FileMetaData& f : c.inputs_[0]) {
+            edit.DeleteFile(c.level_, f.number_);
+            edit.AddFile(output_level, f);
+            KV_DEBUG_LOG("  [Compaction] 平凡移动 #" << f.number_ << " L" << c.level_
+                         << " -> L" << output_level);
+        }
+        if (!versions->LogAndApply(&edit)) {
+            return false;
+        }
+        stats->files_moved_ += c.inputs_[0].size();
+        return true;
+    }
+
+    // 2. 把 level_ 的输入归并成一个流 (“从新到旧”排列：L0 中编号越大越新)
+    std::vector<FileMetaData> upper_files = c.inputs_[0];
+    std::sort(upper_files.begin(), upper_files.end(),
+              [](const FileMetaData& a, const FileMetaData& b) { return a.number_ > b.number_; });
+    std::vector<std::shared_ptr<SSTableReader>> readers;
+    std::vector<std::unique_ptr<Iterator>> children;
+    for (const FileMetaData& f : upper_files) {
+        std::unique_ptr<Iterator> it = OpenInput(versions, f, open_table, &readers);
+        if (it == nullptr) return false;
+        children.push_back(std::move(it));
+        stats->bytes_read_ += f.file_size_;
+    }
+    std::unique_ptr<Iterator> upper = NewMergingIterator(std::move(children));
+    upper->SeekToFirst();
+
+    TableOutputManager output(versions->dbname(), options.OutputOptionsForLevel(output_level),
+                              [versions]() { return versions->NewFileNumber(); },
+                              c.grandparents_);
+    bool ok = true;
+    std::string scratch;
+
+    // 3. 逐个处理 level_+1 的文件 (它们互不重叠且按 Key 升序排列)
+    std::vector<FileMetaData> lower_rewritten; // level_+1 中被读取并重写的文件
+    size_t skipped = 0;
+    for (const FileMetaData& f : c.inputs_[1]) {
+        // 3.1 先输出 level_ 中位于 f 之前的 Key
+        while (ok && upper->Valid() && upper->key() < f.smallest_) {
+            ok = EmitEntry(c, upper->key(), upper->value(), &scratch, &output);
+            upper->Next();
+        }
+        if (!ok) break;
+
+        // 3.2 文件级跳过：没有任何 level_ 的 Key 落在 f 的范围内
+        if (!upper->Valid() || upper->key() > f.largest_) {
+            output.AddBoundary(f.smallest_);
+            skipped++;
+            continue;
+        }
+
+        // 3.3 f 与 level_ 的 Key 交错：两路归并，Key 相同时 level_ 的新值优先
+        std::unique_ptr<Iterator> lower = OpenInput(versions, f, open_table, &readers);
+        if (lower == nullptr) {
+            ok = false;
+            break;
+        }
+        lower_rewritten.push_back(f);
+        stats->bytes_read_ += f.file_size_;
+        while (ok && lower->Valid()) {
+            if (upper->Valid() && upper->key() <= lower->key()) {
+                bool shadowed = upper->key() == lower->key();
+                ok = EmitEntry(c, upper->key(), upper->value(), &scratch, &output);
+                upper->Next();
+                if (shadowed) lower->Next(); // 旧值被覆盖
+            } else {
+                ok = EmitEntry(c, lower->key(), lower->value(), &scratch, &output);
+                lower->Next();
+            }
+        }
+        ok = ok && lower->ok();
+    }
+
+    // 3.4 输出 level_ 中剩余的 Key
+    while (ok && upper->Valid()) {
+        ok = EmitEntry(c, upper->key(), upper->value(), &scratch, &output);
+        upper->Next();
+    }
+    ok = ok && upper->ok() && output.Finish();
+
+    // 4. 记录到 MANIFEST：删除被重写的输入，新增输出 (跳过的文件原样保留)
+    VersionEdit edit;
+    for (const FileMetaData& f : c.inputs_[0]) {
+        edit.DeleteFile(c.level_, f.number_);
+    }
+    for (const FileMetaData& f : lower_rewritten) {
+        edit.DeleteFile(output_level, f.number_);
+    }
+    for (const FileMetaData& f : output.GetOutputs()) {
+        edit.AddFile(output_level, f);
+    }
+    ok = ok && versions->LogAndApply(&edit);
+
+    // 5. 清理：成功时删除旧文件，失败时删除已经写好的输出
+    readers.clear();
+    std::vector<FileMetaData> garbage = ok ? c.inputs_[0] : output.GetOutputs();
+    if (ok) {
+        garbage.insert(garbage.end(), lower_rewritten.begin(), lower_rewritten.end());
+    }
+    for (const FileMetaData& f : garbage) {
+        std::remove(TableFileName(versions->dbname(), f.number_).c_str());
+    }
+    if (!ok) {
+        std::cerr << "错误: Compaction L" << c.level_ << " 失败" << std::endl;
+        return false;
+    }
+
+    stats->compactions_++;
+    stats->files_skipped_ += skipped;
+    stats->bytes_written_ += TotalFileSize(output.GetOutputs());
+    KV_DEBUG_LOG("  [Compaction] L" << c.level_ << " -> L" << output_level << ": 重写 "
+                 << c.inputs_[0].size() + c.inputs_[1].size() - skipped << " 个文件, 输出 "
+                 << output.GetOutputs().size() << " 个文件, " << skipped << " 个文件原地保留");
+    return true;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "dbformat.h"
+#include "tableoutput.h"
+#include "version.h"
+
+class SSTableReader;
+
+/**
+ * @brief TimeSeriesOptions (时间序列模式选项)
+ * 适合按 (series, timestamp) 写入、几乎只追加的数据：
+ * 刷盘按时间窗口切分文件，所有文件留在 L0；同一窗口的文件攒够后合并成一个；
+ * 整个文件都过期后直接删除 (不需要重写数据)。
+ */
+struct TimeSeriesOptions {
+    bool enabled_ = false;
+
+    // 从 Key 中取时间戳 (默认: Key 的最后 8 字节，大端)
+    TimestampExtractor timestamp_extractor_ = ExtractTimestampSuffix;
+
+    // 时间窗口的长度 (与时间戳同单位)
+    uint64_t window_size_ = 3600 * 1000;
+
+    // 同一窗口的文件数达到这个值时合并成一个 (0 表示不合并)
+    int window_compaction_trigger_ = 4;
+
+    // 保留时长：最大时间戳早于 now - ttl_ 的文件被整个删除 (0 表示永久保留)
+    uint64_t ttl_ = 0;
+
+    // 当前时间 (与时间戳同单位)；为空时使用毫秒级 Unix 时间
+    std::function<uint64_t()> clock_;
+};
+
+/**
+ * @brief FifoOptions (FIFO 模式选项)
+ * 适合可以随时丢弃旧数据的缓存类数据集：文件从不归并到下一层，全部留在 L0；
+ * L0 总大小超过 max_table_files_size_ 后从最旧的文件开始整个删除。
+ * 不开启 allow_merge_ 时每个字节只写一次 (写放大为 1)。
+ */
+struct FifoOptions {
+    bool enabled_ = false;
+
+    // L0 文件总大小的上限 (字节)
+    uint64_t max_table_files_size_ = 1024 * 1024 * 1024;
+
+    // 合并小文件以控制文件数 (会多写一次这些文件)：
+    // 最新的连续 merge_trigger_ 个小于 merge_max_file_size_ 的文件合并成一个
+    bool allow_merge_ = false;
+    int merge_trigger_ = 8;
+    uint64_t merge_max_file_size_ = 64 * 1024;
+};
+
+/**
+ * @brief CompactionOptions (Compaction 选项)
+ */
+struct CompactionOptions {
+    // L0 文件数达到这个值时触发 L0 -> L1 的 Compaction
+    int l0_compaction_trigger_ = 4;
+
+    // L1 的容量上限 (字节)；之后每层是上一层的 level_size_multiplier_ 倍
+    uint64_t max_bytes_for_level_base_ = 10 * 64 * 1024;
+    int level_size_multiplier_ = 10;
+
+    // 输出文件的切分选项
+    OutputOptions output_;
+
+    // 每层输出文件的压缩 (下标为层号，例如上层不压缩、最底层用高压缩级别)；
+    // 为空或层号超出长度时使用 output_.builder_options_.compression_
+    std::vector<CompressionOptions> compression_per_level_;
+
+    // 周期性 Compaction：创建超过这么多秒的文件会被重写 (0 表示关闭)
+    // 非最底层的文件归并到下一层，最底层的文件原地重写，让删除标记最终被清除
+    uint64_t periodic_compaction_seconds_ = 0;
+
+    /**
+     * @brief 输出到 level 的文件使用的输出选项 (按层选择压缩)
+     */
+    OutputOptions OutputOptionsForLevel(int level) const;
+
+    // 时间序列模式 (开启后取代按层的 Compaction)
+    TimeSeriesOptions time_series_;
+
+    // FIFO 模式 (开启后取代按层的 Compaction；与时间序列模式同时开启时以时间序列模式为准)
+    FifoOptions fifo_;
+};
+
+/**
+ * @brief Compaction (一次 Compaction 的描述)
+ * 把 level_ 的 inputs_[0] 与 level_+1 中和它们重叠的 inputs_[1] 归并，输出到 level_+1。
+ */
+struct Compaction {
+    enum class Type {
+        LEVEL,        // 把 level_ 归并到 level_+1
+        MERGE_L0,     // 把若干 L0 文件 (同一时间窗口 / FIFO 的小文件) 合并成一个新的 L0 文件
+        DELETE_FILES, // 直接删除 inputs_[0] (过期或超出 FIFO 容量的文件)
+        REWRITE,      // 在 level_ 原地重写 inputs_[0] (周期性 Compaction 的最底层文件)
+    };
+
+    Type type_ = Type::LEVEL;
+    int level_ = 0;
+
+    // 输入包含了这些 Key 的所有版本，可以丢弃删除标记
+    bool drop_deletions_ = false;
+
+    // 输出层之下没有任何数据：除了丢弃删除标记，还把序列号清零
+    // (读路径不使用表中的序列号，清零后每个值的 8 字节标记都相同，更容易压缩)
+    bool bottommost_ = false;
+
+    // [0]: level_ 的输入文件；[1]: level_+1 中与 inputs_[0] 的 Key 范围重叠的文件
+    // (归并时，inputs_[1] 中没有任何 level_ 的 Key 落入其范围的文件会被原地保留，见 RunCompaction)
+    std::vector<FileMetaData> inputs_[2];
+
+    // level_+2 中与本次 Compaction 重叠的文件 (用于切分输出)
+    std::vector<FileMetaData> grandparents_;
+
+    // 平凡移动允许的最大祖父层重叠 (来自 OutputOptions)
+    uint64_t max_grandparent_overlap_bytes_ = 0;
+
+    /**
+     * @brief 是否可以“平凡移动”：
+     * level_+1 中没有需要重写的文件，输入文件之间互不重叠，且与祖父层的重叠不大。
+     * 此时只需要在 MANIFEST 中把文件改到下一层，不需要读写任何数据。
+     */
+    bool IsTrivialMove() const;
+};
+
+/**
+ * @brief 按文件编号打开 (或从表缓存中取出) 一个输入文件；失败时返回 nullptr
+ */
+using TableOpener = std::function<std::shared_ptr<SSTableReader>(uint64_t number)>;
+
+/**
+ * @brief CompactionStats (Compaction 统计)
+ */
+struct CompactionStats {
+    uint64_t compactions_ = 0;     // 执行了归并的 Compaction 次数
+    uint64_t files_moved_ = 0;     // 平凡移动的文件数
+    uint64_t files_skipped_ = 0;   // 归并时原地保留的下一层文件数
+    uint64_t bytes_read_ = 0;      // 归并读取的字节数
+    uint64_t bytes_written_ = 0;   // 归并写出的字节数
+    uint64_t files_expired_ = 0;   // 因过期或超出容量被直接删除的文件数 (时间序列 / FIFO 模式)
+};
+
+/**
+ * @brief CompactionPicker (Compaction 选择器)
+ * 按“分数”选择最需要 Compaction 的层：
+ * L0 的分数 = 文件数 / l0_compaction_trigger_；其他层 = 总字节数 / 该层容量。
+ * 分数 >= 1 的层中选分数最高的一层。
+ */
+class CompactionPicker {
+public:
+    explicit CompactionPicker(const CompactionOptions& options);
+
+    /**
+     * @brief 为当前 Version 选择一次 Compaction
+     * @return 不需要 Compaction 时返回 nullptr
+     */
+    std::unique_ptr<Compaction> PickCompaction(const Version& version);
+
+    /**
+     * @brief 某一层的容量上限 (L1 及以上)
+     */
+    uint64_t MaxBytesForLevel(int level) const;
+
+private:
+    /**
+     * @brief (私有) 根据 inputs_[0] 计算 inputs_[1] / grandparents_
+     */
+    void SetupOtherInputs(const Version& version, Compaction* c) const;
+
+    /**
+     * @brief (私有) 从 level 的 first 文件开始构造一次按层 Compaction
+     */
+    std::unique_ptr<Compaction> SetupLevelCompaction(const Version& version, int level,
+                                                     const FileMetaData& first);
+
+    /**
+     * @brief (私有) 周期性 Compaction：选出创建时间最早且已经超期的文件
+     */
+    std::unique_ptr<Compaction> PickPeriodicCompaction(const Version& version);
+
+    /**
+     * @brief (私有) 时间序列模式：先删除过期文件，再合并文件最多的时间窗口
+     */
+    std::unique_ptr<Compaction> PickTimeSeriesCompaction(const Version& version);
+
+    /**
+     * @brief (私有) FIFO 模式：先删除超出容量的最旧文件，再 (可选) 合并最新的小文件
+     */
+    std::unique_ptr<Compaction> PickFifoCompaction(const Version& version);
+
+    CompactionOptions options_;
+    // 每层上次 Compaction 结束的 Key，下次从它之后继续 (轮流压缩整层)
+    std::string compact_pointer_[NUM_LEVELS];
+};
+
+/**
+ * @brief 执行一次 Compaction，并把结果记录到 MANIFEST
+ * 平凡移动只修改 MANIFEST；否则归并输入文件，写出新文件，并删除被替换的旧文件。
+ * DELETE_FILES 只修改 MANIFEST 并删除文件；MERGE_L0 / REWRITE 把输入合并后写回 level_。
+ * 输出文件按输出层选择压缩；bottommost_ 时丢弃删除标记并把序列号清零。
+ *
+ * 文件级跳过：依次处理 inputs_[1] 中的每个文件，如果 level_ 的下一个 Key 已经超过
+ * 这个文件的范围 (即没有任何 level_ 的 Key 落在它里面)，它就不需要被读取和重写，
+ * 原地留在 level_+1；输出文件会在它的 smallest_ 处切分，保证 level_+1 依然互不重叠。
+ * @param versions 版本集合 (分配文件编号、LogAndApply)
+ * @param c 要执行的 Compaction
+ * @param options Compaction 选项
+ * @param stats [out] 累加统计信息 (可以为 nullptr)
+ * @param open_table 打开输入文件的方式 (可以为空)：设置时通过它打开 (共享 DB 的表缓存和块缓存，
+ *                   数据块以最低优先级读入，不会挤掉用户读取的热块)；为空时直接打开文件，不使用缓存
+ * @return true 成功
+ */
+bool RunCompaction(VersionSet* versions, const Compaction& c,
+                   const CompactionOptions& options, CompactionStats* stats,
+                   const TableOpener& open_table = TableOpener());
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+/**
+ * @brief Key 的排序方式 (记录在表属性 "kv.comparator" 中)
+ */
+enum class ComparatorType : uint8_t {
+    BYTEWISE = 0,         // 按字节升序 (默认，DB 的 Version / Compaction 使用这种顺序)
+    REVERSE_BYTEWISE = 1, // 按字节降序
+    UINT64_BE = 2,        // 8 字节大端整数 (顺序与字节序相同，但一次整数比较完成)
+};
+
+/**
+ * @brief 比较器
+ * 每种比较器是一个无状态的类型，Compare 是内联的静态函数。
+ * MemTable、数据块查找、索引和归并迭代器以比较器为模板参数，
+ * 运行时只在入口处按 ComparatorType 分派一次 (DispatchComparator)，
+ * 每次比较都没有间接调用。
+ * Compare 返回值: < 0 (a 在前)、0 (相等)、> 0 (b 在前)。
+ */
+struct BytewiseComparator {
+    static constexpr ComparatorType kType = ComparatorType::BYTEWISE;
+    static int Compare(std::string_view a, std::string_view b) { return a.compare(b); }
+};
+
+struct ReverseBytewiseComparator {
+    static constexpr ComparatorType kType = ComparatorType::REVERSE_BYTEWISE;
+    static int Compare(std::string_view a, std::string_view b) { return b.compare(a); }
+};
+
+struct Uint64BEComparator {
+    static constexpr ComparatorType kType = ComparatorType::UINT64_BE;
+    static int Compare(std::string_view a, std::string_view b) {
+        if (a.size() != sizeof(uint64_t) || b.size() != sizeof(uint64_t)) {
+            return a.compare(b); // 长度不是 8 的 Key 退回字节序 (与整数顺序一致)
+        }
+        uint64_t x = Load(a.data());
+        uint64_t y = Load(b.data());
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+
+private:
+    static uint64_t Load(const char* p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        return v;
+    }
+};
+
+/**
+ * @brief 把比较器包装成 std::map / std::lower_bound 使用的严格弱序
+ * (is_transparent: 可以直接用 string_view 查找，不需要构造临时 std::string)
+ */
+template <typename Comparator>
+struct KeyLess {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const { return Comparator::Compare(a, b) < 0; }
+};
+
+/**
+ * @brief Key 的 8 字节缩写: 前 8 个字节按大端拼成的整数 (不足 8 字节的部分补 0)
+ * 对内置的三种比较器，缩写不同时它们的整数顺序就是 Key 的顺序 (逆序比较器反过来)，
+ * 缩写相同 (包括 "a" 与 "a\0" 这种补 0 后相同的情况) 才需要比较完整的 Key。
+ */
+inline uint64_t KeyPrefix(std::string_view key) {
+    unsigned char bytes[sizeof(uint64_t)] = {0};
+    memcpy(bytes, key.data(), key.size() < sizeof(bytes) ? key.size() : sizeof(bytes));
+    uint64_t prefix;
+    memcpy(&prefix, bytes, sizeof(prefix));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    prefix = __builtin_bswap64(prefix);
+#endif
+    return prefix;
+}
+
+/**
+ * @brief 带缩写的 Key 引用 (查找时只计算一次目标 Key 的缩写)
+ */
+struct PrefixedKeyRef {
+    explicit PrefixedKeyRef(std::string_view key) : prefix_(KeyPrefix(key)), key_(key) {}
+    PrefixedKeyRef(uint64_t prefix, std::string_view key) : prefix_(prefix), key_(key) {}
+
+    uint64_t prefix_;
+    std::string_view key_;
+};
+
+/**
+ * @brief 带缩写的 Key (MemTable 的 map 节点和 SSTable 的内存索引中使用)
+ * 缩写与 Key 存放在一起，大多数比较只读节点本身，不需要访问 Key 在堆上的内容。
+ */
+struct PrefixedKey {
+    explicit PrefixedKey(std::string key) : prefix_(KeyPrefix(key)), key_(std::move(key)) {}
+
+    operator PrefixedKeyRef() const { return PrefixedKeyRef(prefix_, key_); }
+
+    uint64_t prefix_;
+    std::string key_;
+};
+
+/**
+ * @brief 先比较缩写，缩写相同时再用比较器比较完整的 Key
+ */
+template <typename Comparator>
+inline int ComparePrefixed(PrefixedKeyRef a, PrefixedKeyRef b) {
+    if (a.prefix_ != b.prefix_) {
+        bool less = a.prefix_ < b.prefix_;
+        if (Comparator::kType == ComparatorType::REVERSE_BYTEWISE) {
+            less = !less;
+        }
+        return less ? -1 : 1;
+    }
+    return Comparator::Compare(a.key_, b.key_);
+}
+
+/**
+ * @brief PrefixedKey 的严格弱序 (is_transparent: 可以直接用 PrefixedKeyRef 查找)
+ */
+template <typename Comparator>
+struct PrefixedKeyLess {
+    using is_transparent = void;
+    bool operator()(PrefixedKeyRef a, PrefixedKeyRef b) const { return ComparePrefixed<Comparator>(a, b) < 0; }
+};
+
+/**
+ * @brief 按运行时的比较器类型调用 f(比较器实例)，f 的函数体对每种比较器各实例化一次
+ */
+template <typename F>
+decltype(auto) DispatchComparator(ComparatorType type, F&& f) {
+    switch (type) {
+    case ComparatorType::REVERSE_BYTEWISE:
+        return f(ReverseBytewiseComparator());
+    case ComparatorType::UINT64_BE:
+        return f(Uint64BEComparator());
+    case ComparatorType::BYTEWISE:
+    default:
+        return f(BytewiseComparator());
+    }
+}
+
+/**
+ * @brief 用运行时的比较器类型比较两个 Key (只在不在热循环里的地方使用)
+ */
+inline int CompareKeys(ComparatorType type, std::string_view a, std::string_view b) {
+    return DispatchComparator(type, [&](auto comparator) { return decltype(comparator)::Compare(a, b); });
+}
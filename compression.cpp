@@ -0,0 +1,115 @@
+#include "compression.h"
+#include "base.h"    // 用于 GetFixed32
+#include <iostream>
+#ifdef KV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+bool CompressionSupported(CompressionType type) {
+    switch (type) {
+    case CompressionType::NONE:
+        return true;
+    case CompressionType::ZLIB:
+#ifdef KV_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+#ifdef KV_HAVE_ZLIB
+/**
+ * @brief (辅助) 用 zlib 压缩，output 已经写好了块头
+ */
+template <typename String>
+static bool ZlibCompress(int level, std::string_view raw, String* output) {
+    size_t header = output->size();
+    uLongf bound = compressBound(static_cast<uLong>(raw.size()));
+    output->resize(header + bound);
+    int status = compress2(reinterpret_cast<Bytef*>(&(*output)[header]), &bound,
+                           reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()),
+                           level < 0 ? Z_DEFAULT_COMPRESSION : level);
+    if (status != Z_OK) {
+        return false;
+    }
+    output->resize(header + bound);
+    return true;
+}
+#endif
+
+/**
+ * @brief (辅助) CompressBlock 的实现 (output 可以是 std::string 或 std::pmr::string)
+ */
+template <typename String>
+static void CompressBlockTo(const CompressionOptions& options, std::string_view raw, String* output) {
+    output->clear();
+#ifdef KV_HAVE_ZLIB
+    if (options.type_ == CompressionType::ZLIB) {
+        output->push_back(static_cast<char>(CompressionType::ZLIB));
+        const uint32_t raw_size = static_cast<uint32_t>(raw.size());
+        output->append(reinterpret_cast<const char*>(&raw_size), sizeof(raw_size)); // 同 PutFixed32
+        // 至少省下 1/8 才值得在读取时付出解压的 CPU
+        if (ZlibCompress(options.level_, raw, output) && output->size() < raw.size() - raw.size() / 8) {
+            return;
+        }
+        output->clear();
+    }
+#endif
+    output->push_back(static_cast<char>(CompressionType::NONE));
+    output->append(raw.data(), raw.size());
+}
+
+void CompressBlock(const CompressionOptions& options, std::string_view raw, std::string* output) {
+    CompressBlockTo(options, raw, output);
+}
+
+void CompressBlock(const CompressionOptions& options, std::string_view raw, std::pmr::string* output) {
+    CompressBlockTo(options, raw, output);
+}
+
+/**
+ * @brief (辅助) UncompressBlock 的实现 (output 可以是 std::string 或 std::pmr::string)
+ */
+template <typename String>
+static bool UncompressBlockTo(std::string_view block, String* output) {
+    if (block.empty()) {
+        return false;
+    }
+    CompressionType type = static_cast<CompressionType>(block[0]);
+    block.remove_prefix(1);
+    switch (type) {
+    case CompressionType::NONE:
+        output->assign(block.data(), block.size());
+        return true;
+    case CompressionType::ZLIB: {
+#ifdef KV_HAVE_ZLIB
+        uint32_t raw_size = 0;
+        if (!GetFixed32(&block, &raw_size)) {
+            return false;
+        }
+        output->resize(raw_size);
+        uLongf size = raw_size;
+        if (uncompress(reinterpret_cast<Bytef*>(&(*output)[0]), &size,
+                       reinterpret_cast<const Bytef*>(block.data()), static_cast<uLong>(block.size())) != Z_OK ||
+            size != raw_size) {
+            return false;
+        }
+        return true;
+#else
+        std::cerr << "错误: 数据块使用了 zlib 压缩，但编译时没有找到 zlib" << std::endl;
+        return false;
+#endif
+    }
+    }
+    return false;
+}
+
+bool UncompressBlock(std::string_view block, std::string* output) {
+    return UncompressBlockTo(block, output);
+}
+
+bool UncompressBlock(std::string_view block, std::pmr::string* output) {
+    return UncompressBlockTo(block, output);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <memory_resource>
+#include <string_view>
+#include <cstdint>
+
+/**
+ * @brief 数据块的压缩算法
+ */
+enum class CompressionType : uint8_t {
+    NONE = 0,
+    ZLIB = 1, // deflate (需要编译时找到 zlib)
+};
+
+/**
+ * @brief CompressionOptions (压缩选项)
+ */
+struct CompressionOptions {
+    CompressionType type_ = CompressionType::NONE;
+
+    // 压缩级别 (ZLIB: 1 最快 ~ 9 压缩率最高；-1 使用 zlib 的默认级别)
+    int level_ = -1;
+};
+
+// 开启压缩时每个数据块前的类型字节数 (压缩不划算时，写入的块只比原始数据块大这么多)
+constexpr uint32_t BLOCK_TYPE_SIZE = 1;
+
+/**
+ * @brief 当前构建是否支持某种压缩算法
+ */
+bool CompressionSupported(CompressionType type);
+
+/**
+ * @brief 压缩一个数据块，结果 (覆盖) 写入 output
+ * 开启压缩的文件中，每个数据块的磁盘格式为 [块类型 1B][内容]:
+ *   NONE: 内容就是原始数据块 (压缩后没有变小时退回不压缩)
+ *   ZLIB: [原始大小 4B][deflate 数据]
+ * 未开启压缩的文件中数据块没有类型字节 (格式与之前相同)。
+ */
+void CompressBlock(const CompressionOptions& options, std::string_view raw, std::string* output);
+void CompressBlock(const CompressionOptions& options, std::string_view raw, std::pmr::string* output);
+
+/**
+ * @brief 解压一个由 CompressBlock 生成的数据块
+ * @return false 如果块损坏或者使用了不支持的算法
+ */
+bool UncompressBlock(std::string_view block, std::string* output);
+bool UncompressBlock(std::string_view block, std::pmr::string* output); // 例如块缓存内存池中的块
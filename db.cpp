@@ -0,0 +1,1433 @@
+#include "db.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <cstdio>   // 用于 std::remove
+#include "merger.h"
+
+namespace {
+
+/**
+ * @brief 把 WriteBatch 中的记录 (带连续序列号) 写入 MemTable
+ */
+class MemTableInserter : public WriteBatch::Handler {
+public:
+    MemTableInserter(uint64_t sequence, memtable* mem, RowCache* row_cache = nullptr)
+        : sequence_(sequence), mem_(mem), row_cache_(row_cache) {}
+
+    void Put(std::string_view key, std::string_view value) override {
+        Insert(key, TYPE_VALUE, value);
+    }
+
+    void Delete(std::string_view key) override {
+        Insert(key, TYPE_DELETION, std::string_view());
+    }
+
+private:
+    void Insert(std::string_view key, ValueType type, std::string_view value) {
+        encoded_.clear();
+        if (row_cache_ != nullptr) {
+            row_cache_->Invalidate(key, sequence_);
+        }
+        EncodeInternalValue(&encoded_, sequence_++, type, value);
+        mem_->put(std::string(key), encoded_);
+    }
+
+    uint64_t sequence_;
+    memtable* mem_;
+    RowCache* row_cache_; // 写入的 Key 在行缓存中失效 (可以为空)
+    std::string encoded_; // 复用的编码缓冲区
+};
+
+/**
+ * @brief 把内部值解码成用户值
+ * @return true 如果是一个有效的 Put (删除标记返回 false)
+ */
+bool ResolveValue(std::string_view internal_value, std::string* value) {
+    uint64_t sequence = 0;
+    ValueType type = TYPE_VALUE;
+    std::string_view user_value;
+    if (!DecodeInternalValue(internal_value, &sequence, &type, &user_value) ||
+        type != TYPE_VALUE) {
+        return false;
+    }
+    value->assign(user_value.data(), user_value.size());
+    return true;
+}
+
+/**
+ * @brief 行缓存填充的作用域：Begin() 之后，离开作用域时 (Get 的任何一条返回路径) 结束填充
+ */
+class RowCacheFill {
+public:
+    RowCacheFill() = default;
+    RowCacheFill(const RowCacheFill&) = delete;
+    RowCacheFill& operator=(const RowCacheFill&) = delete;
+    ~RowCacheFill() {
+        if (cache_ != nullptr) {
+            cache_->EndFill(key_);
+        }
+    }
+
+    // 需持有 DB 的锁 (与写入 MemTable 互斥)
+    void Begin(RowCache* cache, std::string_view key) {
+        cache_ = cache;
+        key_ = key;
+        cache_->BeginFill(key_);
+    }
+
+private:
+    RowCache* cache_ = nullptr;
+    std::string_view key_;
+};
+
+/**
+ * @brief 在每次操作时加锁的迭代器 (用于可变 MemTable)
+ * Key/Value 会被拷贝出来，因此在两次操作之间释放锁是安全的。
+ */
+class LockedIterator : public Iterator {
+public:
+    LockedIterator(std::shared_ptr<memtable> mem, std::mutex* mutex)
+        : mem_(std::move(mem)), mutex_(mutex), valid_(false) {}
+
+    bool Valid() const override { return valid_; }
+
+    void SeekToFirst() override {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        const auto& map = mem_->GetMap();
+        Load(map.begin(), map.end());
+    }
+
+    void Seek(std::string_view target) override {
+        std::lock_guard<std::mutex> lock(*mutex_);
+        const auto& map = mem_->GetMap();
+        Load(map.lower_bound(PrefixedKeyRef(target)), map.end());
+    }
+
+    void Next() override {
+        // 节点可能在两次操作之间被插入，因此按 Key 重新定位到下一个
+        std::lock_guard<std::mutex> lock(*mutex_);
+        const auto& map = mem_->GetMap();
+        Load(map.upper_bound(PrefixedKeyRef(key_)), map.end());
+    }
+
+    std::string_view key() const override { return key_; }
+    std::string_view value() const override { return value_; }
+    bool ok() const override { return true; }
+
+private:
+    template <typename It>
+    void Load(It it, It end) {
+        valid_ = (it != end);
+        if (valid_) {
+            key_ = it->first.key_;
+            value_ = it->second;
+        }
+    }
+
+    std::shared_ptr<memtable> mem_;
+    std::mutex* mutex_;
+    bool valid_;
+    std::string key_;
+    std::string value_;
+};
+
+/**
+ * @brief 持有 MemTable / Reader 所有权的迭代器包装
+ */
+template <typename Owner>
+class OwningIterator : public Iterator {
+public:
+    OwningIterator(std::shared_ptr<Owner> owner, std::unique_ptr<Iterator> iter)
+        : owner_(std::move(owner)), iter_(std::move(iter)) {}
+
+    bool Valid() const override { return iter_->Valid(); }
+    void SeekToFirst() override { iter_->SeekToFirst(); }
+    void Seek(std::string_view target) override { iter_->Seek(target); }
+    void Next() override { iter_->Next(); }
+    std::string_view key() const override { return iter_->key(); }
+    std::string_view value() const override { return iter_->value(); }
+    bool ok() const override { return iter_->ok(); }
+
+private:
+    std::shared_ptr<Owner> owner_;
+    std::unique_ptr<Iterator> iter_;
+};
+
+/**
+ * @brief 按顺序串联一层 (L1+) 中互不重叠的文件
+ * (文件的 Reader 在创建时已经打开，迭代期间文件即使被 Compaction 删除也能继续读取)
+ */
+class LevelIterator : public Iterator {
+public:
+    explicit LevelIterator(std::vector<std::pair<FileMetaData, std::shared_ptr<SSTableReader>>> files)
+        : files_(std::move(files)), index_(0) {}
+
+    bool Valid() const override { return iter_ != nullptr && iter_->Valid(); }
+
+    void SeekToFirst() override {
+        OpenFile(0);
+        if (iter_) iter_->SeekToFirst();
+        SkipEmptyFiles();
+    }
+
+    void Seek(std::string_view target) override {
+        // 第一个 largest_ >= target 的文件
+        auto it = std::lower_bound(files_.begin(), files_.end(), target,
+            [](const auto& f, std::string_view k) { return f.first.largest_ < k; });
+        OpenFile(it - files_.begin());
+        if (iter_) iter_->Seek(target);
+        SkipEmptyFiles();
+    }
+
+    void Next() override {
+        iter_->Next();
+        SkipEmptyFiles();
+    }
+
+    std::string_view key() const override { return iter_->key(); }
+    std::string_view value() const override { return iter_->value(); }
+    bool ok() const override { return iter_ == nullptr || iter_->ok(); }
+
+private:
+    void OpenFile(size_t index) {
+        index_ = index;
+        iter_.reset();
+        if (index_ < files_.size()) {
+            iter_ = files_[index_].second->NewIterator();
+        }
+    }
+
+    void SkipEmptyFiles() {
+        while (iter_ != nullptr && !iter_->Valid() && iter_->ok() && index_ + 1 < files_.size()) {
+            OpenFile(index_ + 1);
+            iter_->SeekToFirst();
+        }
+    }
+
+    std::vector<std::pair<FileMetaData, std::shared_ptr<SSTableReader>>> files_;
+    size_t index_;
+    std::unique_ptr<Iterator> iter_;
+};
+
+/**
+ * @brief 时间序列模式下让所有输出文件都在表属性和 MANIFEST 中记录时间戳范围
+ */
+Options SanitizeOptions(const Options& options) {
+    Options result = options;
+    const TimeSeriesOptions& ts = result.compaction_.time_series_;
+    if (ts.enabled_ && ts.timestamp_extractor_) {
+        result.compaction_.output_.builder_options_.timestamp_extractor_ = ts.timestamp_extractor_;
+    }
+    if (result.compaction_.time_series_.window_size_ == 0) {
+        result.compaction_.time_series_.window_size_ = 1;
+    }
+    return result;
+}
+
+} // namespace
+
+DB::DB(const std::string& dbname, const Options& options, bool secondary)
+    : dbname_(dbname),
+      options_(SanitizeOptions(options)),
+      secondary_(secondary),
+      log_number_(0),
+      last_sequence_(0),
+      imm_last_sequence_(0),
+      shutting_down_(false),
+      bg_idle_(false),
+      bg_error_(false),
+      versions_(dbname),
+      flushed_sequence_(0),
+      picker_(options_.compaction_),
+      last_cache_dump_(std::chrono::steady_clock::now()),
+      warmup_done_(true),
+      warmup_blocks_(0),
+      tail_log_number_(0),
+      tail_sequence_(0) {
+    if (options_.huge_pages_ != HugePageMode::NONE) {
+        memtable_memory_ = std::make_shared<HugePageResource>(options_.huge_pages_);
+    }
+    if (options_.block_cache_size_ > 0) {
+        if (!options_.secondary_cache_dir_.empty()) {
+            SecondaryCacheOptions secondary_options;
+            secondary_options.dir_ = options_.secondary_cache_dir_;
+            secondary_options.capacity_ = options_.secondary_cache_size_;
+            secondary_cache_ = std::make_unique<SecondaryCache>(secondary_options);
+        }
+        BlockCacheOptions cache_options;
+        cache_options.capacity_ = options_.block_cache_size_;
+        cache_options.compressed_capacity_ = options_.block_cache_compressed_size_;
+        cache_options.high_pri_pool_ratio_ = options_.block_cache_high_pri_ratio_;
+        cache_options.low_pri_pool_ratio_ = options_.block_cache_low_pri_ratio_;
+        cache_options.secondary_ = secondary_cache_.get();
+        cache_options.huge_pages_ = options_.huge_pages_;
+        block_cache_ = std::make_unique<BlockCache>(cache_options);
+    }
+    if (options_.row_cache_size_ > 0 && !secondary_) {
+        row_cache_ = std::make_unique<RowCache>(options_.row_cache_size_);
+    }
+}
+
+std::unique_ptr<DB> DB::Open(const std::string& dbname, const Options& options) {
+    std::error_code ec;
+    std::filesystem::create_directories(dbname, ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建数据库目录 " << dbname << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<DB> db(new DB(dbname, options, false));
+    if (!db->Recover()) {
+        return nullptr;
+    }
+    db->bg_thread_ = std::thread(&DB::BackgroundThread, db.get());
+    if (options.cache_warmup_ && db->block_cache_ != nullptr &&
+        std::filesystem::exists(CacheWarmupFileName(dbname))) {
+        db->warmup_done_ = false;
+        db->warmup_thread_ = std::thread(&DB::WarmupThread, db.get());
+    }
+    return db;
+}
+
+std::unique_ptr<DB> DB::OpenAsSecondary(const std::string& dbname, const Options& options) {
+    if (!std::filesystem::exists(ManifestFileName(dbname))) {
+        std::cerr << "错误: " << dbname << " 不是一个数据库 (没有 MANIFEST)" << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<DB> db(new DB(dbname, options, true));
+    db->mem_ = std::make_shared<memtable>(db->memtable_memory_);
+    if (!db->TryCatchUpWithPrimary()) {
+        return nullptr;
+    }
+    if (options.secondary_catch_up_interval_ms_ > 0) {
+        db->bg_thread_ = std::thread(&DB::SecondaryThread, db.get());
+    }
+    return db;
+}
+
+DB::~DB() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutting_down_ = true;
+    }
+    bg_cv_.notify_all();
+    warmup_cv_.notify_all();
+    const bool started = bg_thread_.joinable(); // 打开失败时不覆盖上次的预热文件
+    if (bg_thread_.joinable()) {
+        bg_thread_.join();
+    }
+    if (warmup_thread_.joinable()) {
+        warmup_thread_.join();
+    }
+    if (started && options_.cache_warmup_ && !secondary_ && block_cache_ != nullptr) {
+        DumpCacheKeys();
+    }
+}
+
+bool DB::Recover() {
+    if (!versions_.Recover()) {
+        return false;
+    }
+    last_sequence_ = versions_.LastSequence();
+
+    // 1. 找到所有 >= LogNumber 的 WAL (更早的 WAL 已经刷盘)
+    std::vector<uint64_t> logs;
+    std::vector<uint64_t> tables;
+    for (const auto& entry : std::filesystem::directory_iterator(dbname_)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long number = 0;
+        char suffix[8] = {0};
+        if (sscanf(name.c_str(), "%llu.%3s", &number, suffix) != 2) {
+            continue;
+        }
+        if (std::string(suffix) == "log" && number >= versions_.LogNumber()) {
+            logs.push_back(number);
+        } else if (std::string(suffix) == "sst") {
+            tables.push_back(number);
+        }
+    }
+    std::sort(logs.begin(), logs.end());
+
+    // 2. 按顺序重放 WAL
+    // 遇到第一条不完整或损坏的记录就停止，之后的 WAL 也不再重放 (否则序列号会出现空洞)
+    memtable mem;
+    std::string record;
+    WriteBatch batch;
+    for (size_t i = 0; i < logs.size(); i++) {
+        LogReader reader(LogFileName(dbname_, logs[i]));
+        bool corrupted = false;
+        while (reader.ReadRecord(&record)) {
+            if (!batch.SetContents(record) || !batch.Validate()) {
+                corrupted = true;
+                break;
+            }
+            MemTableInserter inserter(batch.Sequence(), &mem);
+            batch.Iterate(&inserter);
+            if (batch.Count() > 0) {
+                last_sequence_ = std::max(last_sequence_, batch.Sequence() + batch.Count() - 1);
+            }
+        }
+        if (corrupted || !reader.eof()) {
+            std::cerr << "警告: WAL " << logs[i] << " 在偏移量 " << reader.Offset()
+                      << " 处有不完整或损坏的记录，忽略之后的 " << (logs.size() - i - 1)
+                      << " 个 WAL" << std::endl;
+            break;
+        }
+    }
+
+    // 3. 恢复出的数据直接刷盘到 L0，然后切换到新的 WAL
+    log_number_ = versions_.NewFileNumber();
+    if (!mem.GetMap().empty()) {
+        if (!FlushMemTable(mem, log_number_, last_sequence_)) {
+            return false;
+        }
+    } else {
+        VersionEdit edit;
+        edit.log_number_ = log_number_;
+        edit.last_sequence_ = last_sequence_;
+        if (!versions_.LogAndApply(&edit)) {
+            return false;
+        }
+    }
+    log_ = std::make_unique<LogWriter>(LogFileName(dbname_, log_number_));
+    if (!log_->is_open()) {
+        return false;
+    }
+    mem_ = std::make_shared<memtable>(memtable_memory_);
+    flushed_sequence_.store(last_sequence_); // 恢复出的写入都已刷盘
+
+    // 4. 删除已经刷盘的 WAL，以及上次崩溃遗留的、不在 Version 中的 SSTable
+    RemoveObsoleteLogs();
+    std::set<uint64_t> live;
+    std::shared_ptr<const Version> version = versions_.current();
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const auto& f : version->files_[level]) {
+            live.insert(f.number_);
+        }
+    }
+    for (uint64_t number : tables) {
+        if (live.count(number) == 0) {
+            std::remove(TableFileName(dbname_, number).c_str());
+        }
+    }
+    return true;
+}
+
+bool DB::Put(std::string_view key, std::string_view value) {
+    WriteBatch batch;
+    batch.Put(key, value);
+    return Write(&batch);
+}
+
+bool DB::Delete(std::string_view key) {
+    WriteBatch batch;
+    batch.Delete(key);
+    return Write(&batch);
+}
+
+bool DB::Write(WriteBatch* batch) {
+    if (secondary_) {
+        std::cerr << "错误: 只读实例不能写入" << std::endl;
+        return false;
+    }
+    if (!batch->Validate()) {
+        std::cerr << "错误: 批次内容损坏 (记录数与头部不一致)" << std::endl;
+        return false;
+    }
+    if (batch->Count() == 0) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!MakeRoomForWrite(&lock)) {
+        return false;
+    }
+    batch->SetSequence(last_sequence_ + 1);
+    return WriteToLogAndMemTable(*batch);
+}
+
+bool DB::ApplyReplicated(const WriteBatch& batch) {
+    if (secondary_) {
+        std::cerr << "错误: 只读实例不能写入" << std::endl;
+        return false;
+    }
+    if (!batch.Validate()) {
+        std::cerr << "错误: 复制批次内容损坏 (记录数与头部不一致)" << std::endl;
+        return false;
+    }
+    if (batch.Count() == 0) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (batch.Sequence() + batch.Count() - 1 <= last_sequence_) {
+        return true; // 已经包含 (快照和日志的重叠部分)
+    }
+    if (batch.Sequence() != last_sequence_ + 1) {
+        std::cerr << "错误: 复制日志不连续: 期望序列号 " << last_sequence_ + 1
+                  << ", 收到 " << batch.Sequence() << std::endl;
+        return false;
+    }
+    if (!MakeRoomForWrite(&lock)) {
+        return false;
+    }
+    return WriteToLogAndMemTable(batch);
+}
+
+bool DB::WriteToLogAndMemTable(const WriteBatch& batch) {
+    // 调用方已经在锁外 Validate()，这里的 Iterate 不会中途失败
+    if (!log_->AddRecord(batch.Contents())) {
+        std::cerr << "错误: 写入 WAL 失败" << std::endl;
+        return false;
+    }
+    MemTableInserter inserter(batch.Sequence(), mem_.get(), row_cache_.get());
+    batch.Iterate(&inserter);
+    last_sequence_ += batch.Count();
+    if (write_listener_) {
+        write_listener_(batch);
+    }
+    return true;
+}
+
+bool DB::MakeRoomForWrite(std::unique_lock<std::mutex>* lock) {
+    while (true) {
+        if (bg_error_) {
+            return false;
+        }
+        if (mem_->ApproximateSize() < options_.write_buffer_size_) {
+            return true;
+        }
+        if (imm_ != nullptr) {
+            // 上一个 MemTable 还在刷盘，等待后台线程
+            done_cv_.wait(*lock);
+            continue;
+        }
+        if (!SwitchMemTable()) {
+            return false;
+        }
+    }
+}
+
+bool DB::SwitchMemTable() {
+    // 切换到新的 MemTable 和新的 WAL
+    uint64_t new_log_number = versions_.NewFileNumber();
+    auto new_log = std::make_unique<LogWriter>(LogFileName(dbname_, new_log_number));
+    if (!new_log->is_open()) {
+        return false;
+    }
+    log_ = std::move(new_log);
+    log_number_ = new_log_number;
+    imm_ = std::move(mem_);
+    imm_last_sequence_ = last_sequence_;
+    mem_ = std::make_shared<memtable>(memtable_memory_);
+    bg_cv_.notify_one();
+    return true;
+}
+
+bool DB::Flush() {
+    if (secondary_) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return bg_error_ || imm_ == nullptr; });
+    if (!mem_->GetMap().empty() && !bg_error_ && !SwitchMemTable()) {
+        return false;
+    }
+    done_cv_.wait(lock, [this] { return bg_error_ || imm_ == nullptr; });
+    return !bg_error_;
+}
+
+void DB::SetWriteListener(std::function<void(const WriteBatch&)> listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_listener_ = std::move(listener);
+}
+
+uint64_t DB::LastSequence() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sequence_;
+}
+
+bool DB::Get(std::string_view key, std::string* value) {
+    std::string internal_value;
+    std::shared_ptr<memtable> imm;
+    std::shared_ptr<const Version> version;
+    uint64_t snapshot = 0;
+    uint64_t epoch = 0;
+    RowCacheFill fill;
+    {
+        // 在锁内同时取 MemTable 和 Version (只读实例跟随时会一起切换它们)
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (mem_->get(key, &internal_value)) {
+            return ResolveValue(internal_value, value);
+        }
+        imm = imm_;
+        if (row_cache_ != nullptr) {
+            // epoch 必须先于 Version 读取：整体失效发生在新 Version 生效之后
+            fill.Begin(row_cache_.get(), key);
+            snapshot = last_sequence_;
+            epoch = row_cache_->Epoch();
+        }
+        version = versions_.current();
+    }
+    if (imm != nullptr && imm->get(key, &internal_value)) {
+        return ResolveValue(internal_value, value);
+    }
+    if (row_cache_ != nullptr && row_cache_->Lookup(key, &internal_value)) {
+        return ResolveValue(internal_value, value);
+    }
+    // Compaction 可能在查找期间删除旧 Version 的文件，此时换成新 Version 重试
+    while (true) {
+        if (GetFromTables(*version, key, &internal_value)) {
+            if (row_cache_ != nullptr) {
+                row_cache_->Insert(key, internal_value, snapshot, epoch);
+            }
+            return ResolveValue(internal_value, value);
+        }
+        std::shared_ptr<const Version> latest = versions_.current();
+        if (version == latest) {
+            return false;
+        }
+        version = std::move(latest);
+    }
+}
+
+bool DB::GetFromTables(const Version& version, std::string_view key, std::string* internal_value) {
+    // 时间序列模式：时间范围不包含 Key 的时间戳的文件直接跳过
+    uint64_t timestamp = 0;
+    const TimestampExtractor& extractor = options_.compaction_.time_series_.timestamp_extractor_;
+    const bool has_timestamp = options_.compaction_.time_series_.enabled_ && extractor &&
+                               extractor(key, &timestamp);
+    auto outside_time_range = [&](const FileMetaData& f) {
+        return has_timestamp && f.has_time_range_ &&
+               (timestamp < f.min_timestamp_ || timestamp > f.max_timestamp_);
+    };
+
+    // L0: 文件之间可能重叠，从新到旧查找
+    const auto& l0 = version.files_[0];
+    for (auto it = l0.rbegin(); it != l0.rend(); ++it) {
+        if (key < it->smallest_ || key > it->largest_ || outside_time_range(*it)) {
+            continue;
+        }
+        std::shared_ptr<SSTableReader> table = GetTable(it->number_);
+        if (table != nullptr && table->Get(key, internal_value)) {
+            return true;
+        }
+    }
+    // L1+: 文件互不重叠，二分找到唯一可能包含 Key 的文件
+    for (int level = 1; level < NUM_LEVELS; level++) {
+        const auto& files = version.files_[level];
+        auto it = std::lower_bound(files.begin(), files.end(), key,
+            [](const FileMetaData& f, std::string_view k) { return f.largest_ < k; });
+        if (it == files.end() || key < it->smallest_ || outside_time_range(*it)) {
+            continue;
+        }
+        std::shared_ptr<SSTableReader> table = GetTable(it->number_);
+        if (table != nullptr && table->Get(key, internal_value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DB::MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found) {
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    std::vector<std::string> internal_values(keys.size());
+    std::vector<size_t> pending; // 还没有找到 (包括删除标记) 的 Key 的下标
+    std::shared_ptr<memtable> imm;
+    std::shared_ptr<const Version> version;
+    uint64_t snapshot = 0;
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (mem_->get(keys[i], &internal_values[i])) {
+                (*found)[i] = ResolveValue(internal_values[i], &(*values)[i]);
+            } else {
+                pending.push_back(i);
+            }
+        }
+        imm = imm_;
+        if (row_cache_ != nullptr) {
+            for (size_t i : pending) {
+                row_cache_->BeginFill(keys[i]);
+            }
+            snapshot = last_sequence_;
+            epoch = row_cache_->Epoch();
+        }
+        version = versions_.current();
+    }
+    const std::vector<size_t> filling = (row_cache_ != nullptr) ? pending : std::vector<size_t>();
+    if (imm != nullptr || row_cache_ != nullptr) {
+        std::vector<size_t> missing;
+        for (size_t i : pending) {
+            if ((imm != nullptr && imm->get(keys[i], &internal_values[i])) ||
+                (row_cache_ != nullptr && row_cache_->Lookup(keys[i], &internal_values[i]))) {
+                (*found)[i] = ResolveValue(internal_values[i], &(*values)[i]);
+            } else {
+                missing.push_back(i);
+            }
+        }
+        pending.swap(missing);
+    }
+    // 与 Get 相同：没找到的 Key 在 Version 变化后用新 Version 重试
+    while (!pending.empty()) {
+        std::vector<bool> hit;
+        MultiGetFromTables(*version, keys, pending, &internal_values, &hit);
+        std::vector<size_t> missing;
+        for (size_t k = 0; k < pending.size(); k++) {
+            const size_t i = pending[k];
+            if (hit[k]) {
+                if (row_cache_ != nullptr) {
+                    row_cache_->Insert(keys[i], internal_values[i], snapshot, epoch);
+                }
+                (*found)[i] = ResolveValue(internal_values[i], &(*values)[i]);
+            } else {
+                missing.push_back(i);
+            }
+        }
+        pending.swap(missing);
+        std::shared_ptr<const Version> latest = versions_.current();
+        if (version == latest) {
+            break;
+        }
+        version = std::move(latest);
+    }
+    for (size_t i : filling) {
+        row_cache_->EndFill(keys[i]);
+    }
+}
+
+void DB::MultiGetFromTables(const Version& version, const std::vector<std::string_view>& keys,
+                            const std::vector<size_t>& pending, std::vector<std::string>* internal_values,
+                            std::vector<bool>* hit) {
+    hit->assign(pending.size(), false);
+
+    // 时间序列模式：每个 Key 的时间戳只提取一次
+    const TimestampExtractor& extractor = options_.compaction_.time_series_.timestamp_extractor_;
+    const bool time_series = options_.compaction_.time_series_.enabled_ && extractor;
+    std::vector<std::pair<bool, uint64_t>> timestamps(pending.size(), std::make_pair(false, 0));
+    if (time_series) {
+        for (size_t k = 0; k < pending.size(); k++) {
+            timestamps[k].first = extractor(keys[pending[k]], &timestamps[k].second);
+        }
+    }
+    auto outside_time_range = [&](const FileMetaData& f, size_t k) {
+        return timestamps[k].first && f.has_time_range_ &&
+               (timestamps[k].second < f.min_timestamp_ || timestamps[k].second > f.max_timestamp_);
+    };
+
+    // 在一个文件中批量查找 group (pending 中的位置)
+    auto probe = [&](uint64_t number, const std::vector<size_t>& group) {
+        std::shared_ptr<SSTableReader> table = GetTable(number);
+        if (table == nullptr) {
+            return;
+        }
+        std::vector<std::string_view> batch;
+        batch.reserve(group.size());
+        for (size_t k : group) {
+            batch.push_back(keys[pending[k]]);
+        }
+        std::vector<std::string> values;
+        std::vector<bool> found;
+        table->MultiGet(batch, &values, &found);
+        for (size_t j = 0; j < group.size(); j++) {
+            if (found[j]) {
+                (*internal_values)[pending[group[j]]].swap(values[j]);
+                (*hit)[group[j]] = true;
+            }
+        }
+    };
+
+    std::vector<size_t> remaining(pending.size());
+    for (size_t k = 0; k < remaining.size(); k++) {
+        remaining[k] = k;
+    }
+    auto drop_hits = [&] {
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](size_t k) { return (*hit)[k]; }),
+                        remaining.end());
+    };
+
+    // L0: 文件之间可能重叠，从新到旧，每个文件查一次与它范围相交的剩余 Key
+    const auto& l0 = version.files_[0];
+    for (auto it = l0.rbegin(); it != l0.rend() && !remaining.empty(); ++it) {
+        std::vector<size_t> group;
+        for (size_t k : remaining) {
+            std::string_view key = keys[pending[k]];
+            if (key >= it->smallest_ && key <= it->largest_ && !outside_time_range(*it, k)) {
+                group.push_back(k);
+            }
+        }
+        if (!group.empty()) {
+            probe(it->number_, group);
+            drop_hits();
+        }
+    }
+    // L1+: 文件互不重叠，按唯一可能包含 Key 的文件分组
+    for (int level = 1; level < NUM_LEVELS && !remaining.empty(); level++) {
+        const auto& files = version.files_[level];
+        std::map<size_t, std::vector<size_t>> groups; // 文件下标 -> 落在其中的 Key
+        for (size_t k : remaining) {
+            std::string_view key = keys[pending[k]];
+            auto it = std::lower_bound(files.begin(), files.end(), key,
+                [](const FileMetaData& f, std::string_view target) { return f.largest_ < target; });
+            if (it != files.end() && key >= it->smallest_ && !outside_time_range(*it, k)) {
+                groups[it - files.begin()].push_back(k);
+            }
+        }
+        for (const auto& group : groups) {
+            probe(files[group.first].number_, group.second);
+        }
+        drop_hits();
+    }
+}
+
+bool DB::Scan(std::string_view start, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* results) {
+    return ScanInternal(start, std::string_view(), nullptr, limit, results);
+}
+
+bool DB::ScanTimeRange(std::string_view start, std::string_view end, uint64_t min_timestamp,
+                       uint64_t max_timestamp, size_t limit,
+                       std::vector<std::pair<std::string, std::string>>* results) {
+    TimeRange range{min_timestamp, max_timestamp};
+    return ScanInternal(start, end, &range, limit, results);
+}
+
+bool DB::ScanInternal(std::string_view start, std::string_view end, const TimeRange* range, size_t limit,
+                      std::vector<std::pair<std::string, std::string>>* results) {
+    results->clear();
+    std::shared_ptr<memtable> mem;
+    std::shared_ptr<memtable> imm;
+    std::shared_ptr<const Version> version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mem = mem_;
+        imm = imm_;
+        version = versions_.current();
+    }
+
+    // 先打开 Version 中的所有文件：Compaction 可能在打开之前删除旧 Version 的文件，
+    // 此时换成新 Version 重试；打开之后 Reader 持有文件句柄，删除不影响读取。
+    std::vector<std::pair<FileMetaData, std::shared_ptr<SSTableReader>>> tables[NUM_LEVELS];
+    bool opened = false;
+    for (bool first = true; !opened; first = false) {
+        if (!first) {
+            version = versions_.current();
+        }
+        opened = true;
+        for (int level = 0; level < NUM_LEVELS && opened; level++) {
+            tables[level].clear();
+            for (const auto& f : version->files_[level]) {
+                if (range != nullptr && f.has_time_range_ &&
+                    (f.max_timestamp_ < range->min_ || f.min_timestamp_ > range->max_)) {
+                    continue; // 整个文件都在时间范围之外
+                }
+                std::shared_ptr<SSTableReader> table = GetTable(f.number_);
+                if (table == nullptr) {
+                    opened = false;
+                    break;
+                }
+                tables[level].emplace_back(f, std::move(table));
+            }
+        }
+        if (!opened && version == versions_.current()) {
+            return false;
+        }
+    }
+
+    // 子迭代器按从新到旧排列 (归并时相同 Key 取最新的)
+    std::vector<std::unique_ptr<Iterator>> children;
+    children.push_back(std::make_unique<LockedIterator>(mem, &mutex_));
+    if (imm != nullptr) {
+        children.push_back(std::make_unique<OwningIterator<memtable>>(imm, imm->NewIterator()));
+    }
+    for (auto it = tables[0].rbegin(); it != tables[0].rend(); ++it) {
+        children.push_back(std::make_unique<OwningIterator<SSTableReader>>(it->second, it->second->NewIterator()));
+    }
+    for (int level = 1; level < NUM_LEVELS; level++) {
+        if (!tables[level].empty()) {
+            children.push_back(std::make_unique<LevelIterator>(std::move(tables[level])));
+        }
+    }
+
+    std::unique_ptr<Iterator> iter = NewMergingIterator(std::move(children));
+    std::string value;
+    const TimestampExtractor& extractor = options_.compaction_.time_series_.timestamp_extractor_;
+    uint64_t timestamp = 0;
+    for (iter->Seek(start); iter->Valid() && results->size() < limit; iter->Next()) {
+        if (!end.empty() && iter->key() >= end) {
+            break;
+        }
+        if (range != nullptr && (!extractor || !extractor(iter->key(), &timestamp) ||
+                                 timestamp < range->min_ || timestamp > range->max_)) {
+            continue;
+        }
+        if (ResolveValue(iter->value(), &value)) {
+            results->emplace_back(std::string(iter->key()), std::move(value));
+        }
+    }
+    return iter->ok();
+}
+
+bool DB::GetLiveFiles(std::vector<std::pair<int, FileMetaData>>* files, uint64_t* flushed_sequence,
+                      std::vector<std::shared_ptr<SSTableReader>>* pinned) {
+    // 与 Scan 相同：文件可能在打开之前被 Compaction 删除，此时换成新 Version 重试
+    while (true) {
+        *flushed_sequence = flushed_sequence_.load();
+        std::shared_ptr<const Version> version = versions_.current();
+        files->clear();
+        pinned->clear();
+        bool opened = true;
+        for (int level = 0; level < NUM_LEVELS && opened; level++) {
+            for (const auto& f : version->files_[level]) {
+                std::shared_ptr<SSTableReader> table = GetTable(f.number_);
+                if (table == nullptr) {
+                    opened = false;
+                    break;
+                }
+                files->emplace_back(level, f);
+                pinned->push_back(std::move(table));
+            }
+        }
+        if (opened) {
+            return true;
+        }
+        if (version == versions_.current()) {
+            return false;
+        }
+    }
+}
+
+void DB::WaitForIdle() {
+    if (secondary_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return bg_error_ || (imm_ == nullptr && bg_idle_); });
+}
+
+CompactionStats DB::GetCompactionStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return compaction_stats_;
+}
+
+void DB::BackgroundThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!shutting_down_) {
+        if (bg_error_) {
+            bg_idle_ = true;
+            done_cv_.notify_all();
+            bg_cv_.wait(lock);
+            continue;
+        }
+
+        // 定期把块缓存的内容写入预热文件
+        if (options_.cache_warmup_ && options_.cache_dump_interval_seconds_ > 0 && block_cache_ != nullptr &&
+            std::chrono::steady_clock::now() - last_cache_dump_ >=
+                std::chrono::seconds(options_.cache_dump_interval_seconds_)) {
+            last_cache_dump_ = std::chrono::steady_clock::now();
+            lock.unlock();
+            DumpCacheKeys();
+            lock.lock();
+            continue;
+        }
+
+        // 1. 刷盘优先：写入可能正在等待
+        if (imm_ != nullptr) {
+            std::shared_ptr<memtable> imm = imm_;
+            uint64_t log_number = log_number_; // imm 之后的写入都在这个及更新的 WAL 中
+            uint64_t last_sequence = imm_last_sequence_;
+            lock.unlock();
+            bool ok = FlushMemTable(*imm, log_number, last_sequence);
+            if (ok) {
+                RemoveObsoleteLogs();
+            }
+            lock.lock();
+            if (ok) {
+                imm_.reset();
+                flushed_sequence_.store(last_sequence);
+            } else {
+                bg_error_ = true;
+            }
+            done_cv_.notify_all();
+            continue;
+        }
+
+        // 2. Compaction
+        std::unique_ptr<Compaction> c = picker_.PickCompaction(*versions_.current());
+        if (c != nullptr) {
+            lock.unlock();
+            CompactionStats stats;
+            bool ok = RunCompaction(&versions_, *c, options_.compaction_, &stats,
+                                    [this](uint64_t number) { return GetTable(number); });
+            EvictObsoleteTables();
+            if (row_cache_ != nullptr && c->type_ == Compaction::Type::DELETE_FILES) {
+                row_cache_->Clear(); // 被删除文件中的数据没有经过写入，行缓存无法逐个失效
+            }
+            lock.lock();
+            compaction_stats_.compactions_ += stats.compactions_;
+            compaction_stats_.files_moved_ += stats.files_moved_;
+            compaction_stats_.files_skipped_ += stats.files_skipped_;
+            compaction_stats_.bytes_read_ += stats.bytes_read_;
+            compaction_stats_.bytes_written_ += stats.bytes_written_;
+            compaction_stats_.files_expired_ += stats.files_expired_;
+            if (!ok) {
+                bg_error_ = true;
+            }
+            continue;
+        }
+
+        // 3. 没有工作了，等待下一次切换 MemTable
+        //    (有过期时间、周期性 Compaction 或定期写预热文件时还要定期醒来检查)
+        bg_idle_ = true;
+        done_cv_.notify_all();
+        if ((options_.compaction_.time_series_.enabled_ && options_.compaction_.time_series_.ttl_ > 0) ||
+            options_.compaction_.periodic_compaction_seconds_ > 0 ||
+            (options_.cache_warmup_ && options_.cache_dump_interval_seconds_ > 0 && block_cache_ != nullptr)) {
+            bg_cv_.wait_for(lock, std::chrono::seconds(1));
+        } else {
+            bg_cv_.wait(lock);
+        }
+        bg_idle_ = false;
+    }
+}
+
+bool DB::TryCatchUpWithPrimary() {
+    if (!secondary_) {
+        return true;
+    }
+    std::lock_guard<std::mutex> catch_up_lock(catch_up_mutex_);
+
+    // 1. 读取新的 MANIFEST 记录。主实例可能在我们打开文件之前就通过 Compaction 删除了它们，
+    //    这时 MANIFEST 一定已经有更新的记录，读取之后重试。
+    ManifestTail tail = versions_.Tail();
+    bool changed = false;
+    bool opened = false;
+    for (int attempt = 0; attempt < 10 && !opened; attempt++) {
+        bool more = false;
+        if (!versions_.ReadManifest(&tail, &more)) {
+            return false;
+        }
+        changed = changed || more;
+        opened = !changed || OpenTables(*tail.version_);
+        if (!opened) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (!opened) {
+        std::cerr << "错误: 无法打开主实例 " << dbname_ << " 的文件" << std::endl;
+        return false;
+    }
+
+    // 2. 读取 WAL。LogNumber 前进说明旧 WAL 的数据都已经在 SSTable 中，从新的 LogNumber 重新读。
+    std::shared_ptr<memtable> rebuilt;
+    std::vector<WriteBatch> batches;
+    if (options_.secondary_tail_wal_) {
+        if (tail.log_number_ != tail_log_number_) {
+            rebuilt = std::make_shared<memtable>(memtable_memory_);
+            tail_offsets_.clear();
+            tail_log_number_ = tail.log_number_;
+            tail_sequence_ = tail.last_sequence_;
+        }
+        ReadNewLogRecords(&batches);
+        if (rebuilt != nullptr) {
+            for (const WriteBatch& batch : batches) {
+                MemTableInserter inserter(batch.Sequence(), rebuilt.get());
+                batch.Iterate(&inserter);
+            }
+        }
+    }
+
+    // 3. 在锁内一起切换 Version 和 MemTable，读者不会看到新旧混合的状态
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (changed) {
+            versions_.Install(tail);
+        }
+        if (rebuilt != nullptr) {
+            mem_ = std::move(rebuilt);
+        } else {
+            for (const WriteBatch& batch : batches) {
+                MemTableInserter inserter(batch.Sequence(), mem_.get());
+                batch.Iterate(&inserter);
+            }
+        }
+        last_sequence_ = std::max(tail.last_sequence_, options_.secondary_tail_wal_ ? tail_sequence_ : 0);
+    }
+    if (changed) {
+        EvictObsoleteTables();
+    }
+    return true;
+}
+
+void DB::SecondaryThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!shutting_down_) {
+        bg_cv_.wait_for(lock, std::chrono::milliseconds(options_.secondary_catch_up_interval_ms_));
+        if (shutting_down_) {
+            break;
+        }
+        lock.unlock();
+        TryCatchUpWithPrimary();
+        lock.lock();
+    }
+}
+
+bool DB::OpenTables(const Version& version) {
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const auto& f : version.files_[level]) {
+            if (GetTable(f.number_) == nullptr) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void DB::ReadNewLogRecords(std::vector<WriteBatch>* batches) {
+    std::vector<uint64_t> logs;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dbname_, ec)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long number = 0;
+        char suffix[8] = {0};
+        if (sscanf(name.c_str(), "%llu.%3s", &number, suffix) == 2 &&
+            std::string(suffix) == "log" && number >= tail_log_number_) {
+            logs.push_back(number);
+        }
+    }
+    std::sort(logs.begin(), logs.end());
+
+    std::string record;
+    WriteBatch batch;
+    for (uint64_t number : logs) {
+        uint64_t& offset = tail_offsets_[number];
+        LogReader reader(LogFileName(dbname_, number), offset);
+        if (!reader.is_open()) {
+            return; // 已经被主实例删除
+        }
+        while (reader.ReadRecord(&record)) {
+            if (!batch.SetContents(record) || !batch.Validate()) {
+                std::cerr << "错误: WAL " << number << " 中有损坏的记录" << std::endl;
+                return;
+            }
+            if (batch.Count() > 0 && batch.Sequence() + batch.Count() - 1 > tail_sequence_) {
+                if (batch.Sequence() != tail_sequence_ + 1) {
+                    return; // 空洞
+                }
+                tail_sequence_ += batch.Count();
+                batches->push_back(batch);
+            }
+            offset = reader.Offset();
+        }
+    }
+}
+
+bool DB::FlushMemTable(const memtable& mem, uint64_t log_number, uint64_t last_sequence) {
+    std::vector<FileMetaData> outputs;
+    const TimeSeriesOptions& ts = options_.compaction_.time_series_;
+    if (ts.enabled_ && ts.timestamp_extractor_) {
+        // 时间序列模式：每个文件只包含一个时间窗口
+        auto new_output = [this] {
+            return std::make_unique<TableOutputManager>(dbname_, options_.compaction_.OutputOptionsForLevel(0),
+                                                        [this] { return versions_.NewFileNumber(); });
+        };
+        if (!WriteMemTableByWindow(mem, ts.timestamp_extractor_, ts.window_size_, new_output, &outputs)) {
+            return false;
+        }
+    } else {
+        TableOutputManager output(dbname_, options_.compaction_.OutputOptionsForLevel(0),
+                                  [this] { return versions_.NewFileNumber(); });
+        if (!WriteMemTable(mem, &output)) {
+            return false;
+        }
+        outputs = output.GetOutputs();
+    }
+    VersionEdit edit;
+    for (const auto& f : outputs) {
+        edit.AddFile(0, f);
+    }
+    edit.log_number_ = log_number;
+    edit.last_sequence_ = last_sequence;
+    return versions_.LogAndApply(&edit);
+}
+
+void DB::RemoveObsoleteLogs() {
+    std::error_code ec;
+    std::vector<std::pair<uint64_t, uint64_t>> obsolete; // (编号, 文件大小)
+    for (const auto& entry : std::filesystem::directory_iterator(dbname_, ec)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long number = 0;
+        char suffix[8] = {0};
+        if (sscanf(name.c_str(), "%llu.%3s", &number, suffix) == 2 &&
+            std::string(suffix) == "log" && number < versions_.LogNumber()) {
+            obsolete.emplace_back(number, entry.file_size(ec));
+        }
+    }
+    // 从新到旧保留，直到超出 wal_retention_size_
+    std::sort(obsolete.rbegin(), obsolete.rend());
+    uint64_t retained = 0;
+    for (const auto& log : obsolete) {
+        retained += log.second;
+        if (retained <= options_.wal_retention_size_) {
+            continue;
+        }
+        std::remove(LogFileName(dbname_, log.first).c_str());
+        std::lock_guard<std::mutex> lock(log_index_mutex_);
+        log_first_sequence_.erase(log.first);
+    }
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> DB::ListLogs() {
+    std::vector<uint64_t> numbers;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dbname_, ec)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long number = 0;
+        char suffix[8] = {0};
+        if (sscanf(name.c_str(), "%llu.%3s", &number, suffix) == 2 && std::string(suffix) == "log") {
+            numbers.push_back(number);
+        }
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    std::vector<std::pair<uint64_t, uint64_t>> logs;
+    std::lock_guard<std::mutex> lock(log_index_mutex_);
+    std::string record;
+    WriteBatch batch;
+    for (uint64_t number : numbers) {
+        auto it = log_first_sequence_.find(number);
+        if (it == log_first_sequence_.end()) {
+            // 只读第一条记录
+            LogReader reader(LogFileName(dbname_, number));
+            if (!reader.ReadRecord(&record) || !batch.SetContents(record)) {
+                continue; // 还没有写入 (或者刚被删除)
+            }
+            it = log_first_sequence_.emplace(number, batch.Sequence()).first;
+        }
+        logs.emplace_back(number, it->second);
+    }
+    return logs;
+}
+
+std::unique_ptr<UpdatesIterator> DB::GetUpdatesSince(uint64_t sequence) {
+    sequence = std::max<uint64_t>(sequence, 1);
+    uint64_t last_sequence = LastSequence();
+    std::vector<std::pair<uint64_t, uint64_t>> logs = ListLogs();
+
+    // 第一个序列号随 WAL 编号递增：二分找到最后一个第一个序列号 <= sequence 的 WAL
+    auto it = std::upper_bound(logs.begin(), logs.end(), sequence,
+        [](uint64_t s, const std::pair<uint64_t, uint64_t>& log) { return s < log.second; });
+    if (sequence <= last_sequence && it == logs.begin()) {
+        std::cerr << "错误: 序列号 " << sequence << " 所在的 WAL 已经被删除" << std::endl;
+        return nullptr;
+    }
+    std::vector<uint64_t> numbers;
+    for (auto from = (it == logs.begin()) ? it : it - 1; from != logs.end(); ++from) {
+        numbers.push_back(from->first);
+    }
+    return std::make_unique<UpdatesIterator>(dbname_, std::move(numbers), sequence, last_sequence);
+}
+
+uint64_t DB::WaitForCacheWarmup() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return warmup_done_; });
+    return warmup_blocks_;
+}
+
+HugePageStats DB::GetHugePageStats() const {
+    HugePageStats stats;
+    if (memtable_memory_ != nullptr) {
+        stats = memtable_memory_->GetStats();
+    }
+    if (block_cache_ != nullptr) {
+        stats += block_cache_->GetHugePageStats();
+    }
+    return stats;
+}
+
+bool DB::DumpCacheKeys() {
+    std::vector<std::pair<uint64_t, uint64_t>> keys;
+    block_cache_->GetKeys(&keys);
+    std::unordered_map<uint64_t, uint64_t> numbers; // 块缓存 id -> 文件编号
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        for (const auto& pair : tables_) {
+            if (pair.second != nullptr) { // 跳过正在打开的占位
+                numbers[pair.second->cache_id()] = pair.first;
+            }
+        }
+    }
+    // 格式: 连续的 [文件编号 8B][偏移量 8B]，按缓存中的热度排列
+    std::string contents;
+    for (const auto& key : keys) {
+        auto it = numbers.find(key.first);
+        if (it != numbers.end()) {
+            PutFixed64(&contents, it->second);
+            PutFixed64(&contents, key.second);
+        }
+    }
+    const std::string filename = CacheWarmupFileName(dbname_);
+    const std::string temp = filename + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size());
+        out.flush();
+        if (!out) {
+            std::cerr << "错误: 无法写入 " << temp << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, filename, ec);
+    if (ec) {
+        std::cerr << "错误: 无法替换 " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DB::WarmupThread() {
+    std::vector<std::pair<uint64_t, uint64_t>> blocks;
+    {
+        std::ifstream in(CacheWarmupFileName(dbname_), std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::string_view input(contents);
+        uint64_t number = 0;
+        uint64_t offset = 0;
+        while (GetFixed64(&input, &number) && GetFixed64(&input, &offset)) {
+            blocks.emplace_back(number, offset);
+        }
+    }
+    // 按 (文件编号, 偏移量) 排序：同一个文件内顺序读取
+    std::sort(blocks.begin(), blocks.end());
+    std::set<uint64_t> live;
+    std::shared_ptr<const Version> version = versions_.current();
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const auto& f : version->files_[level]) {
+            live.insert(f.number_);
+        }
+    }
+
+    const uint64_t rate = options_.cache_warmup_bytes_per_second_;
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    uint64_t loaded = 0;
+    uint64_t table_number = 0;
+    std::shared_ptr<SSTableReader> table;
+    for (const auto& block : blocks) {
+        if (live.count(block.first) == 0) {
+            continue; // 文件已经被 Compaction 删除
+        }
+        if (table_number != block.first) {
+            table_number = block.first;
+            table = GetTable(table_number);
+        }
+        if (table == nullptr) {
+            continue;
+        }
+        const size_t n = table->PrefetchBlock(block.second);
+        if (n == 0) {
+            continue;
+        }
+        loaded++;
+        bytes += n;
+        // 限速：按已读字节数算出应该用掉的时间，读得太快就等待 (关闭时立即退出)
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (rate > 0) {
+            const auto due = start + std::chrono::microseconds(bytes * 1000000 / rate);
+            warmup_cv_.wait_until(lock, due, [this] { return shutting_down_; });
+        }
+        if (shutting_down_) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    warmup_done_ = true;
+    warmup_blocks_ = loaded;
+    done_cv_.notify_all();
+}
+
+std::shared_ptr<SSTableReader> DB::GetTable(uint64_t number) {
+    // 1. 查表缓存；没有时插入一个占位 (nullptr)，同一个文件的其它调用者等待它打开完成
+    {
+        std::unique_lock<std::mutex> lock(table_mutex_);
+        for (;;) {
+            auto it = tables_.find(number);
+            if (it == tables_.end()) {
+                tables_.emplace(number, nullptr);
+                break;
+            }
+            if (it->second != nullptr) {
+                return it->second;
+            }
+            table_cv_.wait(lock);
+        }
+    }
+
+    // 2. 在锁外打开文件 (读取 Footer、索引和 Filter Index)，不阻塞其它文件的查找
+    auto in_level0 = [this, number] {
+        for (const auto& f : versions_.current()->files_[0]) {
+            if (f.number_ == number) {
+                return true;
+            }
+        }
+        return false;
+    };
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = block_cache_.get();
+    reader_options.pin_filters_ = options_.pin_l0_filter_blocks_ && block_cache_ != nullptr && in_level0();
+    auto table = std::make_shared<SSTableReader>(TableFileName(dbname_, number), reader_options);
+    if (!table->is_valid()) {
+        table = nullptr;
+    }
+
+    // 3. 发布 (打开失败时移除占位，等待者会自己重试)
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto it = tables_.find(number);
+        if (it != tables_.end() && it->second == nullptr) {
+            if (table != nullptr) {
+                it->second = table;
+            } else {
+                tables_.erase(it);
+            }
+        }
+    }
+    table_cv_.notify_all();
+
+    // 打开期间文件可能已经离开 L0 (EvictObsoleteTables 跳过了占位)
+    if (table != nullptr && reader_options.pin_filters_ && !in_level0()) {
+        table->UnpinFilters();
+    }
+    return table;
+}
+
+void DB::EvictObsoleteTables() {
+    std::shared_ptr<const Version> version = versions_.current();
+    std::set<uint64_t> live;
+    std::set<uint64_t> level0;
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const auto& f : version->files_[level]) {
+            live.insert(f.number_);
+            if (level == 0) {
+                level0.insert(f.number_);
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    for (auto it = tables_.begin(); it != tables_.end();) {
+        if (live.count(it->first) == 0) {
+            it = tables_.erase(it); // (包括正在打开的占位)
+        } else {
+            if (it->second != nullptr && level0.count(it->first) == 0) {
+                it->second->UnpinFilters(); // 例如平凡移动到 L1：Reader 和已经缓存的块都保留
+            }
+            ++it;
+        }
+    }
+}
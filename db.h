@@ -0,0 +1,403 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <map>
+#include <utility>
+#include <atomic>
+#include <functional>
+#include "memtable.h"
+#include "version.h"
+#include "compaction.h"
+#include "blockcache.h"
+#include "rowcache.h"
+#include "sstablereader.h"
+#include "wal.h"
+#include "writebatch.h"
+#include "kvstore.h"
+
+/**
+ * @brief Options (数据库选项)
+ */
+struct Options {
+    // MemTable 达到这个大小 (字节) 后切换成不可变 MemTable，并在后台刷盘
+    size_t write_buffer_size_ = 64 * 1024;
+
+    // 块缓存容量 (字节)，0 表示不使用块缓存
+    size_t block_cache_size_ = 8 * 1024 * 1024;
+
+    // 块缓存压缩层的容量 (字节)，0 表示不使用压缩层 (需要 zlib)
+    // 热层淘汰的块压缩后放在这里，热层未命中时解压取回，不需要读盘
+    size_t block_cache_compressed_size_ = 0;
+
+    // 块缓存中高 / 低优先级池最多占的容量比例 (Filter 分区是高优先级，用户读取的数据块是低优先级，
+    // Compaction 读取的数据块是最低优先级)；超出比例的最旧条目降到下一个优先级
+    double block_cache_high_pri_ratio_ = 0.5;
+    double block_cache_low_pri_ratio_ = 1.0;
+
+    // L0 文件在 L0 期间把 Filter 分区固定在块缓存中 (每次查找都要查所有 L0 文件的 Filter)
+    bool pin_l0_filter_blocks_ = true;
+
+    // 二级块缓存 (本地 SSD 上的段文件) 所在的目录，为空表示不使用；需要同时开启块缓存
+    // 从块缓存淘汰的块异步写入这里，内存未命中时先查它再读 SSTable
+    std::string secondary_cache_dir_;
+
+    // 二级块缓存容量 (字节)
+    uint64_t secondary_cache_size_ = 256 * 1024 * 1024;
+
+    // 块缓存预热：定期 (以及关闭时) 把块缓存中的块 (文件编号, 偏移量) 写入 CACHE_WARMUP，
+    // 下次打开时由后台线程按文件和偏移量顺序把这些块读回缓存 (只读实例不使用)
+    bool cache_warmup_ = false;
+
+    // 写 CACHE_WARMUP 的间隔 (秒)，0 表示只在关闭时写
+    uint64_t cache_dump_interval_seconds_ = 300;
+
+    // 预热读取的速度上限 (字节/秒)，避免和前台读取争抢 I/O；0 表示不限速
+    uint64_t cache_warmup_bytes_per_second_ = 32 * 1024 * 1024;
+
+    // MemTable 的 Arena 和块缓存的块内容使用的大页模式 (NONE 表示普通的堆内存)
+    // 大容量的 MemTable / 块缓存上的随机查找 TLB 未命中很多，放在 2MB 大页上可以减少；
+    // 系统没有可用的大页时自动退回普通页 (见 GetHugePageStats)
+    HugePageMode huge_pages_ = HugePageMode::NONE;
+
+    // 行缓存容量 (字节)，0 表示不使用行缓存 (只读实例不使用)
+    // 缓存 SSTable 中查到的热点 K/V，命中时跳过索引、Filter 和数据块查找
+    size_t row_cache_size_ = 0;
+
+    // Compaction 与输出文件选项
+    CompactionOptions compaction_;
+
+    // 已经刷盘的 WAL 最多保留的总字节数 (供 GetUpdatesSince 读取历史变更)，
+    // 超出时先删除最旧的；0 表示刷盘后立即删除
+    uint64_t wal_retention_size_ = 0;
+
+    // 只读实例 (OpenAsSecondary) 在后台跟随主实例的间隔 (毫秒)，0 表示只在调用
+    // TryCatchUpWithPrimary() 时跟随
+    int secondary_catch_up_interval_ms_ = 100;
+
+    // 只读实例同时读取主实例的 WAL，可以读到还没有刷盘的写入
+    bool secondary_tail_wal_ = false;
+};
+
+/**
+ * @brief DB (数据库)
+ * 职责：把 MemTable、WAL、SSTable 和 Compaction 组合成一个完整的 LSM-Tree 存储引擎。
+ *
+ * 写路径: WriteBatch -> WAL -> MemTable；MemTable 满了就切换，由后台线程刷盘到 L0，
+ *         随后在后台执行 Compaction。
+ * 读路径: MemTable -> 不可变 MemTable -> L0 (从新到旧) -> L1 ... L6。
+ *
+ * 线程安全：所有公有方法都可以被多个线程并发调用。
+ */
+class DB : public KVStore {
+public:
+    /**
+     * @brief 打开 (或创建) 一个数据库，并重放 WAL 恢复上次未刷盘的写入
+     * @param dbname 数据库目录
+     * @param options 数据库选项
+     * @return 失败时返回 nullptr
+     */
+    static std::unique_ptr<DB> Open(const std::string& dbname, const Options& options);
+
+    /**
+     * @brief 以只读实例 (secondary) 打开另一个进程正在使用的数据库目录
+     * 只读实例不写任何文件：它跟随主实例的 MANIFEST 看到新的 SSTable，
+     * 与主实例共享不可变的 .sst 文件和页缓存。写入接口都返回 false。
+     * @return 失败时 (例如目录中没有 MANIFEST) 返回 nullptr
+     */
+    static std::unique_ptr<DB> OpenAsSecondary(const std::string& dbname, const Options& options);
+
+    /**
+     * @brief 析构函数：停止后台线程 (未刷盘的 MemTable 会在下次打开时从 WAL 恢复)
+     */
+    ~DB() override;
+
+    // 禁用拷贝和赋值
+    DB(const DB&) = delete;
+    DB& operator=(const DB&) = delete;
+
+    bool Put(std::string_view key, std::string_view value) override;
+    bool Delete(std::string_view key) override;
+
+    /**
+     * @brief 原子地写入一个批次 (会为批次分配序列号)
+     */
+    bool Write(WriteBatch* batch) override;
+
+    /**
+     * @brief 查找一个 Key
+     * @return true 如果找到 (且没有被删除)
+     */
+    bool Get(std::string_view key, std::string* value) override;
+
+    /**
+     * @brief 批量查找 (结果与逐个 Get 相同)
+     * MemTable 在一次加锁内查完；SSTable 按文件分组，每个文件内的索引二分交错进行
+     * (见 SSTableReader::MultiGet)。
+     */
+    void MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found) override;
+
+    /**
+     * @brief 从 start 开始 (含) 按升序返回最多 limit 个 K/V (已删除的 Key 不返回)
+     */
+    bool Scan(std::string_view start, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* results) override;
+
+    /**
+     * @brief (时间序列) 返回 [start, end) 中时间戳在 [min_timestamp, max_timestamp] 内的 K/V，最多 limit 个
+     * 时间范围与查询不相交的文件不会被打开。end 为空表示不设上限；取不出时间戳的 Key 不返回。
+     */
+    bool ScanTimeRange(std::string_view start, std::string_view end, uint64_t min_timestamp,
+                       uint64_t max_timestamp, size_t limit,
+                       std::vector<std::pair<std::string, std::string>>* results);
+
+    /**
+     * @brief 等待后台的刷盘和 Compaction 全部完成 (测试/压测使用)
+     */
+    void WaitForIdle();
+
+    /**
+     * @brief 把当前 MemTable 刷盘到 L0 并等待完成
+     */
+    bool Flush();
+
+    // --- 复制 (Replication) 使用的接口 ---
+
+    /**
+     * @brief 设置写入监听器：每个批次写入 WAL 和 MemTable 后 (持有 DB 锁、按序列号顺序) 调用
+     * 监听器必须很快返回，且不能再调用 DB 的方法。传入 nullptr 取消监听。
+     */
+    void SetWriteListener(std::function<void(const WriteBatch&)> listener);
+
+    /**
+     * @brief 按批次自带的序列号写入 (从节点重放主节点的日志)
+     * 已经包含的批次会被跳过；序列号不连续时返回 false。
+     */
+    bool ApplyReplicated(const WriteBatch& batch);
+
+    /**
+     * @brief 已分配的最大序列号
+     */
+    uint64_t LastSequence();
+
+    /**
+     * @brief 序列号不大于这个值的写入都已经在 SSTable 中
+     */
+    uint64_t FlushedSequence() const { return flushed_sequence_.load(); }
+
+    /**
+     * @brief 获取当前 Version 的所有文件 (level, 元数据) 以及它们覆盖到的序列号
+     * @param pinned [out] 已打开的文件，持有期间文件被 Compaction 删除也可以继续读取
+     */
+    bool GetLiveFiles(std::vector<std::pair<int, FileMetaData>>* files, uint64_t* flushed_sequence,
+                      std::vector<std::shared_ptr<SSTableReader>>* pinned);
+
+    /**
+     * @brief 从序列号 sequence 开始按顺序读出已经提交的 WriteBatch (变更数据捕获)
+     * 迭代器读到调用时的最大序列号为止。已刷盘的 WAL 由 wal_retention_size_ 决定保留多久。
+     * @return nullptr 如果包含 sequence 的 WAL 已经被删除
+     */
+    std::unique_ptr<UpdatesIterator> GetUpdatesSince(uint64_t sequence);
+
+    /**
+     * @brief (只读实例) 读取主实例新追加的 MANIFEST 记录 (以及 WAL)，切换到最新的状态
+     * 主实例返回 true 什么也不做。
+     */
+    bool TryCatchUpWithPrimary();
+
+    /**
+     * @brief 获取累计的 Compaction 统计
+     */
+    CompactionStats GetCompactionStats();
+
+    /**
+     * @brief 等待打开时开始的块缓存预热结束
+     * @return 预热从文件读入缓存的块数
+     */
+    uint64_t WaitForCacheWarmup();
+
+    /**
+     * @brief 块缓存 (查看命中率等统计，包括二级缓存)；未开启时返回 nullptr
+     */
+    const BlockCache* GetBlockCache() const { return block_cache_.get(); }
+
+    /**
+     * @brief 行缓存 (查看命中率等统计)；未开启时返回 nullptr
+     */
+    const RowCache* GetRowCache() const { return row_cache_.get(); }
+
+    /**
+     * @brief MemTable 和块缓存实际用到的大页内存 (Options::huge_pages_ 为 NONE 时全为 0)
+     */
+    HugePageStats GetHugePageStats() const;
+
+private:
+    DB(const std::string& dbname, const Options& options, bool secondary);
+
+    struct TimeRange {
+        uint64_t min_;
+        uint64_t max_;
+    };
+
+    /**
+     * @brief (私有) Scan / ScanTimeRange 的实现 (range 为 nullptr 表示不按时间过滤)
+     */
+    bool ScanInternal(std::string_view start, std::string_view end, const TimeRange* range, size_t limit,
+                      std::vector<std::pair<std::string, std::string>>* results);
+
+    /**
+     * @brief (私有) 恢复 MANIFEST 和 WAL，并打开新的 WAL
+     */
+    bool Recover();
+
+    /**
+     * @brief (私有, 需持有锁) 保证 MemTable 有空间写入；必要时切换 MemTable 和 WAL
+     */
+    bool MakeRoomForWrite(std::unique_lock<std::mutex>* lock);
+
+    /**
+     * @brief (私有, 需持有锁) 把当前 MemTable 变成不可变 MemTable 并切换 WAL
+     */
+    bool SwitchMemTable();
+
+    /**
+     * @brief (私有, 需持有锁) 写入 WAL 和 MemTable，并通知写入监听器
+     */
+    bool WriteToLogAndMemTable(const WriteBatch& batch);
+
+    /**
+     * @brief (私有) 后台线程：刷盘不可变 MemTable，执行 Compaction
+     */
+    void BackgroundThread();
+
+    /**
+     * @brief (私有) 只读实例的后台线程：定期跟随主实例
+     */
+    void SecondaryThread();
+
+    /**
+     * @brief (私有, 只读实例) 打开 version 中的所有文件放进表缓存
+     * @return false 如果有文件已经被主实例删除
+     */
+    bool OpenTables(const Version& version);
+
+    /**
+     * @brief (私有, 只读实例) 从 tail_offsets_ 记录的位置继续读取主实例的 WAL
+     * 只接受序列号连续的批次：遇到空洞 (WAL 已经被删除) 时停下，等 MANIFEST 前进后再重新读。
+     */
+    void ReadNewLogRecords(std::vector<WriteBatch>* batches);
+
+    /**
+     * @brief (私有) 把一个 MemTable 写成 L0 文件，并记录到 MANIFEST
+     * @param log_number 刷盘后仍需要保留的最小 WAL 编号
+     */
+    bool FlushMemTable(const memtable& mem, uint64_t log_number, uint64_t last_sequence);
+
+    /**
+     * @brief (私有) 删除编号小于 MANIFEST 中 LogNumber 的 WAL (它们的数据都已刷盘)
+     */
+    void RemoveObsoleteLogs();
+
+    /**
+     * @brief (私有) 列出目录中的 WAL，返回 (编号, 第一个批次的序列号)，按编号升序
+     * 第一个序列号缓存在 log_first_sequence_ 中；还没有记录的 WAL 不返回。
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> ListLogs();
+
+    /**
+     * @brief (私有) 在 SSTable 中按层查找 (找到时 internal_value 是带标签的内部值)
+     */
+    bool GetFromTables(const Version& version, std::string_view key, std::string* internal_value);
+
+    /**
+     * @brief (私有) GetFromTables 的批量版本
+     * @param pending 要查找的 Key 在 keys 中的下标
+     * @param internal_values [out] 按 keys 的下标写入找到的内部值
+     * @param hit [out] 与 pending 一一对应
+     */
+    void MultiGetFromTables(const Version& version, const std::vector<std::string_view>& keys,
+                            const std::vector<size_t>& pending, std::vector<std::string>* internal_values,
+                            std::vector<bool>* hit);
+
+    /**
+     * @brief (私有) 把块缓存中的块 (文件编号, 偏移量) 写入 CACHE_WARMUP (先写临时文件再改名)
+     */
+    bool DumpCacheKeys();
+
+    /**
+     * @brief (私有) 预热线程：把 CACHE_WARMUP 中列出的块按文件和偏移量顺序限速读入块缓存
+     */
+    void WarmupThread();
+
+    /**
+     * @brief (私有) 从表缓存获取一个文件的 Reader (不存在时打开)
+     * 打开文件在 table_mutex_ 之外进行；同一个文件同时只有一个线程打开，其它线程等待它的结果。
+     */
+    std::shared_ptr<SSTableReader> GetTable(uint64_t number);
+
+    /**
+     * @brief (私有) 从表缓存中移除已经不在当前 Version 中的文件；
+     * 已经离开 L0 的文件取消固定 Filter 分区
+     */
+    void EvictObsoleteTables();
+
+    // --- 成员变量 ---
+    const std::string dbname_;
+    const Options options_;
+    const bool secondary_;             // 只读实例
+    std::shared_ptr<HugePageResource> memtable_memory_; // MemTable Arena 的上游 (没有开启大页时为空)
+    std::unique_ptr<SecondaryCache> secondary_cache_; // 必须比 block_cache_ 活得久
+    std::unique_ptr<BlockCache> block_cache_;
+    std::unique_ptr<RowCache> row_cache_;
+
+    // 以下成员由 mutex_ 保护
+    std::mutex mutex_;
+    std::condition_variable bg_cv_;    // 唤醒后台线程
+    std::condition_variable done_cv_;  // 后台完成了一项工作
+    std::shared_ptr<memtable> mem_;    // 当前可写的 MemTable
+    std::shared_ptr<memtable> imm_;    // 正在刷盘的不可变 MemTable (可能为空)
+    std::unique_ptr<LogWriter> log_;   // 当前 MemTable 对应的 WAL
+    uint64_t log_number_;              // 当前 WAL 的编号
+    uint64_t last_sequence_;           // 已分配的最大序列号
+    uint64_t imm_last_sequence_;       // imm_ 中最大的序列号
+    bool shutting_down_;
+    bool bg_idle_;                     // 后台线程没有待做的工作
+    bool bg_error_;                    // 后台出错后拒绝写入
+    CompactionStats compaction_stats_;
+    std::function<void(const WriteBatch&)> write_listener_;
+
+    VersionSet versions_;
+    std::atomic<uint64_t> flushed_sequence_;
+    CompactionPicker picker_;          // 只由后台线程使用
+    std::thread bg_thread_;
+    std::chrono::steady_clock::time_point last_cache_dump_; // 只由后台线程使用
+
+    // 块缓存预热 (warmup_done_ 由 mutex_ 保护，完成时通知 done_cv_)
+    std::thread warmup_thread_;
+    std::condition_variable warmup_cv_; // 关闭时打断限速等待
+    bool warmup_done_;
+    uint64_t warmup_blocks_;
+
+    // 表缓存: 文件编号 -> Reader (nullptr 表示正在打开，打开完成时通知 table_cv_)
+    std::mutex table_mutex_;
+    std::condition_variable table_cv_;
+    std::unordered_map<uint64_t, std::shared_ptr<SSTableReader>> tables_;
+
+    // WAL 编号 -> 第一个批次的序列号 (GetUpdatesSince 定位起始 WAL 用)
+    std::mutex log_index_mutex_;
+    std::map<uint64_t, uint64_t> log_first_sequence_;
+
+    // 只读实例跟随 WAL 的进度，由 catch_up_mutex_ 保护
+    std::mutex catch_up_mutex_;
+    uint64_t tail_log_number_;                   // 从这个编号的 WAL 开始读
+    uint64_t tail_sequence_;                     // 已经读入 MemTable 的最大序列号
+    std::map<uint64_t, uint64_t> tail_offsets_;  // WAL 编号 -> 已读到的偏移量
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstdio>   // 用于 snprintf
+#include "base.h"   // 用于 PutFixed64 / GetFixed64
+
+// LSM-Tree 的层数 (L0 ~ L6)
+const int NUM_LEVELS = 7;
+
+/**
+ * @brief FileMetaData (文件元数据)
+ * 描述一个已经完成的 SSTable 文件：编号、大小和 Key 范围。
+ * 刷盘/Compaction 的输出、以及每一层的文件列表都用它来描述。
+ */
+struct FileMetaData {
+    uint64_t number_ = 0;     // 文件编号 (决定文件名)
+    uint64_t file_size_ = 0;  // 文件大小 (字节)
+    std::string smallest_;    // 文件中最小的 Key
+    std::string largest_;     // 文件中最大的 Key
+
+    // 文件中所有 Key 的时间戳范围 (时间序列模式；每个 Key 都能取出时间戳时才有效)
+    bool has_time_range_ = false;
+    uint64_t min_timestamp_ = 0;
+    uint64_t max_timestamp_ = 0;
+
+    // 文件的创建时间 (Unix 秒；0 表示未知)。平凡移动不改变它，周期性 Compaction 据此重写旧文件
+    uint64_t creation_time_ = 0;
+};
+
+/**
+ * @brief 根据数据库目录和文件编号生成 SSTable 文件名
+ * 例如: TableFileName("db", 7) == "db/000007.sst"
+ */
+inline std::string TableFileName(const std::string& dbname, uint64_t number) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "/%06llu.sst", static_cast<unsigned long long>(number));
+    return dbname + buf;
+}
+
+/**
+ * @brief 根据数据库目录和文件编号生成 WAL (预写日志) 文件名
+ * 例如: LogFileName("db", 8) == "db/000008.log"
+ */
+inline std::string LogFileName(const std::string& dbname, uint64_t number) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "/%06llu.log", static_cast<unsigned long long>(number));
+    return dbname + buf;
+}
+
+/**
+ * @brief MANIFEST 文件名 (记录每一层有哪些文件)
+ */
+inline std::string ManifestFileName(const std::string& dbname) {
+    return dbname + "/MANIFEST";
+}
+
+/**
+ * @brief 块缓存预热文件 (上次运行时缓存中的块: 文件编号 + 偏移量)
+ */
+inline std::string CacheWarmupFileName(const std::string& dbname) {
+    return dbname + "/CACHE_WARMUP";
+}
+
+// --- 内部值格式 ---
+// MemTable 和 SSTable 中存放的 Value 都带一个 8 字节的标签:
+// [tag (8B) = (sequence << 8) | type] [用户的 value]
+// 删除操作写入一个 TYPE_DELETION 的“墓碑”，读到墓碑即表示 Key 已被删除。
+
+enum ValueType : uint8_t {
+    TYPE_DELETION = 0,
+    TYPE_VALUE = 1,
+};
+
+// 序列号最多 56 位 (高 8 位留给 tag 中的 type)
+const uint64_t MAX_SEQUENCE_NUMBER = (1ULL << 56) - 1;
+
+/**
+ * @brief 编码一个内部值，并追加到 dst
+ */
+inline void EncodeInternalValue(std::string* dst, uint64_t sequence, ValueType type, std::string_view value) {
+    PutFixed64(dst, (sequence << 8) | type);
+    dst->append(value.data(), value.size());
+}
+
+/**
+ * @brief 解析一个内部值
+ * @return false 如果格式错误
+ */
+inline bool DecodeInternalValue(std::string_view input, uint64_t* sequence, ValueType* type,
+                                std::string_view* value) {
+    uint64_t tag = 0;
+    if (!GetFixed64(&input, &tag) || (tag & 0xff) > TYPE_VALUE) {
+        return false;
+    }
+    *sequence = tag >> 8;
+    *type = static_cast<ValueType>(tag & 0xff);
+    *value = input;
+    return true;
+}
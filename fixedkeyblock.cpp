@@ -0,0 +1,119 @@
+#include "fixedkeyblock.h"
+#include "base.h"   // 用于 readKV / PutFixed32
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define KV_HAVE_AVX2_SEARCH 1
+#endif
+
+void FixedKeyBlock::Encode(std::string_view kv_block, uint32_t key_size, uint32_t count, std::string* output) {
+    output->clear();
+    PutFixed32(output, MARKER);
+    PutFixed32(output, key_size);
+    PutFixed32(output, count);
+    size_t keys_start = output->size();
+    size_t offsets_start = keys_start + static_cast<size_t>(count) * key_size;
+    size_t values_start = offsets_start + (static_cast<size_t>(count) + 1) * sizeof(uint32_t);
+    output->resize(values_start);
+
+    std::string_view key;
+    std::string_view value;
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < count && readKV(&kv_block, &key, &value); i++) {
+        memcpy(&(*output)[keys_start + i * key_size], key.data(), key_size);
+        memcpy(&(*output)[offsets_start + i * sizeof(uint32_t)], &offset, sizeof(offset));
+        output->append(value.data(), value.size());
+        offset += static_cast<uint32_t>(value.size());
+    }
+    memcpy(&(*output)[offsets_start + count * sizeof(uint32_t)], &offset, sizeof(offset));
+}
+
+bool FixedKeyBlock::Parse(std::string_view block) {
+    uint32_t marker = 0;
+    if (!GetFixed32(&block, &marker) || marker != MARKER || !GetFixed32(&block, &key_size_) ||
+        !GetFixed32(&block, &count_) || key_size_ == 0 || key_size_ > MAX_KEY_SIZE) {
+        return false;
+    }
+    size_t keys_size = static_cast<size_t>(count_) * key_size_;
+    size_t offsets_size = (static_cast<size_t>(count_) + 1) * sizeof(uint32_t);
+    if (block.size() < keys_size + offsets_size) {
+        return false;
+    }
+    keys_ = block.data();
+    offsets_ = keys_ + keys_size;
+    values_ = offsets_ + offsets_size;
+    values_size_ = block.size() - keys_size - offsets_size;
+    return Offset(count_) == values_size_;
+}
+
+/**
+ * @brief (辅助) 把 8 字节大端 Key 读成整数
+ */
+static inline uint64_t LoadBigEndian64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+#ifdef KV_HAVE_AVX2_SEARCH
+/**
+ * @brief (辅助) 统计 keys[0, n) 中排在 target 之前的 Key 个数 (AVX2，每条指令比较 4 个 Key)
+ * AVX2 只有有符号的 64 位比较，所以两边都先翻转符号位。
+ */
+__attribute__((target("avx2")))
+static uint32_t CountBeforeAvx2(const char* keys, uint32_t n, uint64_t target, bool descending) {
+    const __m256i bswap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                           7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+    const __m256i t = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(target)), sign);
+    uint32_t count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i * 8));
+        k = _mm256_xor_si256(_mm256_shuffle_epi8(k, bswap), sign);
+        __m256i before = descending ? _mm256_cmpgt_epi64(k, t) : _mm256_cmpgt_epi64(t, k);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(before)));
+    }
+    for (; i < n; i++) {
+        uint64_t k = LoadBigEndian64(keys + i * 8);
+        count += descending ? (k > target) : (k < target);
+    }
+    return count;
+}
+
+static bool CpuHasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+uint32_t FixedKeyBlock::LowerBound64(std::string_view target, bool descending) const {
+    const uint64_t t = LoadBigEndian64(target.data());
+    auto before = [&](uint32_t i) {
+        uint64_t k = LoadBigEndian64(keys_ + i * 8);
+        return descending ? k > t : k < t;
+    };
+    // 1. 二分把范围缩小到最多 32 个 Key
+    uint32_t left = 0;
+    uint32_t right = count_;
+    while (right - left > 32) {
+        uint32_t mid = left + (right - left) / 2;
+        if (before(mid)) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    // 2. 剩下的一段：Key 有序，“排在 target 之前”的 Key 正好是这一段的前缀，数一下即可
+#ifdef KV_HAVE_AVX2_SEARCH
+    if (CpuHasAvx2()) {
+        return left + CountBeforeAvx2(keys_ + left * 8, right - left, t, descending);
+    }
+#endif
+    while (left < right && before(left)) {
+        left++;
+    }
+    return left;
+}
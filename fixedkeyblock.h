@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include "comparator.h"
+
+/**
+ * @brief 定长 Key 数据块
+ * 一个数据块中所有 Key 等长且不超过 8 字节时 (例如 8 字节整数 Key)，Builder 把它编码成:
+ *   [标记 0xFFFFFFFF 4B][key_size 4B][count 4B]
+ *   [Key 数组: count * key_size 字节，紧密排列]
+ *   [Value 偏移: (count + 1) * 4B，相对 Value 区的起点]
+ *   [Value 区]
+ * 普通数据块以 key_len (4B) 开头，永远不会等于标记，所以两种布局可以在同一个文件中混用。
+ * 查找不需要逐条解析 readKV：直接在 Key 数组上二分；8 字节 Key 的最后一段用 AVX2
+ * 一次比较 4 个 Key (运行时检测 CPU，不支持时退回标量比较)。
+ */
+class FixedKeyBlock {
+public:
+    static constexpr uint32_t MARKER = 0xFFFFFFFF;
+    static constexpr uint32_t MAX_KEY_SIZE = 8;
+
+    /**
+     * @brief 数据块是否是定长 Key 布局
+     */
+    static bool Is(std::string_view block) {
+        uint32_t marker = 0;
+        if (block.size() < sizeof(marker)) return false;
+        memcpy(&marker, block.data(), sizeof(marker));
+        return marker == MARKER;
+    }
+
+    /**
+     * @brief 把一个普通布局 (readKV 序列) 的数据块重新编码成定长 Key 布局
+     * (调用方保证所有 Key 的长度都是 key_size)
+     */
+    static void Encode(std::string_view kv_block, uint32_t key_size, uint32_t count, std::string* output);
+
+    /**
+     * @brief 解析块头
+     * @return false 如果块损坏
+     */
+    bool Parse(std::string_view block);
+
+    uint32_t count() const { return count_; }
+    std::string_view key(uint32_t i) const { return std::string_view(keys_ + i * key_size_, key_size_); }
+    std::string_view value(uint32_t i) const {
+        uint32_t begin = Offset(i);
+        uint32_t end = Offset(i + 1);
+        if (begin > end || end > values_size_) {
+            return std::string_view(); // 块损坏 (Parse 只校验了总长度)
+        }
+        return std::string_view(values_ + begin, end - begin);
+    }
+
+    /**
+     * @brief 第一个不小于 target 的 Key 的下标 (都小于 target 时返回 count())
+     */
+    template <typename Comparator>
+    uint32_t LowerBound(std::string_view target) const {
+        if (target.size() == MAX_KEY_SIZE && key_size_ == MAX_KEY_SIZE) {
+            // 8 字节 Key 的字节序就是大端整数的顺序 (BYTEWISE 与 UINT64_BE 相同，逆序则反过来)
+            return LowerBound64(target, Comparator::kType == ComparatorType::REVERSE_BYTEWISE);
+        }
+        uint32_t left = 0;
+        uint32_t right = count_;
+        while (left < right) {
+            uint32_t mid = left + (right - left) / 2;
+            if (Comparator::Compare(key(mid), target) < 0) {
+                left = mid + 1;
+            } else {
+                right = mid;
+            }
+        }
+        return left;
+    }
+
+private:
+    uint32_t Offset(uint32_t i) const {
+        uint32_t offset;
+        memcpy(&offset, offsets_ + i * sizeof(uint32_t), sizeof(offset));
+        return offset;
+    }
+
+    /**
+     * @brief (私有) 8 字节 Key 的 lower_bound：先二分缩小到一小段，再逐批比较
+     * @param descending Key 是否按降序排列 (逆序比较器)
+     */
+    uint32_t LowerBound64(std::string_view target, bool descending) const;
+
+    uint32_t key_size_ = 0;
+    uint32_t count_ = 0;
+    const char* keys_ = nullptr;
+    const char* offsets_ = nullptr;
+    const char* values_ = nullptr;
+    size_t values_size_ = 0;
+};
@@ -0,0 +1,181 @@
+#include "hugepage.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+#include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <cstdio>
+#include <cinttypes>
+#endif
+
+static size_t RoundUp(size_t n, size_t unit) {
+    return (n + unit - 1) / unit * unit;
+}
+
+HugePageResource::HugePageResource(HugePageMode mode)
+    : mode_(mode), current_(nullptr) {}
+
+HugePageResource::~HugePageResource() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!regions_.empty()) {
+        UnmapLocked(regions_.begin());
+    }
+}
+
+/**
+ * @brief 大请求单独映射；小请求从当前区域顺序切出，区域不够时换一个新区域
+ */
+void* HugePageResource::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes > kHugePageSize / 2) {
+        char* base = MapLocked(RoundUp(bytes, kHugePageSize));
+        Region& region = regions_[base];
+        region.used_ = region.size_;
+        region.live_ = 1;
+        return base;
+    }
+    if (current_ != nullptr) {
+        Region& region = regions_[current_];
+        size_t offset = RoundUp(region.used_, alignment);
+        if (offset + bytes <= region.size_) {
+            region.used_ = offset + bytes;
+            region.live_++;
+            return current_ + offset;
+        }
+        char* old = current_;
+        current_ = nullptr;
+        if (region.live_ == 0) {
+            UnmapLocked(regions_.find(old));
+        }
+    }
+    current_ = MapLocked(kHugePageSize);
+    Region& region = regions_[current_];
+    region.used_ = bytes;
+    region.live_ = 1;
+    return current_;
+}
+
+void HugePageResource::do_deallocate(void* p, size_t /*bytes*/, size_t /*alignment*/) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = regions_.upper_bound(static_cast<char*>(p));
+    if (it == regions_.begin()) {
+        return; // 不是这里分配的 (不应该发生)
+    }
+    --it;
+    if (--it->second.live_ == 0 && it->first != current_) {
+        UnmapLocked(it);
+    }
+}
+
+char* HugePageResource::MapLocked(size_t size) {
+    char* base = nullptr;
+    Backing backing = Backing::REGULAR;
+#ifdef __linux__
+    if (mode_ == HugePageMode::EXPLICIT) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            base = static_cast<char*>(p);
+            backing = Backing::EXPLICIT;
+        }
+    }
+    if (base == nullptr) {
+        // 多映射 2MB，裁掉首尾让起点按 2MB 对齐 (透明大页只能用在对齐的 2MB 范围上)
+        void* p = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char* raw = static_cast<char*>(p);
+        base = reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(raw), kHugePageSize));
+        if (base != raw) {
+            munmap(raw, base - raw);
+        }
+        munmap(base + size, raw + kHugePageSize - base);
+        if (mode_ != HugePageMode::NONE && madvise(base, size, MADV_HUGEPAGE) == 0) {
+            backing = Backing::TRANSPARENT;
+        }
+    }
+#else
+    base = static_cast<char*>(::operator new(size, std::align_val_t(kHugePageSize)));
+#endif
+    Region& region = regions_[base];
+    region.size_ = size;
+    region.backing_ = backing;
+    switch (backing) {
+    case Backing::EXPLICIT:    stats_.explicit_bytes_ += size; break;
+    case Backing::TRANSPARENT: stats_.transparent_bytes_ += size; break;
+    case Backing::REGULAR:     stats_.regular_bytes_ += size; break;
+    }
+    return base;
+}
+
+void HugePageResource::UnmapLocked(std::map<char*, Region>::iterator it) {
+    const Region& region = it->second;
+    switch (region.backing_) {
+    case Backing::EXPLICIT:    stats_.explicit_bytes_ -= region.size_; break;
+    case Backing::TRANSPARENT: stats_.transparent_bytes_ -= region.size_; break;
+    case Backing::REGULAR:     stats_.regular_bytes_ -= region.size_; break;
+    }
+#ifdef __linux__
+    munmap(it->first, region.size_);
+#else
+    ::operator delete(it->first, std::align_val_t(kHugePageSize));
+#endif
+    if (it->first == current_) {
+        current_ = nullptr;
+    }
+    regions_.erase(it);
+}
+
+/**
+ * @brief 透明大页的实际用量：按 /proc/self/smaps 中每个映射的 AnonHugePages，
+ * 按我们的区域占该映射的比例计入 (内核会把相邻的同类映射合并成一个)
+ */
+HugePageStats HugePageResource::GetStats() const {
+    HugePageStats stats;
+    std::vector<std::pair<uintptr_t, uintptr_t>> transparent; // [begin, end)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats = stats_;
+        for (const auto& pair : regions_) {
+            if (pair.second.backing_ == Backing::TRANSPARENT) {
+                uintptr_t begin = reinterpret_cast<uintptr_t>(pair.first);
+                transparent.emplace_back(begin, begin + pair.second.size_);
+            }
+        }
+    }
+#ifdef __linux__
+    if (transparent.empty()) {
+        return stats;
+    }
+    FILE* smaps = fopen("/proc/self/smaps", "r");
+    if (smaps == nullptr) {
+        return stats;
+    }
+    char line[4096]; // 足够放下映射行中的路径
+    uintptr_t vma_begin = 0;
+    uintptr_t vma_end = 0;
+    while (fgets(line, sizeof(line), smaps) != nullptr) {
+        uintmax_t begin = 0;
+        uintmax_t end = 0;
+        unsigned long long kb = 0;
+        if (sscanf(line, "%jx-%jx ", &begin, &end) == 2) {
+            vma_begin = static_cast<uintptr_t>(begin);
+            vma_end = static_cast<uintptr_t>(end);
+        } else if (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1 && kb > 0 && vma_end > vma_begin) {
+            uintptr_t overlap = 0;
+            for (const auto& range : transparent) {
+                uintptr_t lo = std::max(range.first, vma_begin);
+                uintptr_t hi = std::min(range.second, vma_end);
+                if (lo < hi) {
+                    overlap += hi - lo;
+                }
+            }
+            stats.transparent_huge_bytes_ += static_cast<uint64_t>(
+                static_cast<double>(kb) * 1024 * overlap / (vma_end - vma_begin));
+        }
+    }
+    fclose(smaps);
+#endif
+    return stats;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory_resource>
+#include <map>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 大页模式
+ * NONE:        普通 4KB 页 (不使用 HugePageResource)
+ * TRANSPARENT: 按 2MB 对齐映射并 madvise(MADV_HUGEPAGE)，由内核的透明大页 (THP) 决定是否合并成大页
+ * EXPLICIT:    先尝试显式大页 (MAP_HUGETLB，需要预留 vm.nr_hugepages)，失败时退回 TRANSPARENT
+ * 不是 Linux 或者系统不支持时都退回普通页，不会失败。
+ */
+enum class HugePageMode { NONE, TRANSPARENT, EXPLICIT };
+
+/**
+ * @brief HugePageStats (大页统计，当前仍在映射中的字节数)
+ */
+struct HugePageStats {
+    uint64_t explicit_bytes_ = 0;       // 显式大页 (MAP_HUGETLB)
+    uint64_t transparent_bytes_ = 0;    // 请求了透明大页的映射
+    uint64_t transparent_huge_bytes_ = 0; // 其中内核实际放在大页上的字节数 (/proc/self/smaps 的 AnonHugePages)
+    uint64_t regular_bytes_ = 0;        // 退回普通页的映射
+
+    HugePageStats& operator+=(const HugePageStats& other) {
+        explicit_bytes_ += other.explicit_bytes_;
+        transparent_bytes_ += other.transparent_bytes_;
+        transparent_huge_bytes_ += other.transparent_huge_bytes_;
+        regular_bytes_ += other.regular_bytes_;
+        return *this;
+    }
+};
+
+/**
+ * @brief HugePageResource (大页内存资源)
+ * 职责：以 2MB 大页为单位向操作系统申请内存，作为其它内存资源 (MemTable 的 Arena、块缓存的内存池)
+ * 的上游，让这些大块、随机访问的内存占用更少的 TLB 条目。
+ *
+ * 不小于 2MB 的请求单独映射 (向上取整到 2MB 的倍数)，释放时立即归还；
+ * 更小的请求从当前的 2MB 区域中顺序切出，区域中的请求全部释放后整个区域归还。
+ * (上游的调用方都是按块批量申请的内存池，小请求不多，不需要更复杂的空闲链表)
+ *
+ * 线程安全：可以被多个线程并发调用。
+ */
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    explicit HugePageResource(HugePageMode mode);
+
+    /**
+     * @brief 析构函数：归还所有映射 (调用方必须先释放所有分配出去的内存)
+     */
+    ~HugePageResource() override;
+
+    // 禁用拷贝和赋值
+    HugePageResource(const HugePageResource&) = delete;
+    HugePageResource& operator=(const HugePageResource&) = delete;
+
+    HugePageMode mode() const { return mode_; }
+
+    /**
+     * @brief 当前的映射统计 (透明大页的实际用量需要读 /proc/self/smaps，调用开销较大)
+     */
+    HugePageStats GetStats() const;
+
+private:
+    enum class Backing { EXPLICIT, TRANSPARENT, REGULAR };
+
+    struct Region {
+        size_t size_ = 0;    // 映射的字节数
+        Backing backing_ = Backing::REGULAR;
+        size_t used_ = 0;    // 小请求：已经切出的字节数
+        size_t live_ = 0;    // 小请求：尚未释放的分配数
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    // (私有, 需持有锁) 映射一段 size 字节 (2MB 的倍数) 的内存并登记
+    char* MapLocked(size_t size);
+
+    // (私有, 需持有锁) 归还一段映射
+    void UnmapLocked(std::map<char*, Region>::iterator it);
+
+    const HugePageMode mode_;
+    mutable std::mutex mutex_;
+    std::map<char*, Region> regions_; // 起始地址 -> 映射
+    char* current_;                   // 当前用来切小请求的区域 (可以为空)
+    HugePageStats stats_;             // transparent_huge_bytes_ 在 GetStats() 时计算
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string_view>
+
+/**
+ * @brief Iterator (迭代器) - 按 Key 升序遍历 K/V 的抽象接口
+ * SSTable、多路归并等都通过这个接口向上层 (Compaction / Scan) 提供数据。
+ *
+ * key() / value() 返回的视图只在下一次移动迭代器之前有效。
+ */
+class Iterator {
+public:
+    Iterator() = default;
+    virtual ~Iterator() = default;
+
+    // 禁用拷贝和赋值
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+
+    /**
+     * @brief 迭代器当前是否指向一个有效的条目
+     */
+    virtual bool Valid() const = 0;
+
+    /**
+     * @brief 定位到第一个条目
+     */
+    virtual void SeekToFirst() = 0;
+
+    /**
+     * @brief 定位到第一个 Key >= target 的条目
+     */
+    virtual void Seek(std::string_view target) = 0;
+
+    /**
+     * @brief 移动到下一个条目 (要求 Valid())
+     */
+    virtual void Next() = 0;
+
+    virtual std::string_view key() const = 0;
+    virtual std::string_view value() const = 0;
+
+    /**
+     * @brief 遍历过程中是否遇到了错误 (如 I/O 失败、块损坏)
+     */
+    virtual bool ok() const = 0;
+};
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "db.h"
+#include "resp.h"
+#include "binproto.h"
+#include "kvserver.h"
+#include "shardeddb.h"
+#include "netutil.h"
+
+namespace {
+
+struct BenchOptions {
+    std::vector<int> conns_ = {1, 4, 16, 64};
+    int pipeline_ = 1;
+    double seconds_ = 2.0;
+    int server_threads_ = 1;
+    int keys_ = 10000;
+    size_t value_size_ = 100;
+    int shards_ = 0; // > 0 时使用分片模式
+    bool binary_ = false; // 使用二进制协议
+};
+
+struct BenchConnection {
+    int fd_ = -1;
+    std::string in_;
+    int pending_ = 0; // 已发送但未收到回复的命令数
+};
+
+std::string BenchKey(int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+}
+
+/**
+ * @brief 用 num_conns 个连接压测 seconds 秒，返回完成的命令数
+ */
+uint64_t RunClients(int port, int num_conns, const BenchOptions& options, double* elapsed) {
+    std::mt19937 rng(num_conns);
+    std::string value(options.value_size_, 'v');
+    std::string request;
+
+    auto send_batch = [&](BenchConnection* conn) {
+        request.clear();
+        for (int i = 0; i < options.pipeline_; i++) {
+            std::string key = BenchKey(rng() % options.keys_);
+            bool get = (rng() % 2 == 0);
+            if (options.binary_ && get) {
+                EncodeGetRequest(&request, i, key);
+            } else if (options.binary_) {
+                EncodePutRequest(&request, i, key, value);
+            } else if (get) {
+                AppendRespCommand(&request, {"GET", key});
+            } else {
+                AppendRespCommand(&request, {"SET", key, value});
+            }
+        }
+        conn->pending_ = options.pipeline_;
+        return SendAll(conn->fd_, request);
+    };
+
+    int epoll_fd = epoll_create1(0);
+    std::vector<BenchConnection> conns(num_conns);
+    for (int i = 0; i < num_conns; i++) {
+        conns[i].fd_ = ConnectTo("127.0.0.1:" + std::to_string(port));
+        if (conns[i].fd_ < 0) {
+            std::cerr << "错误: 无法连接服务器: " << strerror(errno) << std::endl;
+            return 0;
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conns[i].fd_, &ev);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(options.seconds_);
+    for (auto& conn : conns) {
+        send_batch(&conn);
+    }
+
+    uint64_t ops = 0;
+    int outstanding = num_conns; // 仍有未完成批次的连接数
+    std::vector<epoll_event> events(num_conns);
+    char buf[64 * 1024];
+    while (outstanding > 0) {
+        int n = epoll_wait(epoll_fd, events.data(), num_conns, 1000);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+        bool running = std::chrono::steady_clock::now() < deadline;
+        for (int i = 0; i < n; i++) {
+            BenchConnection* conn = &conns[events[i].data.u32];
+            ssize_t r = read(conn->fd_, buf, sizeof(buf));
+            if (r <= 0) {
+                std::cerr << "错误: 连接被关闭" << std::endl;
+                outstanding = 0;
+                break;
+            }
+            conn->in_.append(buf, r);
+            size_t pos = 0, consumed = 0;
+            BinFrame frame;
+            auto parse_reply = [&] {
+                std::string_view input = std::string_view(conn->in_).substr(pos);
+                return options.binary_
+                    ? ParseBinFrame(input, &frame, &consumed) == BinParseResult::OK
+                    : ParseRespReply(input, &consumed) == RespParseResult::OK;
+            };
+            while (conn->pending_ > 0 && parse_reply()) {
+                pos += consumed;
+                conn->pending_--;
+                ops++;
+            }
+            conn->in_.erase(0, pos);
+            if (conn->pending_ == 0) {
+                if (!running || !send_batch(conn)) {
+                    outstanding--;
+                }
+            }
+        }
+    }
+    *elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto& conn : conns) {
+        close(conn.fd_);
+    }
+    close(epoll_fd);
+    return ops;
+}
+
+std::vector<int> ParseList(const std::string& s) {
+    std::vector<int> values;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+} // namespace
+
+/**
+ * @brief kv_bench: 在进程内启动 RESP 服务器，通过回环地址测量不同连接数下的吞吐量
+ * 用法: kv_bench [--conns 1,4,16,64] [--pipeline 1] [--seconds 2] [--threads 1]
+ *                [--keys 10000] [--value-size 100] [--shards 0] [--protocol resp|binary]
+ * 每个连接一次发送 pipeline 条命令 (GET/SET 各半)，收齐回复后再发送下一批。
+ */
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string arg = argv[i + 1];
+        if (flag == "--conns") {
+            options.conns_ = ParseList(arg);
+        } else if (flag == "--pipeline") {
+            options.pipeline_ = std::max(1, std::atoi(arg.c_str()));
+        } else if (flag == "--seconds") {
+            options.seconds_ = std::atof(arg.c_str());
+        } else if (flag == "--threads") {
+            options.server_threads_ = std::atoi(arg.c_str());
+        } else if (flag == "--keys") {
+            options.keys_ = std::max(1, std::atoi(arg.c_str()));
+        } else if (flag == "--protocol") {
+            options.binary_ = (arg == "binary");
+        } else if (flag == "--shards") {
+            options.shards_ = std::atoi(arg.c_str());
+        } else if (flag == "--value-size") {
+            options.value_size_ = std::atoi(arg.c_str());
+        } else {
+            std::cerr << "未知参数: " << flag << std::endl;
+            return 1;
+        }
+    }
+    DebugLogEnabled() = false;
+
+    const std::string dbname = "kv_bench_db";
+    std::filesystem::remove_all(dbname);
+    ServerOptions server_options;
+    server_options.port_ = 0;
+    server_options.num_threads_ = options.server_threads_;
+    server_options.protocol_ = options.binary_ ? ServerProtocol::BINARY : ServerProtocol::RESP;
+    std::string value(options.value_size_, 'v');
+    std::unique_ptr<DB> db;
+    std::unique_ptr<ShardedDB> sharded;
+    std::unique_ptr<KVServer> server;
+    if (options.shards_ > 0) {
+        ShardedOptions sharded_options;
+        sharded_options.num_shards_ = options.shards_;
+        sharded_options.max_sessions_ = std::max(1, options.server_threads_) + 1;
+        sharded = ShardedDB::Open(dbname, sharded_options);
+        if (sharded == nullptr) {
+            return 1;
+        }
+        std::unique_ptr<ShardSession> session = sharded->NewSession();
+        for (int i = 0; i < options.keys_; i++) {
+            session->Put(BenchKey(i), value);
+        }
+        sharded->WaitForIdle();
+        server = std::make_unique<KVServer>(sharded.get(), server_options);
+    } else {
+        db = DB::Open(dbname, Options());
+        if (db == nullptr) {
+            return 1;
+        }
+        for (int i = 0; i < options.keys_; i++) {
+            db->Put(BenchKey(i), value);
+        }
+        db->WaitForIdle();
+        server = std::make_unique<KVServer>(db.get(), server_options);
+    }
+    if (!server->Start()) {
+        return 1;
+    }
+
+    std::cout << std::setw(8) << "conns" << std::setw(10) << "pipeline"
+              << std::setw(14) << "ops/sec" << std::setw(12) << "us/op" << std::endl;
+    for (int conns : options.conns_) {
+        double elapsed = 0;
+        uint64_t ops = RunClients(server->port(), conns, options, &elapsed);
+        std::cout << std::setw(8) << conns << std::setw(10) << options.pipeline_
+                  << std::setw(14) << static_cast<uint64_t>(ops / elapsed)
+                  << std::setw(12) << std::fixed << std::setprecision(2)
+                  << (ops > 0 ? elapsed * 1e6 / ops : 0.0) << std::endl;
+    }
+    server.reset();
+    db.reset();
+    sharded.reset();
+    std::filesystem::remove_all(dbname);
+    return 0;
+}
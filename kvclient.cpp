@@ -0,0 +1,275 @@
+#include "kvclient.h"
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "netutil.h"
+#include "writebatch.h"
+
+namespace {
+
+/**
+ * @brief 读取数据追加到 buffer
+ * @param block 为 false 时没有数据可读立即返回 true
+ */
+bool ReadSome(int fd, std::string* buffer, bool block) {
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), block ? 0 : MSG_DONTWAIT);
+        if (n > 0) {
+            buffer->append(buf, n);
+            return true;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && !block && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        return false; // 连接关闭或出错
+    }
+}
+
+uint32_t NextId(std::mutex* mutex, uint32_t* next_id) {
+    std::lock_guard<std::mutex> lock(*mutex);
+    return (*next_id)++;
+}
+
+} // namespace
+
+// --- ClientPipeline ---
+
+ClientPipeline::ClientPipeline(KVClient* client, int fd)
+    : client_(client), fd_(fd), ok_(true), next_id_(1), buffered_(0) {}
+
+ClientPipeline::~ClientPipeline() {
+    Wait();
+    if (ok_) {
+        client_->Release(fd_);
+    } else {
+        close(fd_);
+        client_->Release(ConnectTo(client_->Address()));
+    }
+}
+
+void ClientPipeline::Get(std::string_view key, GetCallback done) {
+    uint32_t id = next_id_++;
+    EncodeGetRequest(&send_buffer_, id, key);
+    Enqueue(id, Callback{std::move(done), nullptr});
+}
+
+void ClientPipeline::Put(std::string_view key, std::string_view value, DoneCallback done) {
+    uint32_t id = next_id_++;
+    EncodePutRequest(&send_buffer_, id, key, value);
+    Enqueue(id, Callback{nullptr, std::move(done)});
+}
+
+void ClientPipeline::Delete(std::string_view key, DoneCallback done) {
+    uint32_t id = next_id_++;
+    EncodeDeleteRequest(&send_buffer_, id, key);
+    Enqueue(id, Callback{nullptr, std::move(done)});
+}
+
+void ClientPipeline::Enqueue(uint32_t id, Callback callback) {
+    callbacks_.emplace(id, std::move(callback));
+    if (++buffered_ >= client_->options_.max_batch_) {
+        Flush();
+    }
+}
+
+bool ClientPipeline::Flush() {
+    if (!ok_) {
+        return false;
+    }
+    if (buffered_ > 0) {
+        ok_ = SendAll(fd_, send_buffer_);
+        send_buffer_.clear();
+        buffered_ = 0;
+    }
+    // 顺便处理已经到达的回复，避免回复在 socket 中堆积
+    ok_ = ok_ && ReadSome(fd_, &recv_buffer_, false);
+    return ok_ && ReadReplies();
+}
+
+bool ClientPipeline::Wait() {
+    Flush();
+    while (ok_ && !callbacks_.empty()) {
+        ok_ = ReadSome(fd_, &recv_buffer_, true) && ReadReplies();
+    }
+    if (!ok_) {
+        // 连接出错：未完成的请求全部以失败结束
+        for (auto& pair : callbacks_) {
+            if (pair.second.get_) pair.second.get_(false, std::string_view());
+            if (pair.second.done_) pair.second.done_(false);
+        }
+        callbacks_.clear();
+    }
+    return ok_;
+}
+
+bool ClientPipeline::ReadReplies() {
+    std::string_view input = recv_buffer_;
+    size_t pos = 0;
+    while (true) {
+        BinFrame frame;
+        size_t consumed = 0;
+        BinParseResult result = ParseBinFrame(input.substr(pos), &frame, &consumed);
+        if (result == BinParseResult::INCOMPLETE) {
+            break;
+        }
+        if (result == BinParseResult::ERROR) {
+            return false;
+        }
+        pos += consumed;
+        auto it = callbacks_.find(frame.request_id_);
+        if (it == callbacks_.end()) {
+            continue; // 不认识的回复
+        }
+        BinStatus status = static_cast<BinStatus>(frame.code_);
+        if (it->second.get_) {
+            it->second.get_(status == BinStatus::OK, frame.payload_);
+        }
+        if (it->second.done_) {
+            it->second.done_(status == BinStatus::OK);
+        }
+        callbacks_.erase(it);
+    }
+    recv_buffer_.erase(0, pos);
+    return true;
+}
+
+// --- KVClient ---
+
+std::unique_ptr<KVClient> KVClient::Connect(const ClientOptions& options) {
+    std::unique_ptr<KVClient> client(new KVClient(options));
+    for (int i = 0; i < std::max(1, options.pool_size_); i++) {
+        int fd = ConnectTo(client->Address());
+        if (fd < 0) {
+            std::cerr << "错误: 无法连接 " << options.host_ << ":" << options.port_
+                      << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+        client->free_.push_back(fd);
+    }
+    return client;
+}
+
+KVClient::~KVClient() {
+    for (int fd : free_) {
+        close(fd);
+    }
+}
+
+int KVClient::Acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !free_.empty(); });
+    int fd = free_.back();
+    free_.pop_back();
+    return fd;
+}
+
+void KVClient::Release(int fd) {
+    if (fd < 0) {
+        return; // 重连失败，连接池变小
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(fd);
+    }
+    cv_.notify_one();
+}
+
+std::unique_ptr<ClientPipeline> KVClient::NewPipeline() {
+    return std::unique_ptr<ClientPipeline>(new ClientPipeline(this, Acquire()));
+}
+
+bool KVClient::Call(const std::string& request, uint32_t request_id, BinFrame* reply,
+                    std::string* reply_storage) {
+    int fd = Acquire();
+    reply_storage->clear();
+    bool ok = SendAll(fd, request);
+    while (ok) {
+        size_t consumed = 0;
+        BinParseResult result = ParseBinFrame(*reply_storage, reply, &consumed);
+        if (result == BinParseResult::OK && reply->request_id_ == request_id) {
+            break;
+        }
+        ok = (result == BinParseResult::INCOMPLETE) && ReadSome(fd, reply_storage, true);
+    }
+    if (ok) {
+        Release(fd);
+    } else {
+        std::cerr << "错误: 与服务器的连接中断" << std::endl;
+        close(fd);
+        Release(ConnectTo(Address()));
+    }
+    return ok;
+}
+
+bool KVClient::Ping() {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodePingRequest(&request, id);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) && reply.code_ == static_cast<uint8_t>(BinStatus::OK);
+}
+
+bool KVClient::Get(std::string_view key, std::string* value) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodeGetRequest(&request, id, key);
+    BinFrame reply;
+    if (!Call(request, id, &reply, &storage) || reply.code_ != static_cast<uint8_t>(BinStatus::OK)) {
+        return false;
+    }
+    value->assign(reply.payload_.data(), reply.payload_.size());
+    return true;
+}
+
+bool KVClient::Put(std::string_view key, std::string_view value) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodePutRequest(&request, id, key, value);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) && reply.code_ == static_cast<uint8_t>(BinStatus::OK);
+}
+
+bool KVClient::Delete(std::string_view key) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodeDeleteRequest(&request, id, key);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) && reply.code_ == static_cast<uint8_t>(BinStatus::OK);
+}
+
+bool KVClient::Write(const WriteBatch& batch) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodeWriteBatchRequest(&request, id, batch);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) && reply.code_ == static_cast<uint8_t>(BinStatus::OK);
+}
+
+bool KVClient::MultiGet(const std::vector<std::string_view>& keys,
+                        std::vector<std::string>* values, std::vector<bool>* found) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodeMultiGetRequest(&request, id, keys);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) &&
+           reply.code_ == static_cast<uint8_t>(BinStatus::OK) &&
+           DecodeMultiGetReply(reply.payload_, values, found);
+}
+
+bool KVClient::Scan(std::string_view start, uint32_t limit,
+                    std::vector<std::pair<std::string, std::string>>* results) {
+    std::string request, storage;
+    uint32_t id = NextId(&mutex_, &next_id_);
+    EncodeScanRequest(&request, id, start, limit);
+    BinFrame reply;
+    return Call(request, id, &reply, &storage) &&
+           reply.code_ == static_cast<uint8_t>(BinStatus::OK) &&
+           DecodeScanReply(reply.payload_, results);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include "binproto.h"
+
+class WriteBatch;
+
+/**
+ * @brief ClientOptions (客户端选项)
+ */
+struct ClientOptions {
+    std::string host_ = "127.0.0.1";
+    int port_ = 6380;
+
+    // 连接池中的连接数 (同步调用和 Pipeline 都从池中借用连接)
+    int pool_size_ = 4;
+
+    // Pipeline 缓冲的请求数达到这个值时自动发送
+    size_t max_batch_ = 64;
+};
+
+class KVClient;
+
+/**
+ * @brief ClientPipeline (自动批量的流水线)
+ * 职责：在一个借来的连接上异步发送请求。
+ * 请求先编码进本地缓冲区，攒够 max_batch_ 个 (或调用 Flush/Wait) 时用一次 send 发出；
+ * 回复按 request_id 匹配到各自的回调，因此服务端可以乱序回复。
+ * 一个 Pipeline 只能被一个线程使用。
+ */
+class ClientPipeline {
+public:
+    using GetCallback = std::function<void(bool found, std::string_view value)>;
+    using DoneCallback = std::function<void(bool ok)>;
+
+    ~ClientPipeline();
+
+    // 禁用拷贝和赋值
+    ClientPipeline(const ClientPipeline&) = delete;
+    ClientPipeline& operator=(const ClientPipeline&) = delete;
+
+    void Get(std::string_view key, GetCallback done);
+    void Put(std::string_view key, std::string_view value, DoneCallback done = nullptr);
+    void Delete(std::string_view key, DoneCallback done = nullptr);
+
+    /**
+     * @brief 立即发送所有缓冲的请求 (不等待回复)
+     */
+    bool Flush();
+
+    /**
+     * @brief 发送所有缓冲的请求，并等待所有未完成的回复 (回调在这里被调用)
+     * @return false 如果连接出错
+     */
+    bool Wait();
+
+    /**
+     * @brief 已发送 (或已缓冲) 但未收到回复的请求数
+     */
+    size_t Pending() const { return callbacks_.size(); }
+
+private:
+    friend class KVClient;
+
+    struct Callback {
+        GetCallback get_;
+        DoneCallback done_;
+    };
+
+    ClientPipeline(KVClient* client, int fd);
+
+    /**
+     * @brief (私有) 登记一个请求；缓冲区满时自动发送
+     */
+    void Enqueue(uint32_t id, Callback callback);
+
+    /**
+     * @brief (私有) 读取并分发至少一个回复
+     */
+    bool ReadReplies();
+
+    KVClient* client_;
+    int fd_;
+    bool ok_;
+    uint32_t next_id_;
+    size_t buffered_;                 // 已编码但尚未发送的请求数
+    std::string send_buffer_;
+    std::string recv_buffer_;
+    std::unordered_map<uint32_t, Callback> callbacks_;
+};
+
+/**
+ * @brief KVClient (二进制协议客户端)
+ * 职责：维护到服务器的连接池，提供同步接口和自动批量的 Pipeline。
+ * 同步接口是线程安全的：每次调用从池中借出一个连接，用完归还。
+ * (仅支持 Linux)
+ */
+class KVClient {
+public:
+    /**
+     * @brief 连接服务器 (建立 pool_size_ 个连接)
+     * @return 失败时返回 nullptr
+     */
+    static std::unique_ptr<KVClient> Connect(const ClientOptions& options);
+
+    ~KVClient();
+
+    // 禁用拷贝和赋值
+    KVClient(const KVClient&) = delete;
+    KVClient& operator=(const KVClient&) = delete;
+
+    bool Ping();
+    bool Get(std::string_view key, std::string* value);
+    bool Put(std::string_view key, std::string_view value);
+    bool Delete(std::string_view key);
+    bool Write(const WriteBatch& batch);
+    bool MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found);
+    bool Scan(std::string_view start, uint32_t limit,
+              std::vector<std::pair<std::string, std::string>>* results);
+
+    /**
+     * @brief 借出一个连接创建 Pipeline (Pipeline 销毁时归还连接；池空时等待)
+     */
+    std::unique_ptr<ClientPipeline> NewPipeline();
+
+    const ClientOptions& options() const { return options_; }
+
+private:
+    friend class ClientPipeline;
+
+    explicit KVClient(const ClientOptions& options) : options_(options) {}
+
+    std::string Address() const { return options_.host_ + ":" + std::to_string(options_.port_); }
+
+    int Acquire();
+    void Release(int fd);
+
+    /**
+     * @brief (私有) 在一个连接上发送一个请求并等待它的回复
+     * @param reply_storage [out] 回复帧的存储 (frame 的 payload 指向它)
+     */
+    bool Call(const std::string& request, uint32_t request_id, BinFrame* reply,
+              std::string* reply_storage);
+
+    ClientOptions options_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<int> free_;  // 空闲连接
+    uint32_t next_id_ = 1;   // 同步调用的 request_id (由 mutex_ 保护)
+};
@@ -0,0 +1,375 @@
+#include "kvserver.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "resp.h"
+#include "binproto.h"
+#include "outputbuffer.h"
+#include "db.h"
+#include "shardeddb.h"
+
+namespace {
+
+/**
+ * @brief 一个客户端连接
+ */
+struct Connection {
+    int fd_ = -1;
+    std::string in_;          // 已读取但尚未解析的数据
+    OutputBuffer out_;        // 待发送的回复
+    bool want_write_ = false; // 是否注册了 EPOLLOUT
+    bool want_read_ = true;   // 是否注册了 EPOLLIN (回复积压超过高水位时暂停)
+    bool read_more_ = false;  // 上次读取达到单次上限，socket 中可能还有数据 (需要重新注册事件)
+    bool closing_ = false;    // 回复发送完后关闭 (QUIT 或协议错误)
+};
+
+} // namespace
+
+/**
+ * @brief 一个事件循环线程的状态
+ */
+struct KVServer::Loop {
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd，Stop() 时写入以唤醒 epoll_wait
+    std::unique_ptr<ShardSession> session_; // 分片模式下本线程的会话
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+
+    ~Loop() {
+        for (auto& pair : connections_) {
+            close(pair.first);
+        }
+        if (listen_fd_ >= 0) close(listen_fd_);
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+    }
+};
+
+KVServer::KVServer(KVStore* store, const ServerOptions& options)
+    : store_(store), sharded_(nullptr), options_(options), port_(options.port_) {}
+
+KVServer::KVServer(ShardedDB* sharded, const ServerOptions& options)
+    : store_(nullptr), sharded_(sharded), options_(options), port_(options.port_) {}
+
+KVServer::~KVServer() {
+    Stop();
+}
+
+int KVServer::CreateListenSocket(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "错误: socket() 失败: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, options_.host_.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "错误: 无效的监听地址 " << options_.host_ << std::endl;
+        close(fd);
+        return -1;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        std::cerr << "错误: 无法监听 " << options_.host_ << ":" << port
+                  << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool KVServer::Start() {
+    int num_threads = std::max(1, options_.num_threads_);
+    for (int i = 0; i < num_threads; i++) {
+        auto loop = std::make_unique<Loop>();
+        loop->listen_fd_ = CreateListenSocket(port_);
+        if (loop->listen_fd_ < 0) {
+            Stop();
+            return false;
+        }
+        if (port_ == 0) {
+            // 第一个 socket 由系统分配端口，其余线程绑定到同一个端口
+            sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            getsockname(loop->listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+        }
+        loop->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->epoll_fd_ < 0 || loop->wake_fd_ < 0) {
+            std::cerr << "错误: 无法创建 epoll/eventfd: " << strerror(errno) << std::endl;
+            Stop();
+            return false;
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN; // 监听 socket 用水平触发，每次只需 accept 到 EAGAIN
+        ev.data.fd = loop->listen_fd_;
+        epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, loop->listen_fd_, &ev);
+        ev.data.fd = loop->wake_fd_;
+        epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, loop->wake_fd_, &ev);
+        if (sharded_ != nullptr) {
+            loop->session_ = sharded_->NewSession();
+            if (loop->session_ == nullptr) {
+                Stop();
+                return false;
+            }
+        }
+        loops_.push_back(std::move(loop));
+    }
+    for (auto& loop : loops_) {
+        threads_.emplace_back(&KVServer::RunLoop, this, loop.get());
+    }
+    return true;
+}
+
+void KVServer::Stop() {
+    for (auto& loop : loops_) {
+        uint64_t one = 1;
+        ssize_t n = write(loop->wake_fd_, &one, sizeof(one));
+        (void)n;
+    }
+    for (auto& t : threads_) {
+        t.join();
+    }
+    threads_.clear();
+    loops_.clear();
+}
+
+namespace {
+
+// 每次 writev 最多使用的 iovec 数
+const int MAX_IOVECS = 64;
+
+/**
+ * @brief 尽可能多地发送 out_ (每个输出块一个 iovec)；返回 false 表示连接出错
+ */
+bool FlushOutput(Connection* conn) {
+    iovec iov[MAX_IOVECS];
+    while (!conn->out_.Empty()) {
+        int count = 0;
+        for (size_t i = 0; i < conn->out_.ChunkCount() && count < MAX_IOVECS; i++) {
+            std::string_view chunk = conn->out_.Chunk(i);
+            if (!chunk.empty()) {
+                iov[count].iov_base = const_cast<char*>(chunk.data());
+                iov[count].iov_len = chunk.size();
+                count++;
+            }
+        }
+        // sendmsg + MSG_NOSIGNAL: 对方已关闭时返回 EPIPE 而不是触发 SIGPIPE
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = sendmsg(conn->fd_, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->out_.Consume(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 读空 socket (边沿触发必须读到 EAGAIN)，最多读 max_bytes 字节；返回 false 表示对方关闭或出错
+ * (达到上限时设置 read_more_，由调用方重新注册事件)
+ */
+bool ReadInput(Connection* conn, size_t chunk_size, size_t max_bytes) {
+    for (size_t total = 0;;) {
+        if (total >= max_bytes) {
+            conn->read_more_ = true;
+            return true;
+        }
+        chunk_size = std::min(chunk_size, max_bytes - total);
+        size_t old_size = conn->in_.size();
+        conn->in_.resize(old_size + chunk_size);
+        ssize_t n = read(conn->fd_, &conn->in_[old_size], chunk_size);
+        conn->in_.resize(old_size + std::max<ssize_t>(n, 0));
+        if (n > 0) {
+            total += n;
+            continue;
+        } else if (n == 0) {
+            return false;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief 解析并执行 in_ 中所有完整的 RESP 命令，回复追加到 out_
+ * (协议错误时回复错误并标记关闭)
+ */
+void ProcessRespInput(Connection* conn, RespCommandHandler* handler,
+                      std::vector<std::string_view>* args) {
+    std::string_view input = conn->in_;
+    std::string* out = conn->out_.Tail();
+    size_t pos = 0;
+    while (!conn->closing_ && pos < input.size()) {
+        size_t consumed = 0;
+        RespParseResult result = ParseRespCommand(input.substr(pos), args, &consumed);
+        if (result == RespParseResult::INCOMPLETE) {
+            break;
+        }
+        if (result == RespParseResult::ERROR) {
+            AppendError(out, "ERR Protocol error");
+            conn->closing_ = true;
+            break;
+        }
+        pos += consumed;
+        if (!handler->Execute(*args, out)) {
+            conn->closing_ = true;
+        }
+    }
+    conn->in_.erase(0, pos);
+    conn->out_.Commit();
+}
+
+/**
+ * @brief 解析并执行 in_ 中所有完整的二进制请求帧，回复追加到 out_
+ * (帧长度非法时直接关闭连接)
+ */
+void ProcessBinaryInput(Connection* conn, BinCommandHandler* handler) {
+    std::string_view input = conn->in_;
+    size_t pos = 0;
+    while (pos < input.size()) {
+        BinFrame frame;
+        size_t consumed = 0;
+        BinParseResult result = ParseBinFrame(input.substr(pos), &frame, &consumed);
+        if (result == BinParseResult::INCOMPLETE) {
+            break;
+        }
+        if (result == BinParseResult::ERROR) {
+            conn->closing_ = true;
+            break;
+        }
+        handler->Execute(frame, &conn->out_);
+        pos += consumed;
+    }
+    conn->in_.erase(0, pos);
+    conn->out_.Commit();
+}
+
+} // namespace
+
+void KVServer::RunLoop(Loop* loop) {
+    KVStore* store = (loop->session_ != nullptr) ? static_cast<KVStore*>(loop->session_.get()) : store_;
+    RespCommandHandler resp_handler(store);
+    BinCommandHandler binary_handler(store);
+    std::vector<epoll_event> events(std::max(1, options_.max_events_));
+    std::vector<std::string_view> args;
+
+    auto close_connection = [loop](int fd) {
+        epoll_ctl(loop->epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        loop->connections_.erase(fd);
+    };
+
+    while (true) {
+        int n = epoll_wait(loop->epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "错误: epoll_wait 失败: " << strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == loop->wake_fd_) {
+                return; // Stop()
+            }
+            if (fd == loop->listen_fd_) {
+                while (true) {
+                    int client = accept4(loop->listen_fd_, nullptr, nullptr,
+                                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0) {
+                        break; // EAGAIN 或暂时性错误
+                    }
+                    int one = 1;
+                    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    auto conn = std::make_unique<Connection>();
+                    conn->fd_ = client;
+                    epoll_event ev;
+                    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                    ev.data.fd = client;
+                    epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, client, &ev);
+                    loop->connections_.emplace(client, std::move(conn));
+                }
+                continue;
+            }
+
+            auto it = loop->connections_.find(fd);
+            if (it == loop->connections_.end()) {
+                continue;
+            }
+            Connection* conn = it->second.get();
+            bool alive = true;
+            if (conn->want_read_ && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                // 对方半关闭时仍然处理已读到的命令并尝试回复
+                alive = ReadInput(conn, options_.read_chunk_size_, options_.max_read_per_event_);
+                if (options_.protocol_ == ServerProtocol::BINARY) {
+                    ProcessBinaryInput(conn, &binary_handler);
+                } else {
+                    ProcessRespInput(conn, &resp_handler, &args);
+                }
+                if (!conn->closing_ && conn->in_.size() > options_.max_query_buffer_) {
+                    // 处理完之后还剩这么多，说明是一个声明得很大却迟迟不完整的请求
+                    if (options_.protocol_ == ServerProtocol::RESP) {
+                        AppendError(conn->out_.Tail(), "ERR Protocol error");
+                        conn->out_.Commit();
+                    }
+                    conn->closing_ = true;
+                    std::string().swap(conn->in_);
+                }
+            }
+            if (!FlushOutput(conn)) {
+                alive = false;
+            }
+            bool pending = !conn->out_.Empty();
+            if (!alive || (conn->closing_ && !pending)) {
+                close_connection(fd);
+                continue;
+            }
+            const bool want_read = !conn->closing_ && conn->out_.Size() < options_.output_high_water_;
+            if (pending != conn->want_write_ || want_read != conn->want_read_ || (want_read && conn->read_more_)) {
+                // 只在发送缓冲区满时关注 EPOLLOUT，避免无意义的唤醒；回复积压或连接即将关闭时不关注 EPOLLIN。
+                // EPOLL_CTL_MOD 会重新检查就绪状态：socket 中还有数据时 (读取达到上限，或者暂停期间到达)
+                // 边沿触发也会再产生一次 EPOLLIN
+                epoll_event ev;
+                ev.events = EPOLLRDHUP | EPOLLET | (want_read ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                            (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+                ev.data.fd = fd;
+                epoll_ctl(loop->epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                conn->want_write_ = pending;
+                conn->want_read_ = want_read;
+                conn->read_more_ = false;
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+class KVStore;
+class ShardedDB;
+
+/**
+ * @brief 服务器使用的协议
+ */
+enum class ServerProtocol {
+    RESP,    // Redis 协议 (文本，可以用 redis-cli 连接)
+    BINARY,  // 长度前缀的二进制协议 (见 binproto.h)
+};
+
+/**
+ * @brief ServerOptions (服务器选项)
+ */
+struct ServerOptions {
+    ServerProtocol protocol_ = ServerProtocol::RESP;
+
+    // 监听地址和端口 (端口为 0 时由系统分配，可通过 port() 获取)
+    std::string host_ = "127.0.0.1";
+    int port_ = 6380;
+
+    // 事件循环线程数。每个线程有自己的监听 socket (SO_REUSEPORT) 和 epoll，
+    // 由内核在线程之间分配新连接，线程之间不共享任何连接状态。
+    int num_threads_ = 1;
+
+    // 每次 epoll_wait 最多返回的事件数
+    int max_events_ = 256;
+
+    // 每次 read() 的缓冲区大小
+    size_t read_chunk_size_ = 16 * 1024;
+
+    // 一个连接每次可读事件最多读取的字节数。读满后重新注册事件，
+    // 先处理其它连接，剩下的数据在下一轮再读 (一个连接不能独占事件循环)
+    size_t max_read_per_event_ = 256 * 1024;
+
+    // 待发送回复的高水位 (字节)。超过时暂停读取这个连接 (不再关注 EPOLLIN)，
+    // 回复发送到高水位以下再继续 (只发请求不读回复的客户端不会让服务器内存无限增长)
+    size_t output_high_water_ = 4 * 1024 * 1024;
+
+    // 每个连接未解析完的输入 (查询缓冲区) 的上限 (字节)，类似 Redis 的 client-query-buffer-limit。
+    // 一个请求迟迟不完整、缓冲区超过上限时回复协议错误并关闭连接 (不能靠声明一个巨大的请求耗尽内存)
+    size_t max_query_buffer_ = 1024 * 1024 * 1024;
+};
+
+/**
+ * @brief KVServer (网络服务器)
+ * 职责：通过 RESP 或二进制协议对外提供 DB 的读写。
+ *
+ * 每个连接都是非阻塞的，并以边沿触发 (EPOLLET) 方式注册：
+ * 可读时读空 socket (每次事件最多 max_read_per_event_ 字节)，解析出所有完整的请求 (支持流水线)，
+ * 把这一批请求的回复放进输出队列，用一次 writev() 发送 (大值不拷贝)。
+ * 写不完的部分等待 EPOLLOUT 再继续发送；积压超过 output_high_water_ 时暂停读取。
+ * 未解析完的输入超过 max_query_buffer_ 时关闭连接。
+ * (仅支持 Linux)
+ */
+class KVServer {
+public:
+    /**
+     * @brief 单实例模式：所有事件循环线程共享同一个存储 (DB 或只读副本)
+     */
+    KVServer(KVStore* store, const ServerOptions& options);
+
+    /**
+     * @brief 分片模式：每个事件循环线程持有自己的 ShardSession，
+     * 命令通过 SPSC 队列发送到 Key 所在分片的线程执行
+     */
+    KVServer(ShardedDB* sharded, const ServerOptions& options);
+
+    /**
+     * @brief 析构函数：停止所有事件循环线程并关闭连接
+     */
+    ~KVServer();
+
+    // 禁用拷贝和赋值
+    KVServer(const KVServer&) = delete;
+    KVServer& operator=(const KVServer&) = delete;
+
+    /**
+     * @brief 创建监听 socket 并启动事件循环线程
+     */
+    bool Start();
+
+    /**
+     * @brief 停止事件循环线程 (可重复调用)
+     */
+    void Stop();
+
+    /**
+     * @brief 实际监听的端口
+     */
+    int port() const { return port_; }
+
+private:
+    struct Loop; // 一个事件循环线程的状态 (定义在 .cpp 中)
+
+    /**
+     * @brief (私有) 创建一个绑定到 port 的非阻塞监听 socket
+     */
+    int CreateListenSocket(int port);
+
+    /**
+     * @brief (私有) 事件循环线程的主函数
+     */
+    void RunLoop(Loop* loop);
+
+    KVStore* store_;
+    ShardedDB* sharded_;
+    ServerOptions options_;
+    int port_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::vector<std::thread> threads_;
+};
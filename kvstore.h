@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+class WriteBatch;
+
+/**
+ * @brief KVStore (KV 存储接口)
+ * 职责：RESP 等上层协议使用的最小读写接口。
+ * DB 直接实现它；分片模式下每个线程通过自己的 ShardSession 实现它。
+ */
+class KVStore {
+public:
+    virtual ~KVStore() = default;
+
+    virtual bool Put(std::string_view key, std::string_view value) = 0;
+    virtual bool Delete(std::string_view key) = 0;
+    virtual bool Write(WriteBatch* batch) = 0;
+    virtual bool Get(std::string_view key, std::string* value) = 0;
+    virtual bool Scan(std::string_view start, size_t limit,
+                      std::vector<std::pair<std::string, std::string>>* results) = 0;
+
+    /**
+     * @brief 批量查找 (默认实现逐个调用 Get；实现可以并行或批量处理)
+     * @param values [out] 与 keys 一一对应；未找到的位置为空
+     * @param found [out] 与 keys 一一对应
+     */
+    virtual void MultiGet(const std::vector<std::string_view>& keys,
+                          std::vector<std::string>* values, std::vector<bool>* found) {
+        values->assign(keys.size(), std::string());
+        found->assign(keys.size(), false);
+        for (size_t i = 0; i < keys.size(); i++) {
+            (*found)[i] = Get(keys[i], &(*values)[i]);
+        }
+    }
+};
@@ -1,21 +1,44 @@
 #include "memtable.h"
-#include <iostream> // 用于打印
+#include "base.h"     // 用于 KV_DEBUG_LOG
+
+// Arena 每次向上游申请的最小字节数 (一个 2MB 大页)
+static const size_t kArenaBlockSize = 2 * 1024 * 1024;
+
+template <typename Comparator>
+BasicMemTable<Comparator>::BasicMemTable(std::shared_ptr<std::pmr::memory_resource> upstream)
+    : upstream_(std::move(upstream)),
+      arena_(upstream_ != nullptr
+                 ? std::make_unique<std::pmr::monotonic_buffer_resource>(kArenaBlockSize, upstream_.get())
+                 : nullptr),
+      memtable_(arena_ != nullptr ? arena_.get() : std::pmr::get_default_resource()),
+      approximate_size_(0) {}
 
 /**
  * @brief 向内存中插入/更新一个 K/V。
  */
-void memtable::put(const std::string& key, const std::string& value) {
-    std::cout << "[MemTable] 写入: (" << key << ", " << value << ")" << std::endl;
-    memtable_[key] = value;
+template <typename Comparator>
+void BasicMemTable<Comparator>::put(const std::string& key, const std::string& value) {
+    KV_DEBUG_LOG("[MemTable] 写入: (" << key << ", " << value << ")");
+    auto result = memtable_.emplace(PrefixedKey(key), value);
+    if (result.second) {
+        // 新 Key: map 节点的开销 (估算 64 字节) + 缩写 + K/V 字符串
+        approximate_size_ += 64 + sizeof(uint64_t) + result.first->first.key_.capacity() +
+                             result.first->second.capacity();
+    } else {
+        // 覆盖旧值: 只需要修正 value 的差值
+        approximate_size_ -= result.first->second.capacity();
+        result.first->second = value;
+        approximate_size_ += result.first->second.capacity();
+    }
 }
 
 /**
  * @brief 尝试从内存中获取一个 Key。
  */
-bool memtable::get(std::string_view key, std::string* value) const {
-    // std::map::find 在 C++14 后可以接受 string_view
-    // 为安全起见 (兼容 C++11)，我们先转为 string
-    auto it = memtable_.find(std::string(key));
+template <typename Comparator>
+bool BasicMemTable<Comparator>::get(std::string_view key, std::string* value) const {
+    // PrefixedKeyLess 是透明比较器：目标 Key 的缩写只计算一次，不需要构造临时 string
+    auto it = memtable_.find(PrefixedKeyRef(key));
     if (it != memtable_.end()) {
         *value = it->second;
         return true;
@@ -26,26 +49,49 @@ bool memtable::get(std::string_view key, std::string* value) const {
 /**
  * @brief 为“刷盘”提供一个外部访问 map 的只读接口。
  */
-const std::map<std::string, std::string>& memtable::GetMap() const {
+template <typename Comparator>
+const typename BasicMemTable<Comparator>::Map& BasicMemTable<Comparator>::GetMap() const {
     return memtable_;
 }
 
 /**
  * @brief 估算 MemTable 当前占用的内存大小。
- * 这是一个粗略的估算，只计算 K/V 字符串在堆上的内存。
+ * 这是一个粗略的估算，只计算 map 节点 (每个 ≈ 64 字节) 和 K/V 字符串在堆上的内存。
  * 真实的 LevelDB 会使用更精确的内存分配器来追踪。
  */
-size_t memtable::ApproximateSize() const {
-    size_t total_size = 0;
-    
-    // 加上 map 节点本身的开销 (估算)
-    // (假设每个 map 节点 ≈ 48-64 字节)
-    total_size += memtable_.size() * 64; 
-
-    // 加上 K/V 字符串数据占用的堆内存 (使用 capacity() 更准)
-    for (const auto& pair : memtable_) {
-        total_size += pair.first.capacity();
-        total_size += pair.second.capacity();
-    }
-    return total_size;
+template <typename Comparator>
+size_t BasicMemTable<Comparator>::ApproximateSize() const {
+    return approximate_size_;
+}
+
+/**
+ * @brief MemTableIterator (MemTable 迭代器) - 直接包装 map 的迭代器
+ */
+template <typename Map>
+class MemTableIterator : public Iterator {
+public:
+    explicit MemTableIterator(const Map* map)
+        : map_(map), it_(map->end()) {}
+
+    bool Valid() const override { return it_ != map_->end(); }
+    bool ok() const override { return true; }
+    void SeekToFirst() override { it_ = map_->begin(); }
+    void Seek(std::string_view target) override { it_ = map_->lower_bound(PrefixedKeyRef(target)); }
+    void Next() override { ++it_; }
+    std::string_view key() const override { return it_->first.key_; }
+    std::string_view value() const override { return it_->second; }
+
+private:
+    const Map* map_;
+    typename Map::const_iterator it_;
+};
+
+template <typename Comparator>
+std::unique_ptr<Iterator> BasicMemTable<Comparator>::NewIterator() const {
+    return std::unique_ptr<Iterator>(new MemTableIterator<Map>(&memtable_));
 }
+
+// 显式实例化内置的比较器
+template class BasicMemTable<BytewiseComparator>;
+template class BasicMemTable<ReverseBytewiseComparator>;
+template class BasicMemTable<Uint64BEComparator>;
@@ -2,17 +2,36 @@
 
 #include <string>
 #include <map>
+#include <memory_resource>
 #include <cstdint>
 #include <string_view> // 用于 get() 和 ApproximateSize()
+#include <memory>
+#include "iterator.h"
+#include "comparator.h"
 
 /**
  * @brief MemTable (内存表)
  * 职责：只在内存中缓冲有序的 K/V。
  * 它对磁盘、文件、SSTable 格式一无所知。
+ * Key 的顺序由比较器 Comparator 决定 (编译期确定，比较被内联)；
+ * 三种内置比较器的实例在 memtable.cpp 中显式实例化。
+ * map 的 Key 是 PrefixedKey：节点内联保存 Key 的 8 字节缩写，查找路径上的比较
+ * 大多只比较两个整数，缩写相同时才读取堆上的完整 Key。
+ * 可选的 Arena：构造时给出上游内存资源 (例如 HugePageResource) 时，map 节点 (连同内联的缩写
+ * 和不超过 SSO 长度的短 K/V) 从一个只增不减的 Arena 中分配，MemTable 销毁时整体归还。
  */
-class memtable {
+template <typename Comparator>
+class BasicMemTable {
 public:
-    memtable() = default;
+    using Map = std::pmr::map<PrefixedKey, std::string, PrefixedKeyLess<Comparator>>;
+
+    BasicMemTable() : approximate_size_(0) {}
+
+    /**
+     * @brief 构造函数：map 节点从以 upstream 为上游的 Arena 中分配 (upstream 为空时同默认构造)
+     * (MemTable 持有 upstream 的引用，保证它比 Arena 活得久)
+     */
+    explicit BasicMemTable(std::shared_ptr<std::pmr::memory_resource> upstream);
 
     /**
      * @brief 向内存中插入/更新一个 K/V。
@@ -29,14 +48,26 @@ public:
     /**
      * @brief 为“刷盘”提供一个外部访问 map 的只读接口。
      */
-    const std::map<std::string, std::string>& GetMap() const;
+    const Map& GetMap() const;
+
+    /**
+     * @brief 创建一个按比较器顺序遍历的迭代器
+     * (不是线程安全的：遍历期间如果有并发写入，需要由调用方加锁)
+     */
+    std::unique_ptr<Iterator> NewIterator() const;
 
     /**
      * @brief 估算 MemTable 当前占用的内存大小。
-     * (LSMTree 管理者用它来决定何时刷盘)
+     * (LSMTree 管理者用它来决定何时刷盘，每次写入都会调用，所以是 O(1) 的)
      */
     size_t ApproximateSize() const;
 
 private:
-    std::map<std::string, std::string> memtable_;
+    std::shared_ptr<std::pmr::memory_resource> upstream_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    Map memtable_;
+    size_t approximate_size_; // 在 put() 时增量维护
 };
+
+// DB 使用字节序的 MemTable
+using memtable = BasicMemTable<BytewiseComparator>;
@@ -0,0 +1,77 @@
+#include "merger.h"
+#include <string>
+
+/**
+ * @brief MergingIterator (多路归并迭代器)
+ * 子迭代器的数量很少 (一次 Compaction 的输入文件数)，
+ * 所以每一步直接线性扫描找出最小的 Key，而不是维护一个堆。
+ */
+template <typename Comparator>
+class MergingIterator : public Iterator {
+public:
+    explicit MergingIterator(std::vector<std::unique_ptr<Iterator>> children)
+        : children_(std::move(children)),
+          current_(nullptr) {}
+
+    bool Valid() const override { return current_ != nullptr; }
+    std::string_view key() const override { return current_->key(); }
+    std::string_view value() const override { return current_->value(); }
+
+    bool ok() const override {
+        for (const auto& child : children_) {
+            if (!child->ok()) return false;
+        }
+        return true;
+    }
+
+    void SeekToFirst() override {
+        for (auto& child : children_) {
+            child->SeekToFirst();
+        }
+        FindSmallest();
+    }
+
+    void Seek(std::string_view target) override {
+        for (auto& child : children_) {
+            child->Seek(target);
+        }
+        FindSmallest();
+    }
+
+    void Next() override {
+        // 跳过所有子迭代器中与当前 Key 相同的 (旧) 条目
+        // (先拷贝 Key：移动 current_ 之后它的视图就失效了)
+        current_key_.assign(current_->key().data(), current_->key().size());
+        for (auto& child : children_) {
+            if (child->Valid() && child->key() == current_key_) {
+                child->Next();
+            }
+        }
+        FindSmallest();
+    }
+
+private:
+    /**
+     * @brief 找出 Key 最小的子迭代器；Key 相同时选下标最小 (最新) 的
+     */
+    void FindSmallest() {
+        current_ = nullptr;
+        for (auto& child : children_) {
+            if (child->Valid() &&
+                (current_ == nullptr || Comparator::Compare(child->key(), current_->key()) < 0)) {
+                current_ = child.get();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Iterator>> children_;
+    Iterator* current_;        // 当前输出的子迭代器 (nullptr 表示已结束)
+    std::string current_key_;  // Next() 中使用的 Key 拷贝 (复用)
+};
+
+std::unique_ptr<Iterator> NewMergingIterator(std::vector<std::unique_ptr<Iterator>> children,
+                                             ComparatorType comparator) {
+    return DispatchComparator(comparator, [&](auto c) {
+        return std::unique_ptr<Iterator>(new MergingIterator<decltype(c)>(std::move(children)));
+    });
+}
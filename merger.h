@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "iterator.h"
+#include "comparator.h"
+
+/**
+ * @brief 创建一个多路归并迭代器
+ * 把多个各自有序的子迭代器合并成一个有序的流。
+ * 同一个 Key 出现在多个子迭代器中时，只输出 *下标最小* 的那个子迭代器中的条目
+ * (调用方应按“从新到旧”的顺序排列子迭代器，这样新值会覆盖旧值)。
+ * @param children 子迭代器 (所有权转移给归并迭代器)
+ * @param comparator 子迭代器共同的 Key 顺序 (归并迭代器针对它实例化)
+ */
+std::unique_ptr<Iterator> NewMergingIterator(std::vector<std::unique_ptr<Iterator>> children,
+                                             ComparatorType comparator = ComparatorType::BYTEWISE);
@@ -0,0 +1,143 @@
+#include "netutil.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+const std::string UNIX_PREFIX = "unix:";
+
+bool ParseTcpAddress(const std::string& address, sockaddr_in* addr) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(static_cast<uint16_t>(atoi(address.c_str() + colon + 1)));
+    return inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr->sin_addr) == 1;
+}
+
+bool ParseUnixAddress(const std::string& address, sockaddr_un* addr) {
+    std::string path = address.substr(UNIX_PREFIX.size());
+    if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+        return false;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    memcpy(addr->sun_path, path.data(), path.size());
+    return true;
+}
+
+bool IsUnixAddress(const std::string& address) {
+    return address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0;
+}
+
+} // namespace
+
+int ConnectTo(const std::string& address) {
+    int fd = -1;
+    if (IsUnixAddress(address)) {
+        sockaddr_un addr;
+        if (!ParseUnixAddress(address, &addr)) {
+            return -1;
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    sockaddr_in addr;
+    if (!ParseTcpAddress(address, &addr)) {
+        return -1;
+    }
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int ListenOn(const std::string& address, std::string* bound_address) {
+    int fd = -1;
+    if (IsUnixAddress(address)) {
+        sockaddr_un addr;
+        if (!ParseUnixAddress(address, &addr)) {
+            std::cerr << "错误: 无效的地址 " << address << std::endl;
+            return -1;
+        }
+        unlink(addr.sun_path); // 上次遗留的 socket 文件
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(fd, SOMAXCONN) != 0) {
+            std::cerr << "错误: 无法监听 " << address << ": " << strerror(errno) << std::endl;
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        *bound_address = address;
+        return fd;
+    }
+    sockaddr_in addr;
+    if (!ParseTcpAddress(address, &addr)) {
+        std::cerr << "错误: 无效的地址 " << address << std::endl;
+        return -1;
+    }
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (fd >= 0) {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        std::cerr << "错误: 无法监听 " << address << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    *bound_address = address.substr(0, address.rfind(':') + 1) + std::to_string(ntohs(addr.sin_port));
+    return fd;
+}
+
+bool SendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+bool RecvAll(int fd, char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t r = recv(fd, buf, n, 0);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return false;
+        }
+        buf += r;
+        n -= r;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * 阻塞 socket 的辅助函数 (仅 Linux)
+ * 地址格式: "host:port" (TCP) 或 "unix:/path/to/socket" (Unix 域 socket)
+ */
+
+/**
+ * @brief 连接到 address
+ * @return 已连接的 fd，失败时返回 -1
+ */
+int ConnectTo(const std::string& address);
+
+/**
+ * @brief 在 address 上监听
+ * @param bound_address [out] 实际监听的地址 (TCP 端口为 0 时由系统分配)
+ * @return 监听 fd，失败时返回 -1
+ */
+int ListenOn(const std::string& address, std::string* bound_address);
+
+/**
+ * @brief 发送全部数据 (不会触发 SIGPIPE)
+ */
+bool SendAll(int fd, std::string_view data);
+
+/**
+ * @brief 接收恰好 n 个字节
+ * @return false 如果连接关闭或出错
+ */
+bool RecvAll(int fd, char* buf, size_t n);
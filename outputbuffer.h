@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <cstddef>
+
+// 不小于这个大小的值作为独立的块挂到输出队列上 (移动而不拷贝)，由 writev 直接发送
+const size_t OUTPUT_ZERO_COPY_THRESHOLD = 4 * 1024;
+
+/**
+ * @brief OutputBuffer (连接的输出队列)
+ * 职责：按顺序保存待发送的回复数据。
+ * 小的回复追加到尾部的块中；大的值作为独立的块移动进来，
+ * 发送时每个块对应一个 iovec，避免把大值再拷贝进发送缓冲区。
+ */
+class OutputBuffer {
+public:
+    OutputBuffer() : front_pos_(0), size_(0) {}
+
+    /**
+     * @brief 用于追加小数据的尾部块 (下一次 AppendOwned() 之后可能改变)
+     */
+    std::string* Tail() {
+        if (chunks_.empty() || chunks_.back().size() >= OUTPUT_ZERO_COPY_THRESHOLD * 16 ||
+            tail_sealed_) {
+            chunks_.emplace_back();
+            tail_sealed_ = false;
+        }
+        return &chunks_.back();
+    }
+
+    /**
+     * @brief 追加一段数据并接管其所有权 (大数据不拷贝)
+     */
+    void AppendOwned(std::string&& data) {
+        if (data.size() < OUTPUT_ZERO_COPY_THRESHOLD) {
+            Tail()->append(data);
+            return;
+        }
+        chunks_.push_back(std::move(data));
+        tail_sealed_ = true; // 之后的小数据放到新的块中
+    }
+
+    /**
+     * @brief 在一轮追加之后调用，更新待发送的总字节数
+     */
+    void Commit() {
+        size_ = 0;
+        for (const auto& chunk : chunks_) {
+            size_ += chunk.size();
+        }
+        size_ -= front_pos_;
+    }
+
+    bool Empty() const { return size_ == 0; }
+    size_t Size() const { return size_; }
+
+    /**
+     * @brief 第 i 个待发送的块 (第 0 个块去掉了已发送的部分)
+     */
+    size_t ChunkCount() const { return chunks_.size(); }
+    std::string_view Chunk(size_t i) const {
+        std::string_view chunk = chunks_[i];
+        return i == 0 ? chunk.substr(front_pos_) : chunk;
+    }
+
+    /**
+     * @brief 标记 n 个字节已经发送
+     */
+    void Consume(size_t n) {
+        size_ -= n;
+        while (n > 0 && !chunks_.empty()) {
+            size_t available = chunks_.front().size() - front_pos_;
+            if (n < available) {
+                front_pos_ += n;
+                return;
+            }
+            n -= available;
+            chunks_.pop_front();
+            front_pos_ = 0;
+        }
+        if (chunks_.empty()) {
+            tail_sealed_ = false;
+        }
+    }
+
+private:
+    std::deque<std::string> chunks_;
+    size_t front_pos_;         // 第一个块中已发送的字节数
+    size_t size_;              // 待发送的总字节数 (Commit 时更新)
+    bool tail_sealed_ = false; // 最后一个块是大值，不能再追加
+};
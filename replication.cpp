@@ -0,0 +1,551 @@
+#include "replication.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "netutil.h"
+#include "sstablereader.h"
+#include "version.h"
+
+namespace {
+
+// 消息头: [type 1B][len 4B]
+const size_t MESSAGE_HEADER_SIZE = 1 + sizeof(uint32_t);
+
+// 发送线程每次最多打包的积压记录数
+const size_t MAX_RECORDS_PER_SEND = 256;
+
+int64_t NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AppendMessageHeader(std::string* out, ReplMessage type, size_t payload_size) {
+    out->push_back(static_cast<char>(type));
+    PutFixed32(out, static_cast<uint32_t>(payload_size));
+}
+
+void AppendMessage(std::string* out, ReplMessage type, std::string_view payload) {
+    AppendMessageHeader(out, type, payload.size());
+    out->append(payload.data(), payload.size());
+}
+
+bool ReadMessage(int fd, ReplMessage* type, std::string* payload) {
+    char header[MESSAGE_HEADER_SIZE];
+    if (!RecvAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    *type = static_cast<ReplMessage>(header[0]);
+    uint32_t len = 0;
+    memcpy(&len, header + 1, sizeof(len));
+    payload->resize(len);
+    return len == 0 || RecvAll(fd, &(*payload)[0], len);
+}
+
+void PutLengthPrefixedSlice(std::string* dst, std::string_view s) {
+    PutFixed32(dst, static_cast<uint32_t>(s.size()));
+    dst->append(s.data(), s.size());
+}
+
+bool GetLengthPrefixedSlice(std::string_view* input, std::string_view* result) {
+    uint32_t len = 0;
+    if (!GetFixed32(input, &len) || input->size() < len) {
+        return false;
+    }
+    *result = input->substr(0, len);
+    input->remove_prefix(len);
+    return true;
+}
+
+std::string GenerationDirName(uint64_t generation) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "data-%06llu", static_cast<unsigned long long>(generation));
+    return buf;
+}
+
+} // namespace
+
+// --- ReplicationLeader ---
+
+ReplicationLeader::ReplicationLeader(DB* db, const LeaderOptions& options)
+    : db_(db),
+      options_(options),
+      listen_fd_(-1),
+      stop_(false),
+      snapshots_sent_(0),
+      backlog_base_(0),
+      backlog_min_seq_(0),
+      last_sequence_(0),
+      backlog_size_(0) {}
+
+ReplicationLeader::~ReplicationLeader() {
+    stop_.store(true);
+    db_->SetWriteListener(nullptr);
+    if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR); // 唤醒阻塞的 accept()
+    }
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : follower_fds_) {
+            shutdown(fd, SHUT_RDWR); // 唤醒阻塞的 send()
+        }
+        threads.swap(follower_threads_);
+    }
+    cv_.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+}
+
+bool ReplicationLeader::Start() {
+    listen_fd_ = ListenOn(options_.address_, &address_);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    // 先注册监听器再读取序列号：两者之间的写入会由监听器记录
+    db_->SetWriteListener([this](const WriteBatch& batch) { OnWrite(batch); });
+    uint64_t sequence = db_->LastSequence();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (backlog_min_seq_ == 0) {
+            backlog_min_seq_ = sequence + 1;
+            last_sequence_ = sequence;
+        }
+    }
+    accept_thread_ = std::thread(&ReplicationLeader::AcceptLoop, this);
+    return true;
+}
+
+void ReplicationLeader::OnWrite(const WriteBatch& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (backlog_min_seq_ == 0) {
+        backlog_min_seq_ = batch.Sequence();
+    }
+    Record record;
+    record.first_sequence_ = batch.Sequence();
+    record.last_sequence_ = batch.Sequence() + batch.Count() - 1;
+    record.data_ = batch.Contents();
+    backlog_size_ += record.data_.size();
+    last_sequence_ = record.last_sequence_;
+    backlog_.push_back(std::move(record));
+
+    // 超过上限时丢弃最旧的、已经刷盘的记录 (未刷盘的记录是快照追赶的衔接点，必须保留)
+    uint64_t flushed = db_->FlushedSequence();
+    while (backlog_size_ > options_.backlog_bytes_ && backlog_.size() > 1 &&
+           backlog_.front().last_sequence_ <= flushed) {
+        backlog_min_seq_ = backlog_.front().last_sequence_ + 1;
+        backlog_size_ -= backlog_.front().data_.size();
+        backlog_.pop_front();
+        backlog_base_++;
+    }
+    cv_.notify_all();
+}
+
+bool ReplicationLeader::FindBacklogIndex(uint64_t sequence, uint64_t* index) const {
+    if (sequence < backlog_min_seq_ || sequence > last_sequence_ + 1) {
+        return false;
+    }
+    auto it = std::lower_bound(backlog_.begin(), backlog_.end(), sequence,
+        [](const Record& r, uint64_t s) { return r.last_sequence_ < s; });
+    *index = backlog_base_ + (it - backlog_.begin());
+    return true;
+}
+
+void ReplicationLeader::AcceptLoop() {
+    while (!stop_.load()) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (stop_.load()) {
+                break;
+            }
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        follower_fds_.push_back(fd);
+        follower_threads_.emplace_back(&ReplicationLeader::ServeFollower, this, fd);
+    }
+}
+
+bool ReplicationLeader::SendSnapshot(int fd, uint64_t* next_index) {
+    std::vector<std::pair<int, FileMetaData>> files;
+    std::vector<std::shared_ptr<SSTableReader>> tables;
+    uint64_t flushed_sequence = 0;
+    bool found = false;
+    for (int attempt = 0; attempt < 3 && !found; attempt++) {
+        if (!db_->GetLiveFiles(&files, &flushed_sequence, &tables)) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            found = FindBacklogIndex(flushed_sequence + 1, next_index);
+        }
+        if (!found) {
+            // 快照和积压之间有空洞 (监听器注册之前的写入还在 MemTable 中)，先刷盘
+            db_->Flush();
+        }
+    }
+    if (!found) {
+        std::cerr << "错误: 无法建立与日志积压衔接的快照" << std::endl;
+        return false;
+    }
+
+    std::string message;
+    std::string payload;
+    PutFixed64(&payload, flushed_sequence);
+    PutFixed32(&payload, static_cast<uint32_t>(files.size()));
+    AppendMessage(&message, ReplMessage::SNAPSHOT_BEGIN, payload);
+    if (!SendAll(fd, message)) {
+        return false;
+    }
+    std::string contents;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!tables[i]->ReadFileContents(&contents)) {
+            return false;
+        }
+        payload.clear();
+        payload.push_back(static_cast<char>(files[i].first));
+        PutLengthPrefixedSlice(&payload, files[i].second.smallest_);
+        PutLengthPrefixedSlice(&payload, files[i].second.largest_);
+        payload.push_back(files[i].second.has_time_range_ ? 1 : 0);
+        PutFixed64(&payload, files[i].second.min_timestamp_);
+        PutFixed64(&payload, files[i].second.max_timestamp_);
+        message.clear();
+        AppendMessageHeader(&message, ReplMessage::SNAPSHOT_FILE, payload.size() + contents.size());
+        message.append(payload);
+        if (!SendAll(fd, message) || !SendAll(fd, contents)) {
+            return false;
+        }
+    }
+    message.clear();
+    AppendMessage(&message, ReplMessage::SNAPSHOT_END, std::string_view());
+    snapshots_sent_++;
+    return SendAll(fd, message);
+}
+
+void ReplicationLeader::ServeFollower(int fd) {
+    char handshake[sizeof(uint32_t) + sizeof(uint64_t)] = {};
+    std::string_view input(handshake, sizeof(handshake));
+    uint32_t magic = 0;
+    uint64_t start_sequence = 0;
+    bool ok = RecvAll(fd, handshake, sizeof(handshake)) &&
+              GetFixed32(&input, &magic) && magic == REPLICATION_MAGIC &&
+              GetFixed64(&input, &start_sequence);
+
+    uint64_t next_index = 0;
+    bool need_snapshot = false;
+    if (ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        need_snapshot = !FindBacklogIndex(start_sequence, &next_index);
+    }
+
+    std::string message;
+    std::string payload;
+    while (ok && !stop_.load()) {
+        if (need_snapshot) {
+            ok = SendSnapshot(fd, &next_index);
+            need_snapshot = false;
+            continue;
+        }
+        message.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(options_.heartbeat_interval_ms_), [&] {
+                return stop_.load() || next_index < backlog_base_ + backlog_.size();
+            });
+            if (stop_.load()) {
+                break;
+            }
+            if (next_index < backlog_base_) {
+                // 发送太慢，需要的日志已经被丢弃：改为发送快照
+                need_snapshot = true;
+                continue;
+            }
+            size_t count = 0;
+            while (next_index < backlog_base_ + backlog_.size() && count < MAX_RECORDS_PER_SEND) {
+                AppendMessage(&message, ReplMessage::RECORD, backlog_[next_index - backlog_base_].data_);
+                next_index++;
+                count++;
+            }
+            if (count == 0) {
+                payload.clear();
+                PutFixed64(&payload, last_sequence_);
+                AppendMessage(&message, ReplMessage::HEARTBEAT, payload);
+            }
+        }
+        ok = SendAll(fd, message);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    follower_fds_.erase(std::remove(follower_fds_.begin(), follower_fds_.end(), fd), follower_fds_.end());
+    close(fd);
+}
+
+// --- ReplicaClient ---
+
+ReplicaClient::Replica::~Replica() {
+    db_.reset();
+    if (obsolete_.load()) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+}
+
+ReplicaClient::ReplicaClient(const std::string& dirname, const ReplicaOptions& options)
+    : dirname_(dirname),
+      options_(options),
+      stop_(false),
+      fd_(-1),
+      leader_sequence_(0),
+      last_contact_ms_(0),
+      generation_(0) {}
+
+std::unique_ptr<ReplicaClient> ReplicaClient::Open(const std::string& dirname, const ReplicaOptions& options) {
+    std::error_code ec;
+    std::filesystem::create_directories(dirname, ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建目录 " << dirname << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<ReplicaClient> client(new ReplicaClient(dirname, options));
+
+    // CURRENT 记录当前的数据目录；其余 data-* 目录是切换中途崩溃的遗留
+    uint64_t generation = 1;
+    {
+        std::ifstream ifs(dirname + "/CURRENT");
+        std::string name;
+        unsigned long long value = 0;
+        if (ifs >> name && sscanf(name.c_str(), "data-%llu", &value) == 1) {
+            generation = value;
+        }
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(dirname)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, 5, "data-") == 0 && name != GenerationDirName(generation)) {
+            std::filesystem::remove_all(entry.path(), ec);
+        }
+    }
+    client->current_ = client->OpenReplica(generation);
+    if (client->current_ == nullptr) {
+        return nullptr;
+    }
+    client->generation_ = generation;
+    {
+        std::ofstream ofs(dirname + "/CURRENT", std::ios::trunc);
+        ofs << GenerationDirName(generation) << "\n";
+    }
+    client->thread_ = std::thread(&ReplicaClient::Run, client.get());
+    return client;
+}
+
+ReplicaClient::~ReplicaClient() {
+    stop_.store(true);
+    int fd = fd_.load();
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR); // 唤醒阻塞的 recv()
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::shared_ptr<ReplicaClient::Replica> ReplicaClient::OpenReplica(uint64_t generation) {
+    auto replica = std::make_shared<Replica>();
+    replica->dir_ = dirname_ + "/" + GenerationDirName(generation);
+    replica->db_ = DB::Open(replica->dir_, options_.db_options_);
+    if (replica->db_ == nullptr) {
+        return nullptr;
+    }
+    return replica;
+}
+
+std::shared_ptr<ReplicaClient::Replica> ReplicaClient::Current() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+bool ReplicaClient::Put(std::string_view, std::string_view) { return false; }
+bool ReplicaClient::Delete(std::string_view) { return false; }
+bool ReplicaClient::Write(WriteBatch*) { return false; }
+
+bool ReplicaClient::Get(std::string_view key, std::string* value) {
+    return !Stale() && Current()->db_->Get(key, value);
+}
+
+bool ReplicaClient::Scan(std::string_view start, size_t limit,
+                         std::vector<std::pair<std::string, std::string>>* results) {
+    results->clear();
+    return !Stale() && Current()->db_->Scan(start, limit, results);
+}
+
+void ReplicaClient::MultiGet(const std::vector<std::string_view>& keys,
+                             std::vector<std::string>* values, std::vector<bool>* found) {
+    if (Stale()) {
+        values->assign(keys.size(), std::string());
+        found->assign(keys.size(), false);
+        return;
+    }
+    Current()->db_->MultiGet(keys, values, found);
+}
+
+uint64_t ReplicaClient::AppliedSequence() {
+    return Current()->db_->LastSequence();
+}
+
+bool ReplicaClient::Stale() const {
+    return NowMillis() - last_contact_ms_.load() > options_.max_lag_ms_;
+}
+
+bool ReplicaClient::WaitForSequence(uint64_t sequence, int timeout_ms) {
+    int64_t deadline = NowMillis() + timeout_ms;
+    while (AppliedSequence() < sequence) {
+        if (NowMillis() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void ReplicaClient::Run() {
+    ReplMessage type;
+    std::string payload;
+    WriteBatch batch;
+    while (!stop_.load()) {
+        int fd = ConnectTo(options_.leader_address_);
+        if (fd >= 0) {
+            fd_.store(fd);
+            std::string handshake;
+            PutFixed32(&handshake, REPLICATION_MAGIC);
+            PutFixed64(&handshake, AppliedSequence() + 1);
+            bool ok = !stop_.load() && SendAll(fd, handshake);
+            while (ok && ReadMessage(fd, &type, &payload)) {
+                last_contact_ms_.store(NowMillis());
+                switch (type) {
+                    case ReplMessage::SNAPSHOT_BEGIN:
+                        ok = ReceiveSnapshot(fd, payload);
+                        break;
+                    case ReplMessage::RECORD:
+                        ok = batch.SetContents(payload) && Current()->db_->ApplyReplicated(batch);
+                        if (ok && batch.Count() > 0) {
+                            uint64_t last = batch.Sequence() + batch.Count() - 1;
+                            leader_sequence_.store(std::max(leader_sequence_.load(), last));
+                        }
+                        break;
+                    case ReplMessage::HEARTBEAT: {
+                        std::string_view input = payload;
+                        uint64_t sequence = 0;
+                        ok = GetFixed64(&input, &sequence);
+                        leader_sequence_.store(sequence);
+                        break;
+                    }
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+            fd_.store(-1);
+            close(fd);
+        }
+        // 断开后等待一段时间重连
+        for (int waited = 0; waited < options_.retry_interval_ms_ && !stop_.load(); waited += 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+bool ReplicaClient::ReceiveSnapshot(int fd, std::string_view begin_payload) {
+    uint64_t flushed_sequence = 0;
+    uint32_t file_count = 0;
+    if (!GetFixed64(&begin_payload, &flushed_sequence) || !GetFixed32(&begin_payload, &file_count)) {
+        return false;
+    }
+    uint64_t generation = generation_ + 1; // generation_ 只由复制线程修改
+    const std::string dir = dirname_ + "/" + GenerationDirName(generation);
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir, ec);
+
+    // 1. 把收到的 SSTable 写进新目录，并生成对应的 MANIFEST
+    {
+        VersionSet versions(dir);
+        if (!versions.Recover()) {
+            return false;
+        }
+        VersionEdit edit;
+        ReplMessage type;
+        std::string payload;
+        for (uint32_t i = 0; i < file_count; i++) {
+            if (!ReadMessage(fd, &type, &payload) || type != ReplMessage::SNAPSHOT_FILE || payload.empty()) {
+                return false;
+            }
+            std::string_view input = payload;
+            int level = static_cast<uint8_t>(input[0]);
+            input.remove_prefix(1);
+            std::string_view smallest, largest;
+            if (level >= NUM_LEVELS || !GetLengthPrefixedSlice(&input, &smallest) ||
+                !GetLengthPrefixedSlice(&input, &largest) || input.empty()) {
+                return false;
+            }
+            FileMetaData f;
+            f.creation_time_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()); // 本地的新文件
+            f.has_time_range_ = input[0] != 0;
+            input.remove_prefix(1);
+            if (!GetFixed64(&input, &f.min_timestamp_) || !GetFixed64(&input, &f.max_timestamp_)) {
+                return false;
+            }
+            f.number_ = versions.NewFileNumber();
+            f.file_size_ = input.size();
+            f.smallest_.assign(smallest.data(), smallest.size());
+            f.largest_.assign(largest.data(), largest.size());
+            std::ofstream ofs(TableFileName(dir, f.number_), std::ios::binary | std::ios::trunc);
+            ofs.write(input.data(), input.size());
+            if (!ofs) {
+                return false;
+            }
+            edit.AddFile(level, f);
+        }
+        if (!ReadMessage(fd, &type, &payload) || type != ReplMessage::SNAPSHOT_END) {
+            return false;
+        }
+        edit.last_sequence_ = flushed_sequence;
+        if (!versions.LogAndApply(&edit)) {
+            return false;
+        }
+    }
+
+    // 2. 打开新目录，更新 CURRENT，再原子地切换
+    std::shared_ptr<Replica> replica = OpenReplica(generation);
+    if (replica == nullptr) {
+        return false;
+    }
+    const std::string current_file = dirname_ + "/CURRENT";
+    {
+        std::ofstream ofs(current_file + ".tmp", std::ios::trunc);
+        ofs << GenerationDirName(generation) << "\n";
+    }
+    std::filesystem::rename(current_file + ".tmp", current_file, ec);
+    if (ec) {
+        return false;
+    }
+    std::shared_ptr<Replica> old;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        old = std::move(current_);
+        old->obsolete_.store(true); // 最后一个读者释放后删除旧目录
+        current_ = std::move(replica);
+        generation_ = generation;
+    }
+    return true;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include "db.h"
+#include "kvstore.h"
+
+/**
+ * 复制协议 (主节点 -> 从节点，小端)
+ *
+ * 握手 (从节点发送): [magic 4B][start_sequence 8B]  (start_sequence = 从节点已应用的序列号 + 1)
+ * 之后主节点发送一系列消息: [type 1B][len 4B][payload]
+ *   SNAPSHOT_BEGIN : [flushed_sequence 8B][file_count 4B]
+ *   SNAPSHOT_FILE  : [level 1B][smallest (len 4B + bytes)][largest (len 4B + bytes)]
+ *                  [has_time_range 1B][min_timestamp 8B][max_timestamp 8B][文件内容]
+ *   SNAPSHOT_END   : 空
+ *   RECORD         : WriteBatch::Contents() (带序列号)
+ *   HEARTBEAT      : [leader_last_sequence 8B]
+ *
+ * 从节点落后太多 (需要的日志已经不在主节点的内存积压中) 时，主节点改为发送
+ * 当前 Version 的全部 SSTable (文件在 Finish 之后不可变)，再从快照的序列号之后继续发送日志。
+ */
+
+enum class ReplMessage : uint8_t {
+    SNAPSHOT_BEGIN = 1,
+    SNAPSHOT_FILE = 2,
+    SNAPSHOT_END = 3,
+    RECORD = 4,
+    HEARTBEAT = 5,
+};
+
+// 握手的 magic ("KVRP")
+const uint32_t REPLICATION_MAGIC = 0x5052564b;
+
+/**
+ * @brief LeaderOptions (主节点复制选项)
+ */
+struct LeaderOptions {
+    // 监听地址: "host:port" 或 "unix:/path"
+    std::string address_ = "127.0.0.1:7380";
+
+    // 内存中日志积压的目标上限 (字节)。尚未刷盘的日志总会保留，
+    // 落后超过积压范围的从节点改为通过 SSTable 快照追赶。
+    size_t backlog_bytes_ = 4 * 1024 * 1024;
+
+    // 空闲时发送心跳的间隔
+    int heartbeat_interval_ms_ = 100;
+};
+
+/**
+ * @brief ReplicationLeader (主节点)
+ * 职责：把 DB 的每个写入批次 (带序列号) 推送给所有连接的从节点。
+ * 每个从节点一个发送线程；写入路径上只做一次内存追加。
+ * (仅支持 Linux)
+ */
+class ReplicationLeader {
+public:
+    ReplicationLeader(DB* db, const LeaderOptions& options);
+
+    /**
+     * @brief 析构函数：断开所有从节点并停止线程
+     */
+    ~ReplicationLeader();
+
+    // 禁用拷贝和赋值
+    ReplicationLeader(const ReplicationLeader&) = delete;
+    ReplicationLeader& operator=(const ReplicationLeader&) = delete;
+
+    /**
+     * @brief 开始监听并注册 DB 的写入监听器 (应在 DB 打开后、开始写入之前调用)
+     */
+    bool Start();
+
+    /**
+     * @brief 实际监听的地址
+     */
+    const std::string& address() const { return address_; }
+
+    /**
+     * @brief 已发送过的快照次数 (测试使用)
+     */
+    uint64_t SnapshotsSent() const { return snapshots_sent_.load(); }
+
+private:
+    struct Record {
+        uint64_t first_sequence_;
+        uint64_t last_sequence_;
+        std::string data_;
+    };
+
+    /**
+     * @brief (私有) DB 写入监听器 (持有 DB 锁时调用)
+     */
+    void OnWrite(const WriteBatch& batch);
+
+    void AcceptLoop();
+    void ServeFollower(int fd);
+
+    /**
+     * @brief (私有) 发送 SSTable 快照
+     * @param next_index [out] 快照之后第一条要发送的积压记录的绝对下标
+     */
+    bool SendSnapshot(int fd, uint64_t* next_index);
+
+    /**
+     * @brief (私有, 需持有 mutex_) 第一条包含 sequence 的积压记录的绝对下标；
+     * 积压中没有完整覆盖 sequence 之后的日志时返回 false
+     */
+    bool FindBacklogIndex(uint64_t sequence, uint64_t* index) const;
+
+    DB* db_;
+    LeaderOptions options_;
+    std::string address_;
+    int listen_fd_;
+    std::atomic<bool> stop_;
+    std::thread accept_thread_;
+    std::atomic<uint64_t> snapshots_sent_;
+
+    // 以下成员由 mutex_ 保护
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Record> backlog_;
+    uint64_t backlog_base_;      // backlog_ 第一条记录的绝对下标
+    uint64_t backlog_min_seq_;   // 序列号 >= 它的日志都在积压中
+    uint64_t last_sequence_;     // 主节点最新的序列号
+    size_t backlog_size_;        // 积压的字节数
+    std::vector<int> follower_fds_;
+    std::vector<std::thread> follower_threads_;
+};
+
+/**
+ * @brief ReplicaOptions (从节点选项)
+ */
+struct ReplicaOptions {
+    // 主节点的复制地址
+    std::string leader_address_ = "127.0.0.1:7380";
+
+    // 超过这个时间没有收到主节点的任何消息，读取返回失败 (有界延迟)
+    int max_lag_ms_ = 1000;
+
+    // 连接断开后重连的间隔
+    int retry_interval_ms_ = 100;
+
+    // 本地 DB 的选项
+    Options db_options_;
+};
+
+/**
+ * @brief ReplicaClient (从节点)
+ * 职责：连接主节点，把收到的日志应用到自己的 DB，并提供只读访问。
+ *
+ * 数据放在 dirname/data-NNNNNN 中，dirname/CURRENT 记录当前使用的目录。
+ * 收到快照时在新目录中建立 DB，完成后原子地切换过去，旧目录在没有读者后删除。
+ * 重启后从本地 DB 的序列号继续复制。
+ * (仅支持 Linux)
+ */
+class ReplicaClient : public KVStore {
+public:
+    /**
+     * @brief 打开本地数据并开始复制
+     * @return 失败时返回 nullptr
+     */
+    static std::unique_ptr<ReplicaClient> Open(const std::string& dirname, const ReplicaOptions& options);
+
+    ~ReplicaClient() override;
+
+    // 禁用拷贝和赋值
+    ReplicaClient(const ReplicaClient&) = delete;
+    ReplicaClient& operator=(const ReplicaClient&) = delete;
+
+    // 从节点只读：写入总是返回 false
+    bool Put(std::string_view key, std::string_view value) override;
+    bool Delete(std::string_view key) override;
+    bool Write(WriteBatch* batch) override;
+
+    /**
+     * @brief 读取 (数据过期，即超过 max_lag_ms_ 没有收到主节点消息时返回 false)
+     */
+    bool Get(std::string_view key, std::string* value) override;
+    bool Scan(std::string_view start, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* results) override;
+    void MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found) override;
+
+    /**
+     * @brief 已应用的最大序列号
+     */
+    uint64_t AppliedSequence();
+
+    /**
+     * @brief 最近一次从主节点得知的主节点序列号
+     */
+    uint64_t LeaderSequence() const { return leader_sequence_.load(); }
+
+    /**
+     * @brief 是否超过 max_lag_ms_ 没有收到主节点的消息
+     */
+    bool Stale() const;
+
+    /**
+     * @brief 等待已应用的序列号达到 sequence (测试使用)
+     */
+    bool WaitForSequence(uint64_t sequence, int timeout_ms);
+
+private:
+    /**
+     * @brief 一个数据目录及其 DB；最后一个引用释放时，如果已被替换则删除目录
+     */
+    struct Replica {
+        std::unique_ptr<DB> db_;
+        std::string dir_;
+        std::atomic<bool> obsolete_{false};
+        ~Replica();
+    };
+
+    ReplicaClient(const std::string& dirname, const ReplicaOptions& options);
+
+    std::shared_ptr<Replica> Current();
+
+    /**
+     * @brief (私有) 打开 (或创建) 第 generation 个数据目录
+     */
+    std::shared_ptr<Replica> OpenReplica(uint64_t generation);
+
+    /**
+     * @brief (私有) 复制线程：连接、握手、接收并应用消息，断开后重连
+     */
+    void Run();
+
+    /**
+     * @brief (私有) 接收快照到新的数据目录并切换过去
+     */
+    bool ReceiveSnapshot(int fd, std::string_view begin_payload);
+
+    std::string dirname_;
+    ReplicaOptions options_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+    std::atomic<int> fd_;                       // 当前连接 (析构时用于中断阻塞的读取)
+    std::atomic<uint64_t> leader_sequence_;
+    std::atomic<int64_t> last_contact_ms_;      // 最近一次收到消息的时间 (steady clock)
+
+    std::mutex mutex_;                          // 保护 current_ 和 generation_
+    std::shared_ptr<Replica> current_;
+    uint64_t generation_;
+};
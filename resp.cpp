@@ -0,0 +1,461 @@
+#include "resp.h"
+#include <charconv>
+#include <cctype>
+#include "kvstore.h"
+#include "writebatch.h"
+
+namespace {
+
+/**
+ * @brief 从 pos 开始读取一行 (不含 "\r\n")
+ * @param next [out] 下一行的起始位置
+ */
+RespParseResult ReadLine(std::string_view input, size_t pos, std::string_view* line, size_t* next) {
+    size_t eol = input.find("\r\n", pos);
+    if (eol == std::string_view::npos) {
+        // 协议头不会超过这个长度，再长说明对方发的不是 RESP
+        return input.size() - pos > RESP_MAX_INLINE_LENGTH ? RespParseResult::ERROR
+                                                            : RespParseResult::INCOMPLETE;
+    }
+    *line = input.substr(pos, eol - pos);
+    *next = eol + 2;
+    return RespParseResult::OK;
+}
+
+bool ParseInteger(std::string_view s, int64_t* value) {
+    if (s.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(s.data(), s.data() + s.size(), *value);
+    return result.ec == std::errc() && result.ptr == s.data() + s.size();
+}
+
+/**
+ * @brief 解析 "<type><length>\r\n" 形式的头部
+ */
+RespParseResult ReadLengthHeader(std::string_view input, size_t pos, char type,
+                                 int64_t* length, size_t* next) {
+    if (pos >= input.size()) {
+        return RespParseResult::INCOMPLETE;
+    }
+    if (input[pos] != type) {
+        return RespParseResult::ERROR;
+    }
+    std::string_view line;
+    RespParseResult result = ReadLine(input, pos + 1, &line, next);
+    if (result != RespParseResult::OK) {
+        return result;
+    }
+    return ParseInteger(line, length) ? RespParseResult::OK : RespParseResult::ERROR;
+}
+
+RespParseResult SkipReply(std::string_view input, size_t pos, size_t* next, int depth) {
+    if (pos >= input.size()) {
+        return RespParseResult::INCOMPLETE;
+    }
+    if (depth > 32) {
+        return RespParseResult::ERROR;
+    }
+    char type = input[pos];
+    std::string_view line;
+    RespParseResult result = ReadLine(input, pos + 1, &line, next);
+    if (result != RespParseResult::OK) {
+        return result;
+    }
+    int64_t length = 0;
+    switch (type) {
+        case '+':
+        case '-':
+        case ':':
+            return RespParseResult::OK;
+        case '$':
+            if (!ParseInteger(line, &length) || length < -1) {
+                return RespParseResult::ERROR;
+            }
+            if (length == -1) {
+                return RespParseResult::OK;
+            }
+            if (input.size() - *next < static_cast<size_t>(length) + 2) {
+                return RespParseResult::INCOMPLETE;
+            }
+            *next += length + 2;
+            return RespParseResult::OK;
+        case '*':
+            if (!ParseInteger(line, &length) || length < -1) {
+                return RespParseResult::ERROR;
+            }
+            for (int64_t i = 0; i < length; i++) {
+                result = SkipReply(input, *next, next, depth + 1);
+                if (result != RespParseResult::OK) {
+                    return result;
+                }
+            }
+            return RespParseResult::OK;
+        default:
+            return RespParseResult::ERROR;
+    }
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// SCAN 的游标是下一个 Key 的十六进制编码，"0" 表示开始/结束
+std::string EncodeCursor(std::string_view key) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string cursor;
+    cursor.reserve(key.size() * 2);
+    for (unsigned char c : key) {
+        cursor.push_back(HEX[c >> 4]);
+        cursor.push_back(HEX[c & 0xf]);
+    }
+    return cursor;
+}
+
+bool DecodeCursor(std::string_view cursor, std::string* key) {
+    key->clear();
+    if (cursor == "0") {
+        return true;
+    }
+    if (cursor.size() % 2 != 0) {
+        return false;
+    }
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < cursor.size(); i += 2) {
+        int hi = nibble(cursor[i]);
+        int lo = nibble(cursor[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        key->push_back(static_cast<char>((hi << 4) | lo));
+    }
+    return true;
+}
+
+void AppendWrongArgs(std::string* out, std::string_view command) {
+    out->append("-ERR wrong number of arguments for '");
+    out->append(command.data(), command.size());
+    out->append("' command\r\n");
+}
+
+} // namespace
+
+RespParseResult ParseRespCommand(std::string_view input, std::vector<std::string_view>* args,
+                                 size_t* consumed) {
+    args->clear();
+    if (input.empty()) {
+        return RespParseResult::INCOMPLETE;
+    }
+
+    // 1. 内联命令: 以空白分隔的一行
+    if (input[0] != '*') {
+        size_t eol = input.find('\n');
+        if (eol == std::string_view::npos) {
+            return input.size() > RESP_MAX_INLINE_LENGTH ? RespParseResult::ERROR
+                                                         : RespParseResult::INCOMPLETE;
+        }
+        std::string_view line = input.substr(0, eol);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        size_t pos = 0;
+        while (pos < line.size()) {
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
+            size_t begin = pos;
+            while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t') pos++;
+            if (pos > begin) {
+                args->push_back(line.substr(begin, pos - begin));
+            }
+        }
+        *consumed = eol + 1;
+        return RespParseResult::OK;
+    }
+
+    // 2. RESP 数组: *<n>\r\n 后跟 n 个 $<len>\r\n<data>\r\n
+    int64_t count = 0;
+    size_t pos = 0;
+    RespParseResult result = ReadLengthHeader(input, 0, '*', &count, &pos);
+    if (result != RespParseResult::OK) {
+        return result;
+    }
+    if (count < 0 || static_cast<size_t>(count) > RESP_MAX_ARRAY_LENGTH) {
+        return RespParseResult::ERROR;
+    }
+    for (int64_t i = 0; i < count; i++) {
+        int64_t length = 0;
+        result = ReadLengthHeader(input, pos, '$', &length, &pos);
+        if (result != RespParseResult::OK) {
+            return result;
+        }
+        if (length < 0 || static_cast<size_t>(length) > RESP_MAX_BULK_LENGTH) {
+            return RespParseResult::ERROR;
+        }
+        if (input.size() - pos < static_cast<size_t>(length) + 2) {
+            return RespParseResult::INCOMPLETE;
+        }
+        if (input[pos + length] != '\r' || input[pos + length + 1] != '\n') {
+            return RespParseResult::ERROR;
+        }
+        args->push_back(input.substr(pos, length));
+        pos += length + 2;
+    }
+    *consumed = pos;
+    return RespParseResult::OK;
+}
+
+RespParseResult ParseRespReply(std::string_view input, size_t* consumed) {
+    return SkipReply(input, 0, consumed, 0);
+}
+
+void AppendSimpleString(std::string* out, std::string_view s) {
+    out->push_back('+');
+    out->append(s.data(), s.size());
+    out->append("\r\n");
+}
+
+void AppendError(std::string* out, std::string_view message) {
+    out->push_back('-');
+    out->append(message.data(), message.size());
+    out->append("\r\n");
+}
+
+void AppendInteger(std::string* out, int64_t value) {
+    out->push_back(':');
+    out->append(std::to_string(value));
+    out->append("\r\n");
+}
+
+void AppendBulkString(std::string* out, std::string_view s) {
+    out->push_back('$');
+    out->append(std::to_string(s.size()));
+    out->append("\r\n");
+    out->append(s.data(), s.size());
+    out->append("\r\n");
+}
+
+void AppendNullBulkString(std::string* out) {
+    out->append("$-1\r\n");
+}
+
+void AppendArrayHeader(std::string* out, size_t count) {
+    out->push_back('*');
+    out->append(std::to_string(count));
+    out->append("\r\n");
+}
+
+void AppendRespCommand(std::string* out, const std::vector<std::string_view>& args) {
+    AppendArrayHeader(out, args.size());
+    for (std::string_view arg : args) {
+        AppendBulkString(out, arg);
+    }
+}
+
+bool RespGlobMatch(std::string_view pattern, std::string_view s) {
+    // 贪心匹配 + 回溯到最近的 '*'
+    size_t p = 0, i = 0;
+    size_t star = std::string_view::npos, match = 0;
+    while (i < s.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == s[i])) {
+            p++;
+            i++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            match = i;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            i = ++match;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+bool RespCommandHandler::Execute(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.empty()) {
+        return true;
+    }
+    std::string_view command = args[0];
+    if (EqualsIgnoreCase(command, "GET")) {
+        Get(args, out);
+    } else if (EqualsIgnoreCase(command, "SET")) {
+        Set(args, out);
+    } else if (EqualsIgnoreCase(command, "DEL")) {
+        Del(args, out);
+    } else if (EqualsIgnoreCase(command, "MGET")) {
+        MGet(args, out);
+    } else if (EqualsIgnoreCase(command, "MSET")) {
+        MSet(args, out);
+    } else if (EqualsIgnoreCase(command, "SCAN")) {
+        Scan(args, out);
+    } else if (EqualsIgnoreCase(command, "PING")) {
+        if (args.size() > 1) {
+            AppendBulkString(out, args[1]);
+        } else {
+            AppendSimpleString(out, "PONG");
+        }
+    } else if (EqualsIgnoreCase(command, "COMMAND")) {
+        // redis-cli 连接时会发送 COMMAND DOCS，返回空数组即可
+        AppendArrayHeader(out, 0);
+    } else if (EqualsIgnoreCase(command, "QUIT")) {
+        AppendSimpleString(out, "OK");
+        return false;
+    } else {
+        out->append("-ERR unknown command '");
+        out->append(command.data(), command.size());
+        out->append("'\r\n");
+    }
+    return true;
+}
+
+void RespCommandHandler::Get(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.size() != 2) {
+        AppendWrongArgs(out, "get");
+        return;
+    }
+    if (db_->Get(args[1], &value_)) {
+        AppendBulkString(out, value_);
+    } else {
+        AppendNullBulkString(out);
+    }
+}
+
+void RespCommandHandler::Set(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.size() != 3) {
+        // 不支持 EX/NX 等选项
+        AppendWrongArgs(out, "set");
+        return;
+    }
+    if (db_->Put(args[1], args[2])) {
+        AppendSimpleString(out, "OK");
+    } else {
+        AppendError(out, "ERR write failed");
+    }
+}
+
+void RespCommandHandler::Del(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.size() < 2) {
+        AppendWrongArgs(out, "del");
+        return;
+    }
+    // 返回值是实际存在的 Key 数量，所以先逐个查找
+    int64_t existing = 0;
+    WriteBatch batch;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (db_->Get(args[i], &value_)) {
+            existing++;
+        }
+        batch.Delete(args[i]);
+    }
+    if (db_->Write(&batch)) {
+        AppendInteger(out, existing);
+    } else {
+        AppendError(out, "ERR write failed");
+    }
+}
+
+void RespCommandHandler::MGet(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.size() < 2) {
+        AppendWrongArgs(out, "mget");
+        return;
+    }
+    std::vector<std::string_view> keys(args.begin() + 1, args.end());
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    db_->MultiGet(keys, &values, &found);
+    AppendArrayHeader(out, keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (found[i]) {
+            AppendBulkString(out, values[i]);
+        } else {
+            AppendNullBulkString(out);
+        }
+    }
+}
+
+void RespCommandHandler::MSet(const std::vector<std::string_view>& args, std::string* out) {
+    if (args.size() < 3 || args.size() % 2 != 1) {
+        AppendWrongArgs(out, "mset");
+        return;
+    }
+    WriteBatch batch;
+    for (size_t i = 1; i < args.size(); i += 2) {
+        batch.Put(args[i], args[i + 1]);
+    }
+    if (db_->Write(&batch)) {
+        AppendSimpleString(out, "OK");
+    } else {
+        AppendError(out, "ERR write failed");
+    }
+}
+
+void RespCommandHandler::Scan(const std::vector<std::string_view>& args, std::string* out) {
+    // SCAN cursor [MATCH pattern] [COUNT count]
+    if (args.size() < 2 || args.size() % 2 != 0) {
+        AppendWrongArgs(out, "scan");
+        return;
+    }
+    std::string start;
+    if (!DecodeCursor(args[1], &start)) {
+        AppendError(out, "ERR invalid cursor");
+        return;
+    }
+    std::string_view pattern = "*";
+    int64_t count = 10;
+    for (size_t i = 2; i < args.size(); i += 2) {
+        if (EqualsIgnoreCase(args[i], "MATCH")) {
+            pattern = args[i + 1];
+        } else if (EqualsIgnoreCase(args[i], "COUNT")) {
+            if (!ParseInteger(args[i + 1], &count) || count <= 0) {
+                AppendError(out, "ERR value is not an integer or out of range");
+                return;
+            }
+        } else {
+            AppendError(out, "ERR syntax error");
+            return;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::string>> results;
+    if (!db_->Scan(start, static_cast<size_t>(count), &results)) {
+        AppendError(out, "ERR scan failed");
+        return;
+    }
+    // 和 Redis 一样，MATCH 在取出 COUNT 个 Key 之后过滤，所以一批可能为空
+    std::string next_cursor = "0";
+    if (results.size() == static_cast<size_t>(count)) {
+        std::string next = results.back().first;
+        next.push_back('\0'); // 大于最后一个 Key 的最小 Key
+        next_cursor = EncodeCursor(next);
+    }
+    size_t matched = 0;
+    for (const auto& kv : results) {
+        if (RespGlobMatch(pattern, kv.first)) {
+            matched++;
+        }
+    }
+    AppendArrayHeader(out, 2);
+    AppendBulkString(out, next_cursor);
+    AppendArrayHeader(out, matched);
+    for (const auto& kv : results) {
+        if (RespGlobMatch(pattern, kv.first)) {
+            AppendBulkString(out, kv.first);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class KVStore;
+
+/**
+ * @brief RESP (Redis 协议) 的解析结果
+ */
+enum class RespParseResult {
+    OK,          // 解析出了一个完整的消息
+    INCOMPLETE,  // 数据还不完整，需要继续读取
+    ERROR,       // 协议错误 (应关闭连接)
+};
+
+// 单个 Bulk String 的最大长度
+const size_t RESP_MAX_BULK_LENGTH = 512 * 1024 * 1024;
+
+// 单个数组的最大元素个数
+const size_t RESP_MAX_ARRAY_LENGTH = 1024 * 1024;
+
+// 内联命令 (如 telnet 发送的 "PING\r\n") 的最大长度
+const size_t RESP_MAX_INLINE_LENGTH = 64 * 1024;
+
+/**
+ * @brief 从 input 的开头解析一条客户端命令
+ * 支持 RESP 数组 ("*2\r\n$3\r\nGET\r\n$1\r\nk\r\n") 和内联命令 ("GET k\r\n")。
+ * @param args [out] 命令参数 (指向 input 内部，input 有效期间有效)
+ * @param consumed [out] 成功时这条命令占用的字节数
+ */
+RespParseResult ParseRespCommand(std::string_view input, std::vector<std::string_view>* args,
+                                 size_t* consumed);
+
+/**
+ * @brief 从 input 的开头跳过一条完整的服务端回复 (客户端/压测使用)
+ * @param consumed [out] 成功时这条回复占用的字节数
+ */
+RespParseResult ParseRespReply(std::string_view input, size_t* consumed);
+
+// --- 回复编码 (追加到 out) ---
+void AppendSimpleString(std::string* out, std::string_view s);
+void AppendError(std::string* out, std::string_view message);
+void AppendInteger(std::string* out, int64_t value);
+void AppendBulkString(std::string* out, std::string_view s);
+void AppendNullBulkString(std::string* out);
+void AppendArrayHeader(std::string* out, size_t count);
+
+/**
+ * @brief 把一条命令编码成 RESP 数组 (客户端/压测使用)
+ */
+void AppendRespCommand(std::string* out, const std::vector<std::string_view>& args);
+
+/**
+ * @brief RespCommandHandler (命令执行器)
+ * 职责：在 KVStore (DB 或分片会话) 上执行一条已解析的命令，并把回复追加到输出缓冲区。
+ * 与网络无关，可以直接在测试中使用。
+ *
+ * 支持的命令: PING, GET, SET, DEL, MGET, MSET, SCAN, COMMAND, QUIT
+ */
+class RespCommandHandler {
+public:
+    explicit RespCommandHandler(KVStore* db) : db_(db) {}
+
+    /**
+     * @brief 执行一条命令
+     * @param args 命令参数 (args[0] 是命令名，不区分大小写)
+     * @param out [out] 回复被追加到这里
+     * @return false 如果连接应在回复发送后关闭 (QUIT)
+     */
+    bool Execute(const std::vector<std::string_view>& args, std::string* out);
+
+private:
+    void Get(const std::vector<std::string_view>& args, std::string* out);
+    void Set(const std::vector<std::string_view>& args, std::string* out);
+    void Del(const std::vector<std::string_view>& args, std::string* out);
+    void MGet(const std::vector<std::string_view>& args, std::string* out);
+    void MSet(const std::vector<std::string_view>& args, std::string* out);
+    void Scan(const std::vector<std::string_view>& args, std::string* out);
+
+    KVStore* db_;
+    std::string value_; // 复用的读取缓冲区
+};
+
+/**
+ * @brief 简单的 glob 匹配 (支持 '*' 和 '?')，用于 SCAN 的 MATCH 选项
+ */
+bool RespGlobMatch(std::string_view pattern, std::string_view s);
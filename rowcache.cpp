@@ -0,0 +1,125 @@
+#include "rowcache.h"
+
+// 每个条目除了 K/V 本身，还有链表节点和哈希表节点的开销 (估算)
+static const size_t kEntryOverhead = 96;
+
+// 进行中填充的槽位数
+static const size_t kFillSlots = 1024;
+
+RowCache::RowCache(size_t capacity)
+    : capacity_(capacity),
+      usage_(0),
+      epoch_(0),
+      fills_(new std::atomic<uint32_t>[kFillSlots]),
+      hits_(0),
+      misses_(0),
+      inserts_(0),
+      rejected_(0) {
+    for (size_t i = 0; i < kFillSlots; i++) {
+        fills_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 查找一个 Key；命中时把它移到链表头部
+ */
+bool RowCache::Lookup(std::string_view key, std::string* internal_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = table_.find(key);
+    if (it == table_.end() || it->second->invalidated_) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    lru_.splice(lru_.begin(), lru_, it->second); // O(1) 移到头部，迭代器保持有效
+    *internal_value = it->second->value_;
+    return true;
+}
+
+/**
+ * @brief 插入一次 SSTable 查找的结果 (查找期间发生过相关写入时丢弃)
+ */
+bool RowCache::Insert(std::string_view key, std::string_view internal_value, uint64_t snapshot, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = table_.find(key);
+    if (epoch != epoch_.load(std::memory_order_relaxed) ||
+        (it != table_.end() && it->second->invalidated_ && it->second->sequence_ > snapshot)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (it != table_.end()) {
+        RemoveLocked(it); // 替换旧值或已经被快照覆盖的失效标记
+    }
+    PushLocked(Entry{std::string(key), std::string(internal_value), 0, false, 0});
+    inserts_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void RowCache::BeginFill(std::string_view key) {
+    FillSlot(key).fetch_add(1, std::memory_order_relaxed);
+}
+
+void RowCache::EndFill(std::string_view key) {
+    FillSlot(key).fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 写入使 Key 失效
+ * 没有进行中的填充时，之后开始的查找都能在 MemTable 中看到这次写入，不需要失效标记。
+ * (BeginFill 和 Invalidate 都在 DB 的锁内调用，所以这里一定能看到写入之前开始的填充)
+ */
+void RowCache::Invalidate(std::string_view key, uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = table_.find(key);
+    if (it != table_.end()) {
+        RemoveLocked(it);
+    }
+    if (FillSlot(key).load(std::memory_order_relaxed) > 0) {
+        PushLocked(Entry{std::string(key), std::string(), sequence, true, 0});
+    }
+}
+
+void RowCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_.fetch_add(1, std::memory_order_release);
+    table_.clear();
+    lru_.clear();
+    usage_ = 0;
+}
+
+size_t RowCache::GetUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usage_;
+}
+
+void RowCache::PushLocked(Entry entry) {
+    entry.charge_ = entry.key_.size() + entry.value_.size() + kEntryOverhead;
+    usage_ += entry.charge_;
+    lru_.push_front(std::move(entry));
+    table_[lru_.front().key_] = lru_.begin();
+    EvictLocked();
+}
+
+void RowCache::RemoveLocked(Table::iterator it) {
+    LRUList::iterator entry = it->second;
+    usage_ -= entry->charge_;
+    table_.erase(it); // 先删哈希表: 它的 Key 指向 entry 中的字符串
+    lru_.erase(entry);
+}
+
+/**
+ * @brief 淘汰链表尾部的条目
+ * 淘汰一个还有进行中填充的失效标记后就无法再判断这些查找是否过期，因此 epoch 加一让它们全部放弃插入。
+ */
+void RowCache::EvictLocked() {
+    while (usage_ > capacity_ && !lru_.empty()) {
+        if (lru_.back().invalidated_ && FillSlot(lru_.back().key_).load(std::memory_order_relaxed) > 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+        }
+        RemoveLocked(table_.find(lru_.back().key_));
+    }
+}
+
+std::atomic<uint32_t>& RowCache::FillSlot(std::string_view key) const {
+    return fills_[std::hash<std::string_view>()(key) % kFillSlots];
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief RowCache (行缓存)
+ * 职责：缓存热点 Key 在 SSTable 中查到的内部值 (带标签，包括删除标记)，
+ * 命中时一次哈希查找就能返回，不需要再查索引、Filter 和数据块。按字节数限制容量。
+ *
+ * 行缓存位于 MemTable 之后、SSTable 之前，它缓存的是“MemTable 中没有这个 Key 时”的结果，
+ * 因此必须保证不会缓存过期的值：
+ *   - 查找方在读 MemTable 的同一把锁内调用 BeginFill(key)，并记下快照序列号 snapshot 和 Epoch()，
+ *     读完 SSTable 后 Insert 只在 epoch 未变、且 Key 的失效标记不比 snapshot 新时生效
+ *     (快照之后发生的写入不在这次读到的 MemTable 中，查到的值可能已经过期)，最后调用 EndFill(key)；
+ *   - 写入时调用 Invalidate(key, sequence)：删除缓存的值；只有这个 Key 有进行中的填充时
+ *     才留下一个带序列号的失效标记 (写入大量未缓存的 Key 不会挤掉热点值)；
+ *   - 进行中的填充还需要的失效标记被淘汰、或者整体 Clear() (例如过期文件被直接删除) 时 epoch 加一，
+ *     让所有还在进行中的查找放弃插入。
+ * 进行中的填充按 Key 的哈希计入固定数量的槽位 (不同 Key 落在同一槽位只会多留一些失效标记)。
+ * 淘汰策略：LRU。
+ *
+ * 线程安全：所有公有方法都可以被多个线程并发调用。
+ */
+class RowCache {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 缓存容量 (字节)
+     */
+    explicit RowCache(size_t capacity);
+
+    // 禁用拷贝和赋值
+    RowCache(const RowCache&) = delete;
+    RowCache& operator=(const RowCache&) = delete;
+
+    /**
+     * @brief 查找一个 Key
+     * @param internal_value [out] 命中时存入内部值
+     * @return true 命中 (失效标记不算命中)
+     */
+    bool Lookup(std::string_view key, std::string* internal_value);
+
+    /**
+     * @brief 插入一次 SSTable 查找的结果
+     * @param snapshot 查找开始时 (读 MemTable 时) 的最大序列号
+     * @param epoch 查找开始时的 Epoch()
+     * @return false 如果期间发生了影响这个 Key 的写入或整体失效 (结果被丢弃)
+     */
+    bool Insert(std::string_view key, std::string_view internal_value, uint64_t snapshot, uint64_t epoch);
+
+    /**
+     * @brief 开始一次 Key 的查找填充 (调用方在读 MemTable 的同一把锁内调用，查找结束后调用 EndFill)
+     */
+    void BeginFill(std::string_view key);
+    void EndFill(std::string_view key);
+
+    /**
+     * @brief 序列号为 sequence 的写入修改了 key (调用方在写 MemTable 的同一把锁内调用)
+     */
+    void Invalidate(std::string_view key, uint64_t sequence);
+
+    /**
+     * @brief 删除所有条目 (数据没有经过写入就发生了变化，例如按 TTL 删除整个文件)
+     */
+    void Clear();
+
+    /**
+     * @brief 当前的失效纪元
+     */
+    uint64_t Epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+    // --- 统计信息 ---
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetUsage() const;
+    uint64_t GetHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return misses_.load(std::memory_order_relaxed); }
+    uint64_t GetInserts() const { return inserts_.load(std::memory_order_relaxed); }
+    uint64_t GetRejectedInserts() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::string key_;
+        std::string value_;   // 内部值 (失效标记为空)
+        uint64_t sequence_;   // 失效标记: 最近一次写入的序列号
+        bool invalidated_;    // 失效标记
+        size_t charge_;       // 计入容量的字节数
+    };
+
+    using LRUList = std::list<Entry>; // 头部 = 最近使用，尾部 = 最久未使用
+    using Table = std::unordered_map<std::string_view, LRUList::iterator>; // Key 指向 Entry::key_
+
+    // (私有, 需持有锁) 把条目放到链表头部并计入容量，然后淘汰
+    void PushLocked(Entry entry);
+
+    // (私有, 需持有锁) 从链表和哈希表中移除一个条目
+    void RemoveLocked(Table::iterator it);
+
+    // (私有, 需持有锁) 淘汰条目直到用量不超过容量
+    void EvictLocked();
+
+    // (私有) Key 对应的进行中填充计数
+    std::atomic<uint32_t>& FillSlot(std::string_view key) const;
+
+    // --- 成员变量 ---
+    const size_t capacity_;
+    size_t usage_;
+    LRUList lru_;
+    Table table_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> epoch_;
+    std::unique_ptr<std::atomic<uint32_t>[]> fills_; // 每个槽位进行中的填充数
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> inserts_;
+    std::atomic<uint64_t> rejected_;
+};
@@ -0,0 +1,241 @@
+#include "secondarycache.h"
+#include <filesystem>
+#include <iostream>
+#include <cstdio>
+
+SecondaryCache::SecondaryCache(const SecondaryCacheOptions& options)
+    : options_(options),
+      is_open_(false),
+      next_segment_(1),
+      usage_(0),
+      pending_segments_(0),
+      writing_(false),
+      shutting_down_(false),
+      hits_(0),
+      misses_(0),
+      bytes_written_(0),
+      dropped_inserts_(0) {
+    std::error_code ec;
+    std::filesystem::create_directories(options_.dir_, ec);
+    if (ec || options_.dir_.empty()) {
+        std::cerr << "错误: 无法创建二级缓存目录 " << options_.dir_ << std::endl;
+        return;
+    }
+    // 上次运行留下的段：块的键只在进程内有效，直接删除
+    for (const auto& entry : std::filesystem::directory_iterator(options_.dir_, ec)) {
+        if (entry.path().extension() == ".seg") {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    is_open_ = true;
+    writer_ = std::thread(&SecondaryCache::WriterThread, this);
+}
+
+SecondaryCache::~SecondaryCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutting_down_ = true;
+        writer_cv_.notify_all();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    std::error_code ec;
+    for (const auto& pair : segments_) {
+        if (pair.second->persisted_) {
+            std::filesystem::remove(SegmentFileName(pair.first), ec);
+        }
+    }
+}
+
+std::string SecondaryCache::SegmentFileName(uint64_t number) const {
+    char name[32];
+    snprintf(name, sizeof(name), "cache-%06llu.seg", static_cast<unsigned long long>(number));
+    return (std::filesystem::path(options_.dir_) / name).string();
+}
+
+/**
+ * @brief 把块追加到当前段；段满时封存 (等待写盘的段太多时丢弃这个块)
+ */
+void SecondaryCache::Insert(uint64_t file_id, uint64_t offset, std::string_view block) {
+    if (!is_open_ || block.size() > options_.segment_size_) {
+        return;
+    }
+    const Key key{file_id, offset};
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) != 0) {
+        return; // 从二级缓存提升到内存的块再次被淘汰时不需要重写
+    }
+    if (active_ != nullptr && active_->buffer_.size() + block.size() > options_.segment_size_) {
+        if (pending_segments_ >= options_.max_pending_segments_) {
+            dropped_inserts_.fetch_add(1, std::memory_order_relaxed);
+            return; // 后台写盘跟不上：块只是缓存，丢掉它 (它的数据仍然在 SSTable 中)
+        }
+        SealLocked();
+    }
+    if (active_ == nullptr) {
+        active_ = std::make_shared<Segment>();
+        active_->number_ = next_segment_++;
+        active_->buffer_.reserve(options_.segment_size_);
+        segments_[active_->number_] = active_;
+    }
+    const uint32_t position = static_cast<uint32_t>(active_->buffer_.size());
+    active_->buffer_.append(block);
+    active_->size_ += block.size();
+    active_->keys_.push_back(key);
+    index_[key] = Location{active_, position, static_cast<uint32_t>(block.size())};
+    usage_ += block.size();
+    EvictLocked();
+}
+
+/**
+ * @brief 查找一个块：还没写盘的段从内存复制，否则从段文件读取
+ */
+std::shared_ptr<const std::string> SecondaryCache::Lookup(uint64_t file_id, uint64_t offset) {
+    Location location;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(Key{file_id, offset});
+        if (it == index_.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        location = it->second;
+        if (!location.segment_->persisted_) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return std::make_shared<std::string>(location.segment_->buffer_, location.offset_, location.size_);
+        }
+    }
+    // 段已经写盘：段被淘汰后文件可能已删除，但打开的文件流仍然可以读取
+    auto block = std::make_shared<std::string>(location.size_, '\0');
+    {
+        std::lock_guard<std::mutex> io_lock(location.segment_->io_mutex_);
+        std::ifstream& file = location.segment_->file_;
+        file.clear();
+        file.seekg(location.offset_);
+        file.read(&(*block)[0], location.size_);
+        if (!file || static_cast<uint32_t>(file.gcount()) != location.size_) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void SecondaryCache::Erase(uint64_t file_id, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.erase(Key{file_id, offset});
+}
+
+void SecondaryCache::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (active_ != nullptr) {
+        SealLocked();
+    }
+    flushed_cv_.wait(lock, [this] { return !is_open_ || shutting_down_ || (sealed_.empty() && !writing_); });
+}
+
+uint64_t SecondaryCache::GetUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usage_;
+}
+
+uint64_t SecondaryCache::GetMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t bytes = 0;
+    for (const auto& pair : segments_) {
+        if (!pair.second->persisted_) {
+            bytes += pair.second->size_;
+        }
+    }
+    return bytes;
+}
+
+void SecondaryCache::SealLocked() {
+    sealed_.push_back(std::move(active_));
+    active_.reset();
+    pending_segments_++;
+    writer_cv_.notify_one();
+}
+
+/**
+ * @brief 整段删除最旧的段 (包括它在索引中仍然指向它的条目)
+ */
+void SecondaryCache::EvictLocked() {
+    while (usage_ > options_.capacity_ && !segments_.empty()) {
+        std::shared_ptr<Segment> victim = segments_.begin()->second;
+        segments_.erase(segments_.begin());
+        for (const Key& key : victim->keys_) {
+            auto it = index_.find(key);
+            if (it != index_.end() && it->second.segment_ == victim) {
+                index_.erase(it);
+            }
+        }
+        usage_ -= victim->size_;
+        victim->dropped_ = true;
+        if (victim == active_) {
+            active_.reset();
+        } else if (!victim->persisted_) {
+            pending_segments_--; // 封存但还没写盘 (或写盘失败) 的段
+        }
+        if (victim->persisted_) {
+            std::error_code ec;
+            std::filesystem::remove(SegmentFileName(victim->number_), ec);
+        }
+    }
+}
+
+/**
+ * @brief 后台线程：按封存顺序把段整段写入文件
+ */
+void SecondaryCache::WriterThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        writer_cv_.wait(lock, [this] { return shutting_down_ || !sealed_.empty(); });
+        if (shutting_down_) {
+            break;
+        }
+        std::shared_ptr<Segment> segment = std::move(sealed_.front());
+        sealed_.pop_front();
+        if (segment->dropped_) {
+            flushed_cv_.notify_all();
+            continue; // 还没写盘就被淘汰了
+        }
+        writing_ = true;
+        lock.unlock();
+
+        // 封存之后 buffer_ 不再修改，可以在锁外写盘
+        const std::string filename = SegmentFileName(segment->number_);
+        bool ok = false;
+        {
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            out.write(segment->buffer_.data(), segment->buffer_.size());
+            out.flush();
+            ok = static_cast<bool>(out);
+        }
+        if (ok) {
+            segment->file_.open(filename, std::ios::binary);
+            ok = segment->file_.is_open();
+        }
+
+        lock.lock();
+        writing_ = false;
+        if (ok && !segment->dropped_) {
+            segment->persisted_ = true;
+            pending_segments_--;
+            std::string().swap(segment->buffer_); // 之后从文件读取
+            bytes_written_.fetch_add(segment->size_, std::memory_order_relaxed);
+        } else {
+            // 写盘失败 (或者写盘期间被淘汰)：段内容留在内存中直到被淘汰
+            std::error_code ec;
+            if (segment->dropped_) {
+                std::filesystem::remove(filename, ec);
+            } else {
+                std::cerr << "错误: 二级缓存段写入失败 " << filename << std::endl;
+            }
+        }
+        flushed_cv_.notify_all();
+    }
+    flushed_cv_.notify_all();
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief SecondaryCacheOptions (二级缓存选项)
+ */
+struct SecondaryCacheOptions {
+    // 段文件所在的目录 (通常在本地 SSD 上)；每个缓存独占一个目录，打开时会清空其中旧的段文件
+    std::string dir_;
+
+    // 所有段文件的总字节数上限，超出时整段删除最旧的段
+    uint64_t capacity_ = 256 * 1024 * 1024;
+
+    // 段大小：内存中攒满一段后由后台线程一次顺序写入一个文件
+    uint64_t segment_size_ = 1024 * 1024;
+
+    // 封存但还没写盘 (包括写盘失败) 的段的个数上限。后台写盘跟不上淘汰速度时，
+    // 新插入的块直接丢弃，而不是让段无限堆积在内存中
+    // (内存占用最多约 (max_pending_segments_ + 1) * segment_size_)
+    uint32_t max_pending_segments_ = 4;
+};
+
+/**
+ * @brief SecondaryCache (二级块缓存)
+ * 职责：在本地文件中缓存从 BlockCache (内存) 淘汰出来的块，容量可以比内存大得多。
+ *
+ * 存储是日志结构的：被淘汰的块追加到内存中的当前段，段写满后封存，由后台线程整段顺序写入
+ * 一个段文件 (cache-NNNNNN.seg)；(file_id, offset) -> (段, 段内偏移, 长度) 的索引只在内存中。
+ * 容量超出时删除最旧的整段 (FIFO)，不需要在文件中做空间回收。
+ * 还没写盘的段直接从内存中读取，所以插入之后立即可以命中。
+ *
+ * 块的键来自 BlockCache::NewId()，只在本进程内有效，因此缓存内容不会跨进程重启保留。
+ * 线程安全：所有公有方法都可以被多个线程并发调用。
+ */
+class SecondaryCache {
+public:
+    /**
+     * @brief 构造函数：创建目录 (删除其中旧的段文件) 并启动后台写线程
+     */
+    explicit SecondaryCache(const SecondaryCacheOptions& options);
+
+    /**
+     * @brief 析构函数：停止后台线程，删除段文件 (还没写盘的段直接丢弃)
+     */
+    ~SecondaryCache();
+
+    // 禁用拷贝和赋值
+    SecondaryCache(const SecondaryCache&) = delete;
+    SecondaryCache& operator=(const SecondaryCache&) = delete;
+
+    /**
+     * @brief 目录是否可用 (不可用时 Insert 什么也不做，Lookup 总是未命中)
+     */
+    bool is_open() const { return is_open_; }
+
+    /**
+     * @brief 插入一个块 (只追加到内存中的当前段，写盘是异步的)；已经存在时什么也不做
+     */
+    void Insert(uint64_t file_id, uint64_t offset, std::string_view block);
+
+    /**
+     * @brief 查找一个块
+     * @return 命中时返回块内容；未命中或读取失败返回 nullptr
+     */
+    std::shared_ptr<const std::string> Lookup(uint64_t file_id, uint64_t offset);
+
+    /**
+     * @brief 删除一个块的索引 (段中的数据随整段删除)
+     */
+    void Erase(uint64_t file_id, uint64_t offset);
+
+    /**
+     * @brief 封存当前段，并等待所有封存的段写盘完成
+     */
+    void Flush();
+
+    // --- 统计信息 ---
+    uint64_t GetCapacity() const { return options_.capacity_; }
+    uint64_t GetUsage() const;                // 所有段 (包括内存中的) 的字节数
+    uint64_t GetMemoryUsage() const;          // 还没写盘的段 (当前段 + 封存的段) 占用的内存字节数
+    uint64_t GetHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return misses_.load(std::memory_order_relaxed); }
+    uint64_t GetBytesWritten() const { return bytes_written_.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedInserts() const { return dropped_inserts_.load(std::memory_order_relaxed); } // 因写盘跟不上丢弃的块
+
+private:
+    struct Key {
+        uint64_t file_id_;
+        uint64_t offset_;
+        bool operator==(const Key& other) const {
+            return file_id_ == other.file_id_ && offset_ == other.offset_;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<uint64_t>()(key.file_id_ * 0x9E3779B97F4A7C15ULL ^ key.offset_);
+        }
+    };
+
+    struct Segment {
+        uint64_t number_ = 0;
+        std::string buffer_;       // 写盘完成之前的内容 (由 mutex_ 保护)
+        uint64_t size_ = 0;        // 段的字节数 (写盘之后 buffer_ 被释放)
+        bool persisted_ = false;   // 已经写入段文件 (由 mutex_ 保护)
+        bool dropped_ = false;     // 已经被淘汰 (由 mutex_ 保护)
+        std::vector<Key> keys_;    // 段中的块 (淘汰整段时清理索引)
+        std::mutex io_mutex_;      // 保护 file_ 的 seek + read
+        std::ifstream file_;       // 写盘完成后打开
+    };
+
+    struct Location {
+        std::shared_ptr<Segment> segment_;
+        uint32_t offset_;
+        uint32_t size_;
+    };
+
+    std::string SegmentFileName(uint64_t number) const;
+
+    // (私有, 需持有锁) 封存当前段，交给后台线程写盘
+    void SealLocked();
+
+    // (私有, 需持有锁) 删除最旧的段直到总字节数不超过容量
+    void EvictLocked();
+
+    // (私有) 后台线程：把封存的段写入文件
+    void WriterThread();
+
+    // --- 成员变量 ---
+    const SecondaryCacheOptions options_;
+    bool is_open_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable writer_cv_;   // 有段需要写盘 / 停止
+    std::condition_variable flushed_cv_;  // 一段写盘完成
+    std::unordered_map<Key, Location, KeyHash> index_;
+    std::map<uint64_t, std::shared_ptr<Segment>> segments_; // 编号 -> 段 (最旧的在前，包括当前段)
+    std::shared_ptr<Segment> active_;                        // 当前追加的段
+    std::deque<std::shared_ptr<Segment>> sealed_;            // 等待写盘的段
+    uint64_t next_segment_;
+    uint64_t usage_;
+    uint32_t pending_segments_;                              // 封存但还没写盘的段 (没被淘汰的)
+    bool writing_;                                           // 后台线程正在写一段
+    bool shutting_down_;
+    std::thread writer_;
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> bytes_written_;
+    std::atomic<uint64_t> dropped_inserts_;
+};
@@ -0,0 +1,360 @@
+#include "secondaryindex.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <optional>
+#include "bloom.h"   // 用于 BloomHash
+
+namespace {
+
+// 范围扫描索引条目/回填索引时每页的条数
+const size_t INDEX_SCAN_PAGE = 256;
+
+bool StartsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+/**
+ * @brief 大于所有以 prefix 开头的 Key 的最小 Key (prefix 全是 0xff 时返回空)
+ */
+std::string PrefixSuccessor(std::string prefix) {
+    while (!prefix.empty() && static_cast<uint8_t>(prefix.back()) == 0xff) {
+        prefix.pop_back();
+    }
+    if (!prefix.empty()) {
+        prefix.back() = static_cast<char>(static_cast<uint8_t>(prefix.back()) + 1);
+    }
+    return prefix;
+}
+
+/**
+ * @brief 提取并排序去重索引 Key，丢弃包含 '\0' 的 Key
+ */
+std::vector<std::string> ExtractIndexKeys(const IndexExtractor& extractor, std::string_view key,
+                                          const std::string* value) {
+    std::vector<std::string> index_keys;
+    if (value == nullptr) {
+        return index_keys;
+    }
+    extractor(key, *value, &index_keys);
+    index_keys.erase(std::remove_if(index_keys.begin(), index_keys.end(), [](const std::string& k) {
+        if (k.find('\0') == std::string::npos) {
+            return false;
+        }
+        std::cerr << "错误: 索引 Key 不能包含 '\\0'，已忽略" << std::endl;
+        return true;
+    }), index_keys.end());
+    std::sort(index_keys.begin(), index_keys.end());
+    index_keys.erase(std::unique(index_keys.begin(), index_keys.end()), index_keys.end());
+    return index_keys;
+}
+
+/**
+ * @brief 收集 WriteBatch 中的每一条记录
+ */
+class BatchCollector : public WriteBatch::Handler {
+public:
+    struct Op {
+        std::string key_;
+        std::optional<std::string> value_; // 空表示 Delete
+    };
+
+    void Put(std::string_view key, std::string_view value) override {
+        ops_.push_back({std::string(key), std::string(value)});
+    }
+
+    void Delete(std::string_view key) override {
+        ops_.push_back({std::string(key), std::nullopt});
+    }
+
+    std::vector<Op> ops_;
+};
+
+} // namespace
+
+IndexedDB::IndexedDB(DB* db, const IndexOptions& options)
+    : db_(db),
+      options_(options),
+      stripes_(new std::mutex[std::max<size_t>(options.lock_stripes_, 1)]) {}
+
+bool IndexedDB::AddIndex(const std::string& name, IndexExtractor extractor) {
+    if (name.empty() || name.find('\0') != std::string::npos || FindIndex(name) != nullptr) {
+        std::cerr << "错误: 无效或重复的索引名 " << name << std::endl;
+        return false;
+    }
+    indexes_.push_back({name, std::move(extractor)});
+    return true;
+}
+
+const IndexedDB::Index* IndexedDB::FindIndex(const std::string& name) const {
+    for (const Index& index : indexes_) {
+        if (index.name_ == name) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+std::string IndexedDB::IndexEntryKey(const std::string& name, std::string_view index_key,
+                                     std::string_view primary_key) const {
+    std::string entry;
+    entry.reserve(options_.prefix_.size() + name.size() + index_key.size() + primary_key.size() + 2);
+    entry.append(options_.prefix_).append(name).push_back('\0');
+    entry.append(index_key.data(), index_key.size()).push_back('\0');
+    entry.append(primary_key.data(), primary_key.size());
+    return entry;
+}
+
+std::vector<std::unique_lock<std::mutex>> IndexedDB::LockStripes(const std::vector<std::string>& keys) {
+    const size_t n = std::max<size_t>(options_.lock_stripes_, 1);
+    std::vector<size_t> ids;
+    for (const std::string& key : keys) {
+        ids.push_back(BloomHash(key) % n);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (size_t id : ids) {
+        locks.emplace_back(stripes_[id]);
+    }
+    return locks;
+}
+
+void IndexedDB::AppendIndexUpdates(std::string_view key, const std::string* old_value,
+                                   const std::string* new_value, WriteBatch* batch) const {
+    for (const Index& index : indexes_) {
+        std::vector<std::string> old_keys = ExtractIndexKeys(index.extractor_, key, old_value);
+        std::vector<std::string> new_keys = ExtractIndexKeys(index.extractor_, key, new_value);
+        // 只写变化的部分：旧的有新的没有 -> 删除；新的有旧的没有 -> 添加
+        std::vector<std::string> removed;
+        std::vector<std::string> added;
+        std::set_difference(old_keys.begin(), old_keys.end(), new_keys.begin(), new_keys.end(),
+                            std::back_inserter(removed));
+        std::set_difference(new_keys.begin(), new_keys.end(), old_keys.begin(), old_keys.end(),
+                            std::back_inserter(added));
+        for (const std::string& k : removed) {
+            batch->Delete(IndexEntryKey(index.name_, k, key));
+        }
+        for (const std::string& k : added) {
+            batch->Put(IndexEntryKey(index.name_, k, key), std::string_view());
+        }
+    }
+}
+
+bool IndexedDB::Put(std::string_view key, std::string_view value) {
+    WriteBatch batch;
+    batch.Put(key, value);
+    return Write(&batch);
+}
+
+bool IndexedDB::Delete(std::string_view key) {
+    WriteBatch batch;
+    batch.Delete(key);
+    return Write(&batch);
+}
+
+bool IndexedDB::Write(WriteBatch* batch) {
+    BatchCollector collector;
+    if (!batch->Iterate(&collector)) {
+        return false;
+    }
+    std::vector<std::string> keys;
+    for (const auto& op : collector.ops_) {
+        if (StartsWith(op.key_, options_.prefix_)) {
+            std::cerr << "错误: Key 不能以索引前缀开头" << std::endl;
+            return false;
+        }
+        keys.push_back(op.key_);
+    }
+    if (indexes_.empty()) {
+        return db_->Write(batch);
+    }
+
+    // 锁住涉及的 Key，保证读到的旧值在写入之前不会被其他线程改掉
+    std::vector<std::unique_lock<std::mutex>> locks = LockStripes(keys);
+    WriteBatch combined = *batch;
+    std::map<std::string, std::optional<std::string>, std::less<>> latest; // 批次内已经写过的 Key
+    std::string stored;
+    for (const auto& op : collector.ops_) {
+        std::optional<std::string> old_value;
+        auto it = latest.find(op.key_);
+        if (it != latest.end()) {
+            old_value = it->second;
+        } else if (db_->Get(op.key_, &stored)) {
+            old_value = stored;
+        }
+        AppendIndexUpdates(op.key_, old_value ? &*old_value : nullptr,
+                           op.value_ ? &*op.value_ : nullptr, &combined);
+        latest[op.key_] = op.value_;
+    }
+    if (!db_->Write(&combined)) {
+        return false;
+    }
+    batch->SetSequence(combined.Sequence());
+    return true;
+}
+
+bool IndexedDB::BuildIndex(const std::string& name) {
+    const Index* index = FindIndex(name);
+    if (index == nullptr) {
+        std::cerr << "错误: 索引 " << name << " 不存在" << std::endl;
+        return false;
+    }
+    std::vector<std::pair<std::string, std::string>> page;
+    std::string cursor;
+    while (true) {
+        if (!Scan(cursor, INDEX_SCAN_PAGE, &page)) {
+            return false;
+        }
+        if (page.empty()) {
+            return true;
+        }
+        std::vector<std::string> keys;
+        for (const auto& kv : page) {
+            keys.push_back(kv.first);
+        }
+        // 扫描之后记录可能已经被改写：加锁后重新读取当前值
+        std::vector<std::unique_lock<std::mutex>> locks = LockStripes(keys);
+        std::vector<std::string_view> key_views(keys.begin(), keys.end());
+        std::vector<std::string> values;
+        std::vector<bool> found;
+        db_->MultiGet(key_views, &values, &found);
+        WriteBatch batch;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!found[i]) {
+                continue;
+            }
+            for (const std::string& k : ExtractIndexKeys(index->extractor_, keys[i], &values[i])) {
+                batch.Put(IndexEntryKey(name, k, keys[i]), std::string_view());
+            }
+        }
+        if (!db_->Write(&batch)) {
+            return false;
+        }
+        if (page.size() < INDEX_SCAN_PAGE) {
+            return true;
+        }
+        cursor = page.back().first;
+        cursor.push_back('\0'); // 紧接着上一页最后一个 Key
+    }
+}
+
+bool IndexedDB::Get(std::string_view key, std::string* value) {
+    return db_->Get(key, value);
+}
+
+void IndexedDB::MultiGet(const std::vector<std::string_view>& keys,
+                         std::vector<std::string>* values, std::vector<bool>* found) {
+    db_->MultiGet(keys, values, found);
+}
+
+bool IndexedDB::Scan(std::string_view start, size_t limit,
+                     std::vector<std::pair<std::string, std::string>>* results) {
+    results->clear();
+    std::string cursor(start);
+    const std::string successor = PrefixSuccessor(options_.prefix_);
+    std::vector<std::pair<std::string, std::string>> page;
+    while (results->size() < limit) {
+        if (StartsWith(cursor, options_.prefix_)) {
+            if (successor.empty()) {
+                return true; // 索引区间之后没有 Key
+            }
+            cursor = successor;
+        }
+        if (!db_->Scan(cursor, limit - results->size(), &page)) {
+            return false;
+        }
+        bool skipped = false;
+        for (auto& kv : page) {
+            if (StartsWith(kv.first, options_.prefix_)) {
+                cursor = kv.first; // 跳过整个索引区间后继续
+                skipped = true;
+                break;
+            }
+            results->push_back(std::move(kv));
+        }
+        if (!skipped) {
+            return true;
+        }
+    }
+    return true;
+}
+
+bool IndexedDB::Lookup(const std::string& name, std::string_view index_key, size_t limit,
+                       std::vector<std::pair<std::string, std::string>>* results) {
+    results->clear();
+    const Index* index = FindIndex(name);
+    if (index == nullptr) {
+        return false;
+    }
+    std::string begin = IndexEntryKey(name, index_key, std::string_view());
+    std::string end = begin;
+    end.back() = '\x01'; // [索引 Key]\0 之后的所有主 Key
+    return ResolveEntries(*index, begin, end, limit, results);
+}
+
+bool IndexedDB::LookupRange(const std::string& name, std::string_view begin, std::string_view end, size_t limit,
+                            std::vector<std::pair<std::string, std::string>>* results) {
+    results->clear();
+    const Index* index = FindIndex(name);
+    if (index == nullptr) {
+        return false;
+    }
+    std::string name_prefix = options_.prefix_ + name;
+    name_prefix.push_back('\0');
+    std::string range_end = end.empty() ? options_.prefix_ + name + '\x01'
+                                        : name_prefix + std::string(end);
+    return ResolveEntries(*index, name_prefix + std::string(begin), range_end, limit, results);
+}
+
+bool IndexedDB::ResolveEntries(const Index& index, const std::string& begin, const std::string& end,
+                               size_t limit, std::vector<std::pair<std::string, std::string>>* results) {
+    std::string name_prefix = options_.prefix_ + index.name_;
+    name_prefix.push_back('\0');
+    std::string cursor = begin;
+    std::vector<std::pair<std::string, std::string>> entries;
+    std::vector<std::string> index_keys;
+    std::vector<std::string_view> primary_keys;
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    while (results->size() < limit) {
+        if (!db_->Scan(cursor, INDEX_SCAN_PAGE, &entries)) {
+            return false;
+        }
+        // 1. 解析这一页中属于范围内的索引条目
+        index_keys.clear();
+        primary_keys.clear();
+        bool done = entries.size() < INDEX_SCAN_PAGE;
+        for (const auto& entry : entries) {
+            if (entry.first >= end || !StartsWith(entry.first, name_prefix)) {
+                done = true;
+                break;
+            }
+            std::string_view rest = std::string_view(entry.first).substr(name_prefix.size());
+            size_t pos = rest.find('\0');
+            if (pos == std::string_view::npos) {
+                continue; // 不是本模块写入的条目
+            }
+            index_keys.emplace_back(rest.substr(0, pos));
+            primary_keys.push_back(rest.substr(pos + 1));
+        }
+
+        // 2. 一次 MultiGet 取回主记录；并发写入可能让条目过期，重新提取确认仍然匹配
+        db_->MultiGet(primary_keys, &values, &found);
+        for (size_t i = 0; i < primary_keys.size() && results->size() < limit; i++) {
+            if (!found[i]) {
+                continue;
+            }
+            std::vector<std::string> current = ExtractIndexKeys(index.extractor_, primary_keys[i], &values[i]);
+            if (std::binary_search(current.begin(), current.end(), index_keys[i])) {
+                results->emplace_back(std::string(primary_keys[i]), std::move(values[i]));
+            }
+        }
+        if (done || entries.empty()) {
+            return true;
+        }
+        cursor = entries.back().first;
+        cursor.push_back('\0');
+    }
+    return true;
+}
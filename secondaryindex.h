@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <utility>
+#include "db.h"
+#include "kvstore.h"
+
+/**
+ * @brief 索引提取函数：根据一条记录的 Key 和 Value 生成它的索引 Key (可以有多个，也可以没有)
+ * 索引 Key 不能包含 '\0'。
+ */
+using IndexExtractor = std::function<void(std::string_view key, std::string_view value,
+                                          std::vector<std::string>* index_keys)>;
+
+/**
+ * @brief IndexOptions (二级索引选项)
+ */
+struct IndexOptions {
+    // 索引条目的 Key 前缀。用户 Key 不能以它开头；默认值排在所有可打印 Key 之后
+    std::string prefix_ = "\xff\xff" "idx";
+
+    // 写入时按 Key 哈希分段加锁的段数 (同一个 Key 的“读旧值-写新值”必须串行)
+    size_t lock_stripes_ = 64;
+};
+
+/**
+ * @brief IndexedDB (带二级索引的 DB)
+ * 职责：在写入时维护按 Value 中字段建立的二级索引，把按字段查找从全表扫描变成一次范围扫描。
+ *
+ * 索引条目与记录本身写在同一个 WriteBatch 中 (原子生效)，存放在同一个 DB 的
+ * prefix_ 区间里: [prefix_][索引名]\0[索引 Key]\0[主 Key] -> ""
+ * 查找时先范围扫描索引条目，再用 MultiGet 取回主记录。
+ *
+ * 写入必须都经过 IndexedDB (直接写底层 DB 会让索引过期)。
+ * 线程安全：所有公有方法都可以被多个线程并发调用；AddIndex 需要在写入之前调用。
+ */
+class IndexedDB : public KVStore {
+public:
+    IndexedDB(DB* db, const IndexOptions& options = IndexOptions());
+
+    // 禁用拷贝和赋值
+    IndexedDB(const IndexedDB&) = delete;
+    IndexedDB& operator=(const IndexedDB&) = delete;
+
+    /**
+     * @brief 注册一个索引 (只对之后的写入生效；已有数据用 BuildIndex 回填)
+     * @return false 如果名字为空、包含 '\0' 或者已经存在
+     */
+    bool AddIndex(const std::string& name, IndexExtractor extractor);
+
+    /**
+     * @brief 扫描所有已有记录，回填索引 name 的条目
+     */
+    bool BuildIndex(const std::string& name);
+
+    bool Put(std::string_view key, std::string_view value) override;
+    bool Delete(std::string_view key) override;
+
+    /**
+     * @brief 原子地写入一个批次，以及它引起的所有索引变更
+     */
+    bool Write(WriteBatch* batch) override;
+
+    bool Get(std::string_view key, std::string* value) override;
+
+    /**
+     * @brief 与 DB::Scan 相同，但不会返回索引条目
+     */
+    bool Scan(std::string_view start, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* results) override;
+
+    void MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found) override;
+
+    /**
+     * @brief 查找索引 Key 等于 index_key 的记录，按主 Key 升序返回最多 limit 条
+     */
+    bool Lookup(const std::string& name, std::string_view index_key, size_t limit,
+                std::vector<std::pair<std::string, std::string>>* results);
+
+    /**
+     * @brief 查找索引 Key 在 [begin, end) 范围内的记录 (end 为空表示不设上限)，
+     * 按 (索引 Key, 主 Key) 升序返回最多 limit 条
+     */
+    bool LookupRange(const std::string& name, std::string_view begin, std::string_view end, size_t limit,
+                     std::vector<std::pair<std::string, std::string>>* results);
+
+private:
+    struct Index {
+        std::string name_;
+        IndexExtractor extractor_;
+    };
+
+    /**
+     * @brief (私有) 索引条目的 Key: [prefix_][name]\0[index_key]\0[primary_key]
+     */
+    std::string IndexEntryKey(const std::string& name, std::string_view index_key,
+                              std::string_view primary_key) const;
+
+    /**
+     * @brief (私有) 把记录 key 从 old_value (nullptr 表示不存在) 变成 new_value 时的索引变更追加到 batch
+     */
+    void AppendIndexUpdates(std::string_view key, const std::string* old_value,
+                            const std::string* new_value, WriteBatch* batch) const;
+
+    /**
+     * @brief (私有) 扫描 [begin, end) 中的索引条目，取回仍然匹配的主记录
+     */
+    bool ResolveEntries(const Index& index, const std::string& begin, const std::string& end, size_t limit,
+                        std::vector<std::pair<std::string, std::string>>* results);
+
+    /**
+     * @brief (私有) 按段号升序锁住 keys 所在的段 (避免死锁)
+     */
+    std::vector<std::unique_lock<std::mutex>> LockStripes(const std::vector<std::string>& keys);
+
+    const Index* FindIndex(const std::string& name) const;
+
+    DB* db_;
+    const IndexOptions options_;
+    std::vector<Index> indexes_;
+    std::unique_ptr<std::mutex[]> stripes_;
+};
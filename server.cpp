@@ -0,0 +1,141 @@
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include <pthread.h>
+#include "db.h"
+#include "shardeddb.h"
+#include "kvserver.h"
+#include "replication.h"
+
+/**
+ * @brief kv_server: 通过 RESP 协议对外提供 KV 存储 (可以直接用 redis-cli 连接)
+ * 用法: kv_server [--db DIR] [--host HOST] [--port PORT] [--threads N] [--shards N]
+ *                  [--protocol resp|binary] [--replication-listen ADDR] [--replica-of ADDR]
+ *                  [--secondary manifest|wal]
+ * --shards N (N > 0) 启用分片模式：键空间按哈希分成 N 个独立的分片，每个分片一个绑定 CPU 核的线程。
+ * --replication-listen ADDR 作为主节点，在 ADDR ("host:port" 或 "unix:/path") 上向从节点推送 WAL。
+ * --replica-of ADDR 作为只读从节点，从 ADDR 上的主节点同步数据 (--db 是从节点的本地目录)。
+ * --secondary manifest|wal 以只读实例打开另一个 kv_server 正在使用的 --db 目录，
+ *   跟随它的 MANIFEST (wal: 同时跟随 WAL，可以读到还没刷盘的写入)。
+ */
+int main(int argc, char** argv) {
+    std::string dbname = "kv_data";
+    ServerOptions server_options;
+    int num_shards = 0;
+    std::string replication_listen;
+    std::string replica_of;
+    std::string secondary;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--db") {
+            dbname = argv[i + 1];
+        } else if (flag == "--host") {
+            server_options.host_ = argv[i + 1];
+        } else if (flag == "--port") {
+            server_options.port_ = std::atoi(argv[i + 1]);
+        } else if (flag == "--threads") {
+            server_options.num_threads_ = std::atoi(argv[i + 1]);
+        } else if (flag == "--protocol") {
+            std::string protocol = argv[i + 1];
+            if (protocol != "resp" && protocol != "binary") {
+                std::cerr << "未知协议: " << protocol << std::endl;
+                return 1;
+            }
+            server_options.protocol_ = (protocol == "binary") ? ServerProtocol::BINARY
+                                                              : ServerProtocol::RESP;
+        } else if (flag == "--shards") {
+            num_shards = std::atoi(argv[i + 1]);
+        } else if (flag == "--replication-listen") {
+            replication_listen = argv[i + 1];
+        } else if (flag == "--replica-of") {
+            replica_of = argv[i + 1];
+        } else if (flag == "--secondary") {
+            secondary = argv[i + 1];
+            if (secondary != "manifest" && secondary != "wal") {
+                std::cerr << "未知的只读实例模式: " << secondary << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "未知参数: " << flag << std::endl;
+            return 1;
+        }
+    }
+    if (num_shards > 0 && (!replication_listen.empty() || !replica_of.empty())) {
+        std::cerr << "错误: 分片模式不支持复制" << std::endl;
+        return 1;
+    }
+    DebugLogEnabled() = false;
+
+    // 在创建任何线程之前屏蔽 SIGINT/SIGTERM，由主线程用 sigwait 等待
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::unique_ptr<DB> db;
+    std::unique_ptr<ShardedDB> sharded;
+    std::unique_ptr<ReplicationLeader> leader;
+    std::unique_ptr<ReplicaClient> replica;
+    std::unique_ptr<KVServer> server;
+    if (!replica_of.empty()) {
+        ReplicaOptions replica_options;
+        replica_options.leader_address_ = replica_of;
+        replica = ReplicaClient::Open(dbname, replica_options);
+        if (replica == nullptr) {
+            std::cerr << "错误: 无法打开从节点目录 " << dbname << std::endl;
+            return 1;
+        }
+        server = std::make_unique<KVServer>(replica.get(), server_options);
+    } else if (!secondary.empty()) {
+        Options options;
+        options.secondary_tail_wal_ = (secondary == "wal");
+        db = DB::OpenAsSecondary(dbname, options);
+        if (db == nullptr) {
+            std::cerr << "错误: 无法以只读实例打开数据库 " << dbname << std::endl;
+            return 1;
+        }
+        server = std::make_unique<KVServer>(db.get(), server_options);
+    } else if (num_shards > 0) {
+        ShardedOptions sharded_options;
+        sharded_options.num_shards_ = num_shards;
+        sharded_options.max_sessions_ = std::max(1, server_options.num_threads_);
+        sharded = ShardedDB::Open(dbname, sharded_options);
+        if (sharded == nullptr) {
+            std::cerr << "错误: 无法打开数据库 " << dbname << std::endl;
+            return 1;
+        }
+        server = std::make_unique<KVServer>(sharded.get(), server_options);
+    } else {
+        db = DB::Open(dbname, Options());
+        if (db == nullptr) {
+            std::cerr << "错误: 无法打开数据库 " << dbname << std::endl;
+            return 1;
+        }
+        if (!replication_listen.empty()) {
+            LeaderOptions leader_options;
+            leader_options.address_ = replication_listen;
+            leader = std::make_unique<ReplicationLeader>(db.get(), leader_options);
+            if (!leader->Start()) {
+                std::cerr << "错误: 无法监听复制地址 " << replication_listen << std::endl;
+                return 1;
+            }
+            std::cout << "复制主节点正在监听 " << leader->address() << std::endl;
+        }
+        server = std::make_unique<KVServer>(db.get(), server_options);
+    }
+    if (!server->Start()) {
+        return 1;
+    }
+    std::cout << "kv_server 正在监听 " << server_options.host_ << ":" << server->port()
+              << " (" << server_options.num_threads_ << " 个事件循环线程, 数据库: "
+              << dbname << ", " << num_shards << " 个分片)" << std::endl;
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    std::cout << "收到信号 " << sig << "，正在停止..." << std::endl;
+    server->Stop();
+    return 0;
+}
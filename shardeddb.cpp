@@ -0,0 +1,376 @@
+#include "shardeddb.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "bloom.h"   // 用于 BloomHash
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// 分片线程在进入睡眠前空转 (让出 CPU) 的次数
+const int SHARD_SPIN_ROUNDS = 64;
+
+// 睡眠的最长时间 (防止极端情况下丢失唤醒)
+const auto SHARD_SLEEP_TIMEOUT = std::chrono::milliseconds(10);
+
+void PinCurrentThread(int index) {
+#ifdef __linux__
+    unsigned int ncpu = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % ncpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)index;
+#endif
+}
+
+/**
+ * @brief 把 WriteBatch 中的记录分发到各分片的批次中
+ */
+class BatchSplitter : public WriteBatch::Handler {
+public:
+    BatchSplitter(const ShardedDB* db, ShardRequest* requests) : db_(db), requests_(requests) {}
+
+    void Put(std::string_view key, std::string_view value) override {
+        requests_[db_->ShardFor(key)].batch_.Put(key, value);
+    }
+
+    void Delete(std::string_view key) override {
+        requests_[db_->ShardFor(key)].batch_.Delete(key);
+    }
+
+private:
+    const ShardedDB* db_;
+    ShardRequest* requests_;
+};
+
+/**
+ * @brief 在分片的 DB 上执行一条请求
+ */
+void ExecuteRequest(DB* db, ShardRequest* request) {
+    switch (request->type_) {
+        case ShardRequest::Type::GET:
+            request->ok_ = db->Get(request->key_, &request->value_);
+            break;
+        case ShardRequest::Type::WRITE:
+            request->ok_ = db->Write(&request->batch_);
+            break;
+        case ShardRequest::Type::SCAN:
+            request->ok_ = db->Scan(request->key_, request->limit_, &request->results_);
+            break;
+        case ShardRequest::Type::MULTI_GET: {
+            std::vector<std::string_view> keys(request->keys_.begin(), request->keys_.end());
+            db->MultiGet(keys, &request->values_, &request->found_);
+            request->ok_ = true;
+            break;
+        }
+    }
+    request->done_.store(true, std::memory_order_release);
+}
+
+} // namespace
+
+// --- ShardSession ---
+
+ShardSession::ShardSession(ShardedDB* db, int id)
+    : db_(db), id_(id), requests_(new ShardRequest[db->NumShards()]) {}
+
+ShardSession::~ShardSession() {
+    db_->ReleaseSession(id_);
+}
+
+void ShardSession::Submit(int shard, ShardRequest* request) {
+    ShardedDB::Shard* target = db_->shards_[shard].get();
+    request->done_.store(false, std::memory_order_relaxed);
+    while (!target->queues_[id_]->TryPush(request)) {
+        ShardedDB::Wake(target);
+        std::this_thread::yield();
+    }
+    ShardedDB::Wake(target);
+}
+
+void ShardSession::Wait(ShardRequest* request) {
+    while (!request->done_.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+bool ShardSession::Put(std::string_view key, std::string_view value) {
+    ShardRequest* request = &requests_[0];
+    request->type_ = ShardRequest::Type::WRITE;
+    request->batch_.Clear();
+    request->batch_.Put(key, value);
+    Submit(db_->ShardFor(key), request);
+    Wait(request);
+    return request->ok_;
+}
+
+bool ShardSession::Delete(std::string_view key) {
+    ShardRequest* request = &requests_[0];
+    request->type_ = ShardRequest::Type::WRITE;
+    request->batch_.Clear();
+    request->batch_.Delete(key);
+    Submit(db_->ShardFor(key), request);
+    Wait(request);
+    return request->ok_;
+}
+
+bool ShardSession::Write(WriteBatch* batch) {
+    int num_shards = db_->NumShards();
+    for (int i = 0; i < num_shards; i++) {
+        requests_[i].type_ = ShardRequest::Type::WRITE;
+        requests_[i].batch_.Clear();
+    }
+    BatchSplitter splitter(db_, requests_.get());
+    if (!batch->Iterate(&splitter)) {
+        return false;
+    }
+    // 先全部发出再统一等待，各分片并行执行
+    for (int i = 0; i < num_shards; i++) {
+        if (requests_[i].batch_.Count() > 0) {
+            Submit(i, &requests_[i]);
+        }
+    }
+    bool ok = true;
+    for (int i = 0; i < num_shards; i++) {
+        if (requests_[i].batch_.Count() > 0) {
+            Wait(&requests_[i]);
+            ok = ok && requests_[i].ok_;
+        }
+    }
+    return ok;
+}
+
+bool ShardSession::Get(std::string_view key, std::string* value) {
+    ShardRequest* request = &requests_[0];
+    request->type_ = ShardRequest::Type::GET;
+    request->key_.assign(key.data(), key.size());
+    Submit(db_->ShardFor(key), request);
+    Wait(request);
+    if (request->ok_) {
+        value->swap(request->value_);
+    }
+    return request->ok_;
+}
+
+bool ShardSession::Scan(std::string_view start, size_t limit,
+                        std::vector<std::pair<std::string, std::string>>* results) {
+    int num_shards = db_->NumShards();
+    for (int i = 0; i < num_shards; i++) {
+        requests_[i].type_ = ShardRequest::Type::SCAN;
+        requests_[i].key_.assign(start.data(), start.size());
+        requests_[i].limit_ = limit;
+        Submit(i, &requests_[i]);
+    }
+    results->clear();
+    bool ok = true;
+    for (int i = 0; i < num_shards; i++) {
+        Wait(&requests_[i]);
+        ok = ok && requests_[i].ok_;
+        for (auto& kv : requests_[i].results_) {
+            results->push_back(std::move(kv));
+        }
+    }
+    // 每个分片的结果已有序，且分片之间没有重复 Key
+    std::sort(results->begin(), results->end());
+    if (results->size() > limit) {
+        results->resize(limit);
+    }
+    return ok;
+}
+
+void ShardSession::MultiGet(const std::vector<std::string_view>& keys,
+                            std::vector<std::string>* values, std::vector<bool>* found) {
+    int num_shards = db_->NumShards();
+    for (int i = 0; i < num_shards; i++) {
+        requests_[i].type_ = ShardRequest::Type::MULTI_GET;
+        requests_[i].keys_.clear();
+        requests_[i].positions_.clear();
+    }
+    for (size_t k = 0; k < keys.size(); k++) {
+        ShardRequest* request = &requests_[db_->ShardFor(keys[k])];
+        request->keys_.emplace_back(keys[k]);
+        request->positions_.push_back(k);
+    }
+    for (int i = 0; i < num_shards; i++) {
+        if (!requests_[i].keys_.empty()) {
+            Submit(i, &requests_[i]);
+        }
+    }
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    for (int i = 0; i < num_shards; i++) {
+        ShardRequest* request = &requests_[i];
+        if (request->keys_.empty()) {
+            continue;
+        }
+        Wait(request);
+        for (size_t j = 0; j < request->positions_.size(); j++) {
+            (*values)[request->positions_[j]].swap(request->values_[j]);
+            (*found)[request->positions_[j]] = request->found_[j];
+        }
+    }
+}
+
+// --- ShardedDB ---
+
+ShardedDB::ShardedDB(const ShardedOptions& options)
+    : options_(options),
+      stop_(false),
+      session_used_(options.max_sessions_, false) {}
+
+std::unique_ptr<ShardedDB> ShardedDB::Open(const std::string& dbname, const ShardedOptions& options) {
+    if (options.num_shards_ <= 0 || options.max_sessions_ <= 0) {
+        std::cerr << "错误: 分片数和会话数必须大于 0" << std::endl;
+        return nullptr;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dbname, ec);
+
+    // 分片数决定了 Key 的归属，已有数据库必须使用相同的分片数打开
+    const std::string shards_file = dbname + "/SHARDS";
+    {
+        std::ifstream ifs(shards_file);
+        int existing = 0;
+        if (ifs >> existing) {
+            if (existing != options.num_shards_) {
+                std::cerr << "错误: 数据库 " << dbname << " 有 " << existing
+                          << " 个分片，但打开时指定了 " << options.num_shards_ << " 个" << std::endl;
+                return nullptr;
+            }
+        } else {
+            std::ofstream ofs(shards_file, std::ios::trunc);
+            ofs << options.num_shards_ << "\n";
+            if (!ofs) {
+                std::cerr << "错误: 无法写入 " << shards_file << std::endl;
+                return nullptr;
+            }
+        }
+    }
+
+    std::unique_ptr<ShardedDB> db(new ShardedDB(options));
+    for (int i = 0; i < options.num_shards_; i++) {
+        auto shard = std::make_unique<Shard>();
+        char name[32];
+        snprintf(name, sizeof(name), "/shard-%03d", i);
+        shard->db_ = DB::Open(dbname + name, options.db_options_);
+        if (shard->db_ == nullptr) {
+            return nullptr; // 已创建的分片线程由析构函数停止
+        }
+        for (int s = 0; s < options.max_sessions_; s++) {
+            shard->queues_.push_back(
+                std::make_unique<SpscQueue<ShardRequest*>>(options.queue_capacity_));
+        }
+        db->shards_.push_back(std::move(shard));
+    }
+    for (int i = 0; i < options.num_shards_; i++) {
+        Shard* shard = db->shards_[i].get();
+        shard->thread_ = std::thread(&ShardedDB::RunShard, db.get(), shard, i);
+    }
+    return db;
+}
+
+ShardedDB::~ShardedDB() {
+    stop_.store(true);
+    for (auto& shard : shards_) {
+        Wake(shard.get());
+        {
+            // 持有锁再通知，避免分片线程刚检查完 stop_ 还没开始等待时错过通知
+            std::lock_guard<std::mutex> lock(shard->mutex_);
+            shard->cv_.notify_one();
+        }
+        if (shard->thread_.joinable()) {
+            shard->thread_.join();
+        }
+    }
+}
+
+std::unique_ptr<ShardSession> ShardedDB::NewSession() {
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    for (size_t i = 0; i < session_used_.size(); i++) {
+        if (!session_used_[i]) {
+            session_used_[i] = true;
+            return std::unique_ptr<ShardSession>(new ShardSession(this, static_cast<int>(i)));
+        }
+    }
+    std::cerr << "错误: 会话数已达上限 " << options_.max_sessions_ << std::endl;
+    return nullptr;
+}
+
+void ShardedDB::ReleaseSession(int id) {
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    session_used_[id] = false;
+}
+
+int ShardedDB::ShardFor(std::string_view key) const {
+    // 使用持久稳定的哈希 (std::hash 的结果可能随编译器变化)
+    return static_cast<int>(BloomHash(key) % shards_.size());
+}
+
+void ShardedDB::WaitForIdle() {
+    for (auto& shard : shards_) {
+        shard->db_->WaitForIdle();
+    }
+}
+
+void ShardedDB::Wake(Shard* shard) {
+    // 与 RunShard 中的栅栏配对：要么分片线程看到新请求，要么这里看到 sleeping_
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard->sleeping_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(shard->mutex_);
+        shard->cv_.notify_one();
+    }
+}
+
+void ShardedDB::RunShard(Shard* shard, int index) {
+    if (options_.pin_threads_) {
+        PinCurrentThread(index);
+    }
+    DB* db = shard->db_.get();
+    ShardRequest* request = nullptr;
+    int idle_rounds = 0;
+    auto has_pending = [shard] {
+        for (const auto& queue : shard->queues_) {
+            if (!queue->Empty()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (true) {
+        bool worked = false;
+        for (auto& queue : shard->queues_) {
+            while (queue->TryPop(&request)) {
+                ExecuteRequest(db, request);
+                worked = true;
+            }
+        }
+        if (worked) {
+            idle_rounds = 0;
+            continue;
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (++idle_rounds < SHARD_SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        // 一段时间没有请求，进入睡眠
+        std::unique_lock<std::mutex> lock(shard->mutex_);
+        shard->sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!has_pending() && !stop_.load(std::memory_order_acquire)) {
+            shard->cv_.wait_for(lock, SHARD_SLEEP_TIMEOUT);
+        }
+        shard->sleeping_.store(false, std::memory_order_relaxed);
+        idle_rounds = 0;
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "db.h"
+#include "kvstore.h"
+#include "spscqueue.h"
+
+/**
+ * @brief ShardedOptions (分片模式选项)
+ */
+struct ShardedOptions {
+    // 分片数 (打开已有数据库时必须与创建时一致)
+    int num_shards_ = 4;
+
+    // 最多同时存在的会话数 (每个会话对应一个生产者线程，每个分片为它保留一个队列)
+    int max_sessions_ = 16;
+
+    // 每个 (会话, 分片) 请求队列的容量
+    size_t queue_capacity_ = 1024;
+
+    // 把第 i 个分片的线程绑定到第 i % ncpu 个 CPU 核 (仅 Linux)
+    bool pin_threads_ = true;
+
+    // 每个分片内部 DB 的选项
+    Options db_options_;
+};
+
+/**
+ * @brief 发往某个分片线程的一条请求
+ * 由会话填写后入队，分片线程执行完成后设置 done_。
+ */
+struct ShardRequest {
+    enum class Type { GET, WRITE, SCAN, MULTI_GET };
+
+    Type type_ = Type::GET;
+    std::string key_;       // GET 的 Key / SCAN 的起始 Key
+    WriteBatch batch_;      // WRITE 的批次
+    size_t limit_ = 0;      // SCAN 的数量上限
+    std::vector<std::string> keys_; // MULTI_GET 的 Key
+    std::vector<size_t> positions_; // MULTI_GET: 每个 Key 在调用方结果中的下标 (分片线程不使用)
+
+    // 结果 (分片线程写入)
+    bool ok_ = false;
+    std::string value_;
+    std::vector<std::pair<std::string, std::string>> results_;
+    std::vector<std::string> values_; // MULTI_GET
+    std::vector<bool> found_;         // MULTI_GET
+    std::atomic<bool> done_{false};
+};
+
+class ShardedDB;
+
+/**
+ * @brief ShardSession (分片会话)
+ * 职责：一个生产者线程访问分片引擎的入口。
+ * 请求通过该会话独占的 SPSC 队列发送到目标分片线程，不经过任何共享锁。
+ * 一个会话只能被一个线程使用。
+ */
+class ShardSession : public KVStore {
+public:
+    ~ShardSession() override;
+
+    bool Put(std::string_view key, std::string_view value) override;
+    bool Delete(std::string_view key) override;
+
+    /**
+     * @brief 按分片拆分批次并并行写入
+     * (同一个分片内的写入是原子的；跨分片的批次不保证原子性)
+     */
+    bool Write(WriteBatch* batch) override;
+
+    bool Get(std::string_view key, std::string* value) override;
+
+    /**
+     * @brief 向所有分片并行发出扫描，再按 Key 归并
+     */
+    bool Scan(std::string_view start, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* results) override;
+
+    /**
+     * @brief 按分片分组，每个分片一个请求，并行查找
+     */
+    void MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found) override;
+
+private:
+    friend class ShardedDB;
+
+    ShardSession(ShardedDB* db, int id);
+
+    /**
+     * @brief (私有) 把请求放入目标分片的队列 (队列满时让出 CPU 等待)
+     */
+    void Submit(int shard, ShardRequest* request);
+
+    /**
+     * @brief (私有) 等待请求完成
+     */
+    static void Wait(ShardRequest* request);
+
+    ShardedDB* db_;
+    int id_;                                    // 会话编号 (即每个分片中的队列下标)
+    std::unique_ptr<ShardRequest[]> requests_;  // 每个分片一个可复用的请求
+};
+
+/**
+ * @brief ShardedDB (分片引擎)
+ * 职责：按 Key 的哈希把键空间划分成 N 个互不共享的分片。
+ *
+ * 每个分片有自己的 DB (MemTable、WAL、SSTable 和后台 Compaction 线程)，
+ * 以及一个绑定到 CPU 核的工作线程；分片的 DB 只被这个线程访问。
+ * 请求通过 (会话, 分片) 的 SPSC 队列路由到分片线程，热路径上没有共享锁。
+ * 分片的数据放在 dbname/shard-NNN 目录中。
+ */
+class ShardedDB {
+public:
+    /**
+     * @brief 打开 (或创建) 分片数据库并启动分片线程
+     * @return 失败 (包括分片数与已有数据库不一致) 时返回 nullptr
+     */
+    static std::unique_ptr<ShardedDB> Open(const std::string& dbname, const ShardedOptions& options);
+
+    /**
+     * @brief 析构函数：停止分片线程并关闭所有分片 (所有会话必须已经销毁)
+     */
+    ~ShardedDB();
+
+    // 禁用拷贝和赋值
+    ShardedDB(const ShardedDB&) = delete;
+    ShardedDB& operator=(const ShardedDB&) = delete;
+
+    /**
+     * @brief 创建一个会话
+     * @return 会话数已达 max_sessions_ 时返回 nullptr
+     */
+    std::unique_ptr<ShardSession> NewSession();
+
+    /**
+     * @brief Key 所属的分片
+     */
+    int ShardFor(std::string_view key) const;
+
+    int NumShards() const { return static_cast<int>(shards_.size()); }
+
+    /**
+     * @brief 等待所有分片的后台刷盘和 Compaction 完成 (测试/压测使用)
+     */
+    void WaitForIdle();
+
+private:
+    friend class ShardSession;
+
+    /**
+     * @brief 一个分片的状态
+     */
+    struct Shard {
+        std::unique_ptr<DB> db_;
+        std::vector<std::unique_ptr<SpscQueue<ShardRequest*>>> queues_; // 每个会话一个
+        std::thread thread_;
+
+        // 空闲时分片线程在 cv_ 上睡眠；只有睡眠/唤醒时才使用 mutex_
+        std::atomic<bool> sleeping_{false};
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+
+    explicit ShardedDB(const ShardedOptions& options);
+
+    /**
+     * @brief (私有) 分片线程的主函数
+     */
+    void RunShard(Shard* shard, int index);
+
+    /**
+     * @brief (私有) 如果分片线程在睡眠，唤醒它
+     */
+    static void Wake(Shard* shard);
+
+    /**
+     * @brief (私有) 释放一个会话编号
+     */
+    void ReleaseSession(int id);
+
+    ShardedOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> stop_;
+
+    std::mutex session_mutex_;       // 只保护会话的创建和销毁
+    std::vector<bool> session_used_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 假定的缓存行大小 (head/tail 分开放，避免生产者和消费者互相使对方的缓存行失效)
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief SpscQueue (单生产者单消费者无锁队列)
+ * 职责：在两个固定线程之间传递元素，不使用任何锁。
+ * 固定容量的环形缓冲区；生产者只写 tail_，消费者只写 head_。
+ * 每一端都缓存对端的位置，只有在看起来满/空时才重新读取对端的原子变量。
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 容量 (向上取整到 2 的幂)
+     */
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+
+    // 禁用拷贝和赋值
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief (仅生产者调用) 入队
+     * @return false 如果队列已满
+     */
+    bool TryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        buffer_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief (仅消费者调用) 出队
+     * @return false 如果队列为空
+     */
+    bool TryPop(T* item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        *item = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 队列是否为空 (近似值，任意线程可调用)
+     */
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> buffer_;
+    size_t mask_;
+
+    // 消费者一端
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // 生产者一端
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+};
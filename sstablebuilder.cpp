@@ -1,15 +1,70 @@
 #include "sstablebuilder.h"
+#include "bloom.h"
+#include "fixedkeyblock.h"
 #include <iostream>  // 用于打印调试信息
+#include <algorithm>
 #include <cassert>   // 用于断言 (可选)
 
+/**
+ * @brief 计算页对齐所需的填充字节数
+ * 如果一个大小为 size 的块从 offset 开始写入，会比从页边界开始写入多触碰页，
+ * 则返回填充到下一个页边界所需的字节数；否则返回 0。
+ */
+static uint64_t ComputeAlignPadding(uint64_t offset, uint64_t size, uint64_t page_size) {
+    uint64_t in_page = offset & (page_size - 1);
+    if (in_page == 0) {
+        return 0; // 已经在页边界上
+    }
+    uint64_t min_pages = (size + page_size - 1) / page_size;
+    uint64_t actual_pages = (in_page + size + page_size - 1) / page_size;
+    return actual_pages > min_pages ? page_size - in_page : 0;
+}
+
 // 构造函数：初始化所有成员变量
-SSTableBuilder::SSTableBuilder(const std::string& filename)
-    : ofs_(filename, std::ios::binary | std::ios::trunc), // 清空并以二进制打开
+SSTableBuilder::SSTableBuilder(const std::string& filename, const BuilderOptions& options)
+    : options_(options),
       finished_(false),
+      offset_(0),
       cur_data_block_offset_(0) { // 第一个块从 offset 0 开始
+    if (options_.block_align_) {
+        assert(options_.page_size_ > 0 && (options_.page_size_ & (options_.page_size_ - 1)) == 0);
+    }
+    if (!CompressionSupported(options_.compression_.type_)) {
+        std::cerr << "警告: 不支持的压缩算法，数据块将不压缩" << std::endl;
+        options_.compression_.type_ = CompressionType::NONE;
+    }
+    Reset(filename);
+}
+
+/**
+ * @brief 复用 Builder：关闭旧文件，清空状态 (保留缓冲区容量)，打开新文件
+ */
+bool SSTableBuilder::Reset(const std::string& filename) {
+    if (ofs_.is_open()) {
+        ofs_.close();
+    }
+    ofs_.clear(); // 清除上一个文件留下的错误状态
+    ofs_.open(filename, std::ios::binary | std::ios::trunc); // 清空并以二进制打开
     if (!ofs_) {
         std::cerr << "错误: SSTableBuilder 无法打开文件 " << filename << std::endl;
     }
+
+    finished_ = false;
+    offset_ = 0;
+    props_ = TableProperties();
+    if (options_.block_align_) {
+        props_.page_size_ = options_.page_size_;
+    }
+    props_.compression_ = static_cast<uint64_t>(options_.compression_.type_);
+    props_.comparator_ = static_cast<uint64_t>(options_.comparator_);
+    cur_data_block_offset_ = 0;
+    // clear() 不释放容量，下一个文件可以直接复用这些缓冲区
+    cur_data_block_.clear();
+    last_key_in_block_.clear();
+    index_block_.clear();
+    filter_key_hashes_.clear();
+    filter_index_block_.clear();
+    return ofs_.is_open();
 }
 
 // 析构函数：确保文件关闭 (即使 Finish() 没有被调用)
@@ -27,9 +82,9 @@ SSTableBuilder::~SSTableBuilder() {
 bool SSTableBuilder::Add(std::string_view key, std::string_view value) {
     if (finished_ || !ofs_) return false; // 检查状态
 
-    // 检查 Key 必须是升序的 (防止逻辑错误)
-    if (!last_key_in_block_.empty() && cur_data_block_.empty() && key <= last_key_in_block_) {
-        // 只有在开启一个 *新* 块时，才需要和 *上一个* 块的 last_key 比较
+    // 检查 Key 必须是 (比较器顺序的) 升序 (防止逻辑错误)
+    // (last_key_in_block_ 在刷盘后不会被清空，所以它总是上一个添加的 Key)
+    if (props_.num_entries_ > 0 && CompareKeys(options_.comparator_, key, last_key_in_block_) <= 0) {
         std::cerr << "错误: Key 必须按全局升序添加。" << std::endl;
         return false;
     }
@@ -38,25 +93,62 @@ bool SSTableBuilder::Add(std::string_view key, std::string_view value) {
     uint32_t entry_size = getEntrySize(key, value); 
 
     // 2. 检查是否需要切分
-    if (cur_data_block_.empty()) {
-        // 这是块的第一个条目，记录“便签”：它的起始位置
-        cur_data_block_offset_ = static_cast<uint64_t>(ofs_.tellp());
-    } else if (cur_data_block_.size() + entry_size > DATA_BLOCK_SIZE_THRESHOLD) {
-        // 块满了 (超过 128 字节)，执行刷盘
+    // (块的起始 offset 在 FlushDataBlock() 中确定，因为页对齐可能在块前插入填充)
+    if (!cur_data_block_.empty() && cur_data_block_.size() + entry_size > BlockSizeLimit()) {
+        // 块满了 (超过阈值)，执行刷盘
         FlushDataBlock();
-        // 重置“便签”，为新块记录起始位置
-        cur_data_block_offset_ = static_cast<uint64_t>(ofs_.tellp());
     }
 
     // 3. 将 K/V 写入 *内存* 缓冲区 (函数来自 base.h)
+    if (cur_data_block_.empty()) {
+        block_entries_ = 0;
+        block_key_size_ = static_cast<uint32_t>(key.size());
+        block_fixed_keys_ = options_.fixed_key_blocks_ && !key.empty() && key.size() <= FixedKeyBlock::MAX_KEY_SIZE;
+    }
+    block_fixed_keys_ = block_fixed_keys_ && key.size() == block_key_size_;
+    block_entries_++;
     writeKV(&cur_data_block_, key, value);
 
-    // 4. 实时更新“便签”上的“最后一个 Key”
-    last_key_in_block_ = std::string(key); 
+    // 4. 实时更新“便签”上的“最后一个 Key” (assign 复用已有容量)
+    last_key_in_block_.assign(key.data(), key.size());
+
+    // 5. 记录 Key 的哈希，供 Filter 分区使用
+    if (options_.filter_bits_per_key_ > 0) {
+        filter_key_hashes_.push_back(BloomHash(key));
+    }
+
+    // 6. 累计表属性
+    props_.num_entries_++;
+    props_.raw_key_size_ += key.size();
+    props_.raw_value_size_ += value.size();
+    uint64_t timestamp = 0;
+    if (options_.timestamp_extractor_ && options_.timestamp_extractor_(key, &timestamp)) {
+        if (props_.num_timestamped_entries_ == 0 || timestamp < props_.min_timestamp_) {
+            props_.min_timestamp_ = timestamp;
+        }
+        props_.max_timestamp_ = std::max(props_.max_timestamp_, timestamp);
+        props_.num_timestamped_entries_++;
+    }
     
     return true;
 }
 
+/**
+ * @brief (私有) 当前生效的数据块切分阈值
+ */
+uint32_t SSTableBuilder::BlockSizeLimit() const {
+    if (!options_.block_align_) {
+        return options_.block_size_;
+    }
+    // 页对齐时，一个块 (连同压缩的类型字节) 最多占一页
+    // (压缩成功时块一定比原始数据小，最坏情况是退回不压缩，多出一个类型字节)
+    uint32_t page_limit = options_.page_size_;
+    if (options_.compression_.type_ != CompressionType::NONE) {
+        page_limit -= BLOCK_TYPE_SIZE;
+    }
+    return std::min(options_.block_size_, page_limit);
+}
+
 /**
  * @brief (私有) 刷写数据块，并 *更新* 内存索引
  */
@@ -65,68 +157,168 @@ void SSTableBuilder::FlushDataBlock() {
         return; // 没有数据可刷
     }
 
-    // 1. 将数据块缓冲区写入文件
-    ofs_.write(cur_data_block_.data(), cur_data_block_.size());
-    std::cout << "  [Builder] 刷盘 Data Block (Last Key: " << last_key_in_block_ << ")" << std::endl;
+    // 0. 定长 Key 布局 + 压缩 (开启时写入磁盘的是压缩后的块)
+    std::string_view block = cur_data_block_;
+    if (block_fixed_keys_ && block_entries_ > 1) {
+        FixedKeyBlock::Encode(cur_data_block_, block_key_size_, block_entries_, &fixed_block_);
+        // 条目很少时定长布局的头部和 offset 数组比省下的长度字段还多；
+        // 页对齐时如果因此超过一页，就退回普通布局 (切分时只按普通布局计算了大小)
+        if (!options_.block_align_ || fixed_block_.size() <= BlockSizeLimit()) {
+            block = fixed_block_;
+            props_.num_fixed_key_blocks_++;
+        }
+    }
+    props_.raw_data_size_ += block.size();
+    if (options_.compression_.type_ != CompressionType::NONE) {
+        CompressBlock(options_.compression_, block, &compressed_block_);
+        block = compressed_block_;
+    }
+
+    // 1. 页对齐: 如果块会多跨一页，先填充到下一个页边界
+    if (options_.block_align_) {
+        uint64_t padding = ComputeAlignPadding(offset_, block.size(), options_.page_size_);
+        static const char kZeros[512] = {0};
+        for (uint64_t left = padding; left > 0;) {
+            uint64_t n = left < sizeof(kZeros) ? left : sizeof(kZeros);
+            WriteRaw(kZeros, n);
+            left -= n;
+        }
+        props_.padding_size_ += padding;
+    }
+
+    // 2. 将数据块缓冲区写入文件 (填充之后的位置就是块的起始 offset)
+    cur_data_block_offset_ = offset_;
+    WriteRaw(block.data(), block.size());
+    KV_DEBUG_LOG("  [Builder] 刷盘 Data Block (Last Key: " << last_key_in_block_ << ")");
 
-    // 2. 创建 BlockHandle (指向刚写入的块)
+    // 3. 创建 BlockHandle (指向刚写入的块)
     BlockHandle handle;
     handle.offset_ = cur_data_block_offset_; // 使用“便签”上的 offset
-    handle.size_ = static_cast<uint32_t>(cur_data_block_.size());
+    handle.size_ = static_cast<uint32_t>(block.size());
 
-    // 3. 【实现】将索引条目 (last_key, handle) 存入 *内存* 索引
-    index_data_[last_key_in_block_] = handle;
+    // 4. 【实现】将索引条目 (last_key, handle) 追加到索引缓冲区
+    AppendHandleEntry(&index_block_, last_key_in_block_, handle);
 
-    // 4. 重置 Data Block 缓冲区
+    props_.num_data_blocks_++;
+    props_.data_size_ += block.size();
+
+    // 5. 重置 Data Block 缓冲区
     cur_data_block_.clear();
-    // (注意: cur_data_block_offset_ 会在 Add() 的开头被重置)
+
+    // 6. Filter 分区只在数据块边界上切分，这样每个数据块只属于一个分区
+    if (options_.filter_bits_per_key_ > 0 &&
+        filter_key_hashes_.size() * options_.filter_bits_per_key_ / 8 >= options_.filter_partition_size_) {
+        FlushFilterPartition();
+    }
+}
+
+/**
+ * @brief (私有) 构建并刷写一个 Filter 分区，并 *更新* 内存中的 Filter 索引
+ */
+void SSTableBuilder::FlushFilterPartition() {
+    if (filter_key_hashes_.empty()) {
+        return; // 没有 Key 可过滤
+    }
+
+    filter_block_.clear();
+    CreateBloomFilter(filter_key_hashes_, options_.filter_bits_per_key_, &filter_block_);
+
+    BlockHandle handle;
+    WriteBlock(filter_block_, &handle);
+    // 分区覆盖到当前数据块为止，所以用当前数据块的 last_key 作为索引 Key
+    AppendHandleEntry(&filter_index_block_, last_key_in_block_, handle);
+
+    props_.num_filter_partitions_++;
+    props_.filter_size_ += filter_block_.size();
+    filter_key_hashes_.clear();
+}
+
+/**
+ * @brief (私有) 向文件追加原始字节
+ */
+void SSTableBuilder::WriteRaw(const char* data, size_t size) {
+    ofs_.write(data, size);
+    offset_ += size;
+}
+
+/**
+ * @brief (私有) 在文件当前位置写入一个块
+ */
+void SSTableBuilder::WriteBlock(const std::string& contents, BlockHandle* handle) {
+    handle->offset_ = offset_;
+    handle->size_ = static_cast<uint32_t>(contents.size());
+    WriteRaw(contents.data(), contents.size());
 }
 
 /**
- * @brief (收尾) 写入 Index Block 和 Footer
+ * @brief (私有) 追加一个 (Key -> BlockHandle) 条目
+ */
+void SSTableBuilder::AppendHandleEntry(std::string* dst, std::string_view key, const BlockHandle& handle) {
+    handle_encoding_.clear();
+    handle.EncodeTo(&handle_encoding_);
+    writeKV(dst, key, handle_encoding_);
+}
+
+/**
+ * @brief (收尾) 写入 Filter Index、Index、Properties、MetaIndex Block 和 Footer
  */
 bool SSTableBuilder::Finish() {
     if (finished_ || !ofs_) return false;
 
-    // 1. 刷盘最后一个 Data Block
+    // 1. 刷盘最后一个 Data Block 和最后一个 Filter 分区
     FlushDataBlock();
+    FlushFilterPartition();
 
-    // 2. 准备并写入 Index Block
-    uint64_t index_block_offset = static_cast<uint64_t>(ofs_.tellp());
-    std::string index_block_buffer; 
-    std::cout << "  [Builder] 在 offset " << index_block_offset << " 写入索引块..." << std::endl;
+    // 2. 准备并写入 Filter Index Block (只有生成了 Filter 时才写)
+    std::string meta_index_buffer;
+    if (!filter_index_block_.empty()) {
+        BlockHandle filter_index_handle;
+        WriteBlock(filter_index_block_, &filter_index_handle);
+        AppendHandleEntry(&meta_index_buffer, METAINDEX_FILTER_INDEX_KEY, filter_index_handle);
+        KV_DEBUG_LOG("  [Builder] 写入 " << props_.num_filter_partitions_ << " 个 Filter 分区 ("
+                     << props_.filter_size_ << " 字节)");
+    }
 
-    for (const auto& pair : index_data_) {
-        // ... (写入 index_block_buffer) ...
-        const std::string& last_key = pair.first;
-        const BlockHandle& handle = pair.second;
-        std::string handle_encoded; 
-        handle.EncodeTo(&handle_encoded);
-        writeKV(&index_block_buffer, last_key, handle_encoded);
+    // 3. 写入 Index Block (条目已在 FlushDataBlock 中按序追加好)
+    KV_DEBUG_LOG("  [Builder] 在 offset " << offset_ << " 写入索引块...");
+    Footer footer;
+    WriteBlock(index_block_, &footer.index_block_handle_);
+    props_.index_size_ = index_block_.size();
+
+    // 4. 准备并写入 Properties Block 和 MetaIndex Block
+    std::string properties_block_buffer;
+    props_.EncodeTo(&properties_block_buffer);
+    BlockHandle properties_handle;
+    WriteBlock(properties_block_buffer, &properties_handle);
+    if (props_.padding_size_ > 0) {
+        KV_DEBUG_LOG("  [Builder] 页对齐填充 " << props_.padding_size_ << " 字节");
     }
+
+    AppendHandleEntry(&meta_index_buffer, METAINDEX_PROPERTIES_KEY, properties_handle);
+    WriteBlock(meta_index_buffer, &footer.metaindex_block_handle_);
     
-    ofs_.write(index_block_buffer.data(), index_block_buffer.size());
-    
-    // 3. 准备并写入 Footer
-    Footer footer;
-    footer.index_block_handle_.offset_ = index_block_offset; 
-    footer.index_block_handle_.size_ = static_cast<uint32_t>(index_block_buffer.size()); 
+    // 5. 写入 Footer
     footer.magic_number_ = SSTABLE_MAGIC_NUMBER;
 
     std::string footer_encoded;
     footer.EncodeTo(&footer_encoded); 
 
-    ofs_.write(footer_encoded.data(), FOOTER_SIZE);
+    WriteRaw(footer_encoded.data(), FOOTER_SIZE);
 
-    // --- 4. 收尾 ---
+    // --- 6. 收尾 ---
 
-    // 【修复】必须在 close() *之前* 获取文件大小
-    uint64_t final_file_size = static_cast<uint64_t>(ofs_.tellp());
+    uint64_t final_file_size = offset_;
 
     finished_ = true; 
+    ofs_.flush();
     ofs_.close();      
+    if (!ofs_) {
+        // 写入、刷新或关闭失败 (例如磁盘已满)：文件不完整，调用方不能使用它
+        std::cerr << "错误: SSTable 写入失败 (" << final_file_size << " 字节)" << std::endl;
+        return false;
+    }
     
     // 【修复】现在打印正确的大小
-    std::cout << "--- SSTable 构建完成 (" << final_file_size << " 字节) ---" << std::endl; 
+    KV_DEBUG_LOG("--- SSTable 构建完成 (" << final_file_size << " 字节) ---"); 
     return true;
-}
\ No newline at end of file
+}
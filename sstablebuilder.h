@@ -1,23 +1,91 @@
 #pragma once
 
 #include <string>
-#include <map>
 #include <fstream>      // 包含 std::ofstream
 #include <string_view>  // 包含 std::string_view
+#include <vector>
+#include <functional>
 #include "base.h"       // 包含 BlockHandle, Footer, getEntrySize, writeKV, 和常量
+#include "compression.h"
+#include "comparator.h"
+
+/**
+ * @brief 从 Key 中取出时间戳 (时间序列数据)
+ * @return false 如果这个 Key 不带时间戳
+ */
+using TimestampExtractor = std::function<bool(std::string_view key, uint64_t* timestamp)>;
+
+/**
+ * @brief 默认的时间戳格式：Key 的最后 8 个字节是大端编码的时间戳 (例如 [series][timestamp])
+ * 大端编码保证同一个 series 的 Key 按时间升序排列。
+ */
+inline bool ExtractTimestampSuffix(std::string_view key, uint64_t* timestamp) {
+    if (key.size() < sizeof(uint64_t)) {
+        return false;
+    }
+    uint64_t ts = 0;
+    for (size_t i = key.size() - sizeof(uint64_t); i < key.size(); i++) {
+        ts = (ts << 8) | static_cast<uint8_t>(key[i]);
+    }
+    *timestamp = ts;
+    return true;
+}
+
+/**
+ * @brief BuilderOptions (构建选项)
+ * 控制 Data Block 的切分与磁盘布局。
+ */
+struct BuilderOptions {
+    // Data Block 的切分阈值 (字节)
+    uint32_t block_size_ = DATA_BLOCK_SIZE_THRESHOLD;
+
+    // 是否开启页对齐布局:
+    // 1. 数据块不会超过一页 (块大小阈值被截断到 page_size_)
+    // 2. 如果一个数据块会跨越页边界，先用 0 填充到下一个页边界再写入
+    // 这样每次读块 (direct I/O 或 mmap) 只会触碰最少的页数。
+    bool block_align_ = false;
+
+    // 页对齐使用的页大小 (必须是 2 的幂)
+    uint32_t page_size_ = DEFAULT_PAGE_SIZE;
+
+    // Bloom Filter 每个 Key 的 bit 数 (0 表示不生成 Filter)
+    int filter_bits_per_key_ = 10;
+
+    // Filter 分区的目标大小 (字节)
+    // Filter 按数据块边界切分成多个分区，每个分区覆盖连续的若干个数据块，
+    // 顶层的 Filter Index 记录 (分区最后一个 Key -> 分区句柄)。
+    // Reader 只常驻 Filter Index，分区按需通过 BlockCache 加载。
+    uint32_t filter_partition_size_ = DEFAULT_PAGE_SIZE;
+
+    // 设置后在表属性中记录所有 Key 的最小/最大时间戳 (查询时据此跳过整个文件)
+    TimestampExtractor timestamp_extractor_;
+
+    // 数据块的压缩 (不支持的算法退回不压缩)
+    CompressionOptions compression_;
+
+    // Key 的顺序 (Add 必须按这个顺序调用；记录在表属性中，Reader 据此查找)
+    ComparatorType comparator_ = ComparatorType::BYTEWISE;
+
+    // 块内所有 Key 等长且不超过 8 字节时，使用定长 Key 布局 (见 FixedKeyBlock)
+    bool fixed_key_blocks_ = true;
+};
 
 /**
  * @brief SSTableBuilder (构建器)
- * 负责按顺序写入 K/V，并生成 V2 格式的 SSTable 文件。
- * 这是一个“一次性”的类，在 Finish() 后失效。
+ * 负责按顺序写入 K/V，并生成 V3 格式的 SSTable 文件。
+ * Finish() 后可以调用 Reset() 打开下一个文件继续复用，
+ * 内部缓冲区 (数据块、索引、Filter) 的容量会被保留，
+ * 因此刷盘/Compaction 连续生成多个文件时，每个 Key 几乎不需要分配内存。
  */
 class SSTableBuilder {
 public:
     /**
      * @brief 构造函数：打开一个文件准备写入
      * @param filename 要创建的 SSTable 文件名
+     * @param options 构建选项 (块大小、页对齐等)
      */
-    explicit SSTableBuilder(const std::string& filename);
+    explicit SSTableBuilder(const std::string& filename,
+                            const BuilderOptions& options = BuilderOptions());
 
     /**
      * @brief 析构函数：确保文件被关闭
@@ -41,37 +109,104 @@ public:
     /**
      * @brief 完成 SSTable 的构建。
      * 1. 刷盘最后一个 Data Block。
-     * 2. 写入 Index Block。
-     * 3. 写入 Footer。
-     * 4. 关闭文件。
+     * 2. 刷盘最后一个 Filter 分区，写入 Filter Index Block。
+     * 3. 写入 Index Block。
+     * 4. 写入 Properties Block 和 MetaIndex Block。
+     * 5. 写入 Footer。
+     * 6. 关闭文件。
      * @return true 成功；false 如果状态错误
      */
     bool Finish();
 
+    /**
+     * @brief 复用此 Builder 构建一个新文件 (选项不变)。
+     * 如果上一个文件还没有 Finish()，它会被直接关闭 (成为不完整的文件)。
+     * @param filename 要创建的 SSTable 文件名
+     * @return true 新文件成功打开
+     */
+    bool Reset(const std::string& filename);
+
     /**
      * @brief 检查文件是否成功打开
      */
     bool is_open() const { return ofs_.is_open(); }
 
+    /**
+     * @brief 估算当前文件大小 (已写入的字节 + 尚未刷盘的数据块和索引)
+     * (TableOutputManager 用它来决定何时切换到下一个文件；Finish() 后即为准确的文件大小)
+     */
+    uint64_t FileSize() const {
+        if (finished_) return offset_;
+        return offset_ + cur_data_block_.size() + index_block_.size() + filter_index_block_.size();
+    }
+
+    /**
+     * @brief 获取当前累计的表属性 (Finish() 后即为写入文件的最终值)
+     */
+    const TableProperties& GetProperties() const { return props_; }
+
 private:
     /**
      * @brief (私有) 将当前内存中的 Data Block 刷入磁盘
-     * 并在内存中更新索引 (index_data_)
+     * 并把索引条目追加到 index_block_
      */
     void FlushDataBlock();
 
+    /**
+     * @brief (私有) 当前生效的数据块切分阈值
+     * (开启页对齐时，块大小不会超过一页)
+     */
+    uint32_t BlockSizeLimit() const;
+
+    /**
+     * @brief (私有) 将当前累计的 Key 哈希构建成一个 Filter 分区并刷盘
+     * 并把 Filter 索引条目追加到 filter_index_block_
+     */
+    void FlushFilterPartition();
+
+    /**
+     * @brief (私有) 向文件追加原始字节，并推进 offset_
+     */
+    void WriteRaw(const char* data, size_t size);
+
+    /**
+     * @brief (私有) 在文件当前位置写入一个块，并返回指向它的句柄
+     */
+    void WriteBlock(const std::string& contents, BlockHandle* handle);
+
+    /**
+     * @brief (私有) 将一个 (Key -> BlockHandle) 条目追加到 dst
+     * (Index / Filter Index / MetaIndex 共用，复用 handle_encoding_ 避免分配)
+     */
+    void AppendHandleEntry(std::string* dst, std::string_view key, const BlockHandle& handle);
+
     // --- 成员变量 (统一带 _ 后缀) ---
     
     // 磁盘 I/O 相关
+    BuilderOptions options_; // 构建选项
     std::ofstream ofs_;      // 输出文件流
     bool finished_;          // 是否已调用 Finish()
+    uint64_t offset_;        // 已写入文件的字节数 (即下一次写入的位置)
+    TableProperties props_;  // 表属性 (在 Add / Flush 时累计)
     
     // Data Block 相关
     std::string cur_data_block_;         // 当前数据块的内存缓冲区 (使用 std::string 作为缓冲区)
     std::string last_key_in_block_;      // 当前数据块的最后一个 Key (用于更新索引)
+    std::string compressed_block_;       // 压缩后的数据块 (复用)
+    std::string fixed_block_;            // 定长 Key 布局的数据块 (复用)
+    uint32_t block_entries_ = 0;         // 当前数据块的条目数
+    uint32_t block_key_size_ = 0;        // 当前数据块第一个 Key 的长度
+    bool block_fixed_keys_ = false;      // 当前数据块的 Key 是否都等长且不超过 8 字节
     uint64_t cur_data_block_offset_;     // 当前数据块在文件中的起始偏移量
     
     // Index Block 相关
-    // 内存中的“索引” (Key: last_key, Value: BlockHandle)
-    std::map<std::string, BlockHandle> index_data_;
+    // Key 按升序到达，索引条目 (last_key, BlockHandle) 也天然有序，
+    // 所以直接按磁盘格式追加到缓冲区，Finish() 时整块写出即可。
+    std::string index_block_;
+    std::string handle_encoding_;        // 编码 BlockHandle 的临时缓冲区 (复用)
+
+    // Filter 相关
+    std::vector<uint32_t> filter_key_hashes_; // 当前 Filter 分区中所有 Key 的哈希
+    std::string filter_block_;                // 当前 Filter 分区的缓冲区 (复用)
+    std::string filter_index_block_;          // Filter Index Block (分区的 last_key -> 分区句柄)
 };
\ No newline at end of file
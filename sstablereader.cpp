@@ -1,13 +1,21 @@
 #include "sstablereader.h"
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include "bloom.h"
+#include "compression.h"
+#include "fixedkeyblock.h"
 
 /**
  * @brief 构造函数：打开文件并立即加载索引
  */
-SSTableReader::SSTableReader(const std::string& filename)
-    : ifs_(filename, std::ios::binary | std::ios::ate), // ate: 打开并定位到末尾
-      is_valid_(false) { // 默认无效，直到 LoadIndex 成功
+SSTableReader::SSTableReader(const std::string& filename, const ReaderOptions& options)
+    : options_(options),
+      cache_id_(BlockCache::NewId()),
+      ifs_(filename, std::ios::binary | std::ios::ate), // ate: 打开并定位到末尾
+      comparator_(ComparatorType::BYTEWISE),
+      is_valid_(false), // 默认无效，直到 LoadIndex 成功
+      filters_pinned_(false) {
     
     if (!ifs_) {
         std::cerr << "错误: SSTableReader 无法打开文件 " << filename << std::endl;
@@ -21,19 +29,42 @@ SSTableReader::SSTableReader(const std::string& filename)
     } else {
         is_valid_ = true; // 加载成功
     }
+
+    if (is_valid_ && options_.pin_filters_ && options_.block_cache_ != nullptr) {
+        for (const IndexEntry& entry : filter_index_data_) {
+            if (ReadBlock(entry.handle_, options_.filter_priority_, false) != nullptr) {
+                options_.block_cache_->Pin(cache_id_, entry.handle_.offset_);
+            }
+        }
+        filters_pinned_ = true;
+    }
 }
 
 /**
  * @brief 析构函数：关闭文件
  */
 SSTableReader::~SSTableReader() {
+    if (filters_pinned_) {
+        for (const IndexEntry& entry : filter_index_data_) {
+            options_.block_cache_->Erase(cache_id_, entry.handle_.offset_);
+        }
+    }
     if (ifs_.is_open()) {
         ifs_.close();
     }
 }
 
+void SSTableReader::UnpinFilters() {
+    if (!filters_pinned_.exchange(false)) {
+        return;
+    }
+    for (const IndexEntry& entry : filter_index_data_) {
+        options_.block_cache_->Unpin(cache_id_, entry.handle_.offset_);
+    }
+}
+
 /**
- * @brief (私有) 在构造时调用，读取 Footer 和 Index Block
+ * @brief (私有) 在构造时调用，读取 Footer、MetaIndex 及其指向的元数据块、Index Block
  */
 bool SSTableReader::LoadIndex() {
     // 1. 获取文件大小
@@ -59,9 +90,40 @@ bool SSTableReader::LoadIndex() {
         std::cerr << "错误: 魔数不匹配或文件损坏" << std::endl;
         return false;
     }
-    std::cout << "  [Reader] Footer 校验成功 (Magic Number OK)" << std::endl;
+    KV_DEBUG_LOG("  [Reader] Footer 校验成功 (Magic Number OK)");
 
-    // 3. 读取 Index Block (根据 Footer 的指引)
+    // 3. 读取 MetaIndex Block，找到各个元数据块
+    std::string meta_index_content;
+    std::map<std::string, BlockHandle> meta_index;
+    if (!ReadDataBlock(footer_.metaindex_block_handle_, &meta_index_content) ||
+        !DecodeHandleMap(meta_index_content, &meta_index)) {
+        std::cerr << "错误: 无法读取 MetaIndex Block" << std::endl;
+        return false;
+    }
+
+    // 3.1 Properties Block (必需)
+    auto meta_it = meta_index.find(METAINDEX_PROPERTIES_KEY);
+    std::string properties_block_content;
+    if (meta_it == meta_index.end() ||
+        !ReadDataBlock(meta_it->second, &properties_block_content) ||
+        !props_.DecodeFrom(properties_block_content)) {
+        std::cerr << "错误: 无法读取 Properties Block" << std::endl;
+        return false;
+    }
+    comparator_ = static_cast<ComparatorType>(props_.comparator_);
+
+    // 3.2 Filter Index Block (可选；只有配置了块缓存才加载)
+    meta_it = meta_index.find(METAINDEX_FILTER_INDEX_KEY);
+    if (meta_it != meta_index.end() && options_.block_cache_ != nullptr) {
+        std::string filter_index_content;
+        if (!ReadDataBlock(meta_it->second, &filter_index_content) ||
+            !DecodeHandleList(filter_index_content, &filter_index_data_)) {
+            std::cerr << "错误: 无法读取 Filter Index Block" << std::endl;
+            return false;
+        }
+    }
+
+    // 4. 读取 Index Block (根据 Footer 的指引)
     std::string index_block_content;
     // (调用私有辅助函数 ReadDataBlock 来读取索引块)
     if (!ReadDataBlock(footer_.index_block_handle_, &index_block_content)) {
@@ -69,31 +131,107 @@ bool SSTableReader::LoadIndex() {
         return false;
     }
     
-    // 4. 解析 Index Block, 填充 index_data_ (内存中的 map)
-    std::string_view input = index_block_content;
+    // 5. 解析 Index Block, 填充 index_data_ (内存中的有序列表)
+    if (!DecodeHandleList(index_block_content, &index_data_)) {
+        std::cerr << "错误: 解析 Index Block 失败" << std::endl;
+        return false;
+    }
+    KV_DEBUG_LOG("  [Reader] 索引加载完成, " << index_data_.size() << " 个条目, "
+                 << filter_index_data_.size() << " 个 Filter 分区。");
+    return true;
+}
+
+/**
+ * @brief (私有) 解析 (Key -> BlockHandle) 的 K/V 序列
+ */
+bool SSTableReader::DecodeHandleMap(std::string_view input, std::map<std::string, BlockHandle>* handles) {
     while (!input.empty()) {
-        std::string_view last_key;
+        std::string_view key;
         std::string_view handle_data;
         // (readKV 来自 base.h)
-        if (!readKV(&input, &last_key, &handle_data)) {
-            std::cerr << "错误: 解析 Index Block 失败" << std::endl;
+        if (!readKV(&input, &key, &handle_data)) {
             return false;
         }
 
         BlockHandle handle;
         // (DecodeFrom 来自 base.h)
         if (!handle.DecodeFrom(&handle_data)) {
-            std::cerr << "错误: 解析 BlockHandle 失败" << std::endl;
             return false;
         }
         
-        // 将 (last_key, handle) 存入内存 map
-        index_data_[std::string(last_key)] = handle;
+        // 将 (key, handle) 存入内存 map
+        (*handles)[std::string(key)] = handle;
+    }
+    return true;
+}
+
+/**
+ * @brief (私有) 解析 Index / Filter Index Block 为有序列表
+ */
+bool SSTableReader::DecodeHandleList(std::string_view input, HandleList* handles) {
+    handles->clear();
+    while (!input.empty()) {
+        std::string_view key;
+        std::string_view handle_data;
+        BlockHandle handle;
+        if (!readKV(&input, &key, &handle_data) || !handle.DecodeFrom(&handle_data)) {
+            return false;
+        }
+        // Builder 按比较器顺序写出条目，直接追加即可保持有序
+        handles->push_back(IndexEntry{PrefixedKey(std::string(key)), handle});
     }
-    std::cout << "  [Reader] 索引加载完成, " << index_data_.size() << " 个条目。" << std::endl;
     return true;
 }
 
+template <typename Comparator>
+SSTableReader::HandleList::const_iterator SSTableReader::FindHandle(const HandleList& handles,
+                                                                    std::string_view key) {
+    // 目标 Key 的缩写只计算一次；缩写不同的条目一次整数比较即可排除
+    return std::lower_bound(handles.begin(), handles.end(), PrefixedKeyRef(key),
+                            [](const IndexEntry& entry, PrefixedKeyRef target) {
+                                return ComparePrefixed<Comparator>(entry.key_, target) < 0;
+                            });
+}
+
+template <typename Comparator>
+void SSTableReader::FindHandles(const HandleList& handles, const std::vector<std::string_view>& keys,
+                                std::vector<size_t>* positions) {
+    positions->assign(keys.size(), handles.size());
+    if (handles.empty()) {
+        return;
+    }
+    for (size_t begin = 0; begin < keys.size(); begin += MULTIGET_BATCH) {
+        const size_t n = std::min(MULTIGET_BATCH, keys.size() - begin);
+        uint64_t prefixes[MULTIGET_BATCH];
+        size_t bases[MULTIGET_BATCH];
+        for (size_t j = 0; j < n; j++) {
+            prefixes[j] = KeyPrefix(keys[begin + j]);
+            bases[j] = 0;
+        }
+        // 无分支形式的 lower_bound: 每一轮所有查找的区间长度同步减半，
+        // 轮数只取决于 handles.size()，因此不需要为每个查找单独调度状态机
+        size_t length = handles.size();
+        while (length > 1) {
+            const size_t half = length / 2;
+            const size_t next_half = (length - half) / 2;
+            for (size_t j = 0; j < n; j++) {
+                PrefixedKeyRef target(prefixes[j], keys[begin + j]);
+                if (ComparePrefixed<Comparator>(handles[bases[j] + half].key_, target) < 0) {
+                    bases[j] += half;
+                }
+                // 本轮其余查找的比较会掩盖这次预取的延迟
+                __builtin_prefetch(&handles[bases[j] + next_half]);
+            }
+            length -= half;
+        }
+        for (size_t j = 0; j < n; j++) {
+            PrefixedKeyRef target(prefixes[j], keys[begin + j]);
+            (*positions)[begin + j] =
+                bases[j] + (ComparePrefixed<Comparator>(handles[bases[j]].key_, target) < 0 ? 1 : 0);
+        }
+    }
+}
+
 /**
  * @brief (公有) 查找一个 Key
  */
@@ -101,42 +239,229 @@ bool SSTableReader::Get(std::string_view key, std::string* value) {
     if (!is_valid_) {
         return false; // 文件未成功加载
     }
+    // 只在这里按比较器分派一次，之后的每次比较都是内联的
+    return DispatchComparator(comparator_, [&](auto comparator) {
+        return GetImpl<decltype(comparator)>(key, value);
+    });
+}
 
+template <typename Comparator>
+bool SSTableReader::GetImpl(std::string_view key, std::string* value) {
     // --- 核心的两级查找 ---
 
-    // 1.【查找级别 1 (内存)】: 在 Index Block (内存 map) 中二分查找
+    // 1.【查找级别 1 (内存)】: 在 Index Block (内存中的有序列表) 中二分查找
     // lower_bound: 找到第一个 *不小于* key 的条目。
     // 这就是 key *可能* 所在的那个 Data Block (的索引)。
-    auto it = index_data_.lower_bound(std::string(key));
+    auto it = FindHandle<Comparator>(index_data_, key);
     if (it == index_data_.end()) {
         // key 比所有 Data Block 的 'last_key' 都大，所以不存在
         return false;
     }
+
+    // 2.【过滤】: Filter 分区说“一定不存在”时，省掉一次数据块读取
+    if (!KeyMayMatch<Comparator>(key)) {
+        return false;
+    }
     
-    // 2. 找到了 Data Block 的句柄 (Handle)
-    const BlockHandle& handle = it->second;
+    // 3. 找到了 Data Block 的句柄 (Handle)
+    const BlockHandle& handle = it->handle_;
 
-    // 3.【查找级别 2 (磁盘 I/O)】: 读取 Data Block 到内存
-    std::string block_content;
-    if (!ReadDataBlock(handle, &block_content)) {
+    // 4.【查找级别 2 (磁盘 I/O 或块缓存)】: 读取 Data Block 到内存
+    std::shared_ptr<const BlockContents> block = ReadBlock(handle, options_.data_priority_, true);
+    if (block == nullptr) {
         return false; // I/O 错误
     }
 
-    // 4.【查找级别 3 (CPU)】: 在 Data Block 内部查找 Key
-    return FindInBlock(block_content, key, value);
+    // 5.【查找级别 3 (CPU)】: 在 Data Block 内部查找 Key
+    return FindInBlock<Comparator>(*block, key, value);
+}
+
+/**
+ * @brief (公有) 批量查找一组 Key
+ */
+void SSTableReader::MultiGet(const std::vector<std::string_view>& keys,
+                             std::vector<std::string>* values, std::vector<bool>* found) {
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    if (!is_valid_) {
+        return;
+    }
+    DispatchComparator(comparator_, [&](auto comparator) {
+        MultiGetImpl<decltype(comparator)>(keys, values, found);
+    });
+}
+
+template <typename Comparator>
+void SSTableReader::MultiGetImpl(const std::vector<std::string_view>& keys,
+                                 std::vector<std::string>* values, std::vector<bool>* found) {
+    // 1. 所有 Key 交错地在 Index (以及 Filter Index) 上二分
+    std::vector<size_t> blocks;
+    FindHandles<Comparator>(index_data_, keys, &blocks);
+    std::vector<size_t> filters;
+    FindHandles<Comparator>(filter_index_data_, keys, &filters);
+
+    // 2. 按数据块顺序处理 (Filter 分区的顺序与之一致)，相邻的 Key 复用同一个块
+    std::vector<size_t> order;
+    order.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (blocks[i] < index_data_.size()) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&blocks](size_t a, size_t b) { return blocks[a] < blocks[b]; });
+
+    std::shared_ptr<const BlockContents> filter;
+    size_t filter_pos = filter_index_data_.size();
+    std::shared_ptr<const BlockContents> block;
+    size_t block_pos = index_data_.size();
+    for (size_t i : order) {
+        if (filters[i] < filter_index_data_.size()) {
+            if (filters[i] != filter_pos) {
+                filter_pos = filters[i];
+                filter = ReadBlock(filter_index_data_[filter_pos].handle_, options_.filter_priority_, false);
+            }
+            if (filter != nullptr && !BloomMayMatch(keys[i], *filter)) {
+                continue; // 一定不存在
+            }
+        }
+        if (blocks[i] != block_pos) {
+            block_pos = blocks[i];
+            block = ReadBlock(index_data_[block_pos].handle_, options_.data_priority_, true);
+        }
+        if (block != nullptr) {
+            (*found)[i] = FindInBlock<Comparator>(*block, keys[i], &(*values)[i]);
+        }
+    }
+}
+
+/**
+ * @brief (公有) 把一个块读入块缓存
+ */
+size_t SSTableReader::PrefetchBlock(uint64_t offset) {
+    BlockCache* cache = options_.block_cache_;
+    if (!is_valid_ || cache == nullptr) {
+        return 0;
+    }
+    // 数据块和 Filter 分区都按写入顺序排列，偏移量递增
+    auto find = [offset](const HandleList& handles) {
+        auto it = std::lower_bound(handles.begin(), handles.end(), offset,
+            [](const IndexEntry& entry, uint64_t target) { return entry.handle_.offset_ < target; });
+        return (it != handles.end() && it->handle_.offset_ == offset) ? &it->handle_ : nullptr;
+    };
+    const BlockHandle* handle = find(index_data_);
+    const bool data_block = (handle != nullptr);
+    if (!data_block) {
+        handle = find(filter_index_data_);
+        if (handle == nullptr) {
+            return 0;
+        }
+    }
+    if (cache->Contains(cache_id_, offset)) {
+        return 0; // (Contains 不影响命中统计和 LRU 顺序)
+    }
+    BlockCache::Priority priority = data_block ? options_.data_priority_ : options_.filter_priority_;
+    return ReadBlock(*handle, priority, data_block) != nullptr ? handle->size_ : 0;
+}
+
+/**
+ * @brief (公有) 从内存索引中取出所有数据块的句柄
+ */
+std::vector<BlockHandle> SSTableReader::GetDataBlockHandles() const {
+    std::vector<BlockHandle> handles;
+    handles.reserve(index_data_.size());
+    for (const IndexEntry& entry : index_data_) {
+        handles.push_back(entry.handle_);
+    }
+    return handles;
+}
+
+/**
+ * @brief (私有) 通过 Filter 分区判断 Key 是否可能存在
+ */
+template <typename Comparator>
+bool SSTableReader::KeyMayMatch(std::string_view key) {
+    if (filter_index_data_.empty()) {
+        return true; // 没有 Filter，只能去读数据块
+    }
+    // 分区与数据块的切分边界一致，所以同样用 lower_bound 找到覆盖 key 的分区
+    auto it = FindHandle<Comparator>(filter_index_data_, key);
+    if (it == filter_index_data_.end()) {
+        return true;
+    }
+    std::shared_ptr<const BlockContents> filter = ReadBlock(it->handle_, options_.filter_priority_, false);
+    if (filter == nullptr) {
+        return true; // 读不到 Filter 时不能断定不存在
+    }
+    return BloomMayMatch(key, *filter);
+}
+
+/**
+ * @brief (私有) 通过块缓存读取一个块
+ */
+std::shared_ptr<const BlockContents> SSTableReader::ReadBlock(const BlockHandle& handle,
+                                                            BlockCache::Priority priority, bool data_block) {
+    BlockCache* cache = options_.block_cache_;
+    if (cache != nullptr) {
+        std::shared_ptr<const BlockContents> cached = cache->Lookup(cache_id_, handle.offset_, priority);
+        if (cached != nullptr) {
+            return cached; // 缓存命中，无需 I/O
+        }
+    }
+
+    // 放入缓存的块从缓存的内存池分配 (开启大页时在大页上)
+    std::shared_ptr<BlockContents> block = cache != nullptr ? cache->NewBlock() : std::make_shared<BlockContents>();
+    if (data_block && props_.compression_ != static_cast<uint64_t>(CompressionType::NONE)) {
+        std::string compressed;
+        if (!ReadDataBlock(handle, &compressed)) {
+            return nullptr;
+        }
+        if (!UncompressBlock(compressed, block.get())) {
+            std::cerr << "错误: 数据块解压失败 (offset " << handle.offset_ << ")" << std::endl;
+            return nullptr;
+        }
+    } else if (!ReadDataBlock(handle, block.get())) {
+        return nullptr;
+    }
+    if (cache != nullptr) {
+        cache->Insert(cache_id_, handle.offset_, block, priority);
+    }
+    return block;
 }
 
 /**
  * @brief (私有 I/O) 根据 BlockHandle 读取一个完整的块到内存
  */
-bool SSTableReader::ReadDataBlock(const BlockHandle& handle, std::string* block_content) {
+template <typename String>
+bool SSTableReader::ReadDataBlock(const BlockHandle& handle, String* block_content) {
     block_content->resize(handle.size_);
+    // seek + read 必须是一个整体，多个线程共享同一个 Reader 时需要加锁
+    std::lock_guard<std::mutex> lock(io_mutex_);
     ifs_.seekg(handle.offset_); // 定位
     ifs_.read(&(*block_content)[0], handle.size_); // 读取
     
     if (ifs_.gcount() != handle.size_) {
         std::cerr << "错误: 读取 Data Block 失败 (预期 " << handle.size_ 
                   << ", 实际 " << ifs_.gcount() << ")" << std::endl;
+        ifs_.clear(); // 清除错误状态，不影响后续读取
+        return false;
+    }
+    return true;
+}
+
+bool SSTableReader::ReadFileContents(std::string* contents) {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    ifs_.seekg(0, std::ios::end);
+    std::streamoff file_size = ifs_.tellg();
+    if (file_size < 0) {
+        ifs_.clear();
+        return false;
+    }
+    contents->resize(file_size);
+    ifs_.seekg(0);
+    ifs_.read(&(*contents)[0], file_size);
+    if (ifs_.gcount() != file_size) {
+        std::cerr << "错误: 读取文件内容失败" << std::endl;
+        ifs_.clear();
         return false;
     }
     return true;
@@ -146,7 +471,22 @@ bool SSTableReader::ReadDataBlock(const BlockHandle& handle, std::string* block_
  * @brief (私有 CPU) 在内存块中线性扫描
  * (V1 实现：线性扫描。V2 可升级为二分查找)
  */
+template <typename Comparator>
 bool SSTableReader::FindInBlock(std::string_view block_content, std::string_view key, std::string* value) {
+    // 定长 Key 布局：直接在 Key 数组上查找，不需要逐条解析
+    if (FixedKeyBlock::Is(block_content)) {
+        FixedKeyBlock block;
+        if (!block.Parse(block_content)) {
+            return false; // 块损坏
+        }
+        uint32_t i = block.LowerBound<Comparator>(key);
+        if (i == block.count() || block.key(i) != key) {
+            return false;
+        }
+        value->assign(block.value(i).data(), block.value(i).size());
+        return true;
+    }
+
     std::string_view input = block_content;
     while (!input.empty()) {
         std::string_view current_key;
@@ -156,11 +496,12 @@ bool SSTableReader::FindInBlock(std::string_view block_content, std::string_view
             return false; // 块损坏
         }
         
-        if (current_key == key) {
+        int cmp = Comparator::Compare(current_key, key);
+        if (cmp == 0) {
             *value = std::string(current_value);
             return true; // 找到了！
         }
-        if (current_key > key) {
+        if (cmp > 0) {
             // 优化：Data Block 内部也是有序的，如果
             // 当前 key 已经大于要找的 key，说明找不到了
             return false;
@@ -168,3 +509,128 @@ bool SSTableReader::FindInBlock(std::string_view block_content, std::string_view
     }
     return false; // 块内未找到
 }
+
+/**
+ * @brief TableIterator (SSTable 迭代器)
+ * 沿着内存中的索引逐个加载 Data Block，在块内按顺序解析 K/V。
+ */
+class TableIterator : public Iterator {
+public:
+    TableIterator(SSTableReader* reader, BlockCache::Priority data_priority)
+        : reader_(reader),
+          data_priority_(data_priority),
+          index_it_(reader->index_data_.end()),
+          ok_(reader->is_valid_) {}
+
+    bool Valid() const override { return valid_; }
+    bool ok() const override { return ok_; }
+    std::string_view key() const override { return key_; }
+    std::string_view value() const override { return value_; }
+
+    void SeekToFirst() override {
+        index_it_ = reader_->index_data_.begin();
+        LoadBlock();
+        ParseNext();
+    }
+
+    void Seek(std::string_view target) override {
+        // 和 Get() 一样：第一个 last_key >= target 的块就是 target 所在的块
+        DispatchComparator(reader_->comparator_, [&](auto comparator) {
+            using Comparator = decltype(comparator);
+            index_it_ = SSTableReader::FindHandle<Comparator>(reader_->index_data_, target);
+            LoadBlock();
+            if (fixed_) {
+                fixed_index_ = fixed_block_.LowerBound<Comparator>(target); // 块内直接定位
+            }
+            ParseNext();
+            while (valid_ && Comparator::Compare(key_, target) < 0) {
+                ParseNext();
+            }
+        });
+    }
+
+    void Next() override {
+        ParseNext();
+    }
+
+private:
+    /**
+     * @brief 加载 index_it_ 指向的数据块 (到达末尾时清空)
+     */
+    void LoadBlock() {
+        block_.reset();
+        block_input_ = std::string_view();
+        fixed_ = false;
+        if (!ok_ || index_it_ == reader_->index_data_.end()) {
+            return;
+        }
+        block_ = reader_->ReadBlock(index_it_->handle_, data_priority_, true);
+        if (block_ == nullptr) {
+            ok_ = false; // I/O 错误
+            return;
+        }
+        block_input_ = *block_;
+        fixed_ = FixedKeyBlock::Is(block_input_);
+        fixed_index_ = 0;
+        if (fixed_ && !fixed_block_.Parse(block_input_)) {
+            ok_ = false; // 块损坏
+            fixed_ = false;
+            block_input_ = std::string_view();
+        }
+    }
+
+    /**
+     * @brief 当前块是否还有没解析的条目
+     */
+    bool BlockExhausted() const {
+        return fixed_ ? fixed_index_ >= fixed_block_.count() : block_input_.empty();
+    }
+
+    /**
+     * @brief 解析下一个 K/V；当前块读完时自动切换到下一个块
+     */
+    void ParseNext() {
+        while (BlockExhausted()) {
+            if (!ok_ || index_it_ == reader_->index_data_.end()) {
+                valid_ = false;
+                return;
+            }
+            ++index_it_;
+            LoadBlock();
+        }
+        if (fixed_) {
+            key_ = fixed_block_.key(fixed_index_);
+            value_ = fixed_block_.value(fixed_index_);
+            fixed_index_++;
+            valid_ = true;
+            return;
+        }
+        if (!readKV(&block_input_, &key_, &value_)) {
+            ok_ = false; // 块损坏
+            valid_ = false;
+            return;
+        }
+        valid_ = true;
+    }
+
+    SSTableReader* reader_;
+    BlockCache::Priority data_priority_;
+    SSTableReader::HandleList::const_iterator index_it_; // 当前块的索引条目
+    std::shared_ptr<const BlockContents> block_; // 当前块 (持有它以保证 key_/value_ 有效)
+    std::string_view block_input_;             // 当前块中尚未解析的部分 (普通布局)
+    bool fixed_ = false;                       // 当前块是否是定长 Key 布局
+    FixedKeyBlock fixed_block_;
+    uint32_t fixed_index_ = 0;                 // 定长 Key 布局中下一个要输出的条目
+    std::string_view key_;
+    std::string_view value_;
+    bool valid_ = false;
+    bool ok_;
+};
+
+std::unique_ptr<Iterator> SSTableReader::NewIterator() {
+    return NewIterator(options_.data_priority_);
+}
+
+std::unique_ptr<Iterator> SSTableReader::NewIterator(BlockCache::Priority data_priority) {
+    return std::unique_ptr<Iterator>(new TableIterator(this, data_priority));
+}
@@ -2,26 +2,57 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <fstream>
 #include <string_view>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include "base.h" // 包含 BlockHandle, Footer, readKV, 和常量
+#include "blockcache.h"
+#include "iterator.h"
+#include "comparator.h"
+
+/**
+ * @brief ReaderOptions (读取选项)
+ */
+struct ReaderOptions {
+    // 块缓存 (可选，不归 Reader 所有；多个 Reader 可以共享同一个缓存)
+    // 设置后，Data Block 和 Filter 分区都会通过缓存读取；
+    // 未设置时不使用 Filter (避免每次查找都多读一次磁盘)。
+    BlockCache* block_cache_ = nullptr;
+
+    // Filter 分区在块缓存中的优先级
+    BlockCache::Priority filter_priority_ = BlockCache::Priority::HIGH;
+
+    // Data Block 在块缓存中的优先级
+    BlockCache::Priority data_priority_ = BlockCache::Priority::LOW;
+
+    // 打开时把所有 Filter 分区读入块缓存并固定 (Pin)，直到 UnpinFilters() 或 Reader 析构
+    // (用于 L0 文件：每次查找都要查它们的 Filter，不应该被数据块挤出缓存)
+    bool pin_filters_ = false;
+};
 
 /**
  * @brief SSTableReader (读取器)
  * 职责：只读取 SSTable。
  * 负责打开一个 SSTable, (倒着读)加载其索引, 并提供 Get() 方法。
  * 这是一个“持久”的类，在构造时加载索引。
+ * Key 的顺序由文件的表属性 (kv.comparator) 决定：每次查找只按比较器类型分派一次，
+ * 索引二分和块内查找都是针对该比较器实例化的模板。
  */
 class SSTableReader {
 public:
     /**
      * @brief 构造函数：打开一个文件准备读取
      * @param filename 要读取的 SSTable 文件名
+     * @param options 读取选项 (块缓存等)
      */
-    explicit SSTableReader(const std::string& filename);
+    explicit SSTableReader(const std::string& filename,
+                           const ReaderOptions& options = ReaderOptions());
 
     /**
-     * @brief 析构函数：关闭文件
+     * @brief 析构函数：关闭文件，从块缓存中删除固定的 Filter 分区
      */
     ~SSTableReader();
 
@@ -31,19 +62,80 @@ public:
 
     /**
      * @brief (核心 API) 查找一个 Key。
-     * 执行“两级查找”（1. 查内存索引 -> 2. 查磁盘数据块）
+     * 执行“两级查找”（1. 查内存索引 -> 2. 查 Filter 分区 -> 3. 查磁盘数据块）
      * @param key 要查找的 Key
      * @param value [out] 如果找到，值被存入这里
      * @return true 如果找到, false 如果未找到
      */
     bool Get(std::string_view key, std::string* value);
 
+    /**
+     * @brief 批量查找一组 Key (语义与逐个调用 Get 相同)
+     * 所有 Key 的索引二分交错进行：每一轮依次推进每个查找的一步，并为它的下一次探测发出预取，
+     * 一个查找等待内存时其它查找继续计算；之后按数据块顺序处理，落在同一块中的 Key 只读一次块。
+     * @param values [out] 与 keys 一一对应；未找到的位置为空
+     * @param found [out] 与 keys 一一对应
+     */
+    void MultiGet(const std::vector<std::string_view>& keys,
+                  std::vector<std::string>* values, std::vector<bool>* found);
+
+    /**
+     * @brief 创建一个按 Key 升序遍历整个文件的迭代器
+     * (迭代器使用期间 Reader 必须保持存活)
+     */
+    std::unique_ptr<Iterator> NewIterator();
+
+    /**
+     * @brief 同上，但数据块以 data_priority 读入块缓存
+     * (例如 Compaction 的输入只读一次，用 BOTTOM 避免挤掉用户读取的热块)
+     */
+    std::unique_ptr<Iterator> NewIterator(BlockCache::Priority data_priority);
+
     /**
      * @brief 检查文件是否成功打开并且索引已加载
      */
     bool is_valid() const { return is_valid_; }
 
+    /**
+     * @brief 获取文件的表属性 (在 LoadIndex 时从 Properties Block 加载)
+     */
+    const TableProperties& GetProperties() const { return props_; }
+
+    /**
+     * @brief 读取整个文件的原始内容 (复制时用于传输 SSTable)
+     * 通过已打开的文件句柄读取，因此文件被删除后依然可用。
+     */
+    bool ReadFileContents(std::string* contents);
+
+    /**
+     * @brief 本文件在块缓存中的 id (块缓存的键是 (id, offset))
+     */
+    uint64_t cache_id() const { return cache_id_; }
+
+    /**
+     * @brief Filter 分区是否固定在块缓存中 (ReaderOptions::pin_filters_)
+     */
+    bool filters_pinned() const { return filters_pinned_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 取消固定 Filter 分区 (例如文件离开 L0)，之后它们和其它块一样参与淘汰
+     */
+    void UnpinFilters();
+
+    /**
+     * @brief 把偏移量为 offset 的数据块或 Filter 分区读入块缓存 (缓存预热)
+     * @return 从文件读取的字节数；已经在缓存中、没有配置缓存或 offset 不是块的起点时返回 0
+     */
+    size_t PrefetchBlock(uint64_t offset);
+
+    /**
+     * @brief 所有数据块的句柄 (按 Key 顺序，也就是按文件中的位置；用于检查磁盘布局)
+     */
+    std::vector<BlockHandle> GetDataBlockHandles() const;
+
 private:
+    friend class TableIterator; // 迭代器需要访问索引和 ReadBlock()
+
     /**
      * @brief (私有) 在构造时调用，读取 Footer 和 Index Block 到内存
      * @return true 成功加载, false 失败
@@ -53,10 +145,77 @@ private:
     /**
      * @brief (私有 I/O) 根据 BlockHandle 从磁盘读取一个 Data Block
      * @param handle 指向 Data Block 的指针 (offset, size)
-     * @param block_content [out] 读出的数据块内容
+     * @param block_content [out] 读出的数据块内容 (std::string 或块缓存内存池中的 BlockContents)
      * @return true 成功, false 失败
      */
-    bool ReadDataBlock(const BlockHandle& handle, std::string* block_content);
+    template <typename String>
+    bool ReadDataBlock(const BlockHandle& handle, String* block_content);
+
+    /**
+     * @brief (私有) 通过块缓存读取一个块 (未配置缓存时直接读磁盘)
+     * @param handle 指向块的指针 (offset, size)
+     * @param priority 未命中时插入缓存使用的优先级
+     * @param data_block 是否是数据块 (文件开启了压缩时需要解压；缓存中存放解压后的内容)
+     * @return 块内容；I/O 失败或块损坏时返回 nullptr
+     */
+    std::shared_ptr<const BlockContents> ReadBlock(const BlockHandle& handle,
+                                                 BlockCache::Priority priority, bool data_block);
+
+    // 索引条目: 块的最后一个 Key (带 8 字节缩写，二分时大多只比较缩写) -> BlockHandle
+    struct IndexEntry {
+        PrefixedKey key_;
+        BlockHandle handle_;
+    };
+
+    // 按比较器顺序排列的索引条目列表 (Index / Filter Index)
+    using HandleList = std::vector<IndexEntry>;
+
+    /**
+     * @brief (私有) Get 针对某个比较器的实现
+     */
+    template <typename Comparator>
+    bool GetImpl(std::string_view key, std::string* value);
+
+    /**
+     * @brief (私有) MultiGet 针对某个比较器的实现
+     */
+    template <typename Comparator>
+    void MultiGetImpl(const std::vector<std::string_view>& keys,
+                      std::vector<std::string>* values, std::vector<bool>* found);
+
+    /**
+     * @brief (私有) 通过 Filter 分区判断 Key 是否 *可能* 存在
+     * @return false 表示一定不存在 (可以跳过数据块读取)
+     */
+    template <typename Comparator>
+    bool KeyMayMatch(std::string_view key);
+
+    /**
+     * @brief (私有) 二分查找第一个 Key 不小于 key 的条目 (即 key 可能所在的块)
+     */
+    template <typename Comparator>
+    static HandleList::const_iterator FindHandle(const HandleList& handles, std::string_view key);
+
+    /**
+     * @brief (私有) FindHandle 的批量版本：keys 同时在 handles 上二分 (每批 MULTIGET_BATCH 个交错推进)
+     * @param positions [out] 与 keys 一一对应，第一个 Key 不小于目标的条目下标 (handles.size() 表示没有)
+     */
+    template <typename Comparator>
+    static void FindHandles(const HandleList& handles, const std::vector<std::string_view>& keys,
+                            std::vector<size_t>* positions);
+
+    // FindHandles 同时在途的查找数 (足够覆盖一次内存访问的延迟，又不会让预取挤占缓存)
+    static constexpr size_t MULTIGET_BATCH = 16;
+
+    /**
+     * @brief (私有) 解析 MetaIndex Block (元数据块名 -> BlockHandle)
+     */
+    static bool DecodeHandleMap(std::string_view input, std::map<std::string, BlockHandle>* handles);
+
+    /**
+     * @brief (私有) 解析 Index / Filter Index Block (文件中已经按比较器顺序排列)
+     */
+    static bool DecodeHandleList(std::string_view input, HandleList* handles);
 
     /**
      * @brief (私有 CPU) 在内存中的 Data Block (buffer) 中查找 Key
@@ -65,15 +224,26 @@ private:
      * @param value [out] 如果找到，值被存入这里
      * @return true 找到, false 未找到
      */
-    bool FindInBlock(std::string_view block_content, std::string_view key, std::string* value);
+    template <typename Comparator>
+    static bool FindInBlock(std::string_view block_content, std::string_view key, std::string* value);
 
     // --- 成员变量 (统一带 _ 后缀) ---
     
+    ReaderOptions options_; // 读取选项
+    uint64_t cache_id_;     // 本文件在块缓存中的 id
     std::ifstream ifs_; // 输入文件流
+    std::mutex io_mutex_; // 保护 ifs_ 的 seek + read (Get / 迭代器可以被多个线程并发调用)
     Footer footer_;     // 文件的 Footer (在 LoadIndex 时填充)
+    TableProperties props_; // 文件的表属性 (在 LoadIndex 时填充)
+    ComparatorType comparator_; // Key 的顺序 (来自表属性)
     bool is_valid_;     // 标记文件是否成功打开和加载
+    std::atomic<bool> filters_pinned_; // Filter 分区当前固定在块缓存中
     
     // 内存中的索引 (目录)
     // Key: last_key_in_block, Value: BlockHandle (指向 Data Block)
-    std::map<std::string, BlockHandle> index_data_;
+    HandleList index_data_;
+
+    // 内存中的 Filter 索引 (只常驻这一层，分区本身按需加载)
+    // Key: 分区覆盖的最后一个 Key, Value: BlockHandle (指向 Filter 分区)
+    HandleList filter_index_data_;
 };
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "tableoutput.h"
+#include "memtable.h"
+#include <iostream>
+#include <map>
+#include <chrono>
+#include <cstdio>
+
+TableOutputManager::TableOutputManager(const std::string& dbname,
+                                       const OutputOptions& options,
+                                       std::function<uint64_t()> new_file_number,
+                                       std::vector<FileMetaData> grandparents)
+    : dbname_(dbname),
+      options_(options),
+      new_file_number_(std::move(new_file_number)),
+      has_output_(false),
+      boundary_index_(0),
+      grandparents_(std::move(grandparents)),
+      grandparent_index_(0),
+      seen_key_(false),
+      overlapped_bytes_(0) {}
+
+/**
+ * @brief 添加 K/V，必要时先完成当前文件并打开新文件
+ */
+bool TableOutputManager::Add(std::string_view key, std::string_view value) {
+    // ShouldStopBefore 需要看到每一个 Key 才能正确推进祖父层游标
+    if (ShouldStopBefore(key) && has_output_) {
+        if (!FinishOutput()) return false;
+    }
+    if (!has_output_ && !OpenOutput()) {
+        return false;
+    }
+
+    bool first_key = builder_->GetProperties().num_entries_ == 0;
+    if (!builder_->Add(key, value)) {
+        return false;
+    }
+    if (first_key) {
+        current_.smallest_.assign(key.data(), key.size());
+    }
+    current_.largest_.assign(key.data(), key.size());
+    return true;
+}
+
+bool TableOutputManager::Finish() {
+    return has_output_ ? FinishOutput() : true;
+}
+
+/**
+ * @brief (私有) 判断是否应该在 key 之前切分
+ */
+bool TableOutputManager::ShouldStopBefore(std::string_view key) {
+    // 0. 推进强制边界游标
+    bool crossed_hard_boundary = false;
+    while (boundary_index_ < boundaries_.size() && key >= boundaries_[boundary_index_]) {
+        crossed_hard_boundary = true;
+        boundary_index_++;
+    }
+
+    // 1. 推进祖父层游标，累计当前文件已经“越过”的祖父层文件大小
+    bool crossed_boundary = false;
+    while (grandparent_index_ < grandparents_.size() &&
+           key > grandparents_[grandparent_index_].largest_) {
+        if (seen_key_) {
+            overlapped_bytes_ += grandparents_[grandparent_index_].file_size_;
+            crossed_boundary = true;
+        }
+        grandparent_index_++;
+    }
+    seen_key_ = true;
+
+    if (!has_output_) {
+        return false; // 还没有文件可切
+    }
+
+    // 2. 依次检查切分规则
+    if (crossed_hard_boundary) {
+        return true; // 规则 0: 不能跨越强制边界
+    }
+    uint64_t file_size = builder_->FileSize();
+    if (file_size >= options_.target_file_size_) {
+        return true; // 规则 1: 达到目标大小
+    }
+    if (overlapped_bytes_ > options_.max_grandparent_overlap_bytes_) {
+        return true; // 规则 2: 与祖父层重叠太多
+    }
+    if (crossed_boundary && file_size >= options_.target_file_size_ / 2) {
+        return true; // 规则 3: 在祖父层边界上切分
+    }
+    return false;
+}
+
+/**
+ * @brief (私有) 打开一个新的输出文件 (复用同一个 Builder)
+ */
+bool TableOutputManager::OpenOutput() {
+    current_ = FileMetaData();
+    current_.number_ = new_file_number_();
+    const std::string filename = TableFileName(dbname_, current_.number_);
+
+    if (builder_ == nullptr) {
+        builder_.reset(new SSTableBuilder(filename, options_.builder_options_));
+    } else {
+        builder_->Reset(filename);
+    }
+    if (!builder_->is_open()) {
+        return false;
+    }
+    has_output_ = true;
+    return true;
+}
+
+/**
+ * @brief (私有) 完成当前输出文件
+ */
+bool TableOutputManager::FinishOutput() {
+    has_output_ = false;
+    overlapped_bytes_ = 0;
+    if (!builder_->Finish()) {
+        std::remove(TableFileName(dbname_, current_.number_).c_str()); // 不完整的文件
+        return false;
+    }
+    current_.file_size_ = builder_->FileSize();
+    const TableProperties& props = builder_->GetProperties();
+    current_.has_time_range_ = props.num_timestamped_entries_ > 0 &&
+                               props.num_timestamped_entries_ == props.num_entries_;
+    current_.min_timestamp_ = current_.has_time_range_ ? props.min_timestamp_ : 0;
+    current_.max_timestamp_ = current_.has_time_range_ ? props.max_timestamp_ : 0;
+    current_.creation_time_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    KV_DEBUG_LOG("  [Output] 完成文件 #" << current_.number_ << " (" << current_.file_size_
+                 << " 字节, [" << current_.smallest_ << " .. " << current_.largest_ << "])");
+    outputs_.push_back(current_);
+    return true;
+}
+
+/**
+ * @brief 将一个 MemTable 刷盘
+ * (MemTable 的 map 已经有序，直接按顺序喂给输出管理器即可)
+ */
+bool WriteMemTable(const memtable& mem, TableOutputManager* output) {
+    for (const auto& pair : mem.GetMap()) {
+        if (!output->Add(pair.first.key_, pair.second)) {
+            return false;
+        }
+    }
+    return output->Finish();
+}
+
+bool WriteMemTableByWindow(const memtable& mem, const TimestampExtractor& extractor, uint64_t window_size,
+                           const std::function<std::unique_ptr<TableOutputManager>()>& new_output,
+                           std::vector<FileMetaData>* outputs) {
+    // 窗口编号 -> 该窗口的条目 (保持 MemTable 中的升序)
+    std::map<uint64_t, std::vector<const memtable::Map::value_type*>> windows;
+    for (const auto& pair : mem.GetMap()) {
+        uint64_t timestamp = 0;
+        uint64_t window = extractor(pair.first.key_, &timestamp) ? timestamp / window_size : UINT64_MAX;
+        windows[window].push_back(&pair);
+    }
+    for (const auto& window : windows) {
+        std::unique_ptr<TableOutputManager> output = new_output();
+        for (const auto* pair : window.second) {
+            if (!output->Add(pair->first.key_, pair->second)) {
+                return false;
+            }
+        }
+        if (!output->Finish()) {
+            return false;
+        }
+        outputs->insert(outputs->end(), output->GetOutputs().begin(), output->GetOutputs().end());
+    }
+    return true;
+}
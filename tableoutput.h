@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <memory>
+#include "dbformat.h"
+#include "sstablebuilder.h"
+#include "memtable.h"
+
+/**
+ * @brief OutputOptions (输出选项)
+ * 控制刷盘/Compaction 输出文件的切分。
+ */
+struct OutputOptions {
+    // 单个输出文件的目标大小 (字节)，达到后切换到下一个文件
+    uint64_t target_file_size_ = 64 * 1024;
+
+    // 单个输出文件与祖父层 (level + 2) 重叠的字节数上限
+    // 超过后立即切分，限制将来 Compaction 这个文件时需要重写的数据量
+    uint64_t max_grandparent_overlap_bytes_ = 10 * 64 * 1024;
+
+    // 每个输出文件使用的构建选项
+    BuilderOptions builder_options_;
+};
+
+/**
+ * @brief TableOutputManager (输出文件管理器)
+ * 职责：接收一个按 Key 升序的 K/V 流 (来自刷盘或 Compaction)，
+ * 把它切分成多个大小合适的 SSTable 文件。
+ *
+ * 切分规则 (在两个 Key 之间切分，同一个 Key 不会跨文件):
+ * 0. Key 跨过了一个强制边界 (AddBoundary)，文件不能跨越它。
+ * 1. 当前文件达到 target_file_size_。
+ * 2. 当前文件与祖父层的重叠超过 max_grandparent_overlap_bytes_。
+ * 3. 当前文件已达到目标大小的一半，且 Key 刚好跨过一个祖父层文件的边界
+ *    (尽量让切分点与祖父层的文件边界对齐，减少将来的重叠)。
+ *
+ * 内部只使用一个 SSTableBuilder，通过 Reset() 在文件之间复用。
+ */
+class TableOutputManager {
+public:
+    /**
+     * @brief 构造函数
+     * @param dbname 输出文件所在的目录
+     * @param options 输出选项
+     * @param new_file_number 每打开一个输出文件时调用，分配新的文件编号
+     * @param grandparents 祖父层的文件 (按 Key 升序排列，可以为空)
+     */
+    TableOutputManager(const std::string& dbname,
+                       const OutputOptions& options,
+                       std::function<uint64_t()> new_file_number,
+                       std::vector<FileMetaData> grandparents = {});
+
+    // 禁用拷贝和赋值
+    TableOutputManager(const TableOutputManager&) = delete;
+    TableOutputManager& operator=(const TableOutputManager&) = delete;
+
+    /**
+     * @brief 添加一个 K/V (必须按 Key 升序调用)，必要时先切换到新文件
+     * @return true 成功；false 如果文件打开或写入失败
+     */
+    bool Add(std::string_view key, std::string_view value);
+
+    /**
+     * @brief 追加一个强制边界：任何输出文件都不会同时包含 < boundary 和 >= boundary 的 Key。
+     * (Compaction 用它绕开下一层中原地保留的文件)
+     * @note 边界必须按升序追加，并且大于已经 Add() 过的所有 Key
+     */
+    void AddBoundary(std::string_view boundary) { boundaries_.emplace_back(boundary); }
+
+    /**
+     * @brief 完成当前输出文件 (如果有)
+     * @return true 成功
+     */
+    bool Finish();
+
+    /**
+     * @brief 获取所有已完成的输出文件 (按 Key 升序)
+     */
+    const std::vector<FileMetaData>& GetOutputs() const { return outputs_; }
+
+private:
+    /**
+     * @brief (私有) 判断是否应该在 key 之前切分出一个新文件
+     * (同时推进祖父层的游标，所以每个 Key 只能调用一次)
+     */
+    bool ShouldStopBefore(std::string_view key);
+
+    /**
+     * @brief (私有) 打开一个新的输出文件
+     */
+    bool OpenOutput();
+
+    /**
+     * @brief (私有) 完成当前输出文件，并记录它的元数据
+     */
+    bool FinishOutput();
+
+    // --- 成员变量 ---
+    std::string dbname_;
+    OutputOptions options_;
+    std::function<uint64_t()> new_file_number_;
+
+    std::unique_ptr<SSTableBuilder> builder_; // 在文件之间复用
+    bool has_output_;                         // 当前是否有正在写入的文件
+    FileMetaData current_;                    // 当前文件的元数据
+    std::vector<FileMetaData> outputs_;       // 已完成的文件
+
+    // 强制边界相关
+    std::vector<std::string> boundaries_;
+    size_t boundary_index_;      // 第一个 > 当前 Key 的边界
+
+    // 祖父层相关
+    std::vector<FileMetaData> grandparents_;
+    size_t grandparent_index_;   // 第一个 largest_ >= 当前 Key 的祖父层文件
+    bool seen_key_;              // 是否已经见过第一个 Key (之前越过的祖父层文件不算重叠)
+    uint64_t overlapped_bytes_;  // 当前文件与祖父层的重叠字节数
+};
+
+/**
+ * @brief 将一个 MemTable 的全部内容刷盘 (按输出选项切分成一个或多个文件)
+ * @param mem 要刷盘的 MemTable
+ * @param output 输出文件管理器 (调用后已 Finish)
+ * @return true 成功
+ */
+bool WriteMemTable(const memtable& mem, TableOutputManager* output);
+
+/**
+ * @brief 时间序列模式的刷盘：按时间窗口 (timestamp / window_size) 把 MemTable 分组，
+ * 每组单独输出，保证每个文件只包含一个窗口的 Key (取不出时间戳的 Key 单独成一组)。
+ * @param new_output 为每个窗口创建一个输出文件管理器
+ * @param outputs [out] 追加所有窗口的输出文件
+ * @return true 成功
+ */
+bool WriteMemTableByWindow(const memtable& mem, const TimestampExtractor& extractor, uint64_t window_size,
+                           const std::function<std::unique_ptr<TableOutputManager>()>& new_output,
+                           std::vector<FileMetaData>* outputs);
@@ -3,8 +3,38 @@
 #include <map>
 #include <string>
 #include <cassert> // 用于 assert
+#include <cstdio>  // 用于 snprintf
+#include <cstring> // 用于 memset
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include "sstablebuilder.h"
 #include "sstablereader.h"
+#include "blockcache.h"
+#include "hugepage.h"
+#include "rowcache.h"
+#include "memtable.h"
+#include "tableoutput.h"
+#include "version.h"
+#include "compaction.h"
+#include "merger.h"
+#include "db.h"
+#include "resp.h"
+#include "shardeddb.h"
+#include "spscqueue.h"
+#include "binproto.h"
+#include "outputbuffer.h"
+#include "secondaryindex.h"
+#ifdef __linux__
+#include "kvserver.h"
+#include "kvclient.h"
+#include "replication.h"
+#include "netutil.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <thread>
+#include <chrono>
 // (base.h 已经被 builder/reader include 了)
 
 /**
@@ -43,6 +73,2581 @@ void test_get_notfound(SSTableReader& reader, const std::string& key) {
     assert(!found);
 }
 
+/**
+ * @brief (测试辅助) 不超过一页的数据块都不能跨越页边界
+ * @return 超过一页的数据块个数 (只有单条记录就超过一页时才允许)
+ */
+size_t check_blocks_within_pages(const SSTableReader& reader, uint32_t page_size) {
+    std::vector<BlockHandle> handles = reader.GetDataBlockHandles();
+    assert(handles.size() == reader.GetProperties().num_data_blocks_);
+    size_t crossing = 0;
+    size_t oversized = 0;
+    for (const BlockHandle& handle : handles) {
+        if (handle.size_ > page_size) {
+            oversized++;
+        } else if (handle.offset_ / page_size != (handle.offset_ + handle.size_ - 1) / page_size) {
+            crossing++;
+        }
+    }
+    std::cout << "  - " << handles.size() << " 个数据块, 跨页 " << crossing
+              << " 个, 超过一页 " << oversized << " 个" << std::endl;
+    assert(crossing == 0);
+    return oversized;
+}
+
+/**
+ * @brief (测试辅助) 用给定的选项构建页对齐的 SSTable，检查每个块都不跨页，并读回所有 Key
+ */
+TableProperties build_aligned_table(const std::string& filename, const BuilderOptions& options,
+                                    const std::map<std::string, std::string>& test_data) {
+    {
+        SSTableBuilder builder(filename, options);
+        assert(builder.is_open());
+        for (const auto& pair : test_data) {
+            bool added = builder.Add(pair.first, pair.second);
+            assert(added);
+        }
+        bool finished = builder.Finish();
+        assert(finished);
+    }
+
+    SSTableReader reader(filename);
+    assert(reader.is_valid());
+    const TableProperties& props = reader.GetProperties();
+    std::cout << "  - 数据块 " << props.num_data_blocks_ << " 个 (定长 Key " << props.num_fixed_key_blocks_
+              << " 个), 数据 " << props.data_size_ << " 字节, 填充 " << props.padding_size_ << " 字节" << std::endl;
+    assert(props.num_entries_ == test_data.size());
+    assert(props.page_size_ == options.page_size_);
+    size_t oversized = check_blocks_within_pages(reader, options.page_size_);
+    assert(oversized == 0); // 每条记录都远小于一页
+
+    for (const auto& pair : test_data) {
+        test_get(reader, pair.first, pair.second);
+    }
+    test_get_notfound(reader, "key9999");
+    return props;
+}
+
+/**
+ * @brief (测试) 页对齐布局：块不跨页，填充字节记入表属性
+ * 分别在普通布局、定长 Key 布局和压缩下检查
+ */
+void test_page_aligned_layout() {
+    const std::string filename = "test_aligned.sst";
+    const uint32_t page_size = 4096;
+
+    // 每条记录约 1KB，块阈值 3KB：不对齐时块必然跨越页边界
+    std::map<std::string, std::string> test_data;
+    for (int i = 0; i < 40; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        test_data[key] = std::string(1000, static_cast<char>('a' + i % 26));
+    }
+
+    BuilderOptions options;
+    options.block_size_ = 3 * 1024;
+    options.block_align_ = true;
+    options.page_size_ = page_size;
+    options.fixed_key_blocks_ = false;
+    TableProperties props = build_aligned_table(filename, options, test_data);
+    assert(props.padding_size_ > 0);
+    assert(props.num_fixed_key_blocks_ == 0);
+
+    // 定长 Key：8 字节的 Key，两条记录的普通布局正好一页，定长布局的头部会让它超过一页
+    std::map<std::string, std::string> fixed_data;
+    for (int i = 0; i < 40; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%05d", i);
+        fixed_data[key] = std::string(2032, static_cast<char>('a' + i % 26));
+    }
+    options.block_size_ = page_size;
+    options.fixed_key_blocks_ = true;
+    build_aligned_table(filename, options, fixed_data);
+
+    // 压缩 (压缩不划算时块前的类型字节也计入一页)
+    options.compression_.type_ = CompressionType::ZLIB;
+    if (CompressionSupported(options.compression_.type_)) {
+        build_aligned_table(filename, options, fixed_data);
+        options.block_size_ = 3 * 1024;
+        build_aligned_table(filename, options, test_data);
+    }
+}
+/**
+ * @brief (测试) 页对齐 + 压缩：压缩不划算时块多出的类型字节也不能让块跨页
+ */
+void test_aligned_compressed_layout() {
+    const std::string filename = "test_aligned_zlib.sst";
+    const uint32_t page_size = 4096;
+
+    BuilderOptions options;
+    options.block_size_ = page_size;
+    options.block_align_ = true;
+    options.page_size_ = page_size;
+    options.compression_.type_ = CompressionType::ZLIB;
+    if (!CompressionSupported(options.compression_.type_)) {
+        std::cout << "  - 未编译 zlib，跳过" << std::endl;
+        return;
+    }
+
+    // 8 字节的 Key + 不可压缩的值：4 条普通布局的记录正好一页
+    std::map<std::string, std::string> test_data;
+    uint64_t seed = 88172645463325252ULL;
+    for (int i = 0; i < 400; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%05d", i);
+        std::string value(1008, '\0');
+        for (char& c : value) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            c = static_cast<char>(seed);
+        }
+        test_data[key] = value;
+    }
+    {
+        SSTableBuilder builder(filename, options);
+        assert(builder.is_open());
+        for (const auto& pair : test_data) {
+            bool added = builder.Add(pair.first, pair.second);
+            assert(added);
+        }
+        bool finished = builder.Finish();
+        assert(finished);
+    }
+
+    SSTableReader reader(filename);
+    assert(reader.is_valid());
+    size_t oversized = check_blocks_within_pages(reader, page_size);
+    assert(oversized == 0);
+    for (const auto& pair : test_data) {
+        std::string value;
+        bool found = reader.Get(pair.first, &value);
+        assert(found && value == pair.second);
+    }
+    std::cout << "    > PASSED: 页对齐 + 压缩的块都不跨页" << std::endl;
+}
+
+/**
+ * @brief (测试) 块缓存：容量不足时先淘汰低优先级条目
+ */
+void test_block_cache_priority() {
+    BlockCache cache(1024);
+    auto block = std::make_shared<const BlockContents>(200, 'x');
+    cache.Insert(1, 0, block, BlockCache::Priority::HIGH);
+    for (uint64_t offset = 1; offset <= 10; offset++) {
+        cache.Insert(1, offset, block, BlockCache::Priority::LOW);
+    }
+    assert(cache.GetUsage() <= cache.GetCapacity());
+    std::shared_ptr<const BlockContents> hit = cache.Lookup(1, 0);
+    assert(hit != nullptr);  // 高优先级条目仍在
+    hit = cache.Lookup(1, 1);
+    assert(hit == nullptr);  // 最早的低优先级条目已被淘汰
+    hit = cache.Lookup(1, 10);
+    assert(hit != nullptr);  // 最新的低优先级条目仍在
+    hit = cache.Lookup(2, 10);
+    assert(hit == nullptr);  // 不同文件的相同 offset 互不干扰
+    std::cout << "  - 块缓存优先级淘汰 PASSED" << std::endl;
+}
+
+/**
+ * @brief (测试) 分区 Filter：不存在的 Key 只需读 Filter 分区，不读数据块
+ */
+void test_partitioned_filter() {
+    const std::string filename = "test_filter.sst";
+
+    BuilderOptions options;
+    options.filter_partition_size_ = 32; // 每 ~26 个 Key 切一个分区
+    {
+        SSTableBuilder builder(filename, options);
+        for (int i = 0; i < 200; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i * 2); // 只写偶数
+            bool ok = builder.Add(key, "v");
+            assert(ok);
+        }
+        bool ok = builder.Finish();
+        assert(ok);
+        assert(builder.GetProperties().num_filter_partitions_ > 1);
+    }
+
+    BlockCache cache(1 << 20);
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = &cache;
+    SSTableReader reader(filename, reader_options);
+    assert(reader.is_valid());
+    const TableProperties& props = reader.GetProperties();
+
+    // 查找奇数 Key (都不存在)：绝大多数被 Filter 挡住
+    for (int i = 0; i < 200; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i * 2 + 1);
+        std::string value;
+        bool ok = reader.Get(key, &value);
+        assert(!ok);
+    }
+    uint64_t loads = cache.GetMisses(); // 每次未命中都对应一次磁盘读
+    std::cout << "  - 200 次不存在的查找: 读盘 " << loads << " 次 ("
+              << props.num_filter_partitions_ << " 个 Filter 分区, "
+              << props.num_data_blocks_ << " 个数据块)" << std::endl;
+    assert(loads < props.num_filter_partitions_ + 20);
+
+    // 存在的 Key 必须全部找到 (Filter 不允许假阴性)
+    for (int i = 0; i < 200; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i * 2);
+        std::string value;
+        bool ok = reader.Get(key, &value);
+        assert(ok && value == "v");
+    }
+    std::cout << "  - 分区 Filter PASSED" << std::endl;
+}
+/**
+ * @brief (测试) 同一个 Builder 通过 Reset() 连续构建多个文件
+ */
+void test_builder_reuse() {
+    SSTableBuilder builder("test_reuse_0.sst");
+    for (int file = 0; file < 3; file++) {
+        const std::string filename = "test_reuse_" + std::to_string(file) + ".sst";
+        if (file > 0) {
+            bool ok = builder.Reset(filename);
+            assert(ok);
+        }
+        for (int i = 0; i < 50; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "f%d_key%04d", file, i);
+            bool ok = builder.Add(key, std::to_string(i));
+            assert(ok);
+        }
+        // 块内乱序的 Key 也必须被拒绝
+        bool ok = builder.Add("f0_key0000", "late");
+        assert(!ok);
+        ok = builder.Finish();
+        assert(ok);
+        assert(builder.GetProperties().num_entries_ == 50);
+    }
+
+    for (int file = 0; file < 3; file++) {
+        SSTableReader reader("test_reuse_" + std::to_string(file) + ".sst");
+        assert(reader.is_valid());
+        assert(reader.GetProperties().num_entries_ == 50);
+        char key[16];
+        snprintf(key, sizeof(key), "f%d_key%04d", file, 49);
+        test_get(reader, key, "49");
+        snprintf(key, sizeof(key), "f%d_key%04d", (file + 1) % 3, 0);
+        test_get_notfound(reader, key);
+    }
+
+#ifdef __linux__
+    // 写入失败 (/dev/full 总是返回 ENOSPC) 时 Finish() 必须返回 false
+    if (std::filesystem::exists("/dev/full")) {
+        bool ok = builder.Reset("/dev/full");
+        assert(ok);
+        for (int i = 0; i < 50; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "full_key%04d", i);
+            ok = builder.Add(key, std::string(100, 'v'));
+            assert(ok);
+        }
+        ok = builder.Finish();
+        assert(!ok);
+    }
+#endif
+}
+/**
+ * @brief (测试) TableOutputManager：按目标大小切分，并尽量对齐祖父层边界
+ */
+void test_output_splitting() {
+    const std::string dbname = "test_output_db";
+    std::filesystem::remove_all(dbname);
+    std::filesystem::create_directories(dbname);
+    uint64_t next_file_number = 1;
+    auto new_file_number = [&next_file_number]() { return next_file_number++; };
+
+    memtable mem;
+    for (int i = 0; i < 300; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        mem.put(key, "value_" + std::to_string(i));
+    }
+
+    // 1. 只按目标大小切分
+    OutputOptions options;
+    options.target_file_size_ = 2048;
+    TableOutputManager flush_output(dbname, options, new_file_number);
+    bool ok = WriteMemTable(mem, &flush_output);
+    assert(ok);
+    const std::vector<FileMetaData>& files = flush_output.GetOutputs();
+    assert(files.size() > 1);
+    for (size_t i = 0; i < files.size(); i++) {
+        // 每个文件最多超出目标大小一个数据块 + 元数据
+        assert(files[i].file_size_ < options.target_file_size_ + 1024);
+        if (i > 0) {
+            assert(files[i - 1].largest_ < files[i].smallest_);
+        }
+        SSTableReader reader(TableFileName(dbname, files[i].number_));
+        assert(reader.is_valid());
+        test_get(reader, files[i].smallest_, mem.GetMap().at(PrefixedKey(files[i].smallest_)));
+        test_get(reader, files[i].largest_, mem.GetMap().at(PrefixedKey(files[i].largest_)));
+    }
+    std::cout << "  - 刷盘切分为 " << files.size() << " 个文件 PASSED" << std::endl;
+
+    // 2. 祖父层每 40 个 Key 一个文件：切分点应落在祖父层文件边界上
+    std::vector<FileMetaData> grandparents;
+    for (int i = 0; i < 300; i += 40) {
+        FileMetaData gp;
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        gp.smallest_ = key;
+        snprintf(key, sizeof(key), "key%04d", std::min(i + 39, 299));
+        gp.largest_ = key;
+        gp.file_size_ = 1024;
+        grandparents.push_back(gp);
+    }
+    options.target_file_size_ = 4096;
+    TableOutputManager compact_output(dbname, options, new_file_number, grandparents);
+    ok = WriteMemTable(mem, &compact_output);
+    assert(ok);
+    const std::vector<FileMetaData>& aligned = compact_output.GetOutputs();
+    assert(aligned.size() > 1);
+    for (size_t i = 0; i + 1 < aligned.size(); i++) {
+        bool on_boundary = false;
+        for (const FileMetaData& gp : grandparents) {
+            on_boundary = on_boundary || aligned[i].largest_ == gp.largest_;
+        }
+        assert(on_boundary);
+    }
+    std::cout << "  - 对齐祖父层边界切分为 " << aligned.size() << " 个文件 PASSED" << std::endl;
+}
+/**
+ * @brief (测试辅助) 把一个 MemTable 刷盘到 L0，并记录到 MANIFEST
+ */
+void flush_to_l0(VersionSet* versions, const memtable& mem, const OutputOptions& options) {
+    TableOutputManager output(versions->dbname(), options, [versions]() { return versions->NewFileNumber(); });
+    bool ok = WriteMemTable(mem, &output);
+    assert(ok);
+    VersionEdit edit;
+    for (const FileMetaData& f : output.GetOutputs()) {
+        edit.AddFile(0, f);
+    }
+    ok = versions->LogAndApply(&edit);
+    assert(ok);
+}
+
+/**
+ * @brief (测试辅助) 在 L1 (互不重叠) 中查找一个 Key
+ */
+bool get_from_l1(const VersionSet& versions, const std::string& key, std::string* value) {
+    for (const FileMetaData& f : versions.current()->files_[1]) {
+        if (f.smallest_ <= key && key <= f.largest_) {
+            SSTableReader reader(TableFileName(versions.dbname(), f.number_));
+            return reader.Get(key, value);
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief (测试) 顺序写入只做平凡移动；稀疏覆盖写时，下一层中没有 Key 落入的文件原地保留
+ */
+void test_compaction_trivial_move_and_skip() {
+    const std::string dbname = "test_compaction_db";
+    std::filesystem::remove_all(dbname);
+    std::filesystem::create_directories(dbname);
+
+    CompactionOptions options;
+    options.l0_compaction_trigger_ = 1;
+    options.max_bytes_for_level_base_ = 1 << 30; // 只测试 L0 -> L1
+    options.output_.target_file_size_ = 1 << 20;
+    CompactionStats stats;
+
+    // 1. 顺序写入 4 个互不重叠的 L0 文件：全部平凡移动到 L1
+    {
+        VersionSet versions(dbname);
+        bool ok = versions.Recover();
+        assert(ok);
+        CompactionPicker picker(options);
+        for (int batch = 0; batch < 4; batch++) {
+            memtable mem;
+            for (int i = batch * 100; i < (batch + 1) * 100; i++) {
+                char key[16];
+                snprintf(key, sizeof(key), "k%04d", i);
+                mem.put(key, "old");
+            }
+            flush_to_l0(&versions, mem, options.output_);
+            while (std::unique_ptr<Compaction> c = picker.PickCompaction(*versions.current())) {
+                ok = RunCompaction(&versions, *c, options, &stats);
+                assert(ok);
+            }
+        }
+        assert(stats.files_moved_ == 4 && stats.compactions_ == 0 && stats.bytes_written_ == 0);
+        assert(versions.current()->files_[0].empty() && versions.current()->files_[1].size() == 4);
+    }
+
+    // 2. 重新打开 (重放 MANIFEST)，稀疏地覆盖第 1 个和第 4 个文件
+    VersionSet versions(dbname);
+    bool ok = versions.Recover();
+    assert(ok);
+    assert(versions.current()->files_[1].size() == 4);
+    std::vector<FileMetaData> before = versions.current()->files_[1];
+
+    memtable mem;
+    mem.put("k0050", "new");
+    mem.put("k0350", "new");
+    flush_to_l0(&versions, mem, options.output_);
+    CompactionPicker picker(options);
+    std::unique_ptr<Compaction> c = picker.PickCompaction(*versions.current());
+    assert(c != nullptr && c->inputs_[1].size() == 4 && !c->IsTrivialMove());
+    ok = RunCompaction(&versions, *c, options, &stats);
+    assert(ok);
+    assert(stats.compactions_ == 1 && stats.files_skipped_ == 2);
+
+    // 中间两个文件原封不动 (编号不变)，L1 依然互不重叠
+    const std::vector<FileMetaData>& after = versions.current()->files_[1];
+    int kept = 0;
+    for (size_t i = 0; i < after.size(); i++) {
+        kept += (after[i].number_ == before[1].number_ || after[i].number_ == before[2].number_);
+        if (i > 0) {
+            assert(after[i - 1].largest_ < after[i].smallest_);
+        }
+    }
+    assert(kept == 2);
+
+    std::string value;
+    ok = get_from_l1(versions, "k0050", &value);
+    assert(ok && value == "new");
+    ok = get_from_l1(versions, "k0350", &value);
+    assert(ok && value == "new");
+    ok = get_from_l1(versions, "k0051", &value);
+    assert(ok && value == "old");
+    ok = get_from_l1(versions, "k0150", &value);
+    assert(ok && value == "old");
+    ok = get_from_l1(versions, "k0399", &value);
+    assert(ok && value == "old");
+    std::cout << "  - 平凡移动 " << stats.files_moved_ << " 个文件, 跳过 " << stats.files_skipped_
+              << " 个文件, 归并读 " << stats.bytes_read_ << " 字节 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 DB：读写删除、WAL 恢复、后台刷盘和 Compaction、范围扫描
+ */
+void test_db() {
+    const std::string dbname = "test_db";
+    std::filesystem::remove_all(dbname);
+
+    Options options;
+    options.write_buffer_size_ = 4 * 1024; // 很小的 MemTable，触发多次刷盘
+    options.compaction_.l0_compaction_trigger_ = 2;
+    options.compaction_.output_.target_file_size_ = 8 * 1024;
+
+    char key[16];
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        assert(db != nullptr);
+        for (int i = 0; i < 2000; i++) {
+            snprintf(key, sizeof(key), "k%05d", i);
+            bool ok = db->Put(key, "v" + std::to_string(i));
+            assert(ok);
+        }
+        for (int i = 0; i < 2000; i += 3) {
+            snprintf(key, sizeof(key), "k%05d", i);
+            bool ok = db->Delete(key);
+            assert(ok);
+        }
+        db->WaitForIdle();
+        assert(db->GetCompactionStats().compactions_ + db->GetCompactionStats().files_moved_ > 0);
+
+        std::string value;
+        bool ok = db->Get("k00001", &value);
+        assert(ok && value == "v1");
+        ok = db->Get("k00003", &value);
+        assert(!ok); // 已删除
+        ok = db->Get("nokey", &value);
+        assert(!ok);
+
+        std::vector<std::pair<std::string, std::string>> results;
+        ok = db->Scan("k00000", 4, &results);
+        assert(ok);
+        assert(results.size() == 4 && results[0].first == "k00001" && results[1].first == "k00002" &&
+               results[2].first == "k00004" && results[3].second == "v5");
+
+        // 未刷盘的写入只在 WAL 中
+        ok = db->Put("k00001", "updated");
+        assert(ok);
+        ok = db->Delete("k00002");
+        assert(ok);
+    }
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        assert(db != nullptr);
+        std::string value;
+        bool ok = db->Get("k00001", &value);
+        assert(ok && value == "updated");
+        ok = db->Get("k00002", &value);
+        assert(!ok);
+        ok = db->Get("k01999", &value);
+        assert(ok && value == "v1999");
+
+        std::vector<std::pair<std::string, std::string>> results;
+        ok = db->Scan("", 10000, &results);
+        assert(ok);
+        assert(results.size() == 2000 - 667 - 1);
+    }
+    std::cout << "  - DB 读写/恢复/扫描 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 WAL 校验：损坏的记录和不可能的长度被当作日志结尾，恢复时不会越过它们
+ */
+void test_wal_corruption() {
+    const std::string filename = "test_wal.log";
+    {
+        LogWriter writer(filename);
+        assert(writer.is_open());
+        for (const char* record : {"first", "second", "third"}) {
+            bool added = writer.AddRecord(record);
+            assert(added);
+        }
+    }
+    auto read_all = [&filename](std::vector<std::string>* records) {
+        LogReader reader(filename);
+        std::string record;
+        records->clear();
+        while (reader.ReadRecord(&record)) {
+            records->push_back(record);
+        }
+        return reader.eof();
+    };
+    auto patch = [&filename](std::streamoff offset, const void* data, size_t size) {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.write(static_cast<const char*>(data), size);
+    };
+    std::vector<std::string> records;
+    bool ok = read_all(&records);
+    assert(ok && records.size() == 3 && records[2] == "third");
+
+    // 第二条记录内容中的一个字节被改写：只读出第一条
+    const std::streamoff second = 8 + 5;
+    patch(second + 8, "S", 1);
+    ok = read_all(&records);
+    assert(!ok && records.size() == 1 && records[0] == "first");
+
+    // 第一条记录的长度被改成一个不可能的值：不会按它分配内存，直接停止
+    const uint32_t garbage_len = 0xFFFFFFF0u;
+    patch(4, &garbage_len, sizeof(garbage_len));
+    ok = read_all(&records);
+    assert(!ok && records.empty());
+
+    // DB 恢复：停在损坏的记录上
+    const std::string dbname = "test_wal_db";
+    std::filesystem::remove_all(dbname);
+    uint64_t log_number = 0;
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, Options());
+        assert(db != nullptr);
+        ok = db->Put("a", "1");
+        assert(ok);
+        ok = db->Put("b", "2");
+        assert(ok);
+        for (const auto& entry : std::filesystem::directory_iterator(dbname)) {
+            if (entry.path().extension() == ".log") {
+                log_number = std::max<uint64_t>(log_number, std::stoull(entry.path().stem().string()));
+            }
+        }
+    }
+    const std::string log_name = LogFileName(dbname, log_number);
+    {
+        // 改写最后一条记录的最后一个字节
+        std::fstream file(log_name, std::ios::in | std::ios::out | std::ios::binary | std::ios::ate);
+        file.seekg(-1, std::ios::end);
+        char last = static_cast<char>(file.get() ^ 0x5A);
+        file.seekp(-1, std::ios::end);
+        file.put(last);
+    }
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, Options());
+        assert(db != nullptr);
+        std::string value;
+        ok = db->Get("a", &value);
+        assert(ok && value == "1");
+        ok = db->Get("b", &value);
+        assert(!ok);
+
+        // 记录数与头部不一致的批次在写 WAL 之前被拒绝
+        WriteBatch bad;
+        bad.Put("x", "1");
+        std::string contents = bad.Contents();
+        const uint32_t bad_count = 2;
+        memcpy(&contents[sizeof(uint64_t)], &bad_count, sizeof(bad_count));
+        ok = bad.SetContents(contents);
+        assert(ok);
+        const uint64_t sequence = db->LastSequence();
+        ok = db->Write(&bad);
+        assert(!ok && db->LastSequence() == sequence);
+        ok = db->Get("x", &value);
+        assert(!ok);
+        ok = db->Put("c", "3");
+        assert(ok);
+    }
+    {
+        // 校验和正确但批次内容不一致：恢复停在这条记录上，之后的记录也不重放
+        for (const auto& entry : std::filesystem::directory_iterator(dbname)) {
+            if (entry.path().extension() == ".log") {
+                log_number = std::max<uint64_t>(log_number, std::stoull(entry.path().stem().string()));
+            }
+        }
+        std::vector<std::string> log_records;
+        {
+            LogReader reader(LogFileName(dbname, log_number));
+            std::string record;
+            while (reader.ReadRecord(&record)) {
+                log_records.push_back(record);
+            }
+        }
+        assert(log_records.size() == 1);
+        WriteBatch last;
+        ok = last.SetContents(log_records[0]);
+        assert(ok);
+        WriteBatch bad;
+        bad.Put("x", "1");
+        bad.Put("y", "2");
+        bad.SetSequence(last.Sequence() + 1);
+        std::string contents = bad.Contents();
+        const uint32_t bad_count = 3;
+        memcpy(&contents[sizeof(uint64_t)], &bad_count, sizeof(bad_count));
+        WriteBatch after;
+        after.Put("z", "4");
+        after.SetSequence(last.Sequence() + 4);
+        LogWriter writer(LogFileName(dbname, log_number));
+        for (const std::string& record : {log_records[0], contents, after.Contents()}) {
+            bool added = writer.AddRecord(record);
+            assert(added);
+        }
+    }
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, Options());
+        assert(db != nullptr);
+        std::string value;
+        ok = db->Get("c", &value);
+        assert(ok && value == "3");
+        for (const char* key : {"x", "y", "z"}) {
+            ok = db->Get(key, &value);
+            assert(!ok);
+        }
+    }
+    std::cout << "  - WAL 校验和 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 RESP 解析 (完整/不完整/流水线/内联) 和命令执行
+ */
+void test_resp() {
+    std::vector<std::string_view> args;
+    size_t consumed = 0;
+
+    std::string input = "*2\r\n$3\r\nGET\r\n$3\r\nfoo\r\n*1\r\n$4\r\nPING\r\n";
+    RespParseResult result = ParseRespCommand(input, &args, &consumed);
+    assert(result == RespParseResult::OK);
+    assert(args.size() == 2 && args[0] == "GET" && args[1] == "foo" && consumed == 22);
+    result = ParseRespCommand(std::string_view(input).substr(consumed), &args, &consumed);
+    assert(result == RespParseResult::OK);
+    assert(args.size() == 1 && args[0] == "PING");
+    for (size_t len = 0; len < 22; len++) {
+        result = ParseRespCommand(std::string_view(input).substr(0, len), &args, &consumed);
+        assert(result == RespParseResult::INCOMPLETE);
+    }
+    result = ParseRespCommand("set a  b\r\n", &args, &consumed);
+    assert(result == RespParseResult::OK);
+    assert(args.size() == 3 && args[2] == "b" && consumed == 10);
+    result = ParseRespCommand("*1\r\n$x\r\n", &args, &consumed);
+    assert(result == RespParseResult::ERROR);
+    result = ParseRespReply("*2\r\n$1\r\na\r\n$-1\r\n", &consumed);
+    assert(result == RespParseResult::OK && consumed == 16);
+    result = ParseRespReply("*2\r\n$1\r\na\r\n", &consumed);
+    assert(result == RespParseResult::INCOMPLETE);
+    assert(RespGlobMatch("user:*", "user:42") && RespGlobMatch("a?c*", "abcde") && !RespGlobMatch("a*z", "abc"));
+
+    const std::string dbname = "test_resp_db";
+    std::filesystem::remove_all(dbname);
+    std::unique_ptr<DB> db = DB::Open(dbname, Options());
+    assert(db != nullptr);
+    RespCommandHandler handler(db.get());
+    std::string out;
+    auto run = [&](std::vector<std::string_view> cmd) {
+        out.clear();
+        return handler.Execute(cmd, &out);
+    };
+    run({"SET", "a", "1"});
+    assert(out == "+OK\r\n");
+    run({"mset", "b", "2", "c", "3"});
+    run({"GET", "a"});
+    assert(out == "$1\r\n1\r\n");
+    run({"MGET", "a", "x", "c"});
+    assert(out == "*3\r\n$1\r\n1\r\n$-1\r\n$1\r\n3\r\n");
+    run({"DEL", "a", "x"});
+    assert(out == ":1\r\n");
+    run({"SCAN", "0", "COUNT", "1"});
+    assert(out == "*2\r\n$4\r\n6200\r\n*1\r\n$1\r\nb\r\n"); // 游标是 "b\0" 的十六进制
+    run({"SCAN", "6200", "COUNT", "10"});
+    assert(out == "*2\r\n$1\r\n0\r\n*1\r\n$1\r\nc\r\n");
+    run({"NOPE"});
+    assert(out[0] == '-');
+    bool ok = run({"QUIT"});
+    assert(!ok);
+    std::cout << "  - RESP 解析/命令 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 SPSC 队列和分片引擎 (多个会话并发写入，跨分片扫描，分片数校验)
+ */
+void test_sharded_db() {
+    SpscQueue<int> queue(3); // 容量向上取整到 4
+    int item = 0;
+    for (int i = 0; i < 4; i++) {
+        bool ok = queue.TryPush(i);
+        assert(ok);
+    }
+    bool ok = queue.TryPush(4);
+    assert(!ok);
+    ok = queue.TryPop(&item);
+    assert(ok && item == 0);
+    ok = queue.TryPush(4);
+    assert(ok);
+    for (int i = 1; i <= 4; i++) {
+        ok = queue.TryPop(&item);
+        assert(ok && item == i);
+    }
+    ok = queue.TryPop(&item);
+    assert(!ok && queue.Empty());
+
+    const std::string dbname = "test_sharded_db";
+    std::filesystem::remove_all(dbname);
+    ShardedOptions options;
+    options.num_shards_ = 3;
+    options.max_sessions_ = 2;
+    options.pin_threads_ = false;
+    options.queue_capacity_ = 4; // 很小的队列，覆盖队列满时的等待
+    {
+        std::unique_ptr<ShardedDB> db = ShardedDB::Open(dbname, options);
+        assert(db != nullptr);
+        // 两个线程各自用自己的会话并发写入
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 2; t++) {
+            writers.emplace_back([&db, t] {
+                std::unique_ptr<ShardSession> session = db->NewSession();
+                assert(session != nullptr);
+                char key[16];
+                for (int i = t; i < 600; i += 2) {
+                    snprintf(key, sizeof(key), "k%04d", i);
+                    bool ok = session->Put(key, std::to_string(i));
+                    assert(ok);
+                }
+            });
+        }
+        for (auto& w : writers) {
+            w.join();
+        }
+
+        std::unique_ptr<ShardSession> session = db->NewSession();
+        std::unique_ptr<ShardSession> session2 = db->NewSession();
+        std::unique_ptr<ShardSession> session3 = db->NewSession();
+        assert(session3 == nullptr); // 会话数已达上限
+
+        WriteBatch batch; // 跨分片的批次
+        batch.Delete("k0000");
+        batch.Delete("k0001");
+        batch.Put("k0002", "two");
+        ok = session->Write(&batch);
+        assert(ok);
+
+        std::string value;
+        ok = session->Get("k0002", &value);
+        assert(ok && value == "two");
+        ok = session2->Get("k0599", &value);
+        assert(ok && value == "599");
+        ok = session->Get("k0000", &value);
+        assert(!ok);
+
+        std::vector<std::pair<std::string, std::string>> results;
+        ok = session->Scan("k0000", 5, &results);
+        assert(ok);
+        assert(results.size() == 5 && results[0].first == "k0002" && results[4].first == "k0006");
+        ok = session->Scan("", 1000, &results);
+        assert(ok && results.size() == 598);
+
+        int counts[3] = {0, 0, 0};
+        for (const auto& kv : results) {
+            counts[db->ShardFor(kv.first)]++;
+        }
+        assert(counts[0] > 0 && counts[1] > 0 && counts[2] > 0);
+    }
+    ShardedOptions wrong = options;
+    wrong.num_shards_ = 2;
+    std::unique_ptr<ShardedDB> rejected = ShardedDB::Open(dbname, wrong);
+    assert(rejected == nullptr);
+    {
+        std::unique_ptr<ShardedDB> db = ShardedDB::Open(dbname, options);
+        assert(db != nullptr);
+        std::unique_ptr<ShardSession> session = db->NewSession();
+        std::string value;
+        ok = session->Get("k0100", &value);
+        assert(ok && value == "100");
+    }
+    std::cout << "  - 分片引擎 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试二进制协议：帧编解码、OutputBuffer 的分块、请求执行
+ */
+void test_binary_protocol() {
+    std::string input;
+    EncodeGetRequest(&input, 7, "key");
+    EncodePutRequest(&input, 8, "k", "v");
+    BinFrame frame;
+    size_t consumed = 0;
+    BinParseResult result;
+    for (size_t len = 0; len < BIN_FRAME_HEADER_SIZE + 3; len++) {
+        result = ParseBinFrame(std::string_view(input).substr(0, len), &frame, &consumed);
+        assert(result == BinParseResult::INCOMPLETE);
+    }
+    result = ParseBinFrame(input, &frame, &consumed);
+    assert(result == BinParseResult::OK);
+    assert(frame.request_id_ == 7 && frame.code_ == static_cast<uint8_t>(BinOpcode::GET) &&
+           frame.payload_ == "key" && consumed == BIN_FRAME_HEADER_SIZE + 3);
+    std::string bad(4, '\xff');
+    result = ParseBinFrame(bad, &frame, &consumed);
+    assert(result == BinParseResult::ERROR);
+
+    // 大值作为独立的块，小数据追加在尾部块
+    OutputBuffer out;
+    out.Tail()->append("abc");
+    out.AppendOwned(std::string(OUTPUT_ZERO_COPY_THRESHOLD, 'x'));
+    out.Tail()->append("de");
+    out.Commit();
+    assert(out.ChunkCount() == 3 && out.Size() == OUTPUT_ZERO_COPY_THRESHOLD + 5);
+    out.Consume(4);
+    assert(out.ChunkCount() == 2 && out.Chunk(0).size() == OUTPUT_ZERO_COPY_THRESHOLD - 1);
+    out.Consume(OUTPUT_ZERO_COPY_THRESHOLD + 1);
+    assert(out.Empty());
+
+    const std::string dbname = "test_binproto_db";
+    std::filesystem::remove_all(dbname);
+    std::unique_ptr<DB> db = DB::Open(dbname, Options());
+    BinCommandHandler handler(db.get());
+    OutputBuffer replies;
+    std::string requests;
+    EncodePutRequest(&requests, 1, "a", "1");
+    EncodeMultiGetRequest(&requests, 2, {"a", "b"});
+    EncodeGetRequest(&requests, 3, "b");
+    std::string_view rest = requests;
+    while (ParseBinFrame(rest, &frame, &consumed) == BinParseResult::OK) {
+        handler.Execute(frame, &replies);
+        rest.remove_prefix(consumed);
+    }
+    replies.Commit();
+    std::string flat;
+    for (size_t i = 0; i < replies.ChunkCount(); i++) {
+        flat.append(replies.Chunk(i));
+    }
+    rest = flat;
+    result = ParseBinFrame(rest, &frame, &consumed);
+    assert(result == BinParseResult::OK && frame.request_id_ == 1 &&
+           frame.code_ == static_cast<uint8_t>(BinStatus::OK));
+    rest.remove_prefix(consumed);
+    result = ParseBinFrame(rest, &frame, &consumed);
+    assert(result == BinParseResult::OK && frame.request_id_ == 2);
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    bool ok = DecodeMultiGetReply(frame.payload_, &values, &found);
+    assert(ok);
+    assert(found.size() == 2 && found[0] && values[0] == "1" && !found[1]);
+    rest.remove_prefix(consumed);
+    result = ParseBinFrame(rest, &frame, &consumed);
+    assert(result == BinParseResult::OK && frame.request_id_ == 3 &&
+           frame.code_ == static_cast<uint8_t>(BinStatus::NOT_FOUND));
+
+    // 头部 count 与实际记录数不一致的批次被整体拒绝：序列号和数据都不变
+    WriteBatch good;
+    good.Put("c", "3");
+    good.Put("d", "4");
+    const std::string& contents = good.Contents();
+    const size_t count_offset = sizeof(uint64_t);
+    std::vector<std::string> bad_batches;
+    for (uint32_t count : {0xFFFFFFFFu, 0u, 1u, 3u}) {
+        std::string bad_contents = contents;
+        memcpy(&bad_contents[count_offset], &count, sizeof(count));
+        bad_batches.push_back(bad_contents);
+    }
+    bad_batches.push_back(contents.substr(0, contents.size() - 1)); // 最后一条记录被截断
+    const uint64_t sequence = db->LastSequence();
+    for (const std::string& bad_contents : bad_batches) {
+        std::string request;
+        AppendBinFrameHeader(&request, 9, static_cast<uint8_t>(BinOpcode::WRITE_BATCH), bad_contents.size());
+        request.append(bad_contents);
+        result = ParseBinFrame(request, &frame, &consumed);
+        assert(result == BinParseResult::OK);
+        OutputBuffer bad_replies;
+        handler.Execute(frame, &bad_replies);
+        bad_replies.Commit();
+        std::string reply;
+        for (size_t i = 0; i < bad_replies.ChunkCount(); i++) {
+            reply.append(bad_replies.Chunk(i));
+        }
+        result = ParseBinFrame(reply, &frame, &consumed);
+        assert(result == BinParseResult::OK && frame.request_id_ == 9 &&
+               frame.code_ == static_cast<uint8_t>(BinStatus::ERROR));
+        assert(db->LastSequence() == sequence);
+        std::string value;
+        bool got = db->Get("c", &value);
+        assert(!got);
+    }
+    std::cout << "  - 二进制协议编解码 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试只读实例：跟随主实例的 MANIFEST (Compaction 删除文件后仍可读)，以及可选的 WAL 跟随
+ */
+void test_secondary_instance() {
+    const std::string dbname = "test_secondary_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 4 * 1024;
+    options.compaction_.l0_compaction_trigger_ = 2;
+    options.compaction_.output_.target_file_size_ = 8 * 1024;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    char key[16];
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), "k%05d", i);
+        bool ok = db->Put(key, "v" + std::to_string(i));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+
+    Options secondary_options = options;
+    secondary_options.secondary_catch_up_interval_ms_ = 0; // 手动跟随
+    std::unique_ptr<DB> secondary = DB::OpenAsSecondary(dbname, secondary_options);
+    assert(secondary != nullptr);
+    std::unique_ptr<DB> missing = DB::OpenAsSecondary("test_secondary_missing", secondary_options);
+    assert(missing == nullptr);
+    std::string value;
+    ok = secondary->Get("k00042", &value);
+    assert(ok && value == "v42");
+    ok = secondary->Put("x", "y");
+    assert(!ok);
+    ok = secondary->Flush();
+    assert(!ok);
+
+    // 主实例继续写入、刷盘、Compaction (旧文件被删除)，只读实例跟随后看到新数据
+    for (int i = 500; i < 3000; i++) {
+        snprintf(key, sizeof(key), "k%05d", i);
+        ok = db->Put(key, "v" + std::to_string(i));
+        assert(ok);
+    }
+    for (int i = 0; i < 3000; i += 3) {
+        snprintf(key, sizeof(key), "k%05d", i);
+        ok = db->Delete(key);
+        assert(ok);
+    }
+    ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    ok = secondary->Get("k02999", &value);
+    assert(!ok);
+    ok = secondary->Get("k00042", &value);
+    assert(ok && value == "v42"); // 已删除的旧文件仍然可读
+    ok = secondary->TryCatchUpWithPrimary();
+    assert(ok);
+    ok = secondary->Get("k02999", &value);
+    assert(ok && value == "v2999");
+    ok = secondary->Get("k00042", &value);
+    assert(!ok);
+    std::vector<std::pair<std::string, std::string>> results;
+    ok = secondary->Scan("k00000", 4, &results);
+    assert(ok && results.size() == 4 &&
+           results[0].first == "k00001" && results[2].first == "k00004");
+
+    // WAL 跟随：还没有刷盘的写入也可见；后台线程自动跟随
+    Options tail_options = options;
+    tail_options.secondary_tail_wal_ = true;
+    tail_options.secondary_catch_up_interval_ms_ = 10;
+    std::unique_ptr<DB> tailing = DB::OpenAsSecondary(dbname, tail_options);
+    assert(tailing != nullptr);
+    ok = db->Put("unflushed", "1");
+    assert(ok);
+    bool seen = false;
+    for (int i = 0; i < 200 && !seen; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        seen = tailing->Get("unflushed", &value);
+    }
+    assert(seen && value == "1" && tailing->LastSequence() == db->LastSequence());
+    for (int i = 3000; i < 4000; i++) { // 跨越多次 MemTable 切换
+        snprintf(key, sizeof(key), "k%05d", i);
+        ok = db->Put(key, "v" + std::to_string(i));
+        assert(ok);
+    }
+    for (int i = 0; i < 200 && tailing->LastSequence() != db->LastSequence(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(tailing->LastSequence() == db->LastSequence());
+    ok = tailing->Get("k03999", &value);
+    assert(ok && value == "v3999");
+    ok = tailing->Get("k03001", &value);
+    assert(ok && value == "v3001");
+    ok = secondary->Get("unflushed", &value);
+    assert(!ok); // 不跟随 WAL 的实例看不到
+    std::cout << "  - 只读实例 (跟随 MANIFEST/WAL) PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试变更数据捕获：GetUpdatesSince 跨多个 (已刷盘且被保留的) WAL 按序读出批次
+ */
+void test_get_updates_since() {
+    const std::string dbname = "test_cdc_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 4 * 1024;
+    options.wal_retention_size_ = 1024 * 1024;
+    char key[16];
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        for (int i = 0; i < 1000; i++) {
+            WriteBatch batch;
+            snprintf(key, sizeof(key), "c%05d", i);
+            batch.Put(key, "v" + std::to_string(i));
+            if (i % 2 == 0) {
+                batch.Delete("old" + std::to_string(i));
+            }
+            bool ok = db->Write(&batch);
+            assert(ok);
+        }
+        db->WaitForIdle();
+    }
+    std::unique_ptr<DB> db = DB::Open(dbname, options); // 重启后刷盘的 WAL 也保留
+    bool ok = db->Put("after_restart", "1");
+    assert(ok);
+    const uint64_t last = db->LastSequence();
+    assert(last == 1501);
+
+    std::unique_ptr<UpdatesIterator> iter = db->GetUpdatesSince(1);
+    assert(iter != nullptr);
+    uint64_t expected = 1;
+    int batches = 0;
+    for (; iter->Valid(); iter->Next()) {
+        assert(iter->batch().Sequence() == expected);
+        expected += iter->batch().Count();
+        batches++;
+    }
+    assert(iter->ok() && batches == 1001 && expected == last + 1);
+
+    // 从批次中间开始：返回包含它的批次
+    iter = db->GetUpdatesSince(1499);
+    assert(iter != nullptr && iter->Valid() && iter->batch().Sequence() == 1498);
+    iter = db->GetUpdatesSince(last + 1);
+    assert(iter != nullptr && !iter->Valid() && iter->ok());
+
+    // 不保留 WAL 时，已刷盘的历史变更不可读
+    db.reset();
+    options.wal_retention_size_ = 0;
+    db = DB::Open(dbname, options);
+    iter = db->GetUpdatesSince(1);
+    assert(iter == nullptr);
+    ok = db->Put("new", "1");
+    assert(ok);
+    iter = db->GetUpdatesSince(last + 1);
+    assert(iter != nullptr && iter->Valid() && iter->batch().Sequence() == last + 1);
+    iter->Next();
+    assert(!iter->Valid() && iter->ok());
+    std::cout << "  - GetUpdatesSince (变更数据捕获) PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试二级索引：写入时原子维护索引条目，按字段查找/范围查找，回填已有数据
+ */
+void test_secondary_index() {
+    const std::string dbname = "test_index_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 4 * 1024;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    // Value 格式: "city=<城市>;age=<年龄>"
+    auto field = [](std::string_view value, std::string_view name) {
+        size_t pos = value.find(std::string(name) + "=");
+        if (pos == std::string_view::npos) {
+            return std::string();
+        }
+        size_t start = pos + name.size() + 1;
+        return std::string(value.substr(start, value.find(';', start) - start));
+    };
+    IndexedDB indexed(db.get());
+    bool ok = indexed.AddIndex("city", [&](std::string_view, std::string_view value, std::vector<std::string>* keys) {
+        std::string city = field(value, "city");
+        if (!city.empty()) keys->push_back(city);
+    });
+    assert(ok);
+    ok = indexed.AddIndex("city", nullptr);
+    assert(!ok);
+
+    char key[16];
+    const char* cities[] = {"beijing", "shanghai", "shenzhen"};
+    for (int i = 0; i < 300; i++) {
+        snprintf(key, sizeof(key), "u%04d", i);
+        char age[8];
+        snprintf(age, sizeof(age), "%03d", i % 100);
+        ok = indexed.Put(key, std::string("city=") + cities[i % 3] + ";age=" + age);
+        assert(ok);
+    }
+    std::vector<std::pair<std::string, std::string>> results;
+    ok = indexed.Lookup("city", "shanghai", 1000, &results);
+    assert(ok && results.size() == 100);
+    assert(results[0].first == "u0001" && field(results[0].second, "city") == "shanghai");
+    ok = indexed.Lookup("city", "shang", 10, &results);
+    assert(ok && results.empty()); // 精确匹配
+
+    // 改写、删除和批次内的多次修改都会更新索引
+    ok = indexed.Put("u0001", "city=beijing;age=001");
+    assert(ok);
+    ok = indexed.Delete("u0004");
+    assert(ok);
+    WriteBatch batch;
+    batch.Put("u0007", "city=hangzhou;age=007");
+    batch.Put("u0007", "city=hangzhou2;age=007");
+    batch.Put("new", "city=hangzhou;age=050");
+    ok = indexed.Write(&batch);
+    assert(ok);
+    ok = indexed.Lookup("city", "shanghai", 1000, &results);
+    assert(ok && results.size() == 97);
+    ok = indexed.Lookup("city", "hangzhou", 10, &results);
+    assert(ok && results.size() == 1 && results[0].first == "new");
+    ok = indexed.LookupRange("city", "hangzhou", "hangzhou~", 10, &results);
+    assert(ok && results.size() == 2 &&
+           results[1].first == "u0007");
+    ok = indexed.LookupRange("city", "s", "", 1000, &results);
+    assert(ok && results.size() == 197);
+
+    // 普通扫描看不到索引条目；Key 不能落在索引前缀里
+    ok = indexed.Scan("u0298", 10, &results);
+    assert(ok && results.size() == 2);
+    ok = indexed.Scan("", 1000, &results);
+    assert(ok && results.size() == 300);
+    ok = indexed.Put(IndexOptions().prefix_ + "x", "y");
+    assert(!ok);
+
+    // 新增的索引回填已有数据
+    ok = indexed.AddIndex("age", [&](std::string_view, std::string_view value, std::vector<std::string>* keys) {
+        keys->push_back(field(value, "age"));
+    });
+    assert(ok);
+    ok = indexed.LookupRange("age", "000", "010", 1000, &results);
+    assert(ok && results.empty());
+    ok = indexed.BuildIndex("age");
+    assert(ok);
+    ok = indexed.LookupRange("age", "000", "010", 1000, &results);
+    assert(ok && results.size() == 29);
+    assert(results[0].first == "u0000" && results[1].first == "u0100");
+    std::cout << "  - 二级索引 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试时间序列模式：按时间窗口切分文件、窗口内合并、按时间范围跳过文件、整文件过期删除
+ */
+void test_time_series() {
+    const std::string dbname = "test_ts_db";
+    std::filesystem::remove_all(dbname);
+    uint64_t now = 10000;
+    Options options;
+    options.write_buffer_size_ = 1024 * 1024; // 只在 Flush 时刷盘
+    TimeSeriesOptions& ts = options.compaction_.time_series_;
+    ts.enabled_ = true;
+    ts.window_size_ = 1000;
+    ts.window_compaction_trigger_ = 2;
+    ts.ttl_ = 5000;
+    ts.clock_ = [&now] { return now; };
+    // Key: [series][时间戳 8B 大端]
+    auto make_key = [](const std::string& series, uint64_t timestamp) {
+        std::string key = series;
+        for (int i = 7; i >= 0; i--) {
+            key.push_back(static_cast<char>((timestamp >> (i * 8)) & 0xff));
+        }
+        return key;
+    };
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    auto live_files = [&db] {
+        std::vector<std::pair<int, FileMetaData>> files;
+        uint64_t flushed = 0;
+        std::vector<std::shared_ptr<SSTableReader>> pinned;
+        assert(db->GetLiveFiles(&files, &flushed, &pinned));
+        for (const auto& f : files) {
+            assert(f.first == 0 && f.second.has_time_range_ &&
+                   f.second.min_timestamp_ / 1000 == f.second.max_timestamp_ / 1000);
+        }
+        return files.size();
+    };
+
+    // 一次刷盘跨 3 个窗口 -> 3 个文件，各自只覆盖一个窗口
+    for (uint64_t t = 5000; t < 8000; t += 10) {
+        bool ok = db->Put(make_key("cpu", t), std::to_string(t));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    assert(live_files() == 3);
+
+    // 同一窗口再写一次：该窗口达到 2 个文件，被合并成 1 个
+    for (uint64_t t = 6005; t < 6500; t += 10) {
+        ok = db->Put(make_key("cpu", t), "late");
+        assert(ok);
+    }
+    ok = db->Delete(make_key("cpu", 6100));
+    assert(ok);
+    ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    assert(live_files() == 3);
+    assert(db->GetCompactionStats().compactions_ >= 1);
+
+    std::string value;
+    ok = db->Get(make_key("cpu", 6005), &value);
+    assert(ok && value == "late");
+    ok = db->Get(make_key("cpu", 7990), &value);
+    assert(ok && value == "7990");
+    ok = db->Get(make_key("cpu", 6100), &value);
+    assert(!ok);
+    ok = db->Get(make_key("cpu", 9000), &value);
+    assert(!ok);
+
+    // 时间范围扫描只返回范围内的点
+    std::vector<std::pair<std::string, std::string>> results;
+    ok = db->ScanTimeRange(make_key("cpu", 0), "cpv", 7000, 7095, 1000, &results);
+    assert(ok);
+    assert(results.size() == 10 && results[0].second == "7000");
+    ok = db->ScanTimeRange("cpu", "cpv", 6000, 6009, 1000, &results);
+    assert(ok);
+    assert(results.size() == 2 && results[0].second == "6000" && results[1].second == "late");
+    ok = db->ScanTimeRange("", "", 100, 200, 1000, &results);
+    assert(ok && results.empty());
+
+    // 时间推进：最大时间戳早于 now - ttl 的文件被整个删除
+    now = 12000;
+    ok = db->Put(make_key("cpu", 11500), "new");
+    assert(ok);
+    ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    assert(db->GetCompactionStats().files_expired_ == 2);
+    ok = db->Get(make_key("cpu", 5000), &value);
+    assert(!ok);
+    ok = db->Get(make_key("cpu", 6005), &value);
+    assert(!ok);
+    ok = db->Get(make_key("cpu", 7000), &value);
+    assert(ok && value == "7000");
+    ok = db->Scan("", 1000, &results);
+    assert(ok && results.size() == 101);
+
+    // 重启后时间范围从 MANIFEST 恢复
+    db.reset();
+    db = DB::Open(dbname, options);
+    ok = db->ScanTimeRange("", "", 11000, 11999, 10, &results);
+    assert(ok && results.size() == 1);
+    ok = db->Get(make_key("cpu", 11500), &value);
+    assert(ok && value == "new");
+    std::cout << "  - 时间序列模式 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 FIFO 模式：超出容量后整文件删除最旧数据，从不归并；可选合并最新的小文件
+ */
+void test_fifo_compaction() {
+    const std::string dbname = "test_fifo_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 1024 * 1024; // 只在 Flush 时刷盘
+    options.compaction_.fifo_.enabled_ = true;
+    options.compaction_.fifo_.max_table_files_size_ = 64 * 1024;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    auto l0_bytes = [&db] {
+        std::vector<std::pair<int, FileMetaData>> files;
+        uint64_t flushed = 0;
+        std::vector<std::shared_ptr<SSTableReader>> pinned;
+        assert(db->GetLiveFiles(&files, &flushed, &pinned));
+        uint64_t total = 0;
+        for (const auto& f : files) {
+            assert(f.first == 0);
+            total += f.second.file_size_;
+        }
+        return std::make_pair(files.size(), total);
+    };
+
+    // 每批约 20KB，写 10 批：只保留最新的几批
+    char key[16];
+    const std::string value(200, 'f');
+    for (int batch = 0; batch < 10; batch++) {
+        for (int i = 0; i < 100; i++) {
+            snprintf(key, sizeof(key), "k%02d_%03d", batch, i);
+            bool ok = db->Put(key, value);
+            assert(ok);
+        }
+        bool ok = db->Flush();
+        assert(ok);
+        db->WaitForIdle();
+        assert(l0_bytes().second <= options.compaction_.fifo_.max_table_files_size_);
+    }
+    CompactionStats stats = db->GetCompactionStats();
+    assert(stats.files_expired_ > 0 && stats.compactions_ == 0 && stats.bytes_written_ == 0);
+    std::string result;
+    bool ok = db->Get("k00_000", &result);
+    assert(!ok);
+    ok = db->Get("k09_099", &result);
+    assert(ok && result == value);
+
+    // 开启小文件合并：最新的连续小文件被合并成一个，合并后的读取仍然正确
+    db.reset();
+    options.compaction_.fifo_.allow_merge_ = true;
+    options.compaction_.fifo_.merge_trigger_ = 3;
+    options.compaction_.fifo_.merge_max_file_size_ = 4 * 1024;
+    db = DB::Open(dbname, options);
+    const size_t files_before = l0_bytes().first;
+    for (int batch = 0; batch < 3; batch++) {
+        ok = db->Put("small", std::to_string(batch));
+        assert(ok);
+        snprintf(key, sizeof(key), "s%02d", batch);
+        ok = db->Put(key, "v");
+        assert(ok);
+        ok = db->Flush();
+        assert(ok);
+        db->WaitForIdle();
+    }
+    assert(db->GetCompactionStats().compactions_ == 1);
+    assert(l0_bytes().first == files_before + 1);
+    ok = db->Get("small", &result);
+    assert(ok && result == "2");
+    ok = db->Get("s00", &result);
+    assert(ok);
+    ok = db->Get("k09_099", &result);
+    assert(ok);
+    std::cout << "  - FIFO Compaction PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试按层压缩、最底层 Compaction (丢弃删除标记、序列号清零) 和周期性 Compaction
+ */
+void test_compression_and_periodic_compaction() {
+    const std::string dbname = "test_periodic_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 1024 * 1024; // 只在 Flush 时刷盘
+    options.compaction_.l0_compaction_trigger_ = 2;
+    options.compaction_.output_.builder_options_.block_size_ = 4096; // 块太小时压缩不了多少
+    options.compaction_.compression_per_level_.assign(NUM_LEVELS, CompressionOptions{CompressionType::ZLIB, 9});
+    options.compaction_.compression_per_level_[0] = CompressionOptions(); // L0 不压缩
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    struct LiveFiles {
+        std::vector<std::pair<int, FileMetaData>> files;
+        std::vector<std::shared_ptr<SSTableReader>> tables;
+        uint64_t entries = 0;
+    };
+    auto live_files = [&db] {
+        LiveFiles live;
+        uint64_t flushed = 0;
+        assert(db->GetLiveFiles(&live.files, &flushed, &live.tables));
+        for (const auto& table : live.tables) {
+            live.entries += table->GetProperties().num_entries_;
+        }
+        return live;
+    };
+
+    char key[16];
+    const std::string value = "value-" + std::string(100, 'z');
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 200; i++) {
+            snprintf(key, sizeof(key), "k%03d", i);
+            bool ok = round == 0 ? db->Put(key, value) : (i % 2 == 0 ? db->Delete(key) : true);
+            assert(ok);
+        }
+        bool ok = db->Flush();
+        assert(ok);
+        db->WaitForIdle();
+    }
+
+    // L0 -> L1 时 L1 就是最底层：删除标记和被删除的值一起消失，序列号清零，按 L1 的设置压缩
+    LiveFiles live = live_files();
+    assert(!live.files.empty() && live.entries == 100);
+    const bool zlib = CompressionSupported(CompressionType::ZLIB);
+    for (size_t i = 0; i < live.files.size(); i++) {
+        const TableProperties& props = live.tables[i]->GetProperties();
+        assert(live.files[i].first == 1 && live.files[i].second.creation_time_ != 0);
+        assert(props.compression_ == static_cast<uint64_t>(zlib ? CompressionType::ZLIB : CompressionType::NONE));
+        assert(!zlib || props.data_size_ * 4 < props.raw_data_size_);
+        std::unique_ptr<Iterator> it = live.tables[i]->NewIterator();
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            uint64_t sequence = 1;
+            ValueType type = TYPE_DELETION;
+            std::string_view user_value;
+            bool ok = DecodeInternalValue(it->value(), &sequence, &type, &user_value);
+            assert(ok);
+            assert(sequence == 0 && type == TYPE_VALUE && user_value == value);
+        }
+    }
+    std::string result;
+    bool ok = db->Get("k000", &result);
+    assert(!ok);
+    ok = db->Get("k001", &result);
+    assert(ok && result == value);
+
+    // 一个没有达到 Compaction 阈值的 L0 文件里的删除标记，只有周期性 Compaction 才会清除
+    for (int i = 1; i < 50; i += 2) {
+        snprintf(key, sizeof(key), "k%03d", i);
+        ok = db->Delete(key);
+        assert(ok);
+    }
+    ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    live = live_files();
+    assert(live.files.front().first == 0 && live.tables.front()->GetProperties().compression_ == 0);
+    db.reset();
+    options.compaction_.periodic_compaction_seconds_ = 1;
+    db = DB::Open(dbname, options);
+    for (int i = 0; i < 50; i++) { // 最多等 5 秒
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        live = live_files();
+        if (live.files.front().first > 0 && live.entries == 75) break;
+    }
+    assert(live.files.front().first > 0 && live.entries == 75);
+    ok = db->Get("k001", &result);
+    assert(!ok);
+    ok = db->Get("k051", &result);
+    assert(ok && result == value);
+    std::vector<std::pair<std::string, std::string>> results;
+    ok = db->Scan("", 1000, &results);
+    assert(ok && results.size() == 75);
+    std::cout << "  - 按层压缩 / 最底层与周期性 Compaction PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试可插拔比较器：逆序 / 8 字节整数 Key 的 MemTable、SSTable 和归并迭代器
+ */
+void test_comparators() {
+    // 整数比较器与字节序一致
+    auto be = [](uint64_t v) {
+        std::string key(8, '\0');
+        for (int i = 7; i >= 0; i--, v >>= 8) key[i] = static_cast<char>(v & 0xff);
+        return key;
+    };
+    const uint64_t samples[] = {0, 1, 255, 256, 65535, 1ull << 40, ~0ull};
+    for (uint64_t a : samples) {
+        for (uint64_t b : samples) {
+            int expected = a < b ? -1 : (a > b ? 1 : 0);
+            assert(Uint64BEComparator::Compare(be(a), be(b)) == expected);
+            assert((BytewiseComparator::Compare(be(a), be(b)) > 0) == (expected > 0));
+        }
+    }
+
+    // 逆序 MemTable -> SSTable -> Reader
+    BasicMemTable<ReverseBytewiseComparator> reverse_mem;
+    char key[16];
+    for (int i = 0; i < 300; i++) {
+        snprintf(key, sizeof(key), "r%04d", i);
+        reverse_mem.put(key, "v" + std::to_string(i));
+    }
+    assert(reverse_mem.GetMap().begin()->first.key_ == "r0299");
+    const std::string filename = "test_comparator.sst";
+    BuilderOptions options;
+    options.comparator_ = ComparatorType::REVERSE_BYTEWISE;
+    {
+        SSTableBuilder builder(filename, options);
+        for (const auto& pair : reverse_mem.GetMap()) {
+            bool ok = builder.Add(pair.first.key_, pair.second);
+            assert(ok);
+        }
+        bool ok = builder.Add("r9999", "out of order");
+        assert(!ok); // 逆序文件中更大的 Key 必须在前面
+        ok = builder.Finish();
+        assert(ok);
+    }
+    BlockCache cache(64 * 1024);
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = &cache; // 同时经过 Filter 分区的查找
+    SSTableReader reader(filename, reader_options);
+    assert(reader.is_valid() && reader.GetProperties().comparator_ == 1);
+    std::string value;
+    bool ok = reader.Get("r0000", &value);
+    assert(ok && value == "v0");
+    ok = reader.Get("r0150", &value);
+    assert(ok && value == "v150");
+    ok = reader.Get("r0150x", &value);
+    assert(!ok);
+    ok = reader.Get("a", &value);
+    assert(!ok);
+    std::unique_ptr<Iterator> it = reader.NewIterator();
+    it->Seek("r0100x"); // 逆序中 "r0100x" 之后的第一个 Key
+    assert(it->Valid() && it->key() == "r0100");
+    it->Next();
+    assert(it->Valid() && it->key() == "r0099");
+
+    // 逆序的两路归并：新值覆盖旧值，顺序保持逆序
+    BasicMemTable<ReverseBytewiseComparator> newer;
+    newer.put("r0150", "new");
+    newer.put("r9999", "top");
+    std::vector<std::unique_ptr<Iterator>> children;
+    children.push_back(newer.NewIterator());
+    children.push_back(reader.NewIterator());
+    std::unique_ptr<Iterator> merged = NewMergingIterator(std::move(children), ComparatorType::REVERSE_BYTEWISE);
+    merged->SeekToFirst();
+    assert(merged->Valid() && merged->key() == "r9999");
+    merged->Seek("r0150");
+    assert(merged->Valid() && merged->value() == "new");
+    int count = 0;
+    for (merged->SeekToFirst(); merged->Valid(); merged->Next()) count++;
+    assert(count == 301 && merged->ok());
+
+    // 8 字节整数 Key
+    BasicMemTable<Uint64BEComparator> int_mem;
+    for (uint64_t i = 0; i < 500; i++) {
+        int_mem.put(be(i * 3), std::to_string(i * 3));
+    }
+    options.comparator_ = ComparatorType::UINT64_BE;
+    {
+        SSTableBuilder builder(filename, options);
+        for (const auto& pair : int_mem.GetMap()) {
+            ok = builder.Add(pair.first.key_, pair.second);
+            assert(ok);
+        }
+        ok = builder.Finish();
+        assert(ok);
+    }
+    SSTableReader int_reader(filename);
+    ok = int_reader.Get(be(999), &value);
+    assert(ok && value == "999");
+    ok = int_reader.Get(be(1000), &value);
+    assert(!ok);
+    it = int_reader.NewIterator();
+    it->Seek(be(1000));
+    assert(it->Valid() && it->key() == be(1002));
+    std::filesystem::remove(filename);
+    std::cout << "  - 可插拔比较器 (逆序 / 整数 Key) PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试定长 Key 数据块：自动选择布局、块内查找 (含 AVX2 路径)、迭代与 Seek
+ */
+void test_fixed_key_blocks() {
+    auto be = [](uint64_t v) {
+        std::string key(8, '\0');
+        for (int i = 7; i >= 0; i--, v >>= 8) key[i] = static_cast<char>(v & 0xff);
+        return key;
+    };
+    const std::string filename = "test_fixed_key.sst";
+    // 每种组合：比较器、Key 生成方式、是否压缩
+    struct Case {
+        ComparatorType comparator;
+        bool four_byte_keys;
+        bool compress;
+    };
+    const Case cases[] = {
+        {ComparatorType::BYTEWISE, false, false},
+        {ComparatorType::UINT64_BE, false, true},
+        {ComparatorType::REVERSE_BYTEWISE, false, false},
+        {ComparatorType::BYTEWISE, true, false},
+    };
+    for (const Case& c : cases) {
+        const int n = 2000;
+        std::vector<std::string> keys;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(c.four_byte_keys ? be(static_cast<uint64_t>(i) * 2).substr(4)
+                                            : be(static_cast<uint64_t>(i) * 2 + (1ull << 60)));
+        }
+        if (c.comparator == ComparatorType::REVERSE_BYTEWISE) {
+            std::reverse(keys.begin(), keys.end());
+        }
+        BuilderOptions options;
+        options.comparator_ = c.comparator;
+        options.block_size_ = 4096;
+        options.compression_.type_ = c.compress ? CompressionType::ZLIB : CompressionType::NONE;
+        {
+            SSTableBuilder builder(filename, options);
+            for (int i = 0; i < n; i++) {
+                bool ok = builder.Add(keys[i], "v" + std::to_string(i));
+                assert(ok);
+            }
+            bool ok = builder.Finish();
+            assert(ok);
+            const TableProperties& props = builder.GetProperties();
+            assert(props.num_data_blocks_ > 1 && props.num_fixed_key_blocks_ == props.num_data_blocks_);
+        }
+        SSTableReader reader(filename);
+        assert(reader.is_valid());
+        std::string value;
+        for (int i = 0; i < n; i += 7) {
+            bool ok = reader.Get(keys[i], &value);
+            assert(ok && value == "v" + std::to_string(i));
+        }
+        // 奇数不存在；Seek 落到顺序上的下一个 Key
+        std::string missing = c.four_byte_keys ? be(999).substr(4) : be(999 + (1ull << 60));
+        bool ok = reader.Get(missing, &value);
+        assert(!ok);
+        std::unique_ptr<Iterator> it = reader.NewIterator();
+        it->Seek(missing);
+        const int next = c.comparator == ComparatorType::REVERSE_BYTEWISE ? n - 1 - 499 : 500;
+        assert(it->Valid() && it->key() == keys[next] && it->value() == "v" + std::to_string(next));
+        int count = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            assert(it->key() == keys[count]);
+            count++;
+        }
+        assert(count == n && it->ok());
+    }
+
+    // Key 长度不一致时使用普通布局
+    {
+        SSTableBuilder builder(filename);
+        bool ok = builder.Add("a", "1");
+        assert(ok);
+        ok = builder.Add("bb", "2");
+        assert(ok);
+        ok = builder.Finish();
+        assert(ok);
+        assert(builder.GetProperties().num_fixed_key_blocks_ == 0);
+    }
+    SSTableReader reader(filename);
+    std::string value;
+    bool ok = reader.Get("bb", &value);
+    assert(ok && value == "2");
+    std::filesystem::remove(filename);
+    std::cout << "  - 定长 Key 数据块 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试 Key 缩写：缩写相同 (长公共前缀、补 0) 时必须退回完整比较
+ */
+void test_key_prefixes() {
+    assert(KeyPrefix("") == 0 && KeyPrefix("a") == KeyPrefix(std::string("a\0", 2)));
+    assert(KeyPrefix("abcdefgh") == KeyPrefix("abcdefghZZ"));
+    assert(ComparePrefixed<BytewiseComparator>(PrefixedKeyRef("a"), PrefixedKeyRef(std::string_view("a\0", 2))) < 0);
+    assert(ComparePrefixed<ReverseBytewiseComparator>(PrefixedKeyRef("b"), PrefixedKeyRef("a")) < 0);
+    assert(ComparePrefixed<BytewiseComparator>(PrefixedKeyRef("\xff"), PrefixedKeyRef("\x01")) > 0);
+
+    // 前 8 字节相同的 Key (只在尾部不同) 与短 Key 混在一起
+    std::vector<std::string> keys;
+    for (int i = 0; i < 400; i++) {
+        keys.push_back("user:000" + std::to_string(i % 4) + ":" + std::to_string(i));
+    }
+    keys.push_back("user");
+    keys.push_back(std::string("user\0", 5));
+    keys.push_back("\xfe\xff");
+
+    BasicMemTable<BytewiseComparator> mem;
+    BasicMemTable<ReverseBytewiseComparator> reverse_mem;
+    for (const auto& key : keys) {
+        mem.put(key, "v" + key);
+        reverse_mem.put(key, "v" + key);
+    }
+    std::vector<std::string> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    size_t i = 0;
+    for (const auto& pair : mem.GetMap()) {
+        assert(pair.first.key_ == sorted[i++]);
+    }
+    i = sorted.size();
+    for (const auto& pair : reverse_mem.GetMap()) {
+        assert(pair.first.key_ == sorted[--i]);
+    }
+    std::string value;
+    bool found = mem.get(std::string("user\0", 5), &value);
+    assert(found && value == "v" + std::string("user\0", 5));
+    found = mem.get("user:0001:2", &value);
+    assert(!found);
+    found = reverse_mem.get("user:0001:2", &value);
+    assert(!found);
+
+    // 索引中相邻块的最后一个 Key 共享前 8 字节
+    const std::string filename = "test_key_prefix.sst";
+    for (ComparatorType type : {ComparatorType::BYTEWISE, ComparatorType::REVERSE_BYTEWISE}) {
+        BuilderOptions options;
+        options.comparator_ = type;
+        {
+            SSTableBuilder builder(filename, options);
+            if (type == ComparatorType::BYTEWISE) {
+                for (const auto& pair : mem.GetMap()) {
+                    bool ok = builder.Add(pair.first.key_, pair.second);
+                    assert(ok);
+                }
+            } else {
+                for (const auto& pair : reverse_mem.GetMap()) {
+                    bool ok = builder.Add(pair.first.key_, pair.second);
+                    assert(ok);
+                }
+            }
+            bool ok = builder.Finish();
+            assert(ok);
+            assert(builder.GetProperties().num_data_blocks_ > 10);
+        }
+        SSTableReader reader(filename);
+        for (const auto& key : keys) {
+            bool ok = reader.Get(key, &value);
+            assert(ok && value == "v" + key);
+        }
+        bool ok = reader.Get("user:0001:2", &value);
+        assert(!ok);
+        ok = reader.Get("user:0003:9999", &value);
+        assert(!ok);
+        std::unique_ptr<Iterator> it = reader.NewIterator();
+        it->Seek("user:0002:");
+        const std::string expected = type == ComparatorType::BYTEWISE ? "user:0002:10" : "user:0001:97";
+        assert(it->Valid() && it->key() == expected);
+    }
+    std::filesystem::remove(filename);
+    std::cout << "  - Key 缩写 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试批量查找：Reader 和 DB 的 MultiGet 与逐个 Get 结果一致
+ */
+void test_batched_lookups() {
+    // Reader: 多个数据块 + Filter 分区，批次大小不是 16 的倍数
+    const std::string filename = "test_multiget.sst";
+    char key[16];
+    {
+        SSTableBuilder builder(filename);
+        for (int i = 0; i < 2000; i += 2) {
+            snprintf(key, sizeof(key), "m%05d", i);
+            bool ok = builder.Add(key, "v" + std::to_string(i));
+            assert(ok);
+        }
+        bool ok = builder.Finish();
+        assert(ok);
+    }
+    BlockCache cache(1024 * 1024);
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = &cache;
+    SSTableReader reader(filename, reader_options);
+    std::vector<std::string> key_storage;
+    for (int i = 1999; i >= 0; i -= 3) { // 乱序、一半不存在
+        snprintf(key, sizeof(key), "m%05d", i);
+        key_storage.push_back(key);
+    }
+    key_storage.push_back("a");
+    key_storage.push_back("zzz");
+    std::vector<std::string_view> keys(key_storage.begin(), key_storage.end());
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    reader.MultiGet(keys, &values, &found);
+    assert(values.size() == keys.size() && found.size() == keys.size());
+    std::string value;
+    for (size_t i = 0; i < keys.size(); i++) {
+        bool expected = reader.Get(keys[i], &value);
+        assert(found[i] == expected && (!expected || values[i] == value));
+    }
+    std::filesystem::remove(filename);
+
+    // DB: 数据分布在 MemTable、L0 和更深的层，包括删除和覆盖
+    const std::string dbname = "test_multiget_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 1024 * 1024;
+    options.compaction_.l0_compaction_trigger_ = 2;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    for (int round = 0; round < 2; round++) { // 两个 L0 文件触发一次到 L1 的 Compaction
+        for (int i = round; i < 1000; i += 2) {
+            snprintf(key, sizeof(key), "d%04d", i);
+            bool ok = db->Put(key, "old" + std::to_string(i));
+            assert(ok);
+        }
+        bool ok = db->Flush();
+        assert(ok);
+    }
+    db->WaitForIdle();
+    {
+        std::vector<std::pair<int, FileMetaData>> files;
+        uint64_t flushed = 0;
+        std::vector<std::shared_ptr<SSTableReader>> pinned;
+        assert(db->GetLiveFiles(&files, &flushed, &pinned) && !files.empty() && files.back().first > 0);
+    }
+    for (int i = 0; i < 1000; i += 5) {
+        snprintf(key, sizeof(key), "d%04d", i);
+        bool ok = db->Put(key, "new" + std::to_string(i));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    for (int i = 0; i < 1000; i += 7) {
+        snprintf(key, sizeof(key), "d%04d", i);
+        ok = db->Delete(key);
+        assert(ok);
+    }
+    ok = db->Put("d0003", "mem");
+    assert(ok);
+    key_storage.clear();
+    for (int i = 0; i < 1100; i++) {
+        snprintf(key, sizeof(key), "d%04d", (i * 37) % 1100);
+        key_storage.push_back(key);
+    }
+    keys.assign(key_storage.begin(), key_storage.end());
+    db->MultiGet(keys, &values, &found);
+    for (size_t i = 0; i < keys.size(); i++) {
+        bool expected = db->Get(keys[i], &value);
+        assert(found[i] == expected && (!expected || values[i] == value));
+    }
+    assert(found[0] == false);                       // d0000 已删除
+    ok = db->Get("d0003", &value);
+    assert(ok && value == "mem");
+    db.reset();
+    std::filesystem::remove_all(dbname);
+    std::cout << "  - 批量查找 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试行缓存：命中路径、写入失效、进行中的查找不会插入过期的值
+ */
+void test_row_cache() {
+    RowCache cache(1024);
+    std::string value;
+    uint64_t epoch = cache.Epoch();
+    bool ok = cache.Insert("k", "v1", 10, epoch);
+    assert(ok);
+    ok = cache.Lookup("k", &value);
+    assert(ok && value == "v1");
+    cache.BeginFill("k");                              // 快照 10 的查找进行中
+    cache.Invalidate("k", 12);                         // 快照 10 之后的写入
+    ok = cache.Lookup("k", &value);
+    assert(!ok);
+    ok = cache.Insert("k", "stale", 10, epoch);
+    assert(!ok);                                       // 快照早于写入：丢弃
+    cache.EndFill("k");
+    ok = cache.Insert("k", "v2", 12, epoch);
+    assert(ok);
+    ok = cache.Lookup("k", &value);
+    assert(ok && value == "v2");
+    cache.Clear();
+    ok = cache.Insert("x", "v", 12, epoch);
+    assert(!ok);                                       // 整体失效后 epoch 变化
+    epoch = cache.Epoch();
+    cache.BeginFill("old");
+    cache.Invalidate("old", 13);
+    for (int i = 0; i < 20; i++) {                     // 把失效标记挤出去
+        ok = cache.Insert("fill" + std::to_string(i), std::string(100, 'f'), 13, cache.Epoch());
+        assert(ok);
+    }
+    assert(cache.Epoch() != epoch);
+    ok = cache.Insert("old", "stale", 12, epoch);
+    assert(!ok);
+    cache.EndFill("old");
+    assert(cache.GetUsage() <= cache.GetCapacity() && cache.GetRejectedInserts() == 3);
+
+    // 没有缓存、也没有进行中查找的 Key 被写入时不留失效标记：不占容量，也不会改变 epoch
+    const size_t usage = cache.GetUsage();
+    epoch = cache.Epoch();
+    for (int i = 0; i < 100; i++) {
+        cache.Invalidate("cold" + std::to_string(i), 14 + i);
+    }
+    assert(cache.GetUsage() == usage && cache.Epoch() == epoch);
+
+    // DB: 刷盘后的热点 Key 从行缓存返回；写入 (包括删除) 之后读到新值
+    const std::string dbname = "test_row_cache_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.row_cache_size_ = 64 * 1024;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    char key[16];
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), "r%04d", i);
+        ok = db->Put(key, "v" + std::to_string(i));
+        assert(ok);
+    }
+    ok = db->Flush();
+    assert(ok);
+    const RowCache* row_cache = db->GetRowCache();
+    assert(row_cache != nullptr);
+    ok = db->Get("r0042", &value);
+    assert(ok && value == "v42");
+    const uint64_t hits = row_cache->GetHits();
+    ok = db->Get("r0042", &value);
+    assert(ok && value == "v42" && row_cache->GetHits() == hits + 1);
+    ok = db->Put("r0042", "new");
+    assert(ok);
+    ok = db->Delete("r0043");
+    assert(ok);
+    ok = db->Flush();
+    assert(ok);
+    ok = db->Get("r0042", &value);
+    assert(ok && value == "new");
+    ok = db->Get("r0043", &value);
+    assert(!ok);
+    ok = db->Get("r0043", &value); // 第二次也不能从行缓存读到旧值
+    assert(!ok);
+    std::vector<std::string_view> keys = {"r0042", "r0043", "r0044", "zzz"};
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    db->MultiGet(keys, &values, &found);
+    assert(found[0] && values[0] == "new" && !found[1] && found[2] && values[2] == "v44" && !found[3]);
+    assert(row_cache->GetInserts() > 0 && row_cache->GetUsage() <= row_cache->GetCapacity());
+
+    // 大量写入未缓存的 Key 不会把热点 Key 挤出行缓存
+    for (int i = 0; i < 5000; i++) {
+        snprintf(key, sizeof(key), "w%05d", i);
+        ok = db->Put(key, "x");
+        assert(ok);
+    }
+    const uint64_t hot_hits = row_cache->GetHits();
+    ok = db->Get("r0044", &value);
+    assert(ok && value == "v44" && row_cache->GetHits() == hot_hits + 1);
+    db.reset();
+    std::filesystem::remove_all(dbname);
+    std::cout << "  - 行缓存 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试二级块缓存：内存淘汰的块写入段文件，内存未命中时从二级缓存取回
+ */
+void test_secondary_cache() {
+    const std::string dir = "test_secondary_cache";
+    SecondaryCacheOptions secondary_options;
+    secondary_options.dir_ = dir;
+    secondary_options.capacity_ = 64 * 1024;
+    secondary_options.segment_size_ = 8 * 1024;
+    secondary_options.max_pending_segments_ = 64; // 下面的断言要求所有块都被插入 (写盘跟不上时也不丢)
+    {
+        SecondaryCache secondary(secondary_options);
+        assert(secondary.is_open());
+        BlockCache cache(4 * 1024, &secondary);
+        auto block_of = [](int i) { return std::string(1000, static_cast<char>('a' + i % 26)) + std::to_string(i); };
+        for (int i = 0; i < 40; i++) {
+            cache.Insert(7, i * 1000, std::make_shared<BlockContents>(block_of(i)), BlockCache::Priority::LOW);
+        }
+        assert(cache.GetUsage() <= cache.GetCapacity() && secondary.GetUsage() > 0);
+        std::shared_ptr<const BlockContents> block = cache.Lookup(7, 39 * 1000); // 还在内存中
+        assert(block != nullptr && std::string_view(*block) == block_of(39) && cache.GetSecondaryHits() == 0);
+        block = cache.Lookup(7, 30 * 1000);                                   // 还在当前段 (内存缓冲)
+        assert(block != nullptr && std::string_view(*block) == block_of(30) && cache.GetSecondaryHits() == 1);
+        secondary.Flush();
+        assert(secondary.GetBytesWritten() > 0);
+        block = cache.Lookup(7, 0);                                           // 从段文件读取
+        assert(block != nullptr && std::string_view(*block) == block_of(0) && cache.GetSecondaryHits() == 2);
+        cache.Erase(7, 1000);
+        block = cache.Lookup(7, 1000);
+        assert(block == nullptr);
+
+        // 超出容量时整段淘汰最旧的段
+        for (int i = 100; i < 300; i++) {
+            cache.Insert(8, i * 1000, std::make_shared<BlockContents>(block_of(i)), BlockCache::Priority::LOW);
+        }
+        secondary.Flush();
+        assert(secondary.GetUsage() <= secondary_options.capacity_);
+        block = cache.Lookup(8, 100 * 1000);
+        assert(block == nullptr);
+        block = cache.Lookup(8, 280 * 1000);
+        assert(block != nullptr && std::string_view(*block) == block_of(280));
+        assert(secondary.GetDroppedInserts() == 0);
+    }
+
+    // 写盘跟不上时，内存中等待写盘的段不超过上限 (多出来的块被丢弃)
+    secondary_options.max_pending_segments_ = 1;
+    {
+        SecondaryCache secondary(secondary_options);
+        const std::string block(1000, 'p');
+        uint64_t max_memory = 0;
+        for (int i = 0; i < 500; i++) {
+            secondary.Insert(9, i * 1000, block);
+            max_memory = std::max(max_memory, secondary.GetMemoryUsage());
+        }
+        assert(max_memory <= (secondary_options.max_pending_segments_ + 1) * secondary_options.segment_size_);
+        secondary.Flush();
+        assert(secondary.GetMemoryUsage() == 0);
+        std::cout << "  - 二级缓存写盘积压上限: 内存最多 " << max_memory << " 字节, 丢弃 "
+                  << secondary.GetDroppedInserts() << " 个块" << std::endl;
+    }
+
+    // SSTableReader: 内存块缓存很小，第二遍查找从二级缓存命中
+    const std::string filename = "test_secondary_cache.sst";
+    char key[16];
+    {
+        SSTableBuilder builder(filename);
+        for (int i = 0; i < 3000; i++) {
+            snprintf(key, sizeof(key), "s%05d", i);
+            bool ok = builder.Add(key, "v" + std::to_string(i));
+            assert(ok);
+        }
+        bool ok = builder.Finish();
+        assert(ok);
+    }
+    SecondaryCache secondary(secondary_options);
+    BlockCache cache(2 * 1024, &secondary);
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = &cache;
+    SSTableReader reader(filename, reader_options);
+    std::string value;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < 3000; i += 11) {
+            snprintf(key, sizeof(key), "s%05d", i);
+            bool ok = reader.Get(key, &value);
+            assert(ok && value == "v" + std::to_string(i));
+        }
+    }
+    assert(cache.GetSecondaryHits() > 0 && secondary.GetHits() == cache.GetSecondaryHits());
+    std::filesystem::remove(filename);
+    std::filesystem::remove_all(dir);
+    std::cout << "  - 二级块缓存 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试块缓存的压缩层：热层淘汰的块压缩保存，未命中时解压取回
+ */
+void test_compressed_block_cache() {
+    if (!CompressionSupported(CompressionType::ZLIB)) {
+        std::cout << "  - 块缓存压缩层 SKIPPED (没有 zlib)" << std::endl;
+        return;
+    }
+    BlockCacheOptions options;
+    options.capacity_ = 8 * 1024;
+    options.compressed_capacity_ = 64 * 1024;
+    BlockCache cache(options);
+    assert(cache.GetCompressedTier() != nullptr);
+    auto block_of = [](int i) {
+        std::string block;
+        for (int j = 0; j < 100; j++) block += "key" + std::to_string(i * 100 + j) + "=value;";
+        return block;
+    };
+    const int n = 60; // 原始总量约 80KB: 热层放不下，压缩后全部装进压缩层
+    size_t raw_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        auto block = std::make_shared<BlockContents>(block_of(i));
+        raw_bytes += block->size();
+        cache.Insert(1, i * 4096, std::move(block), BlockCache::Priority::LOW);
+    }
+    const BlockCache* compressed = cache.GetCompressedTier();
+    assert(cache.GetUsage() <= cache.GetCapacity());
+    assert(compressed->GetUsage() <= compressed->GetCapacity() && compressed->GetUsage() < raw_bytes / 2);
+    for (int i = 0; i < n; i++) {
+        std::shared_ptr<const BlockContents> block = cache.Lookup(1, i * 4096);
+        assert(block != nullptr && std::string_view(*block) == block_of(i));
+    }
+    assert(cache.GetCompressedHits() > 0 && cache.GetMisses() == cache.GetCompressedHits());
+    cache.Erase(1, 0);
+    std::shared_ptr<const BlockContents> erased = cache.Lookup(1, 0);
+    assert(erased == nullptr);
+
+    // DB 选项：读路径经过压缩层
+    const std::string dbname = "test_compressed_cache_db";
+    std::filesystem::remove_all(dbname);
+    Options db_options;
+    db_options.block_cache_size_ = 4 * 1024;
+    db_options.block_cache_compressed_size_ = 256 * 1024;
+    std::unique_ptr<DB> db = DB::Open(dbname, db_options);
+    char key[16];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "c%05d", i);
+        bool ok = db->Put(key, "value-" + std::to_string(i));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    std::string value;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < 2000; i += 13) {
+            snprintf(key, sizeof(key), "c%05d", i);
+            ok = db->Get(key, &value);
+            assert(ok && value == "value-" + std::to_string(i));
+        }
+    }
+    assert(db->GetBlockCache()->GetCompressedHits() > 0);
+    db.reset();
+    std::filesystem::remove_all(dbname);
+    std::cout << "  - 块缓存压缩层 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试块缓存预热：关闭时记录缓存中的块，重新打开后在后台读回缓存
+ */
+void test_cache_warmup() {
+    const std::string dbname = "test_cache_warmup_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.cache_warmup_ = true;
+    options.cache_dump_interval_seconds_ = 0;  // 只在关闭时写
+    options.cache_warmup_bytes_per_second_ = 0; // 不限速
+    char key[16];
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        uint64_t warmed = db->WaitForCacheWarmup();
+        assert(warmed == 0); // 第一次打开没有预热文件
+        for (int i = 0; i < 3000; i++) {
+            snprintf(key, sizeof(key), "w%05d", i);
+            bool ok = db->Put(key, "value-" + std::to_string(i));
+            assert(ok);
+        }
+        bool ok = db->Flush();
+        assert(ok);
+        std::string value;
+        for (int i = 0; i < 3000; i += 3) {
+            snprintf(key, sizeof(key), "w%05d", i);
+            ok = db->Get(key, &value);
+            assert(ok);
+        }
+        assert(db->GetBlockCache()->GetUsage() > 0);
+    }
+    assert(std::filesystem::file_size(CacheWarmupFileName(dbname)) > 0);
+
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        uint64_t warmed = db->WaitForCacheWarmup();
+        assert(warmed > 0);
+        const BlockCache* cache = db->GetBlockCache();
+        const uint64_t misses = cache->GetMisses();
+        std::string value;
+        for (int i = 0; i < 3000; i += 3) {
+            snprintf(key, sizeof(key), "w%05d", i);
+            bool ok = db->Get(key, &value);
+            assert(ok && value == "value-" + std::to_string(i));
+        }
+        assert(cache->GetMisses() == misses); // 全部命中预热的块
+    }
+
+    // 限速很低时关闭不会被预热线程拖住
+    options.cache_warmup_bytes_per_second_ = 1;
+    {
+        std::unique_ptr<DB> db = DB::Open(dbname, options);
+        auto start = std::chrono::steady_clock::now();
+        db.reset();
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    }
+    std::filesystem::remove_all(dbname);
+
+    // 预热跳过已缓存的块时没有副作用：不计入命中/未命中，不调整 LRU 顺序
+    const std::string filename = "test_prefetch.sst";
+    {
+        SSTableBuilder builder(filename);
+        for (int i = 0; i < 200; i++) {
+            snprintf(key, sizeof(key), "w%05d", i);
+            bool added = builder.Add(key, "value-" + std::to_string(i));
+            assert(added);
+        }
+        bool finished = builder.Finish();
+        assert(finished);
+    }
+    BlockCache cache(1024 * 1024);
+    ReaderOptions reader_options;
+    reader_options.block_cache_ = &cache;
+    SSTableReader reader(filename, reader_options);
+    std::vector<BlockHandle> handles = reader.GetDataBlockHandles();
+    for (const BlockHandle& handle : handles) {
+        size_t read = reader.PrefetchBlock(handle.offset_);
+        assert(read == handle.size_);
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> keys_before;
+    cache.GetKeys(&keys_before);
+    const uint64_t hits = cache.GetHits();
+    const uint64_t misses = cache.GetMisses();
+    for (auto it = handles.rbegin(); it != handles.rend(); ++it) { // 倒序：如果调整了 LRU 顺序就能看出来
+        size_t read = reader.PrefetchBlock(it->offset_);
+        assert(read == 0);
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> keys_after;
+    cache.GetKeys(&keys_after);
+    assert(cache.GetHits() == hits && cache.GetMisses() == misses);
+    assert(keys_after == keys_before);
+    std::cout << "  - 块缓存预热 PASSED" << std::endl;
+}
+
+/**
+ * @brief (测试) 块缓存优先级池：池比例上限、最低优先级先淘汰、固定的块不淘汰，
+ * 以及 DB 固定 L0 文件的 Filter、Compaction 以最低优先级读取
+ */
+void test_block_cache_pools() {
+    BlockCacheOptions cache_options;
+    cache_options.capacity_ = 4096;
+    cache_options.high_pri_pool_ratio_ = 0.25;
+    BlockCache cache(cache_options);
+    auto block = std::make_shared<const BlockContents>(200, 'x');
+
+    // 高优先级池超出 1/4 容量：最旧的条目降为低优先级
+    for (uint64_t offset = 0; offset < 6; offset++) {
+        cache.Insert(1, offset, block, BlockCache::Priority::HIGH);
+    }
+    assert(cache.GetPoolUsage(BlockCache::Priority::HIGH) <= 1024);
+    assert(cache.GetPoolUsage(BlockCache::Priority::LOW) > 0);
+
+    // 大量最低优先级的块 (Compaction 读取) 只会淘汰彼此
+    for (uint64_t offset = 0; offset < 30; offset++) {
+        cache.Insert(2, offset, block, BlockCache::Priority::BOTTOM);
+    }
+    assert(cache.GetUsage() <= cache.GetCapacity());
+    std::shared_ptr<const BlockContents> hit;
+    for (uint64_t offset = 0; offset < 6; offset++) {
+        // 以 BOTTOM 查找不会提升条目的优先级
+        hit = cache.Lookup(1, offset, BlockCache::Priority::BOTTOM);
+        assert(hit != nullptr);
+    }
+    hit = cache.Lookup(2, 0, BlockCache::Priority::BOTTOM);
+    assert(hit == nullptr);
+
+    // 固定的块在任何压力下都不淘汰，Erase 后释放
+    cache.Insert(3, 0, block, BlockCache::Priority::LOW);
+    bool pinned = cache.Pin(3, 0);
+    assert(pinned);
+    pinned = cache.Pin(3, 1);
+    assert(!pinned);
+    assert(cache.GetPinnedUsage() > 0);
+    for (uint64_t offset = 0; offset < 40; offset++) {
+        cache.Insert(4, offset, block, BlockCache::Priority::HIGH);
+    }
+    hit = cache.Lookup(3, 0);
+    assert(hit != nullptr);
+    hit.reset();
+    cache.Erase(3, 0);
+    assert(cache.GetPinnedUsage() == 0);
+    hit = cache.Lookup(3, 0);
+    assert(hit == nullptr);
+
+    // DB：L0 文件的 Filter 分区固定在缓存中，归并到 L1 后释放；Compaction 的读取是最低优先级
+    const std::string dbname = "test_block_cache_pools_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.write_buffer_size_ = 1024 * 1024; // 只在 Flush 时切换 MemTable，每次产生一个 L0 文件
+    options.compaction_.l0_compaction_trigger_ = 2;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    const BlockCache* db_cache = db->GetBlockCache();
+    char key[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "p%05d", i);
+        bool ok = db->Put(key, "value-" + std::to_string(i));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    std::string value;
+    ok = db->Get("p00042", &value);
+    assert(ok && value == "value-42");
+    assert(db_cache->GetPinnedUsage() > 0);
+
+    for (int i = 0; i < 1000; i += 2) {
+        snprintf(key, sizeof(key), "p%05d", i);
+        ok = db->Put(key, "new-" + std::to_string(i));
+        assert(ok);
+    }
+    ok = db->Flush();
+    assert(ok);
+    db->WaitForIdle();
+    assert(db_cache->GetPinnedUsage() == 0);
+    assert(db_cache->GetPoolUsage(BlockCache::Priority::BOTTOM) > 0);
+    ok = db->Get("p00042", &value);
+    assert(ok && value == "new-42");
+    ok = db->Get("p00043", &value);
+    assert(ok && value == "value-43");
+    db.reset();
+    std::filesystem::remove_all(dbname);
+    std::cout << "  - 块缓存优先级池 PASSED" << std::endl;
+}
+
+/**
+ * @brief (测试) 大页内存：区域的分配与归还、块缓存的块内容、DB 的 MemTable Arena (没有大页时退回普通页)
+ */
+void test_huge_pages() {
+    auto total = [](const HugePageStats& stats) {
+        return stats.explicit_bytes_ + stats.transparent_bytes_ + stats.regular_bytes_;
+    };
+    {
+        HugePageResource resource(HugePageMode::EXPLICIT);
+        std::vector<void*> small;
+        for (int i = 0; i < 100; i++) {
+            small.push_back(resource.allocate(4096));
+            memset(small.back(), i, 4096);
+        }
+        assert(total(resource.GetStats()) == HugePageResource::kHugePageSize); // 小请求共用一个区域
+        void* large = resource.allocate(3 * 1024 * 1024);
+        memset(large, 1, 3 * 1024 * 1024);
+        assert(total(resource.GetStats()) == 3 * HugePageResource::kHugePageSize);
+        resource.deallocate(large, 3 * 1024 * 1024);
+        for (void* p : small) {
+            resource.deallocate(p, 4096);
+        }
+        assert(total(resource.GetStats()) == HugePageResource::kHugePageSize); // 当前区域留着复用
+    }
+
+    BlockCacheOptions cache_options;
+    cache_options.capacity_ = 64 * 1024;
+    cache_options.huge_pages_ = HugePageMode::TRANSPARENT;
+    std::shared_ptr<const BlockContents> kept;
+    {
+        BlockCache cache(cache_options);
+        for (uint64_t offset = 0; offset < 100; offset++) {
+            std::shared_ptr<BlockContents> block = cache.NewBlock();
+            block->assign(4000, static_cast<char>('a' + offset % 26));
+            cache.Insert(1, offset, std::move(block), BlockCache::Priority::LOW);
+        }
+        assert(cache.GetUsage() <= cache.GetCapacity());
+        kept = cache.Lookup(1, 99);
+        assert(kept != nullptr && kept->size() == 4000 && (*kept)[0] == 'a' + 99 % 26);
+        assert(total(cache.GetHugePageStats()) > 0);
+    }
+    assert(kept->size() == 4000 && kept->back() == 'a' + 99 % 26); // 块比缓存活得久
+    kept.reset();
+
+    const std::string dbname = "test_huge_pages_db";
+    std::filesystem::remove_all(dbname);
+    Options options;
+    options.huge_pages_ = HugePageMode::TRANSPARENT;
+    std::unique_ptr<DB> db = DB::Open(dbname, options);
+    char key[16];
+    for (int i = 0; i < 3000; i++) {
+        snprintf(key, sizeof(key), "h%05d", i);
+        bool ok = db->Put(key, "value-" + std::to_string(i));
+        assert(ok);
+    }
+    bool ok = db->Flush();
+    assert(ok);
+    std::string value;
+    for (int i = 0; i < 3000; i += 7) {
+        snprintf(key, sizeof(key), "h%05d", i);
+        ok = db->Get(key, &value);
+        assert(ok && value == "value-" + std::to_string(i));
+    }
+    HugePageStats stats = db->GetHugePageStats();
+    assert(total(stats) >= HugePageResource::kHugePageSize);
+    assert(stats.transparent_huge_bytes_ <= stats.transparent_bytes_);
+    std::cout << "    (大页: 显式 " << stats.explicit_bytes_ << " B, 透明 " << stats.transparent_bytes_
+              << " B (实际 " << stats.transparent_huge_bytes_ << " B), 普通页 " << stats.regular_bytes_ << " B)"
+              << std::endl;
+    db.reset();
+    std::filesystem::remove_all(dbname);
+    std::cout << "  - 大页内存 PASSED" << std::endl;
+}
+
+#ifdef __linux__
+/**
+ * @brief 通过回环地址测试二进制协议服务器和客户端 (连接池、Pipeline、大值)
+ */
+void test_binary_client_server() {
+    const std::string dbname = "test_binserver_db";
+    std::filesystem::remove_all(dbname);
+    std::unique_ptr<DB> db = DB::Open(dbname, Options());
+    ServerOptions server_options;
+    server_options.port_ = 0;
+    server_options.protocol_ = ServerProtocol::BINARY;
+    server_options.max_read_per_event_ = 4 * 1024;     // 一次事件读不完的请求在下一轮继续
+    server_options.output_high_water_ = 64 * 1024;     // 大值的回复会触发暂停读取
+    KVServer server(db.get(), server_options);
+    bool ok = server.Start();
+    assert(ok);
+
+    ClientOptions client_options;
+    client_options.port_ = server.port();
+    client_options.pool_size_ = 2;
+    client_options.max_batch_ = 8;
+    std::unique_ptr<KVClient> client = KVClient::Connect(client_options);
+    assert(client != nullptr);
+    ok = client->Ping();
+    assert(ok);
+
+    std::string big(100 * 1024, 'B'); // 走 writev 的独立块
+    ok = client->Put("big", big);
+    assert(ok);
+    std::string value;
+    ok = client->Get("big", &value);
+    assert(ok && value == big);
+    ok = client->Get("missing", &value);
+    assert(!ok);
+
+    {
+        std::unique_ptr<ClientPipeline> pipeline = client->NewPipeline();
+        int done = 0;
+        for (int i = 0; i < 100; i++) {
+            pipeline->Put("p" + std::to_string(i), std::to_string(i), [&done](bool ok) {
+                assert(ok);
+                done++;
+            });
+        }
+        ok = pipeline->Wait();
+        assert(ok && done == 100 && pipeline->Pending() == 0);
+        int hits = 0;
+        for (int i = 0; i < 100; i++) {
+            pipeline->Get("p" + std::to_string(i), [&hits, i](bool found, std::string_view v) {
+                hits += (found && v == std::to_string(i));
+            });
+        }
+        ok = pipeline->Wait();
+        assert(ok && hits == 100);
+
+        // 回复积压超过高水位时服务器暂停读取，回复被读走后继续：所有请求都得到回复
+        int big_hits = 0;
+        for (int i = 0; i < 50; i++) {
+            pipeline->Get("big", [&big_hits, &big](bool found, std::string_view v) {
+                big_hits += (found && v == big);
+            });
+        }
+        ok = pipeline->Wait();
+        assert(ok && big_hits == 50);
+    }
+
+    WriteBatch batch;
+    batch.Put("w1", "x");
+    batch.Delete("p0");
+    ok = client->Write(batch);
+    assert(ok);
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    ok = client->MultiGet({"w1", "p0", "p1"}, &values, &found);
+    assert(ok);
+    assert(found[0] && values[0] == "x" && !found[1] && found[2] && values[2] == "1");
+    std::vector<std::pair<std::string, std::string>> results;
+    ok = client->Scan("p1", 3, &results);
+    assert(ok && results.size() == 3 && results[0].first == "p1");
+    std::cout << "  - 二进制协议客户端/服务器 PASSED" << std::endl;
+}
+
+/**
+ * @brief 测试查询缓冲区上限：声明一个巨大却不发完的 RESP 请求，服务器回复协议错误并关闭连接
+ */
+void test_query_buffer_limit() {
+    const std::string dbname = "test_querybuf_db";
+    std::filesystem::remove_all(dbname);
+    std::unique_ptr<DB> db = DB::Open(dbname, Options());
+    ServerOptions server_options;
+    server_options.port_ = 0;
+    server_options.max_read_per_event_ = 4 * 1024;
+    server_options.max_query_buffer_ = 64 * 1024;
+    KVServer server(db.get(), server_options);
+    bool ok = server.Start();
+    assert(ok);
+    const std::string address = "127.0.0.1:" + std::to_string(server.port());
+
+    // 读到对方关闭为止
+    auto read_until_eof = [](int fd) {
+        std::string reply;
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            reply.append(buf, n);
+        }
+        return reply;
+    };
+
+    int fd = ConnectTo(address);
+    assert(fd >= 0);
+    std::string request = "*1\r\n$536870912\r\n" + std::string(200 * 1024, 'x');
+    SendAll(fd, request); // 服务器可能在发完之前就关闭了连接
+    shutdown(fd, SHUT_WR);
+    std::string reply = read_until_eof(fd);
+    close(fd);
+    assert(reply == "-ERR Protocol error\r\n");
+
+    // 没超过上限的请求不受影响
+    fd = ConnectTo(address);
+    assert(fd >= 0);
+    ok = SendAll(fd, "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$" + std::to_string(32 * 1024) + "\r\n" +
+                         std::string(32 * 1024, 'v') + "\r\n");
+    assert(ok);
+    shutdown(fd, SHUT_WR);
+    reply = read_until_eof(fd);
+    close(fd);
+    assert(reply == "+OK\r\n");
+    std::cout << "  - 查询缓冲区上限 PASSED" << std::endl;
+}
+
+/**
+ * @brief 通过 Unix socket 测试主从复制：WAL 流式同步、积压不足时的快照追赶、主节点消失后的过期检测
+ */
+void test_replication() {
+    const std::string leader_dir = "test_repl_leader_db";
+    const std::string replica_dir = "test_repl_replica_db";
+    std::filesystem::remove_all(leader_dir);
+    std::filesystem::remove_all(replica_dir);
+    Options options;
+    options.write_buffer_size_ = 4 * 1024;
+    std::unique_ptr<DB> db = DB::Open(leader_dir, options);
+    auto key = [](int i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "r%06d", i);
+        return std::string(buf);
+    };
+
+    LeaderOptions leader_options;
+    leader_options.address_ = "unix:test_repl.sock";
+    leader_options.backlog_bytes_ = 1024;
+    std::unique_ptr<ReplicationLeader> leader = std::make_unique<ReplicationLeader>(db.get(), leader_options);
+    bool ok = leader->Start();
+    assert(ok);
+    for (int i = 0; i < 20; i++) { // 不超过积压上限
+        ok = db->Put(key(i), "v" + std::to_string(i));
+        assert(ok);
+    }
+
+    ReplicaOptions replica_options;
+    replica_options.leader_address_ = leader->address();
+    replica_options.max_lag_ms_ = 200;
+    replica_options.db_options_ = options;
+    {
+        // 1. 从空目录开始：积压里有全部写入，直接流式同步
+        std::unique_ptr<ReplicaClient> replica = ReplicaClient::Open(replica_dir, replica_options);
+        assert(replica != nullptr);
+        ok = replica->WaitForSequence(db->LastSequence(), 5000);
+        assert(ok);
+        std::string value;
+        ok = replica->Get(key(12), &value);
+        assert(ok && value == "v12");
+        ok = replica->Put("x", "y");
+        assert(!ok); // 只读
+        assert(leader->SnapshotsSent() == 0);
+    }
+
+    // 2. 从节点离线期间写入远超积压上限的数据
+    for (int i = 20; i < 2000; i++) {
+        ok = db->Put(key(i), "v" + std::to_string(i));
+        assert(ok);
+    }
+    for (int i = 0; i < 2000; i += 10) {
+        ok = db->Delete(key(i));
+        assert(ok);
+    }
+    ok = db->Flush();
+    assert(ok);
+
+    std::unique_ptr<ReplicaClient> replica = ReplicaClient::Open(replica_dir, replica_options);
+    assert(replica != nullptr);
+    ok = replica->WaitForSequence(db->LastSequence(), 5000);
+    assert(ok);
+    assert(leader->SnapshotsSent() == 1);
+    assert(std::filesystem::exists(replica_dir + "/data-000002"));
+    for (int i = 0; i < 100 && std::filesystem::exists(replica_dir + "/data-000001"); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 旧目录由最后一个持有者删除
+    }
+    assert(!std::filesystem::exists(replica_dir + "/data-000001"));
+    std::vector<std::string> keys;
+    for (int i = 0; i < 2000; i += 7) {
+        keys.push_back(key(i));
+    }
+    std::vector<std::string_view> key_views(keys.begin(), keys.end());
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    replica->MultiGet(key_views, &values, &found);
+    for (size_t i = 0; i < keys.size(); i++) {
+        int n = static_cast<int>(i) * 7;
+        assert(found[i] == (n % 10 != 0));
+        assert(!found[i] || values[i] == "v" + std::to_string(n));
+    }
+
+    // 3. 快照之后继续流式同步
+    ok = db->Put("after_snapshot", "1");
+    assert(ok);
+    ok = replica->WaitForSequence(db->LastSequence(), 5000);
+    assert(ok);
+    std::string value;
+    ok = replica->Get("after_snapshot", &value);
+    assert(ok && value == "1");
+    assert(replica->LeaderSequence() == db->LastSequence());
+
+    // 4. 主节点消失后，超过 max_lag_ms_ 的从节点拒绝读
+    leader.reset();
+    bool stale = false;
+    for (int i = 0; i < 200 && !stale; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stale = !replica->Get("after_snapshot", &value);
+    }
+    assert(stale && replica->Stale());
+    std::cout << "  - 主从复制 (WAL 流 + 快照追赶) PASSED" << std::endl;
+}
+#endif
 
 int main() {
     const std::string sst_filename = "test_v1.sst";
@@ -103,6 +2708,102 @@ int main() {
     // 测试 7: 查找一个不存在的 Key (比所有 Key 都小)
     test_get_notfound(reader, "aaa_Nobody");
 
+    // 测试 8: 表属性
+    const TableProperties& props = reader.GetProperties();
+    assert(props.num_entries_ == 15);
+    assert(props.num_data_blocks_ > 1);
+    assert(props.padding_size_ == 0 && props.page_size_ == 0);
+
+    std::cout << "\n--- Phase 4: 页对齐布局 (block_align_) ---" << std::endl;
+    test_page_aligned_layout();
+
+    std::cout << "\n--- Phase 5: 分区 Filter + 块缓存 ---" << std::endl;
+    test_block_cache_priority();
+    test_partitioned_filter();
+
+    std::cout << "\n--- Phase 6: 复用 Builder ---" << std::endl;
+    test_builder_reuse();
+
+    std::cout << "\n--- Phase 7: 按目标大小切分输出文件 ---" << std::endl;
+    test_output_splitting();
+
+    std::cout << "\n--- Phase 8: 平凡移动 + 文件级跳过 ---" << std::endl;
+    test_compaction_trivial_move_and_skip();
+
+    std::cout << "\n--- Phase 9: DB 引擎 + RESP 协议 ---" << std::endl;
+    DebugLogEnabled() = false; // DB 的写入量较大，关闭逐条日志
+    test_db();
+    test_resp();
+
+    std::cout << "\n--- Phase 10: 分片引擎 (thread-per-core) ---" << std::endl;
+    test_sharded_db();
+
+    std::cout << "\n--- Phase 11: 二进制协议 + 客户端 ---" << std::endl;
+    test_binary_protocol();
+#ifdef __linux__
+    test_binary_client_server();
+    test_query_buffer_limit();
+#endif
+
+#ifdef __linux__
+    std::cout << "\n--- Phase 12: 主从复制 ---" << std::endl;
+    test_replication();
+#endif
+
+    std::cout << "\n--- Phase 13: 只读实例 ---" << std::endl;
+    test_secondary_instance();
+
+    std::cout << "\n--- Phase 14: 变更数据捕获 ---" << std::endl;
+    test_get_updates_since();
+
+    std::cout << "\n--- Phase 15: 二级索引 ---" << std::endl;
+    test_secondary_index();
+
+    std::cout << "\n--- Phase 16: 时间序列模式 ---" << std::endl;
+    test_time_series();
+
+    std::cout << "\n--- Phase 17: FIFO Compaction ---" << std::endl;
+    test_fifo_compaction();
+
+    std::cout << "\n--- Phase 18: 按层压缩 + 周期性 Compaction ---" << std::endl;
+    test_compression_and_periodic_compaction();
+
+    std::cout << "\n--- Phase 19: 可插拔比较器 ---" << std::endl;
+    test_comparators();
+
+    std::cout << "\n--- Phase 20: 定长 Key 数据块 ---" << std::endl;
+    test_fixed_key_blocks();
+
+    std::cout << "\n--- Phase 21: Key 缩写 (MemTable / 索引) ---" << std::endl;
+    test_key_prefixes();
+
+    std::cout << "\n--- Phase 22: 交错的批量查找 ---" << std::endl;
+    test_batched_lookups();
+
+    std::cout << "\n--- Phase 23: 行缓存 ---" << std::endl;
+    test_row_cache();
+
+    std::cout << "\n--- Phase 24: 二级块缓存 (本地文件) ---" << std::endl;
+    test_secondary_cache();
+
+    std::cout << "\n--- Phase 25: 块缓存压缩层 ---" << std::endl;
+    test_compressed_block_cache();
+
+    std::cout << "\n--- Phase 26: 块缓存预热 ---" << std::endl;
+    test_cache_warmup();
+
+    std::cout << "\n--- Phase 27: 块缓存优先级池 ---" << std::endl;
+    test_block_cache_pools();
+
+    std::cout << "\n--- Phase 28: 大页内存 ---" << std::endl;
+    test_huge_pages();
+
+    std::cout << "\n--- Phase 29: 页对齐 + 压缩 ---" << std::endl;
+    test_aligned_compressed_layout();
+
+    std::cout << "\n--- Phase 30: WAL 校验 ---" << std::endl;
+    test_wal_corruption();
+
     std::cout << "\n--- V1 模块集成测试完成 ---" << std::endl;
 
     return 0;
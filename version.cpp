@@ -0,0 +1,283 @@
+#include "version.h"
+#include "base.h"
+#include <algorithm>
+#include <iostream>
+#include <filesystem>
+#include <iterator>
+
+// --- VersionEdit ---
+
+void VersionEdit::EncodeTo(std::string* dst) const {
+    std::string field;
+    if (next_file_number_ != 0) {
+        PutFixed64(&field, next_file_number_);
+        writeKV(dst, "next_file", field);
+    }
+    if (log_number_ != 0) {
+        field.clear();
+        PutFixed64(&field, log_number_);
+        writeKV(dst, "log", field);
+    }
+    if (last_sequence_ != 0) {
+        field.clear();
+        PutFixed64(&field, last_sequence_);
+        writeKV(dst, "last_seq", field);
+    }
+    for (const auto& deleted : deleted_files_) {
+        field.clear();
+        PutFixed32(&field, static_cast<uint32_t>(deleted.first));
+        PutFixed64(&field, deleted.second);
+        writeKV(dst, "del", field);
+    }
+    for (const auto& added : new_files_) {
+        const FileMetaData& f = added.second;
+        field.clear();
+        PutFixed32(&field, static_cast<uint32_t>(added.first));
+        PutFixed64(&field, f.number_);
+        PutFixed64(&field, f.file_size_);
+        writeKV(&field, f.smallest_, f.largest_);
+        // 可选属性: 与记录本身一样是 [名字] -> [值] 的 K/V 序列
+        std::string property;
+        if (f.has_time_range_) {
+            PutFixed64(&property, f.min_timestamp_);
+            PutFixed64(&property, f.max_timestamp_);
+            writeKV(&field, "time_range", property);
+        }
+        if (f.creation_time_ != 0) {
+            property.clear();
+            PutFixed64(&property, f.creation_time_);
+            writeKV(&field, "creation_time", property);
+        }
+        writeKV(dst, "add", field);
+    }
+}
+
+bool VersionEdit::DecodeFrom(std::string_view input) {
+    while (!input.empty()) {
+        std::string_view tag;
+        std::string_view field;
+        if (!readKV(&input, &tag, &field)) {
+            return false;
+        }
+
+        uint32_t level = 0;
+        if (tag == "next_file") {
+            if (!GetFixed64(&field, &next_file_number_)) return false;
+        } else if (tag == "log") {
+            if (!GetFixed64(&field, &log_number_)) return false;
+        } else if (tag == "last_seq") {
+            if (!GetFixed64(&field, &last_sequence_)) return false;
+        } else if (tag == "del") {
+            uint64_t number = 0;
+            if (!GetFixed32(&field, &level) || !GetFixed64(&field, &number)) return false;
+            DeleteFile(static_cast<int>(level), number);
+        } else if (tag == "add") {
+            FileMetaData f;
+            std::string_view smallest;
+            std::string_view largest;
+            if (!GetFixed32(&field, &level) || !GetFixed64(&field, &f.number_) ||
+                !GetFixed64(&field, &f.file_size_) || !readKV(&field, &smallest, &largest)) {
+                return false;
+            }
+            f.smallest_ = std::string(smallest);
+            f.largest_ = std::string(largest);
+            while (!field.empty()) {
+                std::string_view name;
+                std::string_view property;
+                if (!readKV(&field, &name, &property)) {
+                    return false;
+                }
+                if (name == "time_range") {
+                    if (!GetFixed64(&property, &f.min_timestamp_) || !GetFixed64(&property, &f.max_timestamp_)) {
+                        return false;
+                    }
+                    f.has_time_range_ = true;
+                } else if (name == "creation_time") {
+                    if (!GetFixed64(&property, &f.creation_time_)) return false;
+                }
+            }
+            AddFile(static_cast<int>(level), f);
+        }
+        // (未知的字段直接跳过，便于以后追加新字段)
+        if (level >= NUM_LEVELS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Version ---
+
+void Version::GetOverlappingInputs(int level, std::string_view begin, std::string_view end,
+                                   std::vector<FileMetaData>* inputs) const {
+    for (const FileMetaData& f : files_[level]) {
+        if (f.largest_ < begin || f.smallest_ > end) {
+            continue; // 完全在范围之外
+        }
+        inputs->push_back(f);
+    }
+}
+
+uint64_t Version::LevelBytes(int level) const {
+    uint64_t total = 0;
+    for (const FileMetaData& f : files_[level]) {
+        total += f.file_size_;
+    }
+    return total;
+}
+
+// --- VersionSet ---
+
+VersionSet::VersionSet(const std::string& dbname)
+    : dbname_(dbname),
+      next_file_number_(1),
+      log_number_(0),
+      last_sequence_(0),
+      manifest_offset_(0),
+      current_(std::make_shared<Version>()) {}
+
+ManifestTail VersionSet::Tail() const {
+    ManifestTail tail;
+    tail.offset_ = manifest_offset_;
+    tail.version_ = current();
+    tail.next_file_number_ = next_file_number_.load();
+    tail.log_number_ = log_number_;
+    tail.last_sequence_ = last_sequence_;
+    return tail;
+}
+
+/**
+ * @brief 重放 MANIFEST
+ * MANIFEST 格式: 连续的 [record_len (4B)] [VersionEdit 记录]
+ * 最后一条记录如果不完整 (写入时崩溃，或者主实例正在写入)，停在它之前。
+ */
+bool VersionSet::ReadManifest(ManifestTail* tail, bool* changed) const {
+    *changed = false;
+    const std::string filename = ManifestFileName(dbname_);
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+        return true; // MANIFEST 不存在：空数据库
+    }
+    ifs.seekg(static_cast<std::streamoff>(tail->offset_));
+    std::string contents((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    std::string_view input = contents;
+    std::shared_ptr<Version> version;
+    int records = 0;
+    uint32_t record_len = 0;
+    while (GetFixed32(&input, &record_len) && input.size() >= record_len) {
+        VersionEdit edit;
+        if (!edit.DecodeFrom(input.substr(0, record_len))) {
+            std::cerr << "错误: MANIFEST 记录损坏 " << filename << std::endl;
+            return false;
+        }
+        input.remove_prefix(record_len);
+        version = Apply(version ? *version : *tail->version_, edit);
+        if (edit.next_file_number_ != 0) {
+            tail->next_file_number_ = edit.next_file_number_;
+        }
+        if (edit.log_number_ != 0) {
+            tail->log_number_ = edit.log_number_;
+        }
+        if (edit.last_sequence_ != 0) {
+            tail->last_sequence_ = edit.last_sequence_;
+        }
+        tail->offset_ += sizeof(record_len) + record_len;
+        records++;
+    }
+    if (records == 0) {
+        return true;
+    }
+    KV_DEBUG_LOG("  [VersionSet] 重放 MANIFEST: " << records << " 条记录");
+
+    // 新文件编号必须大于所有已存在的文件
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        for (const FileMetaData& f : version->files_[level]) {
+            tail->next_file_number_ = std::max(tail->next_file_number_, f.number_ + 1);
+        }
+    }
+    tail->version_ = std::move(version);
+    *changed = true;
+    return true;
+}
+
+void VersionSet::Install(const ManifestTail& tail) {
+    manifest_offset_ = tail.offset_;
+    next_file_number_.store(std::max(next_file_number_.load(), tail.next_file_number_));
+    log_number_ = tail.log_number_;
+    last_sequence_ = tail.last_sequence_;
+    std::atomic_store(&current_, tail.version_);
+}
+
+bool VersionSet::Recover() {
+    ManifestTail tail = Tail();
+    bool changed = false;
+    if (!ReadManifest(&tail, &changed)) {
+        return false;
+    }
+    Install(tail);
+
+    // 截掉可能存在的不完整尾部记录，然后以追加模式打开
+    const std::string filename = ManifestFileName(dbname_);
+    if (std::filesystem::exists(filename)) {
+        std::filesystem::resize_file(filename, manifest_offset_);
+    }
+    manifest_.open(filename, std::ios::binary | std::ios::app);
+    if (!manifest_) {
+        std::cerr << "错误: 无法打开 MANIFEST " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VersionSet::LogAndApply(VersionEdit* edit) {
+    edit->next_file_number_ = next_file_number_.load();
+
+    // 1. 先写 MANIFEST (持久化)
+    std::string record;
+    edit->EncodeTo(&record);
+    std::string header;
+    PutFixed32(&header, static_cast<uint32_t>(record.size()));
+    manifest_.write(header.data(), header.size());
+    manifest_.write(record.data(), record.size());
+    manifest_.flush();
+    if (!manifest_) {
+        std::cerr << "错误: 写入 MANIFEST 失败" << std::endl;
+        return false;
+    }
+    manifest_offset_ += header.size() + record.size();
+
+    // 2. 再切换内存中的当前版本
+    if (edit->log_number_ != 0) {
+        log_number_ = edit->log_number_;
+    }
+    if (edit->last_sequence_ != 0) {
+        last_sequence_ = edit->last_sequence_;
+    }
+    std::shared_ptr<const Version> base = current();
+    std::atomic_store(&current_, std::shared_ptr<const Version>(Apply(*base, *edit)));
+    return true;
+}
+
+/**
+ * @brief 生成新版本：先删除，再添加，最后重新排序
+ */
+std::shared_ptr<Version> VersionSet::Apply(const Version& base, const VersionEdit& edit) {
+    std::shared_ptr<Version> v = std::make_shared<Version>(base);
+    for (const auto& deleted : edit.deleted_files_) {
+        std::vector<FileMetaData>& files = v->files_[deleted.first];
+        files.erase(std::remove_if(files.begin(), files.end(),
+                                   [&](const FileMetaData& f) { return f.number_ == deleted.second; }),
+                    files.end());
+    }
+    for (const auto& added : edit.new_files_) {
+        v->files_[added.first].push_back(added.second);
+    }
+
+    std::sort(v->files_[0].begin(), v->files_[0].end(),
+              [](const FileMetaData& a, const FileMetaData& b) { return a.number_ < b.number_; });
+    for (int level = 1; level < NUM_LEVELS; level++) {
+        std::sort(v->files_[level].begin(), v->files_[level].end(),
+                  [](const FileMetaData& a, const FileMetaData& b) { return a.smallest_ < b.smallest_; });
+    }
+    return v;
+}
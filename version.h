@@ -0,0 +1,163 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <utility>
+#include "dbformat.h"
+
+/**
+ * @brief VersionEdit (版本变更)
+ * 描述一次刷盘/Compaction 对文件集合的修改：删除哪些文件、新增哪些文件。
+ * 每个 VersionEdit 作为一条记录追加到 MANIFEST，重启时按顺序重放即可恢复文件集合。
+ *
+ * 记录格式: K/V 序列 (与 Data Block 相同的 writeKV 格式)
+ *   "next_file" -> [next_file_number (8B)]
+ *   "log"       -> [log_number (8B)]       (编号小于它的 WAL 都已经刷盘，可以删除)
+ *   "last_seq"  -> [last_sequence (8B)]
+ *   "del"       -> [level (4B)] [number (8B)]
+ *   "add"       -> [level (4B)] [number (8B)] [file_size (8B)] [smallest/largest (K/V)]
+ *                  [min_timestamp (8B)] [max_timestamp (8B)]  (可选，仅当文件有时间戳范围)
+ */
+struct VersionEdit {
+    std::vector<std::pair<int, uint64_t>> deleted_files_;  // (level, 文件编号)
+    std::vector<std::pair<int, FileMetaData>> new_files_;  // (level, 文件)
+    uint64_t next_file_number_ = 0;                        // 0 表示未设置
+    uint64_t log_number_ = 0;                              // 0 表示未设置
+    uint64_t last_sequence_ = 0;                           // 0 表示未设置
+
+    void DeleteFile(int level, uint64_t number) {
+        deleted_files_.emplace_back(level, number);
+    }
+
+    void AddFile(int level, const FileMetaData& file) {
+        new_files_.emplace_back(level, file);
+    }
+
+    void EncodeTo(std::string* dst) const;
+    bool DecodeFrom(std::string_view input);
+};
+
+/**
+ * @brief Version (版本) - 某一时刻每一层的文件列表
+ * 一个 Version 创建后就不再修改 (LogAndApply 会生成新的 Version)，
+ * 所以读者持有 shared_ptr 期间可以安全地遍历它。
+ *
+ * L0 的文件之间可能重叠，按文件编号升序排列 (越靠后越新)；
+ * L1 及以上每层的文件互不重叠，按 smallest_ 升序排列。
+ */
+struct Version {
+    std::vector<FileMetaData> files_[NUM_LEVELS];
+
+    /**
+     * @brief 找出 level 中与 [begin, end] 重叠的所有文件
+     */
+    void GetOverlappingInputs(int level, std::string_view begin, std::string_view end,
+                              std::vector<FileMetaData>* inputs) const;
+
+    /**
+     * @brief 某一层所有文件的总字节数
+     */
+    uint64_t LevelBytes(int level) const;
+};
+
+/**
+ * @brief ManifestTail (MANIFEST 读取进度)
+ * 重放到 MANIFEST 某个位置得到的状态。只读实例用它增量地跟随主实例追加的记录：
+ * 先读出新的状态，准备好之后再安装。
+ */
+struct ManifestTail {
+    uint64_t offset_ = 0;                    // 下一条记录在 MANIFEST 中的偏移量
+    std::shared_ptr<const Version> version_;
+    uint64_t next_file_number_ = 1;
+    uint64_t log_number_ = 0;
+    uint64_t last_sequence_ = 0;
+};
+
+/**
+ * @brief VersionSet (版本集合)
+ * 职责：管理当前 Version、分配文件编号、读写 MANIFEST。
+ * 线程安全：LogAndApply() 需要由调用方串行调用；current() 和 NewFileNumber() 可以并发调用。
+ */
+class VersionSet {
+public:
+    /**
+     * @brief 构造函数
+     * @param dbname 数据库目录 (MANIFEST 和 SSTable 都在这里)
+     */
+    explicit VersionSet(const std::string& dbname);
+
+    // 禁用拷贝和赋值
+    VersionSet(const VersionSet&) = delete;
+    VersionSet& operator=(const VersionSet&) = delete;
+
+    /**
+     * @brief 重放 MANIFEST 恢复文件集合 (MANIFEST 不存在时从空版本开始)，
+     * 然后打开 MANIFEST 准备追加新的记录。
+     * @return true 成功
+     */
+    bool Recover();
+
+    /**
+     * @brief 把 edit 追加到 MANIFEST 并生成新的当前 Version
+     * @return true 成功 (MANIFEST 写入失败时当前 Version 不变)
+     */
+    bool LogAndApply(VersionEdit* edit);
+
+    /**
+     * @brief 当前已安装的状态 (作为 ReadManifest() 的起点)
+     */
+    ManifestTail Tail() const;
+
+    /**
+     * @brief 以只读方式重放 MANIFEST 中 tail->offset_ 之后新增的完整记录 (不修改 MANIFEST 和当前版本)
+     * @param changed [out] 是否读到了新记录
+     * @return false 如果记录损坏
+     */
+    bool ReadManifest(ManifestTail* tail, bool* changed) const;
+
+    /**
+     * @brief 安装 ReadManifest() 读出的状态
+     * 线程安全：与 LogAndApply() 一样需要由调用方串行调用。
+     */
+    void Install(const ManifestTail& tail);
+
+    /**
+     * @brief 分配一个新的文件编号
+     */
+    uint64_t NewFileNumber() { return next_file_number_.fetch_add(1); }
+
+    /**
+     * @brief 获取当前 Version
+     */
+    std::shared_ptr<const Version> current() const { return std::atomic_load(&current_); }
+
+    const std::string& dbname() const { return dbname_; }
+
+    /**
+     * @brief 当前仍需要重放的最小 WAL 编号 (更小的 WAL 都已经刷盘)
+     */
+    uint64_t LogNumber() const { return log_number_; }
+
+    /**
+     * @brief 已经持久化到 SSTable 的最大序列号 (至少)
+     */
+    uint64_t LastSequence() const { return last_sequence_; }
+
+private:
+    /**
+     * @brief (私有) 把 edit 应用到 base 上，生成一个新的 Version
+     */
+    static std::shared_ptr<Version> Apply(const Version& base, const VersionEdit& edit);
+
+    std::string dbname_;
+    std::atomic<uint64_t> next_file_number_;
+    uint64_t log_number_;
+    uint64_t last_sequence_;
+    uint64_t manifest_offset_;   // 已经重放到的 MANIFEST 位置
+    std::shared_ptr<const Version> current_;
+    std::ofstream manifest_; // MANIFEST 的追加写入流
+};
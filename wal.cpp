@@ -0,0 +1,148 @@
+#include "wal.h"
+#include "base.h"
+#include "dbformat.h"
+#include <array>
+
+/**
+ * @brief (辅助) CRC-32 (IEEE 802.3 多项式，与 zlib 的 crc32 相同)
+ */
+static uint32_t Crc32(uint32_t crc, const char* data, size_t n) {
+    static const auto kTable = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        crc = kTable[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief (辅助) 一条记录的校验和 (覆盖长度字段和内容)
+ */
+static uint32_t RecordCrc(uint32_t record_len, std::string_view record) {
+    uint32_t crc = Crc32(0, reinterpret_cast<const char*>(&record_len), sizeof(record_len));
+    return Crc32(crc, record.data(), record.size());
+}
+
+LogWriter::LogWriter(const std::string& filename)
+    : ofs_(filename, std::ios::binary | std::ios::trunc),
+      size_(0) {
+    if (!ofs_) {
+        std::cerr << "错误: 无法创建 WAL 文件 " << filename << std::endl;
+    }
+}
+
+bool LogWriter::AddRecord(std::string_view record) {
+    uint32_t record_len = static_cast<uint32_t>(record.size());
+    uint32_t crc = RecordCrc(record_len, record);
+    ofs_.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    ofs_.write(reinterpret_cast<const char*>(&record_len), sizeof(record_len));
+    ofs_.write(record.data(), record.size());
+    ofs_.flush(); // 交给操作系统，进程崩溃也不会丢
+    if (!ofs_) {
+        return false;
+    }
+    size_ += sizeof(crc) + sizeof(record_len) + record.size();
+    return true;
+}
+
+LogReader::LogReader(const std::string& filename, uint64_t offset)
+    : ifs_(filename, std::ios::binary | std::ios::ate),
+      offset_(offset),
+      file_size_(0),
+      eof_(false) {
+    if (ifs_) {
+        file_size_ = static_cast<uint64_t>(ifs_.tellg());
+        ifs_.seekg(static_cast<std::streamoff>(offset_));
+    }
+}
+
+bool LogReader::ReadRecord(std::string* record) {
+    eof_ = false;
+    uint32_t header[2] = {0, 0}; // [crc32][record_len]
+    ifs_.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (ifs_.gcount() == 0) {
+        eof_ = (offset_ == file_size_);
+        return false; // 文件结尾
+    }
+    if (ifs_.gcount() != sizeof(header)) {
+        return false; // 不完整的头部
+    }
+    const uint32_t crc = header[0];
+    const uint32_t record_len = header[1];
+    // (文件在打开后可能还在增长，超出打开时大小的部分当作还没有写入)
+    const uint64_t available = file_size_ > offset_ + sizeof(header) ? file_size_ - offset_ - sizeof(header) : 0;
+    if (record_len > available) {
+        return false; // 长度超出文件: 不完整的尾部记录或者损坏的长度 (不按它分配内存)
+    }
+    record->resize(record_len);
+    ifs_.read(&(*record)[0], record_len);
+    if (static_cast<uint32_t>(ifs_.gcount()) != record_len) {
+        return false; // 不完整的尾部记录
+    }
+    if (RecordCrc(record_len, *record) != crc) {
+        std::cerr << "错误: WAL 记录校验和不符 (偏移量 " << offset_ << ")" << std::endl;
+        return false;
+    }
+    offset_ += sizeof(header) + record_len;
+    return true;
+}
+
+UpdatesIterator::UpdatesIterator(const std::string& dbname, std::vector<uint64_t> logs,
+                                 uint64_t start_sequence, uint64_t last_sequence)
+    : dbname_(dbname),
+      logs_(std::move(logs)),
+      last_sequence_(last_sequence),
+      index_(0),
+      next_sequence_(start_sequence),
+      valid_(false),
+      ok_(true) {
+    ReadNext();
+}
+
+void UpdatesIterator::ReadNext() {
+    valid_ = false;
+    if (!ok_ || next_sequence_ > last_sequence_) {
+        return;
+    }
+    while (index_ < logs_.size()) {
+        if (reader_ == nullptr) {
+            reader_ = std::make_unique<LogReader>(LogFileName(dbname_, logs_[index_]));
+            if (!reader_->is_open()) {
+                std::cerr << "错误: WAL " << logs_[index_] << " 已经被删除" << std::endl;
+                ok_ = false;
+                return;
+            }
+        }
+        while (reader_->ReadRecord(&record_)) {
+            if (!batch_.SetContents(record_)) {
+                std::cerr << "错误: WAL " << logs_[index_] << " 中有损坏的记录" << std::endl;
+                ok_ = false;
+                return;
+            }
+            if (batch_.Count() == 0 || batch_.Sequence() + batch_.Count() - 1 < next_sequence_) {
+                continue; // 起始序列号之前的批次
+            }
+            if (batch_.Sequence() > next_sequence_) {
+                std::cerr << "错误: WAL 中的序列号不连续: 期望 " << next_sequence_
+                          << ", 读到 " << batch_.Sequence() << std::endl;
+                ok_ = false;
+                return;
+            }
+            next_sequence_ = batch_.Sequence() + batch_.Count();
+            valid_ = true;
+            return;
+        }
+        reader_.reset();
+        index_++;
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "writebatch.h"
+
+/**
+ * @brief WAL (预写日志) 格式
+ * 文件由连续的记录组成: [crc32 (4B)] [record_len (4B)] [record (record_len 字节)]
+ * crc32 覆盖 record_len 和 record。每条记录是一个 WriteBatch 的序列化内容。
+ * 写入时崩溃可能留下一条不完整的尾部记录，读取时会把它当作文件结尾；
+ * 校验和不符或者长度超出文件的记录 (损坏) 同样被当作文件结尾。
+ */
+
+/**
+ * @brief LogWriter (WAL 写入器)
+ * 每条记录写入后立即 flush 到操作系统 (进程崩溃不丢数据；掉电可能丢失最后几条)。
+ */
+class LogWriter {
+public:
+    /**
+     * @brief 构造函数：创建 (清空) 一个 WAL 文件
+     */
+    explicit LogWriter(const std::string& filename);
+
+    // 禁用拷贝和赋值
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    /**
+     * @brief 追加一条记录
+     * @return true 成功
+     */
+    bool AddRecord(std::string_view record);
+
+    bool is_open() const { return ofs_.is_open(); }
+
+    /**
+     * @brief 已写入的字节数
+     */
+    uint64_t Size() const { return size_; }
+
+private:
+    std::ofstream ofs_;
+    uint64_t size_;
+};
+
+/**
+ * @brief LogReader (WAL 读取器)
+ * 按顺序读出每一条完整的记录。
+ */
+class LogReader {
+public:
+    /**
+     * @brief 构造函数
+     * @param offset 从这个偏移量开始读 (必须是某条记录的开头，例如上一次的 Offset())
+     */
+    explicit LogReader(const std::string& filename, uint64_t offset = 0);
+
+    // 禁用拷贝和赋值
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    bool is_open() const { return ifs_.is_open(); }
+
+    /**
+     * @brief 读取下一条记录
+     * @param record [out] 记录内容
+     * @return false 如果已经没有完整的记录 (文件结尾、不完整的尾部记录或损坏的记录)
+     */
+    bool ReadRecord(std::string* record);
+
+    /**
+     * @brief ReadRecord 返回 false 时，是否正好停在文件结尾
+     * (false 表示停在了不完整或损坏的记录上，之后的内容都不可信)
+     */
+    bool eof() const { return eof_; }
+
+    /**
+     * @brief 最后一条完整记录结尾的文件偏移量
+     */
+    uint64_t Offset() const { return offset_; }
+
+private:
+    std::ifstream ifs_;
+    uint64_t offset_;
+    uint64_t file_size_; // 打开时的文件大小 (记录长度不可能超出它)
+    bool eof_;
+};
+
+/**
+ * @brief UpdatesIterator (变更迭代器)
+ * 按序列号顺序依次读出一组 WAL 中已经提交的 WriteBatch (由 DB::GetUpdatesSince 创建)。
+ * 第一个批次是包含起始序列号的那个批次；之后每个批次的序列号都紧接着上一个。
+ * 读到创建时的最大序列号为止；需要继续跟随时，从最后一个批次之后的序列号重新创建。
+ */
+class UpdatesIterator {
+public:
+    /**
+     * @brief 构造函数
+     * @param logs 按编号升序排列的 WAL 编号，第一个 WAL 包含 start_sequence
+     * @param last_sequence 只读到这个序列号 (含) 为止
+     */
+    UpdatesIterator(const std::string& dbname, std::vector<uint64_t> logs,
+                    uint64_t start_sequence, uint64_t last_sequence);
+
+    // 禁用拷贝和赋值
+    UpdatesIterator(const UpdatesIterator&) = delete;
+    UpdatesIterator& operator=(const UpdatesIterator&) = delete;
+
+    bool Valid() const { return valid_; }
+    void Next() { ReadNext(); }
+
+    /**
+     * @brief 当前批次 (batch().Sequence() 是它第一条记录的序列号)
+     */
+    const WriteBatch& batch() const { return batch_; }
+
+    /**
+     * @brief false 如果中途遇到损坏的记录、被删除的 WAL 或不连续的序列号
+     */
+    bool ok() const { return ok_; }
+
+private:
+    void ReadNext();
+
+    const std::string dbname_;
+    const std::vector<uint64_t> logs_;
+    const uint64_t last_sequence_;
+    size_t index_;                      // 正在读取的 WAL 在 logs_ 中的下标
+    std::unique_ptr<LogReader> reader_;
+    uint64_t next_sequence_;            // 下一个批次应当包含的序列号
+    std::string record_;
+    WriteBatch batch_;
+    bool valid_;
+    bool ok_;
+};
@@ -0,0 +1,94 @@
+#include "writebatch.h"
+#include "base.h"
+#include "dbformat.h"
+
+// 头部: [sequence (8B)] [count (4B)]
+static const size_t kHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+WriteBatch::WriteBatch() {
+    Clear();
+}
+
+void WriteBatch::Clear() {
+    rep_.clear();
+    rep_.resize(kHeaderSize, 0);
+}
+
+uint32_t WriteBatch::Count() const {
+    uint32_t count = 0;
+    memcpy(&count, rep_.data() + sizeof(uint64_t), sizeof(count));
+    return count;
+}
+
+uint64_t WriteBatch::Sequence() const {
+    uint64_t sequence = 0;
+    memcpy(&sequence, rep_.data(), sizeof(sequence));
+    return sequence;
+}
+
+void WriteBatch::SetSequence(uint64_t sequence) {
+    memcpy(&rep_[0], &sequence, sizeof(sequence));
+}
+
+void WriteBatch::Put(std::string_view key, std::string_view value) {
+    uint32_t count = Count() + 1;
+    memcpy(&rep_[sizeof(uint64_t)], &count, sizeof(count));
+    rep_.push_back(static_cast<char>(TYPE_VALUE));
+    writeKV(&rep_, key, value);
+}
+
+void WriteBatch::Delete(std::string_view key) {
+    uint32_t count = Count() + 1;
+    memcpy(&rep_[sizeof(uint64_t)], &count, sizeof(count));
+    rep_.push_back(static_cast<char>(TYPE_DELETION));
+    writeKV(&rep_, key, std::string_view());
+}
+
+bool WriteBatch::Iterate(Handler* handler) const {
+    std::string_view input(rep_);
+    input.remove_prefix(kHeaderSize);
+    uint32_t found = 0;
+    while (!input.empty()) {
+        char type = input[0];
+        input.remove_prefix(1);
+        std::string_view key;
+        std::string_view value;
+        if (!readKV(&input, &key, &value)) {
+            return false;
+        }
+        if (type == TYPE_VALUE) {
+            handler->Put(key, value);
+        } else if (type == TYPE_DELETION) {
+            handler->Delete(key);
+        } else {
+            return false; // 未知的记录类型
+        }
+        found++;
+    }
+    return found == Count();
+}
+
+namespace {
+
+// 只计数的 Handler，用于 Validate()
+class CountingHandler : public WriteBatch::Handler {
+public:
+    void Put(std::string_view, std::string_view) override { count_++; }
+    void Delete(std::string_view) override { count_++; }
+    uint32_t count_ = 0;
+};
+
+} // namespace
+
+bool WriteBatch::Validate() const {
+    CountingHandler counter;
+    return Iterate(&counter) && counter.count_ == Count();
+}
+
+bool WriteBatch::SetContents(std::string_view contents) {
+    if (contents.size() < kHeaderSize) {
+        return false;
+    }
+    rep_.assign(contents.data(), contents.size());
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+/**
+ * @brief WriteBatch (写批次)
+ * 把多个 Put / Delete 打包成一次原子写入：要么全部生效，要么全部不生效。
+ * 整个批次作为 *一条* WAL 记录落盘，所以崩溃恢复时也是原子的。
+ *
+ * 格式: [sequence (8B)] [count (4B)] [记录...]
+ * 记录: [type (1B)] [key/value (writeKV 格式；Delete 的 value 为空)]
+ * 批次中第 i 条记录的序列号是 sequence + i。
+ */
+class WriteBatch {
+public:
+    /**
+     * @brief Handler (遍历回调) - Iterate() 按写入顺序回调每条记录
+     */
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+        virtual void Put(std::string_view key, std::string_view value) = 0;
+        virtual void Delete(std::string_view key) = 0;
+    };
+
+    WriteBatch();
+
+    void Put(std::string_view key, std::string_view value);
+    void Delete(std::string_view key);
+
+    /**
+     * @brief 清空批次 (保留缓冲区容量)
+     */
+    void Clear();
+
+    /**
+     * @brief 批次中的记录数
+     */
+    uint32_t Count() const;
+
+    /**
+     * @brief 批次第一条记录的序列号 (由 DB 在写入时分配)
+     */
+    uint64_t Sequence() const;
+    void SetSequence(uint64_t sequence);
+
+    /**
+     * @brief 按写入顺序遍历所有记录
+     * @return false 如果批次内容损坏
+     */
+    bool Iterate(Handler* handler) const;
+
+    /**
+     * @brief 只解析不应用，检查记录都能完整解析且条数与头部的 count 一致
+     * 来自网络或磁盘的批次在写入 WAL / MemTable 之前先校验，避免只应用一半
+     */
+    bool Validate() const;
+
+    /**
+     * @brief 批次的序列化内容 (即 WAL 记录的内容)
+     */
+    const std::string& Contents() const { return rep_; }
+
+    /**
+     * @brief 从序列化内容恢复批次 (WAL 重放时使用)
+     * @return false 如果内容太短
+     */
+    bool SetContents(std::string_view contents);
+
+private:
+    std::string rep_;
+};